@@ -0,0 +1,117 @@
+#pragma once
+
+#include "core/session.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace bench
+{
+// CPU time consumed by the calling thread, in seconds.
+inline double ThreadCpuSeconds()
+{
+#if defined(_WIN32)
+    FILETIME creation{};
+    FILETIME exit{};
+    FILETIME kernel{};
+    FILETIME user{};
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    const auto toTicks = [](const FILETIME& ft)
+    {
+        return (static_cast<unsigned long long>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    };
+    return static_cast<double>(toTicks(kernel) + toTicks(user)) / 10000000.0;
+#else
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+#endif
+}
+
+// Nearest-rank percentile of an already sorted sample (p in [0, 100]).
+inline double SortedPercentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Ex-Gaussian reaction times (mu 250 ms, sigma 30 ms, tau 80 ms), a typical simple-RT shape, drawn from the
+// caller's generator so other draws can be interleaved with them.
+class ExGaussian
+{
+public:
+    double operator()(std::mt19937_64& rng) { return gaussian_(rng) + exponential_(rng); }
+
+private:
+    std::normal_distribution<double> gaussian_{250.0, 30.0};
+    std::exponential_distribution<double> exponential_{1.0 / 80.0};
+};
+
+// `count` ex-Gaussian reactions from a generator seeded with `seed`.
+inline std::vector<double> ExGaussianSample(size_t count, std::uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    ExGaussian reaction;
+    std::vector<double> values(count);
+    for (double& value : values)
+    {
+        value = reaction(rng);
+    }
+    return values;
+}
+
+// One check line ("  ok   name   detail" or FAIL); returns `ok`.
+inline bool PrintCheck(const char* name, bool ok, const char* detail, int nameWidth = 34)
+{
+    std::printf("  %-4s %-*s %s\n", ok ? "ok" : "FAIL", nameWidth, name, detail);
+    return ok;
+}
+
+// Sorts `ns` and prints its p50, p99, p99.9 and max under a "%-*s %9s %9s %9s %11s" header.
+inline void ReportLatency(const char* name, std::vector<double>& ns, int nameWidth)
+{
+    std::sort(ns.begin(), ns.end());
+    std::printf("  %-*s %9.0f %9.0f %9.0f %11.0f\n",
+        nameWidth,
+        name,
+        SortedPercentile(ns, 50.0),
+        SortedPercentile(ns, 99.0),
+        SortedPercentile(ns, 99.9),
+        ns.empty() ? 0.0 : ns.back());
+}
+
+// Synthetic session results (uniform 2-5 s foreperiods, ex-Gaussian reactions, ~3% false starts), seeded
+// so every run exports the same bytes.
+std::vector<purple::TrialResult> MakeSyntheticResults(size_t count);
+
+int RunAggregateBench(int argc, char** argv);
+int RunAnalyticsBench(int argc, char** argv);
+int RunCompareBench(int argc, char** argv);
+int RunExportBench(int argc, char** argv);
+int RunForeperiodBench(int argc, char** argv);
+int RunJournalBench(int argc, char** argv);
+int RunLogBench(int argc, char** argv);
+int RunPollingBench(int argc, char** argv);
+int RunRingBench(int argc, char** argv);
+int RunRtBench(int argc, char** argv);
+int RunSimulateBench(int argc, char** argv);
+int RunStatsBench(int argc, char** argv);
+int RunStoppingBench(int argc, char** argv);
+int RunSuiteBench(int argc, char** argv);
+int RunTelemetryBench(int argc, char** argv);
+int RunWaitBench(int argc, char** argv);
+} // namespace bench
@@ -0,0 +1,245 @@
+#include "bench.h"
+
+#include "core/aggregate.h"
+#include "core/columnar.h"
+#include "core/export.h"
+#include "core/headless.h"
+#include "core/parallel.h"
+#include "core/parse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace
+{
+struct AggregateBenchOptions
+{
+    int files = 10000;
+    int trialsPerFile = 200;
+    int repeats = 3;
+    int maxThreads = 0;  // 0: one per hardware thread
+};
+
+// Export text carries six decimals, so parsed values match the originals to within half a microsecond
+// of a millisecond; summary statistics are compared at that resolution.
+bool Close(double a, double b)
+{
+    return std::fabs(a - b) <= 1e-6 * std::max(1.0, std::fabs(b));
+}
+
+bool SameSummary(const purple::ReactionSummary& a, const purple::ReactionSummary& b)
+{
+    return a.trialCount == b.trialCount && a.validCount == b.validCount && a.falseStartCount == b.falseStartCount &&
+        Close(a.meanMs, b.meanMs) && Close(a.sdMs, b.sdMs) && Close(a.minMs, b.minMs) && Close(a.maxMs, b.maxMs) &&
+        Close(a.p50Ms, b.p50Ms) && Close(a.p99Ms, b.p99Ms) && Close(a.trimmedMeanMs, b.trimmedMeanMs) &&
+        Close(a.madMs, b.madMs);
+}
+// Best wall time of `repeats` aggregations over `files`; `report` keeps the last one.
+double BestAggregateMs(const std::vector<std::string>& files,
+    const purple::AggregateOptions& options,
+    int repeats,
+    purple::AggregateReport& report)
+{
+    purple::MonotonicClock clock;
+    double bestMs = 0.0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        const purple::Ticks start = clock.Now();
+        report = purple::AggregateResultFiles(files, options);
+        const double ms = purple::TicksToMilliseconds(clock.Now() - start, clock.Frequency());
+        bestMs = (r == 0 || ms < bestMs) ? ms : bestMs;
+    }
+    return bestMs;
+}
+
+double TotalMegabytes(const std::vector<std::string>& files)
+{
+    double megabytes = 0.0;
+    std::error_code error;
+    for (const std::string& file : files)
+    {
+        megabytes += static_cast<double>(std::filesystem::file_size(file, error)) / 1e6;
+    }
+    return megabytes;
+}
+} // namespace
+
+namespace bench
+{
+int RunAggregateBench(int argc, char** argv)
+{
+    AggregateBenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        int* target = nullptr;
+        if (std::strcmp(argv[i], "--files") == 0 && hasValue)
+        {
+            target = &options.files;
+        }
+        else if (std::strcmp(argv[i], "--trials") == 0 && hasValue)
+        {
+            target = &options.trialsPerFile;
+        }
+        else if (std::strcmp(argv[i], "--repeats") == 0 && hasValue)
+        {
+            target = &options.repeats;
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            target = &options.maxThreads;
+        }
+        if (target == nullptr || !purple::TryParseIntNarrow(argv[++i], *target))
+        {
+            std::printf("Usage: purple_bench aggregate [--files n] [--trials n] [--repeats n] [--threads max]\n");
+            return 1;
+        }
+    }
+
+    // One synthetic stream cut into per-file sessions; even files export CSV, odd files JSON, spread over
+    // ten dates so --group date has work to do.
+    const size_t fileCount = static_cast<size_t>(options.files);
+    const size_t trialsPerFile = static_cast<size_t>(options.trialsPerFile);
+    const std::vector<purple::TrialResult> all = MakeSyntheticResults(fileCount * trialsPerFile);
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "purple_bench_aggregate";
+    std::error_code error;
+    std::filesystem::remove_all(dir, error);
+    std::filesystem::create_directories(dir, error);
+    if (error)
+    {
+        std::printf("Could not create %s\n", dir.string().c_str());
+        return 1;
+    }
+
+    purple::MonotonicClock clock;
+    purple::Ticks start = clock.Now();
+    std::vector<double> expectedValid;
+    size_t expectedFalseStarts = 0;
+    for (size_t f = 0; f < fileCount; ++f)
+    {
+        const std::vector<purple::TrialResult> results(
+            all.begin() + static_cast<std::ptrdiff_t>(f * trialsPerFile),
+            all.begin() + static_cast<std::ptrdiff_t>((f + 1) * trialsPerFile));
+        const purple::RunningStats stats = purple::ComputeRunningStats(results);
+        char name[64];
+        std::snprintf(name, sizeof(name), "PurpleReaction_202601%02zu_%06zu.%s", 10 + f % 10, f, f % 2 == 0 ? "csv" : "json");
+        const std::string path = (dir / name).string();
+        if (!purple::ExportResults(results, stats, f % 2 == 0 ? path : std::string(), f % 2 == 0 ? std::string() : path))
+        {
+            return 1;
+        }
+        for (const purple::TrialResult& trial : results)
+        {
+            if (trial.falseStart)
+            {
+                ++expectedFalseStarts;
+            }
+            else
+            {
+                // Round-trip through the exported text so the check compares like with like.
+                char text[32];
+                std::snprintf(text, sizeof(text), "%.6f", trial.reactionMs);
+                expectedValid.push_back(std::strtod(text, nullptr));
+            }
+        }
+    }
+    std::sort(expectedValid.begin(), expectedValid.end());
+    const purple::ReactionSummary expected = purple::SummarizeSorted(expectedValid, expectedFalseStarts);
+    const double writeSeconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+
+    const std::vector<std::string> files = purple::CollectResultFiles({dir.string()});
+    const double megabytes = TotalMegabytes(files);
+    std::printf("Wrote %zu files (%.1f MB, %zu trials each) in %.2f s\n", files.size(), megabytes, trialsPerFile, writeSeconds);
+
+    // Thread counts 1, 2, 4, ... up to the limit (always including the limit itself).
+    const int maxThreads = purple::ResolveThreadCount(options.maxThreads);
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    bool correct = files.size() == fileCount;
+    double baselineMs = 0.0;
+    std::printf("\nAggregate %zu files, --group date, best of %d\n", files.size(), options.repeats);
+    std::printf("%8s %10s %10s %9s %8s %s\n", "threads", "ms", "files/s", "MB/s", "speedup", "pooled");
+    for (const int threads : threadCounts)
+    {
+        purple::AggregateOptions aggregate;
+        aggregate.threads = threads;
+        aggregate.grouping = purple::AggregateGrouping::Date;
+
+        purple::AggregateReport report;
+        const double bestMs = BestAggregateMs(files, aggregate, options.repeats, report);
+        if (threads == 1)
+        {
+            baselineMs = bestMs;
+        }
+
+        size_t groupTrials = 0;
+        for (const purple::GroupSummary& group : report.groups)
+        {
+            groupTrials += group.summary.trialCount;
+        }
+        const bool match = report.failedFiles == 0 && SameSummary(report.pooled.summary, expected) &&
+            groupTrials == expected.trialCount && report.groups.size() == std::min<size_t>(fileCount, 10);
+        correct = correct && match;
+        std::printf("%8d %10.2f %10.0f %9.1f %7.2fx %s\n",
+            threads,
+            bestMs,
+            static_cast<double>(files.size()) / (bestMs / 1000.0),
+            megabytes / (bestMs / 1000.0),
+            bestMs > 0.0 ? baselineMs / bestMs : 0.0,
+            match ? "exact" : "MISMATCH");
+    }
+    if (std::thread::hardware_concurrency() < 2)
+    {
+        std::printf("(single hardware thread: no parallel speedup to measure)\n");
+    }
+
+    // The same sessions as columnar .prr files, summarized straight from the mapped tick columns.
+    const std::filesystem::path columnarDir = dir / "columnar";
+    std::filesystem::create_directories(columnarDir, error);
+    for (size_t f = 0; f < fileCount && !error; ++f)
+    {
+        std::vector<purple::TrialResult> results(
+            all.begin() + static_cast<std::ptrdiff_t>(f * trialsPerFile),
+            all.begin() + static_cast<std::ptrdiff_t>((f + 1) * trialsPerFile));
+        purple::SynthesizeTrialTicks(results);
+        purple::SessionConfig config;
+        config.trialCount = options.trialsPerFile;
+        char name[64];
+        std::snprintf(name, sizeof(name), "PurpleReaction_202601%02zu_%06zu.prr", 10 + f % 10, f);
+        if (!purple::ExportResultsColumnar(results, config, purple::kTextTickFrequency, (columnarDir / name).string()))
+        {
+            return 1;
+        }
+    }
+    const std::vector<std::string> columnarFiles = purple::CollectResultFiles({columnarDir.string()});
+    const double columnarMegabytes = TotalMegabytes(columnarFiles);
+    purple::AggregateOptions aggregate;
+    aggregate.threads = maxThreads;
+    aggregate.grouping = purple::AggregateGrouping::Date;
+    purple::AggregateReport report;
+    const double columnarMs = BestAggregateMs(columnarFiles, aggregate, options.repeats, report);
+    const bool columnarMatch = report.failedFiles == 0 && columnarFiles.size() == fileCount &&
+        SameSummary(report.pooled.summary, expected);
+    correct = correct && columnarMatch;
+    std::printf("\nColumnar .prr (%.1f MB), %d threads: %.2f ms, %.0f files/s, %s\n",
+        columnarMegabytes,
+        maxThreads,
+        columnarMs,
+        static_cast<double>(columnarFiles.size()) / (columnarMs / 1000.0),
+        columnarMatch ? "exact" : "MISMATCH");
+
+    std::filesystem::remove_all(dir, error);
+    return correct ? 0 : 2;
+}
+} // namespace bench
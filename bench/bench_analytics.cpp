@@ -0,0 +1,299 @@
+#include "bench.h"
+
+#include "core/analytics.h"
+#include "core/headless.h"
+#include "core/parse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace
+{
+struct AnalyticsBenchOptions
+{
+    int millions = 10;   // trials
+    int repeats = 3;     // best of
+};
+
+// Everything one kernel table computes over the bench data.
+struct KernelResults
+{
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    std::vector<std::uint64_t> bins;
+    std::vector<std::uint64_t> logBins;
+    std::vector<double> density;
+    std::vector<double> cdf;
+    double seconds[5] = {};
+};
+
+const char* const kKernelNames[5] = {"sum + sum of squares", "fixed-bin histogram", "log-bin histogram", "Gaussian KDE", "ECDF"};
+
+double BestSeconds(int repeats, const std::function<void()>& run)
+{
+    purple::MonotonicClock clock;
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        const purple::Ticks start = clock.Now();
+        run();
+        const double seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+        best = r == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+KernelResults RunKernels(const purple::AnalyticsKernels& kernels,
+    const std::vector<double>& values,
+    const std::vector<double>& sorted,
+    const purple::DistributionReport& layout,
+    const purple::DistributionOptions& options,
+    const std::vector<double>& queries,
+    int repeats)
+{
+    KernelResults results;
+    results.density.resize(layout.grid.size());
+    results.cdf.resize(queries.size());
+    results.seconds[0] = BestSeconds(repeats, [&]
+    {
+        kernels.sumSquares(values.data(), values.size(), results.sum, results.sumSquares);
+    });
+    results.seconds[1] = BestSeconds(repeats, [&]
+    {
+        results.bins.assign(options.binCount + 2, 0);
+        kernels.fixedHistogram(values.data(), values.size(), options.lowMs, 1.0 / options.binMs, options.binCount, results.bins.data());
+    });
+    results.seconds[2] = BestSeconds(repeats, [&]
+    {
+        results.logBins.assign(layout.logEdges.size() + 1, 0);
+        kernels.edgeHistogram(values.data(), values.size(), layout.logEdges.data(), layout.logEdges.size(), results.logBins.data());
+    });
+    results.seconds[3] = BestSeconds(repeats, [&]
+    {
+        kernels.gaussianKde(sorted.data(), sorted.size(), layout.bandwidthMs, layout.grid.data(), layout.grid.size(), results.density.data());
+    });
+    results.seconds[4] = BestSeconds(repeats, [&]
+    {
+        kernels.ecdf(sorted.data(), sorted.size(), queries.data(), queries.size(), results.cdf.data());
+    });
+    return results;
+}
+
+double RelativeDifference(double x, double y)
+{
+    return std::fabs(x - y) / std::max(std::fabs(y), 1e-300);
+}
+
+// Largest density difference relative to the peak density.
+double DensityDifference(const std::vector<double>& x, const std::vector<double>& y)
+{
+    double peak = 0.0;
+    double worst = 0.0;
+    for (size_t i = 0; i < y.size(); ++i)
+    {
+        peak = std::max(peak, y[i]);
+        worst = std::max(worst, std::fabs(x[i] - y[i]));
+    }
+    return peak > 0.0 ? worst / peak : worst;
+}
+
+// Both tables over every length up to 40, so each vector loop's remainder handling is covered.
+bool ShortInputsAgree(const purple::AnalyticsKernels& simd, const purple::AnalyticsKernels& scalar,
+    const std::vector<double>& values, const purple::DistributionReport& layout, const purple::DistributionOptions& options)
+{
+    for (size_t length = 0; length <= 40; ++length)
+    {
+        std::vector<double> sorted(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(length));
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<std::uint64_t> bins[2];
+        std::vector<std::uint64_t> logBins[2];
+        std::vector<double> density[2];
+        std::vector<double> cdf[2];
+        double sums[2][2] = {};
+        const purple::AnalyticsKernels* tables[2] = {&simd, &scalar};
+        for (size_t t = 0; t < 2; ++t)
+        {
+            bins[t].assign(options.binCount + 2, 0);
+            logBins[t].assign(layout.logEdges.size() + 1, 0);
+            density[t].assign(layout.grid.size(), 0.0);
+            cdf[t].assign(37, 0.0);  // an odd count, for the ECDF remainder
+            tables[t]->sumSquares(values.data(), length, sums[t][0], sums[t][1]);
+            tables[t]->fixedHistogram(values.data(), length, options.lowMs, 1.0 / options.binMs, options.binCount, bins[t].data());
+            tables[t]->edgeHistogram(values.data(), length, layout.logEdges.data(), layout.logEdges.size(), logBins[t].data());
+            tables[t]->gaussianKde(sorted.data(), length, layout.bandwidthMs, layout.grid.data(), layout.grid.size(), density[t].data());
+            tables[t]->ecdf(sorted.data(), length, values.data(), cdf[t].size(), cdf[t].data());
+        }
+        if (bins[0] != bins[1] || logBins[0] != logBins[1] || cdf[0] != cdf[1] ||
+            RelativeDifference(sums[0][0], sums[1][0]) > 1e-12 || RelativeDifference(sums[0][1], sums[1][1]) > 1e-12 ||
+            DensityDifference(density[0], density[1]) > 1e-12)
+        {
+            std::printf("  tables disagree on %zu values\n", length);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every edge, its neighbouring doubles and out-of-range values, repeated past the length where the AVX2 log
+// bins switch to their lookup table: both tables must bin them alike.
+bool EdgeValuesAgree(const purple::AnalyticsKernels& simd, const purple::AnalyticsKernels& scalar,
+    const purple::DistributionReport& layout, const purple::DistributionOptions& options)
+{
+    std::vector<double> pattern = {0.0, -0.0, -5.0, 1e-300, 1e9, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+    for (const double edge : layout.logEdges)
+    {
+        pattern.insert(pattern.end(), {std::nextafter(edge, 0.0), edge, std::nextafter(edge, 1e300)});
+    }
+    for (size_t b = 0; b <= options.binCount; ++b)
+    {
+        const double edge = options.lowMs + static_cast<double>(b) * options.binMs;
+        pattern.insert(pattern.end(), {std::nextafter(edge, -1e300), edge, std::nextafter(edge, 1e300)});
+    }
+    std::vector<double> values;
+    while (values.size() < 10000)
+    {
+        values.insert(values.end(), pattern.begin(), pattern.end());
+    }
+    std::vector<std::uint64_t> bins[2];
+    std::vector<std::uint64_t> logBins[2];
+    const purple::AnalyticsKernels* tables[2] = {&simd, &scalar};
+    for (size_t t = 0; t < 2; ++t)
+    {
+        bins[t].assign(options.binCount + 2, 0);
+        logBins[t].assign(layout.logEdges.size() + 1, 0);
+        tables[t]->fixedHistogram(values.data(), values.size(), options.lowMs, 1.0 / options.binMs, options.binCount, bins[t].data());
+        tables[t]->edgeHistogram(values.data(), values.size(), layout.logEdges.data(), layout.logEdges.size(), logBins[t].data());
+    }
+    return bins[0] == bins[1] && logBins[0] == logBins[1];
+}
+
+bool ParseOptions(int argc, char** argv, AnalyticsBenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = hasValue;
+        if (std::strcmp(arg, "--millions") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.millions) && options.millions <= 1000;
+        }
+        else if (std::strcmp(arg, "--repeats") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.repeats);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+namespace bench
+{
+int RunAnalyticsBench(int argc, char** argv)
+{
+    AnalyticsBenchOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::printf("Usage: purple_bench analytics [--millions n] [--repeats n]\n");
+        return 1;
+    }
+
+    const size_t count = static_cast<size_t>(options.millions) * 1000000;
+    const std::vector<double> values = ExGaussianSample(count, 31);
+    std::vector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    // ECDF queries in trial order: a million lookups at unrelated points, as when placing one set in another.
+    const std::vector<double> queries(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(std::min<size_t>(count, 1000000)));
+    const purple::DistributionOptions distribution;
+    const purple::DistributionReport layout = purple::ComputeDistribution(sorted, distribution, purple::SimdLevel::Scalar);
+
+    const purple::SimdLevel level = purple::DetectSimdLevel();
+    std::printf("%zu ex-Gaussian trials, %zu + %zu bins, %zu-point KDE (bandwidth %.3f ms), %zu ECDF queries; best of %d\n",
+        count,
+        distribution.binCount,
+        layout.logEdges.size() - 1,
+        layout.grid.size(),
+        layout.bandwidthMs,
+        queries.size(),
+        options.repeats);
+    std::printf("Detected SIMD level: %s\n", purple::SimdLevelName(level));
+
+    const purple::AnalyticsKernels& scalarKernels = purple::GetAnalyticsKernels(purple::SimdLevel::Scalar);
+    const KernelResults scalar = RunKernels(scalarKernels, values, sorted, layout, distribution, queries, options.repeats);
+    if (level == purple::SimdLevel::Scalar)
+    {
+        for (size_t k = 0; k < 5; ++k)
+        {
+            std::printf("  %-22s scalar %9.3f ms\n", kKernelNames[k], 1e3 * scalar.seconds[k]);
+        }
+        std::printf("AVX2 kernels are not available on this CPU or build; nothing to compare.\n");
+        return 0;
+    }
+
+    const purple::AnalyticsKernels& simdKernels = purple::GetAnalyticsKernels(level);
+    const KernelResults simd = RunKernels(simdKernels, values, sorted, layout, distribution, queries, options.repeats);
+    for (size_t k = 0; k < 5; ++k)
+    {
+        std::printf("  %-22s scalar %9.3f ms  %s %9.3f ms  speedup %5.2fx\n",
+            kKernelNames[k],
+            1e3 * scalar.seconds[k],
+            purple::SimdLevelName(level),
+            1e3 * simd.seconds[k],
+            scalar.seconds[k] / simd.seconds[k]);
+    }
+    const double reportScalar = BestSeconds(options.repeats, [&]
+    {
+        purple::ComputeDistribution(sorted, distribution, purple::SimdLevel::Scalar);
+    });
+    const double reportSimd = BestSeconds(options.repeats, [&]
+    {
+        purple::ComputeDistribution(sorted, distribution, level);
+    });
+    std::printf("  %-22s scalar %9.3f ms  %s %9.3f ms  speedup %5.2fx\n",
+        "whole report", 1e3 * reportScalar, purple::SimdLevelName(level), 1e3 * reportSimd, reportScalar / reportSimd);
+
+    bool ok = true;
+    char detail[160];
+    const double sumError = std::max(RelativeDifference(simd.sum, scalar.sum), RelativeDifference(simd.sumSquares, scalar.sumSquares));
+    std::snprintf(detail, sizeof(detail), "relative difference %.2e", sumError);
+    ok &= PrintCheck("sums match", sumError <= 1e-12, detail);
+    std::uint64_t binned = 0;
+    for (const std::uint64_t bin : scalar.bins)
+    {
+        binned += bin;
+    }
+    std::snprintf(detail, sizeof(detail), "%llu of %zu trials", static_cast<unsigned long long>(binned), count);
+    ok &= PrintCheck("fixed bins identical", simd.bins == scalar.bins && binned == count, detail);
+    ok &= PrintCheck("log bins identical", simd.logBins == scalar.logBins, "");
+    const double densityError = DensityDifference(simd.density, scalar.density);
+    std::snprintf(detail, sizeof(detail), "largest difference %.2e of the peak", densityError);
+    ok &= PrintCheck("KDE densities match", densityError <= 1e-12, detail);
+    // The grid covers the fixed-bin range, so the density integrates to the share of trials inside it.
+    const double step = layout.grid[1] - layout.grid[0];
+    double integral = 0.0;
+    for (size_t i = 1; i < scalar.density.size(); ++i)
+    {
+        integral += 0.5 * step * (scalar.density[i - 1] + scalar.density[i]);
+    }
+    const double inside = static_cast<double>(count - scalar.bins.front() - scalar.bins.back()) / static_cast<double>(count);
+    std::snprintf(detail, sizeof(detail), "%.6f vs %.6f of the trials", integral, inside);
+    ok &= PrintCheck("KDE integrates to the trial share", std::fabs(integral - inside) <= 1e-3, detail);
+    ok &= PrintCheck("ECDF identical", simd.cdf == scalar.cdf, "");
+    ok &= PrintCheck("short inputs agree", ShortInputsAgree(simdKernels, scalarKernels, values, layout, distribution), "0-40 values");
+    ok &= PrintCheck("edge values bin alike", EdgeValuesAgree(simdKernels, scalarKernels, layout, distribution), "every edge and its neighbours");
+    return ok ? 0 : 2;
+}
+} // namespace bench
@@ -0,0 +1,212 @@
+#include "bench.h"
+
+#include "core/compare.h"
+#include "core/headless.h"
+#include "core/parallel.h"
+#include "core/parse.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+struct CompareBenchOptions
+{
+    int trials = 1000;        // per set, for the timing and the shift check
+    int resamples = 100000;
+    int permutations = 100000;
+    int threads = 0;          // largest thread count timed; 0: one per hardware thread
+    int nullComparisons = 400;
+    double shiftMs = 10.0;
+};
+
+std::vector<double> ShiftedExGaussian(size_t count, double shiftMs, std::uint64_t seed)
+{
+    std::vector<double> values = bench::ExGaussianSample(count, seed);
+    for (double& value : values)
+    {
+        value += shiftMs;
+    }
+    return values;
+}
+
+bool SameReport(const purple::ComparisonReport& x, const purple::ComparisonReport& y)
+{
+    if (x.statistics.size() != y.statistics.size())
+    {
+        return false;
+    }
+    for (size_t s = 0; s < x.statistics.size(); ++s)
+    {
+        const purple::StatisticComparison& p = x.statistics[s];
+        const purple::StatisticComparison& q = y.statistics[s];
+        if (p.differenceMs != q.differenceMs || p.lowMs != q.lowMs || p.highMs != q.highMs || p.pValue != q.pValue)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParseOptions(int argc, char** argv, CompareBenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = hasValue;
+        if (std::strcmp(arg, "--trials") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.trials) && options.trials >= 2;
+        }
+        else if (std::strcmp(arg, "--resamples") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.resamples);
+        }
+        else if (std::strcmp(arg, "--permutations") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.permutations);
+        }
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.threads);
+        }
+        else if (std::strcmp(arg, "--null") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.nullComparisons);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+namespace bench
+{
+int RunCompareBench(int argc, char** argv)
+{
+    CompareBenchOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::printf("Usage: purple_bench compare [--trials n] [--resamples n] [--permutations n] [--threads n] [--null n]\n");
+        return 1;
+    }
+
+    const std::vector<double> a = ShiftedExGaussian(static_cast<size_t>(options.trials), 0.0, 11);
+    const std::vector<double> b = ShiftedExGaussian(static_cast<size_t>(options.trials), options.shiftMs, 12);
+    purple::CompareOptions compare;
+    compare.resamples = options.resamples;
+    compare.permutations = options.permutations;
+    compare.percentiles = {90.0, 99.0};
+    compare.seed = 7;
+
+    // Throughput per thread count; every run must reproduce the single-threaded report bit for bit. Odd and
+    // oversubscribed counts are included so the check splits the work unevenly even on small machines.
+    std::printf("%d + %d trials, %d resamples + %d permutations:\n", options.trials, options.trials, options.resamples,
+        options.permutations);
+    const int maxThreads = purple::ResolveThreadCount(options.threads);
+    std::vector<int> threadCounts = {1, 2, 3, 4};
+    for (int threads = 8; threads <= maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    if (maxThreads > threadCounts.back())
+    {
+        threadCounts.push_back(maxThreads);
+    }
+    purple::ComparisonReport reference;
+    bool identical = true;
+    purple::MonotonicClock clock;
+    double singleSeconds = 0.0;
+    for (const int threads : threadCounts)
+    {
+        compare.threads = threads;
+        const purple::Ticks start = clock.Now();
+        const purple::ComparisonReport report = purple::CompareSamples(a, b, compare);
+        const double seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+        if (threads == 1)
+        {
+            reference = report;
+            singleSeconds = seconds;
+        }
+        identical = identical && SameReport(reference, report);
+        std::printf("  %2d threads: %.3f s, %.0f resamples and permutations/s, speedup %.2fx%s\n",
+            threads,
+            seconds,
+            static_cast<double>(options.resamples + options.permutations) / seconds,
+            singleSeconds / seconds,
+            threads > maxThreads ? " (oversubscribed)" : "");
+    }
+    for (const purple::StatisticComparison& statistic : reference.statistics)
+    {
+        std::printf("  %-7s %+8.3f ms [%+8.3f, %+8.3f] p=%.5f\n",
+            statistic.name.c_str(),
+            statistic.differenceMs,
+            statistic.lowMs,
+            statistic.highMs,
+            statistic.pValue);
+    }
+
+    bool ok = true;
+    char detail[160];
+    std::snprintf(detail, sizeof(detail), "%zu thread counts up to %d", threadCounts.size(), threadCounts.back());
+    ok &= PrintCheck("identical on every thread count", identical, detail);
+    const purple::StatisticComparison& mean = reference.statistics[0];
+    std::snprintf(detail, sizeof(detail), "[%+.3f, %+.3f] vs +%.1f, p=%.5f", mean.lowMs, mean.highMs, options.shiftMs, mean.pValue);
+    ok &= PrintCheck("shift found", mean.lowMs > 0.0 && mean.lowMs <= options.shiftMs && options.shiftMs <= mean.highMs &&
+        (options.permutations == 0 || mean.pValue < 0.01), detail);
+
+    // Same-distribution pairs: the permutation test should reject at its nominal rate and the bootstrap
+    // intervals should cover the zero difference at about their nominal rate.
+    purple::CompareOptions small;
+    small.resamples = 2000;
+    small.permutations = 2000;
+    small.percentiles = {90.0};
+    small.threads = purple::ResolveThreadCount(options.threads);
+    int rejections[3] = {};
+    int covered[3] = {};
+    for (int i = 0; i < options.nullComparisons; ++i)
+    {
+        small.seed = 1000 + static_cast<std::uint64_t>(i);
+        const purple::ComparisonReport report = purple::CompareSamples(
+            ShiftedExGaussian(60, 0.0, 2000 + 2 * static_cast<std::uint64_t>(i)),
+            ShiftedExGaussian(60, 0.0, 2001 + 2 * static_cast<std::uint64_t>(i)),
+            small);
+        for (size_t s = 0; s < 3; ++s)
+        {
+            rejections[s] += report.statistics[s].pValue <= 0.05 ? 1 : 0;
+            covered[s] += report.statistics[s].lowMs <= 0.0 && 0.0 <= report.statistics[s].highMs ? 1 : 0;
+        }
+    }
+    if (options.nullComparisons > 0)
+    {
+        const double n = static_cast<double>(options.nullComparisons);
+        const double slack = 4.0 * std::sqrt(0.05 * 0.95 / n);
+        const char* names[3] = {"mean", "median", "p90"};
+        for (size_t s = 0; s < 3; ++s)
+        {
+            const double rate = rejections[s] / n;
+            const double coverage = covered[s] / n;
+            // Permutation tests are exact (at most the nominal rate); percentile bootstrap intervals of 60
+            // trials run a little narrow, the nearest-rank quantiles' discreteness more so.
+            char name[64];
+            std::snprintf(name, sizeof(name), "null %s: type I error", names[s]);
+            std::snprintf(detail, sizeof(detail), "%.4f vs 0.05", rate);
+            ok &= PrintCheck(name, rate <= 0.05 + slack, detail);
+            std::snprintf(name, sizeof(name), "null %s: CI covers 0", names[s]);
+            std::snprintf(detail, sizeof(detail), "%.4f vs 0.95", coverage);
+            ok &= PrintCheck(name, coverage >= 0.95 - 0.03 - slack, detail);
+        }
+    }
+    return ok ? 0 : 2;
+}
+} // namespace bench
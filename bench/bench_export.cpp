@@ -0,0 +1,263 @@
+#include "bench.h"
+
+#include "core/export.h"
+#include "core/headless.h"
+#include "core/parse.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <string>
+
+namespace
+{
+// The std::ofstream exporters as they were before the to_chars writer, kept as the comparison baseline.
+void LegacyWriteFooterRow(std::ofstream& out, const char* label, double value, bool hasValue)
+{
+    out << label << ",,";
+    if (hasValue)
+    {
+        out << value;
+    }
+    out << ",\n";
+}
+
+void LegacyWriteJsonNumberField(std::ofstream& out, const char* name, double value, bool hasValue)
+{
+    out << "  \"" << name << "\": ";
+    if (hasValue)
+    {
+        out << value;
+    }
+    else
+    {
+        out << "null";
+    }
+    out << ",\n";
+}
+
+bool LegacyExportCsv(const std::vector<purple::TrialResult>& results, const purple::RunningStats& stats, const std::string& path)
+{
+    std::ofstream out(path, std::ios::trunc);
+    out << std::fixed << std::setprecision(6);
+    out << "trial,random_delay_seconds,reaction_ms,false_start\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        out << (i + 1) << ","
+            << results[i].delaySeconds << ",";
+        if (results[i].falseStart)
+        {
+            out << ",1\n";
+        }
+        else
+        {
+            out << results[i].reactionMs << ",0\n";
+        }
+    }
+    const purple::ReactionSummary summary = stats.Summary();
+    out << "average,," << summary.meanMs << ",\n";
+    LegacyWriteFooterRow(out, "sd", summary.sdMs, summary.validCount > 1);
+    LegacyWriteFooterRow(out, "median", summary.p50Ms, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "p90", summary.p90Ms, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "p95", summary.p95Ms, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "p99", summary.p99Ms, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "min", summary.minMs, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "max", summary.maxMs, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "trimmed_mean_10", summary.trimmedMeanMs, summary.validCount > 0);
+    LegacyWriteFooterRow(out, "mad", summary.madMs, summary.validCount > 0);
+    return out.good();
+}
+
+bool LegacyExportJson(const std::vector<purple::TrialResult>& results, const purple::RunningStats& stats, const std::string& path)
+{
+    std::ofstream out(path, std::ios::trunc);
+    const purple::ReactionSummary summary = stats.Summary();
+    out << std::fixed << std::setprecision(6);
+    out << "{\n";
+    out << "  \"trial_count\": " << results.size() << ",\n";
+    out << "  \"valid_count\": " << summary.validCount << ",\n";
+    out << "  \"false_start_count\": " << summary.falseStartCount << ",\n";
+    LegacyWriteJsonNumberField(out, "average_reaction_ms", summary.meanMs, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "reaction_sd_ms", summary.sdMs, summary.validCount > 1);
+    LegacyWriteJsonNumberField(out, "median_reaction_ms", summary.p50Ms, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "p90_reaction_ms", summary.p90Ms, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "p95_reaction_ms", summary.p95Ms, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "p99_reaction_ms", summary.p99Ms, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "min_reaction_ms", summary.minMs, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "max_reaction_ms", summary.maxMs, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "trimmed_mean_reaction_ms", summary.trimmedMeanMs, summary.validCount > 0);
+    LegacyWriteJsonNumberField(out, "mad_reaction_ms", summary.madMs, summary.validCount > 0);
+    out << "  \"trials\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const purple::TrialResult& trial = results[i];
+        out << "    {\"trial\": " << (i + 1)
+            << ", \"random_delay_seconds\": " << trial.delaySeconds
+            << ", \"reaction_ms\": ";
+        if (trial.falseStart)
+        {
+            out << "null";
+        }
+        else
+        {
+            out << trial.reactionMs;
+        }
+        out << ", \"false_start\": " << (trial.falseStart ? "true" : "false") << "}";
+        if (i + 1 < results.size())
+        {
+            out << ",";
+        }
+        out << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return out.good();
+}
+
+bool SameFileContents(const std::string& a, const std::string& b)
+{
+    std::ifstream left(a, std::ios::binary);
+    std::ifstream right(b, std::ios::binary);
+    return std::equal(
+        std::istreambuf_iterator<char>(left),
+        std::istreambuf_iterator<char>(),
+        std::istreambuf_iterator<char>(right),
+        std::istreambuf_iterator<char>());
+}
+
+template <typename Fn>
+double BestMilliseconds(int repeats, Fn&& fn)
+{
+    purple::MonotonicClock clock;
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        const purple::Ticks start = clock.Now();
+        fn();
+        const double ms = purple::TicksToMilliseconds(clock.Now() - start, clock.Frequency());
+        best = (r == 0 || ms < best) ? ms : best;
+    }
+    return best;
+}
+} // namespace
+
+namespace bench
+{
+std::vector<purple::TrialResult> MakeSyntheticResults(size_t count)
+{
+    // Uniform 2-5 s foreperiods, ex-Gaussian reactions, ~3% false starts.
+    std::mt19937_64 rng(12345);
+    std::uniform_real_distribution<double> delay(2.0, 5.0);
+    ExGaussian reaction;
+    std::bernoulli_distribution falseStart(0.03);
+
+    std::vector<purple::TrialResult> results(count);
+    for (purple::TrialResult& trial : results)
+    {
+        trial.delaySeconds = delay(rng);
+        trial.falseStart = falseStart(rng);
+        if (!trial.falseStart)
+        {
+            trial.reactionMs = std::max(0.0, reaction(rng));
+        }
+    }
+    return results;
+}
+
+int RunExportBench(int argc, char** argv)
+{
+    std::vector<int> sizes = {10000, 100000, 1000000};
+    int repeats = 3;
+    for (int i = 1; i < argc; ++i)
+    {
+        int value = 0;
+        if (std::strcmp(argv[i], "--trials") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], value))
+            {
+                return 1;
+            }
+            sizes.assign(1, value);
+        }
+        else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], repeats))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            std::printf("Usage: purple_bench export [--trials n] [--repeats n]\n");
+            return 1;
+        }
+    }
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string legacyCsv = (dir / "purple_bench_legacy.csv").string();
+    const std::string legacyJson = (dir / "purple_bench_legacy.json").string();
+    const std::string csv = (dir / "purple_bench_export.csv").string();
+    const std::string json = (dir / "purple_bench_export.json").string();
+
+    struct Row
+    {
+        int trials;
+        double legacyMs;
+        double csvMs;
+        double jsonMs;
+        double singlePassMs;
+        double megabytes;
+        bool identical;
+    };
+    std::vector<Row> rows;
+
+    bool allIdentical = true;
+    for (const int size : sizes)
+    {
+        const std::vector<purple::TrialResult> results = MakeSyntheticResults(static_cast<size_t>(size));
+        const purple::RunningStats stats = purple::ComputeRunningStats(results);
+
+        Row row{};
+        row.trials = size;
+        row.legacyMs = BestMilliseconds(repeats, [&]
+        {
+            LegacyExportCsv(results, stats, legacyCsv);
+            LegacyExportJson(results, stats, legacyJson);
+        });
+        row.csvMs = BestMilliseconds(repeats, [&] { purple::ExportResultsCsv(results, stats, csv); });
+        row.jsonMs = BestMilliseconds(repeats, [&] { purple::ExportResultsJson(results, stats, json); });
+        row.singlePassMs = BestMilliseconds(repeats, [&] { purple::ExportResults(results, stats, csv, json); });
+        row.megabytes = static_cast<double>(std::filesystem::file_size(csv) + std::filesystem::file_size(json)) / 1e6;
+        row.identical = SameFileContents(legacyCsv, csv) && SameFileContents(legacyJson, json);
+        allIdentical = allIdentical && row.identical;
+        rows.push_back(row);
+    }
+
+    std::printf("\nCSV+JSON export, best of %d (ms)\n", repeats);
+    std::printf("%9s %10s %10s %10s %12s %8s %9s %s\n",
+        "trials", "ofstream", "csv", "json", "single-pass", "speedup", "MB/s", "output");
+    for (const Row& row : rows)
+    {
+        std::printf("%9d %10.2f %10.2f %10.2f %12.2f %7.1fx %9.1f %s\n",
+            row.trials,
+            row.legacyMs,
+            row.csvMs,
+            row.jsonMs,
+            row.singlePassMs,
+            row.singlePassMs > 0.0 ? row.legacyMs / row.singlePassMs : 0.0,
+            row.singlePassMs > 0.0 ? row.megabytes / (row.singlePassMs / 1000.0) : 0.0,
+            row.identical ? "identical" : "DIFFERENT");
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove(legacyCsv, ignored);
+    std::filesystem::remove(legacyJson, ignored);
+    std::filesystem::remove(csv, ignored);
+    std::filesystem::remove(json, ignored);
+    return allIdentical ? 0 : 2;
+}
+} // namespace bench
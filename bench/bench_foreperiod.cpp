@@ -0,0 +1,179 @@
+#include "bench.h"
+
+#include "core/foreperiod.h"
+#include "core/headless.h"
+#include "core/parse.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+// Schedules of kDigestTrials trials over 2-5 s with seed kDigestSeed hash to these values on every
+// platform and compiler; a mismatch means a seed no longer reproduces the schedules of earlier builds.
+constexpr std::uint64_t kDigestSeed = 20260117;
+constexpr int kDigestTrials = 100000;
+
+struct DistributionCase
+{
+    purple::ForeperiodDistribution distribution;
+    std::uint64_t digest;
+};
+
+constexpr DistributionCase kCases[] = {
+    {purple::ForeperiodDistribution::Uniform, 0xdbd02c686aeed46cull},
+    {purple::ForeperiodDistribution::Exponential, 0xe8915a8401fd460eull},
+    {purple::ForeperiodDistribution::Geometric, 0x5353343aee6bb776ull},
+};
+
+// FNV-1a over the delays' bit patterns.
+std::uint64_t ScheduleDigest(const std::vector<double>& schedule)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const double delay : schedule)
+    {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &delay, sizeof(bits));
+        for (int i = 0; i < 8; ++i)
+        {
+            hash = (hash ^ ((bits >> (8 * i)) & 0xFF)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+purple::SessionConfig MakeConfig(purple::ForeperiodDistribution distribution, int trials)
+{
+    purple::SessionConfig config;
+    config.trialCount = trials;
+    config.minDelaySeconds = 2.0;
+    config.maxDelaySeconds = 5.0;
+    config.foreperiod.distribution = distribution;
+    config.foreperiod.seeded = true;
+    config.foreperiod.seed = kDigestSeed;
+    return config;
+}
+
+// Mean of min + mean * E truncated to [min, max]: the exponential's mean minus the mass cut off above max.
+double TruncatedExponentialMean(const purple::SessionConfig& config)
+{
+    const double range = config.maxDelaySeconds - config.minDelaySeconds;
+    const double mean = range / 4.0;
+    const double tail = std::exp(-range / mean);
+    return config.minDelaySeconds + mean - range * tail / (1.0 - tail);
+}
+
+// The geometric schedule's mean: k steps with probability proportional to p^k, p = exp(-step / mean), for
+// k up to the last step inside the range.
+double TruncatedGeometricMean(const purple::SessionConfig& config)
+{
+    const double range = config.maxDelaySeconds - config.minDelaySeconds;
+    const double step = config.foreperiod.stepSeconds;
+    const double p = std::exp(-step / (range / 4.0));
+    const int maxSteps = static_cast<int>(std::floor(range / step + 1e-9));
+    double weight = 1.0;
+    double total = 0.0;
+    double weighted = 0.0;
+    for (int k = 0; k <= maxSteps; ++k)
+    {
+        total += weight;
+        weighted += weight * k * step;
+        weight *= p;
+    }
+    return config.minDelaySeconds + weighted / total;
+}
+
+// One distribution: the golden digest, the delays' range and mean, and schedule build time for `trials`.
+bool RunCase(const DistributionCase& entry, int trials)
+{
+    const char* name = purple::ForeperiodDistributionName(entry.distribution);
+    const std::uint64_t digest = ScheduleDigest(purple::BuildForeperiodSchedule(MakeConfig(entry.distribution, kDigestTrials)));
+
+    const purple::SessionConfig config = MakeConfig(entry.distribution, trials);
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    const std::vector<double> schedule = purple::BuildForeperiodSchedule(config);
+    const double buildMs = static_cast<double>(clock.Now() - start) * 1000.0 / static_cast<double>(clock.Frequency());
+    const bool repeatable = purple::BuildForeperiodSchedule(config) == schedule;
+
+    bool inRange = schedule.size() == static_cast<size_t>(trials);
+    bool onGrid = true;
+    for (const double delay : schedule)
+    {
+        inRange = inRange && delay >= config.minDelaySeconds && delay <= config.maxDelaySeconds;
+        const double steps = (delay - config.minDelaySeconds) / config.foreperiod.stepSeconds;
+        onGrid = onGrid && std::fabs(steps - std::round(steps)) < 1e-9;
+    }
+    const double n = static_cast<double>(schedule.size());
+    const double mean = std::accumulate(schedule.begin(), schedule.end(), 0.0) / n;
+    double ss = 0.0;
+    for (const double delay : schedule)
+    {
+        ss += (delay - mean) * (delay - mean);
+    }
+
+    double expectedMean = 0.0;
+    switch (entry.distribution)
+    {
+    case purple::ForeperiodDistribution::Exponential:
+        expectedMean = TruncatedExponentialMean(config);
+        break;
+    case purple::ForeperiodDistribution::Geometric:
+        expectedMean = TruncatedGeometricMean(config);
+        break;
+    default:
+        expectedMean = (config.minDelaySeconds + config.maxDelaySeconds) / 2.0;
+        break;
+    }
+    // Five standard errors: a correct schedule practically never misses.
+    const bool meanOk = std::fabs(mean - expectedMean) < 5.0 * std::sqrt(ss / (n - 1.0) / n);
+    const bool gridOk = entry.distribution != purple::ForeperiodDistribution::Geometric || onGrid;
+
+    const bool ok = digest == entry.digest && repeatable && inRange && meanOk && gridOk;
+    std::printf("  %-4s %-12s digest %016llx%s  mean %.4f s (expected %.4f)  build %8.2f ms (%5.1f ns/trial)%s%s\n",
+        ok ? "ok" : "FAIL",
+        name,
+        static_cast<unsigned long long>(digest),
+        digest == entry.digest ? "" : " (MISMATCH)",
+        mean,
+        expectedMean,
+        buildMs,
+        buildMs * 1e6 / static_cast<double>(trials),
+        inRange ? "" : ", OUT OF RANGE",
+        repeatable && gridOk ? "" : ", NOT REPEATABLE OR OFF GRID");
+    return ok;
+}
+} // namespace
+
+namespace bench
+{
+int RunForeperiodBench(int argc, char** argv)
+{
+    int trials = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--trials") == 0 && i + 1 < argc && purple::TryParseIntNarrow(argv[i + 1], trials) && trials > 1)
+        {
+            ++i;
+        }
+        else
+        {
+            std::printf("Usage: purple_bench foreperiod [--trials n]\n");
+            return 1;
+        }
+    }
+
+    std::printf("Foreperiod schedules, 2-5 s, seed %llu (digests over the first %d trials):\n",
+        static_cast<unsigned long long>(kDigestSeed),
+        kDigestTrials);
+    bool ok = true;
+    for (const DistributionCase& entry : kCases)
+    {
+        ok = RunCase(entry, trials) && ok;
+    }
+    return ok ? 0 : 2;
+}
+} // namespace bench
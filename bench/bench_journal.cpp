@@ -0,0 +1,269 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/journal.h"
+#include "core/parse.h"
+#include "core/simulate.h"
+#include "core/trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+struct JournalBenchOptions
+{
+    int trials = 1000000;
+    int crashRounds = 5;
+    int crashTrials = 20000;
+};
+
+// Per-call cost of Append against the in-memory push_back it replaces, timed call by call on the real
+// clock over a full-length run (every window switch included, in PrepareNext as in the loop).
+bool RunAppendLatency(const JournalBenchOptions& options, const std::filesystem::path& dir)
+{
+    const size_t count = static_cast<size_t>(options.trials);
+    const std::vector<purple::TrialResult> source = bench::MakeSyntheticResults(4096);
+    purple::SessionConfig config;
+    config.trialCount = options.trials;
+    purple::MonotonicClock clock;
+    const double nsPerTick = 1e9 / static_cast<double>(clock.Frequency());
+
+    purple::TrialJournal journal;
+    const std::string path = (dir / "latency.prj").string();
+    if (!journal.Open(path, config, clock.Frequency()))
+    {
+        return false;
+    }
+
+    std::vector<double> timerNs(count);
+    std::vector<double> appendNs(count);
+    std::vector<double> prepareNs;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const purple::Ticks t0 = clock.Now();
+        const purple::Ticks t1 = clock.Now();
+        journal.PrepareNext();
+        const purple::Ticks t2 = clock.Now();
+        journal.Append(source[i % source.size()]);
+        const purple::Ticks t3 = clock.Now();
+        timerNs[i] = static_cast<double>(t1 - t0) * nsPerTick;
+        appendNs[i] = static_cast<double>(t3 - t2) * nsPerTick;
+        if (i % purple::TrialJournal::kWindowRecords == 0 && i > 0)
+        {
+            prepareNs.push_back(static_cast<double>(t2 - t1) * nsPerTick);
+        }
+    }
+    const bool committed = journal.Committed() == count;
+    journal.Close(purple::SessionOutcome::Completed);
+
+    std::vector<double> pushNs(count);
+    {
+        std::vector<purple::TrialResult> results;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const purple::Ticks t0 = clock.Now();
+            results.push_back(source[i % source.size()]);
+            pushNs[i] = static_cast<double>(clock.Now() - t0) * nsPerTick;
+        }
+    }
+
+    purple::JournalContents contents;
+    const bool loaded = purple::LoadJournal(path, contents) && contents.closed && contents.results.size() == count;
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    std::printf("Per-trial cost, %zu trials (%zu-byte records, %u-record windows):\n",
+        count,
+        sizeof(purple::JournalRecord),
+        purple::TrialJournal::kWindowRecords);
+    std::printf("  %-18s %9s %9s %9s %11s\n", "", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    bench::ReportLatency("timer only", timerNs, 18);
+    bench::ReportLatency("journal Append", appendNs, 18);
+    bench::ReportLatency("vector push_back", pushNs, 18);
+    if (!prepareNs.empty())
+    {
+        bench::ReportLatency("window switch", prepareNs, 18);
+        // A real run writes 128 bytes per trial; this loop writes the whole file in well under a second, so the
+        // kernel throttles the faults on fresh dirty pages.
+        std::printf("  (window switches run between trials; here they include dirty-page writeback throttling)\n");
+    }
+    std::printf("  journal memory: one %u KB window mapped at a time; in-memory results: %.0f MB at the end\n",
+        purple::TrialJournal::kWindowRecords * static_cast<unsigned>(sizeof(purple::JournalRecord)) / 1024,
+        static_cast<double>(count * sizeof(purple::TrialResult)) / (1024.0 * 1024.0));
+    std::printf("  %-4s all %zu records committed and read back\n", committed && loaded ? "ok" : "FAIL", count);
+    return committed && loaded;
+}
+
+#if !defined(_WIN32)
+// Simulated participant that kills the process partway through trial killAt + 1, as a crash would.
+class KillingResponder
+{
+public:
+    KillingResponder(purple::SimulatedResponder& responder, int killAt)
+        : responder_(responder),
+          killAt_(killAt)
+    {
+    }
+
+    void Pump(purple::Session& session)
+    {
+        if (killAt_ >= 0 && session.trialIndex == killAt_ && session.phase != purple::Phase::BeginTrial)
+        {
+            raise(SIGKILL);
+        }
+        responder_.Pump(session);
+    }
+
+private:
+    purple::SimulatedResponder& responder_;
+    int killAt_;
+};
+
+// One seeded virtual-clock session, optionally journaled and killed; deterministic for a given seed.
+void RunSeededSession(purple::Session& session, int trials, std::uint64_t seed, int killAt)
+{
+    session.config.trialCount = trials;
+    session.config.logTrials = false;
+    session.config.wait.spinBudgetSeconds = 0.0;
+    session.config.wait.pollIntervalSeconds = 3600.0;
+    session.config.foreperiod.seeded = true;
+    session.config.foreperiod.seed = seed;
+    purple::ResetSessionState(session);
+
+    purple::VirtualClock clock;
+    purple::NullDisplay display;
+    purple::SimulatedResponder responder(clock, purple::ResponderModel{}, seed + 1);
+    KillingResponder input(responder, killAt);
+    purple::RunTrialLoop(session, clock, display, input);
+}
+
+bool SameResult(const purple::TrialResult& a, const purple::TrialResult& b)
+{
+    return a.delaySeconds == b.delaySeconds && a.reactionMs == b.reactionMs && a.falseStart == b.falseStart &&
+        a.onsetOvershootMs == b.onsetOvershootMs && a.block == b.block && a.onsetSource == b.onsetSource &&
+        a.onsetCorrectionMs == b.onsetCorrectionMs &&
+        std::memcmp(&a.ticks, &b.ticks, sizeof(a.ticks)) == 0;
+}
+
+// Forks a journaled session, SIGKILLs it mid-trial at a random point, then recovers the journal in the
+// parent and compares it with the same seeded session run to completion without a journal.
+bool RunCrashRecovery(const JournalBenchOptions& options, const std::filesystem::path& dir)
+{
+    std::printf("Crash recovery, %d rounds of %d-trial sessions killed mid-trial:\n", options.crashRounds, options.crashTrials);
+    std::mt19937_64 rng(20260116);
+    bool allOk = true;
+    for (int round = 0; round < options.crashRounds; ++round)
+    {
+        const std::uint64_t seed = rng();
+        const int killAt = static_cast<int>(rng() % static_cast<std::uint64_t>(options.crashTrials - 1)) + 1;
+        const std::string path = (dir / "crash.prj").string();
+
+        const pid_t child = fork();
+        if (child == 0)
+        {
+            purple::Session session;
+            session.config.trialCount = options.crashTrials;
+            purple::ResetSessionState(session);
+            purple::TrialJournal journal;
+            if (journal.Open(path, session.config, purple::VirtualClock{}.Frequency()))
+            {
+                session.journal = &journal;
+                RunSeededSession(session, options.crashTrials, seed, killAt);
+            }
+            _exit(1);  // not reached when the kill lands
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        const bool killed = child > 0 && WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL;
+
+        purple::JournalContents contents;
+        const bool loaded = killed && purple::LoadJournal(path, contents);
+        purple::Session reference;
+        RunSeededSession(reference, options.crashTrials, seed, -1);
+        bool matches = loaded && !contents.closed && contents.results.size() == static_cast<size_t>(killAt);
+        for (size_t i = 0; matches && i < contents.results.size(); ++i)
+        {
+            matches = SameResult(contents.results[i], reference.results[i]);
+        }
+
+        const bool preserved = purple::PreserveInterruptedJournal(path) && !std::filesystem::exists(path) &&
+            std::filesystem::exists(purple::NumberedTracePath(path + ".interrupted", 1));
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        std::filesystem::remove(path + ".interrupted", error);
+
+        const bool ok = killed && matches && preserved;
+        std::printf("  %-4s round %d: killed in trial %d, recovered %zu trials%s%s\n",
+            ok ? "ok" : "FAIL",
+            round + 1,
+            killAt + 1,
+            contents.results.size(),
+            matches ? ", identical to the uninterrupted run" : ", MISMATCH",
+            preserved ? ", moved aside on reuse" : ", not moved aside");
+        allOk = allOk && ok;
+    }
+    return allOk;
+}
+#endif
+} // namespace
+
+namespace bench
+{
+int RunJournalBench(int argc, char** argv)
+{
+    JournalBenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        int* target = nullptr;
+        if (std::strcmp(argv[i], "--trials") == 0 && hasValue)
+        {
+            target = &options.trials;
+        }
+        else if (std::strcmp(argv[i], "--crash-rounds") == 0 && hasValue)
+        {
+            target = &options.crashRounds;
+        }
+        else if (std::strcmp(argv[i], "--crash-trials") == 0 && hasValue)
+        {
+            target = &options.crashTrials;
+        }
+        if (target == nullptr || !purple::TryParseIntNarrow(argv[++i], *target) || *target < 1 || options.crashTrials < 2)
+        {
+            std::printf("Usage: purple_bench journal [--trials n] [--crash-rounds n] [--crash-trials n]\n");
+            return 1;
+        }
+    }
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "purple_bench_journal";
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error)
+    {
+        std::printf("Could not create %s\n", dir.string().c_str());
+        return 1;
+    }
+
+    bool ok = RunAppendLatency(options, dir);
+#if defined(_WIN32)
+    std::printf("Crash recovery: needs fork(); run it on Linux.\n");
+#else
+    ok = RunCrashRecovery(options, dir) && ok;
+#endif
+    std::filesystem::remove_all(dir, error);
+    return ok ? 0 : 2;
+}
+} // namespace bench
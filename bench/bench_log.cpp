@@ -0,0 +1,166 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/trial_log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace
+{
+struct LogBenchOptions
+{
+    int messages = 100000;
+    double intervalUs = 20.0;  // between messages; a run logs two per trial, so this is far faster than real
+};
+
+purple::TrialLogRecord MakeRecord(int i)
+{
+    purple::TrialLogRecord record;
+    record.event = i % 2 == 0 ? purple::TrialLogEvent::TrialWaiting : purple::TrialLogEvent::Reaction;
+    record.trial = i / 2 + 1;
+    record.trialCount = 1000000;
+    record.values[0] = 2.0 + (i % 3000) * 0.001;
+    record.values[1] = 0.05;
+    return record;
+}
+
+// Times `emit` once per message on the real clock, spinning `intervalUs` between messages like a trial loop.
+template <typename Emit>
+std::vector<double> TimeProducer(const LogBenchOptions& options, Emit&& emit)
+{
+    purple::MonotonicClock clock;
+    const double nsPerTick = 1e9 / static_cast<double>(clock.Frequency());
+    const purple::Ticks interval = static_cast<purple::Ticks>(options.intervalUs * 1e-6 * static_cast<double>(clock.Frequency()));
+    std::vector<double> ns(static_cast<size_t>(options.messages));
+    purple::Ticks next = clock.Now();
+    for (int i = 0; i < options.messages; ++i)
+    {
+        while (clock.Now() < next)
+        {
+        }
+        const purple::TrialLogRecord record = MakeRecord(i);
+        const purple::Ticks t0 = clock.Now();
+        emit(record);
+        ns[static_cast<size_t>(i)] = static_cast<double>(clock.Now() - t0) * nsPerTick;
+        next += interval;
+    }
+    return ns;
+}
+
+#if !defined(_WIN32)
+// The console stops reading: a pipe nobody drains until the producer is done. The log thread blocks in
+// fwrite once the pipe buffer is full; the producer must keep its cost and count the overflow as drops.
+bool RunStalledConsumer(const LogBenchOptions& options)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return false;
+    }
+    std::FILE* out = fdopen(fds[1], "w");
+    purple::TrialLog log;
+    log.Open(out);
+    std::vector<double> ns = TimeProducer(options, [&log](const purple::TrialLogRecord& record) { log.Publish(record); });
+    const unsigned long long dropped = log.Dropped();
+
+    std::thread reader([fd = fds[0]]
+    {
+        char buffer[65536];
+        while (read(fd, buffer, sizeof(buffer)) > 0)
+        {
+        }
+    });
+    log.Close();
+    std::fclose(out);
+    reader.join();
+    close(fds[0]);
+
+    bench::ReportLatency("Publish, stalled console", ns, 28);
+    // Getting here at all shows Publish never waited: nothing read the pipe until the producer was done.
+    const bool ok = dropped > 0;
+    std::printf("  %-4s %llu of %d messages dropped while the console was stalled; the producer never blocked\n",
+        ok ? "ok" : "FAIL",
+        dropped,
+        options.messages);
+    return ok;
+}
+#endif
+} // namespace
+
+namespace bench
+{
+int RunLogBench(int argc, char** argv)
+{
+    LogBenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        bool ok = false;
+        if (std::strcmp(argv[i], "--messages") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.messages) && options.messages > 0;
+        }
+        else if (std::strcmp(argv[i], "--interval-us") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.intervalUs) && options.intervalUs >= 0.0;
+        }
+        if (!ok)
+        {
+            std::printf("Usage: purple_bench log [--messages n] [--interval-us us]\n");
+            return 1;
+        }
+    }
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "purple_bench_log.txt";
+    std::FILE* file = std::fopen(path.string().c_str(), "w");
+    if (file == nullptr)
+    {
+        std::printf("Could not create %s\n", path.string().c_str());
+        return 1;
+    }
+
+    // The old path: format and write on the timing thread, flushed per line like an unbuffered console.
+    std::vector<double> printNs = TimeProducer(options, [file](const purple::TrialLogRecord& record)
+    {
+        purple::FormatTrialLog(file, record);
+        std::fflush(file);
+    });
+
+    purple::TrialLog log;
+    log.Open(file);
+    std::vector<double> publishNs = TimeProducer(options, [&log](const purple::TrialLogRecord& record) { log.Publish(record); });
+    log.Close();
+    const unsigned long long dropped = log.Dropped();
+    std::fclose(file);
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    std::printf("Producer-side cost per message, %d messages %.0f us apart (%zu-byte records, %zu-slot ring):\n",
+        options.messages,
+        options.intervalUs,
+        sizeof(purple::TrialLogRecord),
+        purple::TrialLog::Ring::capacity());
+    std::printf("  %-28s %9s %9s %9s %11s\n", "", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    ReportLatency("fprintf + fflush (file)", printNs, 28);
+    ReportLatency("TrialLog::Publish", publishNs, 28);
+    bool ok = dropped == 0;
+    std::printf("  %-4s %llu messages dropped with a file that keeps up\n", ok ? "ok" : "FAIL", dropped);
+#if defined(_WIN32)
+    std::printf("Stalled console: needs pipe(); run it on POSIX.\n");
+#else
+    ok = RunStalledConsumer(options) && ok;
+#endif
+    return ok ? 0 : 2;
+}
+} // namespace bench
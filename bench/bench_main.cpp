@@ -0,0 +1,62 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+struct BenchEntry
+{
+    const char* name;
+    const char* description;
+    int (*run)(int argc, char** argv);
+};
+
+constexpr BenchEntry kBenches[] = {
+    {"aggregate", "bulk CSV/JSON aggregation over 10k generated result files: files/s and speedup per thread count", bench::RunAggregateBench},
+    {"analytics", "distribution kernels (histograms, KDE, ECDF, sums) over millions of trials: AVX2 vs scalar time and agreement", bench::RunAnalyticsBench},
+    {"compare", "bootstrap/permutation comparison engine: resamples/s per thread count, bit-identity across thread counts, null checks", bench::RunCompareBench},
+    {"export", "CSV/JSON export throughput: to_chars writer vs std::ofstream, byte-identity check", bench::RunExportBench},
+    {"foreperiod", "seeded foreperiod schedules: golden digests per distribution, range/mean checks and build time", bench::RunForeperiodBench},
+    {"journal", "crash-safe trial journal: per-trial Append cost vs push_back, and SIGKILL recovery checks (POSIX)", bench::RunJournalBench},
+    {"log", "trial console log: producer-side Publish cost vs fprintf, drops under a stalled console (POSIX)", bench::RunLogBench},
+    {"polling", "input polling analyzer on synthetic 125 Hz-8 kHz mice: rate, missed/coalesced reports, jitter, bounce", bench::RunPollingBench},
+    {"ring", "SPSC input ring stress: lossless delivery and enqueue-to-dequeue latency", bench::RunRingBench},
+    {"rt", "timing-thread jitter per --rt-profile under load: loop stalls, CPU migrations, wait overshoot", bench::RunRtBench},
+    {"simulate", "virtual-clock sessions with a synthetic ex-Gaussian responder, sharded across cores: checks and trials/s", bench::RunSimulateBench},
+    {"stats", "streaming RunningStats vs exact statistics: update cost and estimate error", bench::RunStatsBench},
+    {"stopping", "sequential stopping rule on simulated sessions: CI coverage at the stop, trials saved, Add cost", bench::RunStoppingBench},
+    {"suite", "regression suite as JSON: wait overshoot sweep, clock read cost, loop gaps, export (p50/p99/p99.9/max)", bench::RunSuiteBench},
+    {"telemetry", "shared-memory telemetry seqlock: Publish cost alone and under polling reader processes, torn-read checks (POSIX)", bench::RunTelemetryBench},
+    {"wait", "foreperiod wait overshoot and CPU time: wait engine vs Sleep(1)/yield polling", bench::RunWaitBench},
+};
+
+void PrintUsage()
+{
+    std::printf("Usage: purple_bench <name> [options]\n");
+    for (const BenchEntry& entry : kBenches)
+    {
+        std::printf("  %-10s %s\n", entry.name, entry.description);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    for (const BenchEntry& entry : kBenches)
+    {
+        if (std::strcmp(argv[1], entry.name) == 0)
+        {
+            return entry.run(argc - 1, argv + 1);
+        }
+    }
+
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,152 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/polling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+struct PollingBenchOptions
+{
+    double seconds = 20.0;  // capture window per synthetic device
+    int seed = 1;
+    bool print = false;     // print the analysis like --poll-analyze does
+};
+
+// Per-rate jitter stays well inside a polling interval, as on real hardware, so every gap classifies cleanly.
+struct SyntheticDevice
+{
+    double rateHz;
+    double jitterUs;
+};
+constexpr SyntheticDevice kDevices[] = {{125.0, 100.0}, {1000.0, 20.0}, {8000.0, 5.0}};
+} // namespace
+
+namespace bench
+{
+int RunPollingBench(int argc, char** argv)
+{
+    PollingBenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        bool ok = false;
+        if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.seconds) && options.seconds > 0.0 && options.seconds <= 600.0;
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.seed);
+        }
+        else if (std::strcmp(argv[i], "--print") == 0)
+        {
+            options.print = true;
+            ok = true;
+        }
+        if (!ok)
+        {
+            std::printf("Usage: purple_bench polling [--seconds s] [--seed n] [--print]\n");
+            return 1;
+        }
+    }
+
+    // The devices report concurrently, as they would during one --poll-analyze window.
+    std::vector<purple::InputReport> reports;
+    std::vector<purple::SyntheticPollingTruth> truths;
+    for (size_t i = 0; i < std::size(kDevices); ++i)
+    {
+        purple::SyntheticPollingModel model;
+        model.rateHz = kDevices[i].rateHz;
+        model.jitterUs = kDevices[i].jitterUs;
+        model.seconds = options.seconds;
+        truths.push_back(purple::SynthesizeReports(model, i + 1, static_cast<std::uint64_t>(options.seed) * 31 + i, reports));
+    }
+    std::stable_sort(reports.begin(), reports.end(),
+        [](const purple::InputReport& a, const purple::InputReport& b) { return a.timestamp < b.timestamp; });
+
+    constexpr purple::Ticks kFrequency = 1000000000;
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    const std::vector<purple::DevicePolling> devices = purple::AnalyzeReports(reports, kFrequency);
+    const double analyzeSeconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+
+    std::printf("Polling analysis of %zu synthetic reports (%.1f s per device): %.2f ms, %.1f M reports/s\n",
+        reports.size(),
+        options.seconds,
+        analyzeSeconds * 1000.0,
+        static_cast<double>(reports.size()) / analyzeSeconds / 1e6);
+    if (options.print)
+    {
+        purple::PrintPollingAnalysis(devices, options.seconds);
+    }
+
+    char name[64];
+    char detail[160];
+    bool ok = PrintCheck("one entry per device", devices.size() == std::size(kDevices), "");
+    for (size_t i = 0; i < std::size(kDevices); ++i)
+    {
+        // Devices come out in order of first report, which the start jitter decides.
+        const auto found = std::find_if(devices.begin(), devices.end(),
+            [i](const purple::DevicePolling& device) { return device.device == i + 1; });
+        if (found == devices.end())
+        {
+            continue;
+        }
+        const purple::DevicePolling& device = *found;
+        const purple::SyntheticPollingTruth& truth = truths[i];
+        const double rate = kDevices[i].rateHz;
+        std::printf(" %.0f Hz mouse:\n", rate);
+
+        std::snprintf(detail, sizeof(detail), "%.0f Hz (median %.4f ms), effective %.1f Hz", device.nominalHz,
+            device.medianIntervalMs, device.effectiveHz);
+        ok &= PrintCheck("nominal rate", device.nominalHz == rate, detail);
+        std::snprintf(detail, sizeof(detail), "%zu vs %zu", device.missedReports, truth.missed);
+        ok &= PrintCheck("missed reports", device.missedReports == truth.missed, detail);
+        std::snprintf(detail, sizeof(detail), "%zu vs %zu", device.coalescedReports, truth.coalesced);
+        ok &= PrintCheck("coalesced reports", device.coalescedReports == truth.coalesced, detail);
+
+        // Each gap is the difference of two independent delivery times.
+        const double expectedJitterMs = std::sqrt(2.0) * kDevices[i].jitterUs / 1000.0;
+        std::snprintf(detail, sizeof(detail), "%.4f vs %.4f ms", device.jitterMs, expectedJitterMs);
+        std::snprintf(name, sizeof(name), "interval jitter (within 5%%)");
+        ok &= PrintCheck(name, std::fabs(device.jitterMs - expectedJitterMs) <= 0.05 * expectedJitterMs, detail);
+
+        std::snprintf(detail, sizeof(detail), "%zu vs %zu (%zu clicks)", device.presses, truth.presses, truth.clicks);
+        ok &= PrintCheck("presses", device.presses == truth.presses, detail);
+        std::snprintf(detail, sizeof(detail), "%zu vs %zu", device.bounces, truth.bounces);
+        ok &= PrintCheck("bounces", device.bounces == truth.bounces, detail);
+    }
+
+    // Recordings analyze exactly like the stream they were written from.
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "purple_bench_polling.prp";
+    std::vector<purple::InputReport> loaded;
+    purple::Ticks loadedFrequency = 0;
+    const bool roundTrip = purple::SaveReportStream(path.string(), reports, kFrequency) &&
+        purple::LoadReportStream(path.string(), loaded, loadedFrequency) && loadedFrequency == kFrequency &&
+        loaded.size() == reports.size() &&
+        std::memcmp(loaded.data(), reports.data(), reports.size() * sizeof(purple::InputReport)) == 0;
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::snprintf(detail, sizeof(detail), "%zu reports", loaded.size());
+    ok &= PrintCheck("report stream file round trip", roundTrip, detail);
+
+    purple::ReportRecorder recorder(reports.size() / 2);
+    const purple::InputReport* before = recorder.Reports().data();
+    for (const purple::InputReport& report : reports)
+    {
+        recorder.Add(report);
+    }
+    std::snprintf(detail, sizeof(detail), "%zu kept, %llu overflow", recorder.Reports().size(), recorder.Overflow());
+    ok &= PrintCheck("recorder never reallocates",
+        recorder.Reports().data() == before && recorder.Reports().size() + recorder.Overflow() == reports.size(), detail);
+    return ok ? 0 : 2;
+}
+} // namespace bench
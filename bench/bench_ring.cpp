@@ -0,0 +1,162 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/input.h"
+#include "core/parse.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace
+{
+struct RingRunResult
+{
+    unsigned long long received = 0;
+    unsigned long long outOfOrder = 0;
+    unsigned long long producerRetries = 0;
+    double seconds = 0.0;
+    std::vector<double> latencyUs;
+};
+
+// One synthetic producer thread feeds `count` events (device = sequence number) into the ring while the
+// calling thread drains it the way the session loop does. A full ring makes the producer retry, so any
+// gap or reorder in the sequence is a real loss.
+RingRunResult RunRing(unsigned long long count, purple::Ticks producerGapTicks)
+{
+    purple::MonotonicClock clock;
+    auto ring = std::make_unique<purple::InputRing>();
+    std::atomic<bool> done{false};
+    std::atomic<unsigned long long> retries{0};
+
+    RingRunResult result;
+    result.latencyUs.reserve(static_cast<size_t>(count));
+
+    const purple::Ticks start = clock.Now();
+    std::thread producer([&]
+    {
+        purple::MonotonicClock producerClock;
+        unsigned long long localRetries = 0;
+        for (unsigned long long i = 0; i < count; ++i)
+        {
+            if (producerGapTicks > 0)
+            {
+                const purple::Ticks until = producerClock.Now() + producerGapTicks;
+                while (producerClock.Now() < until)
+                {
+                    purple::CpuRelax();
+                }
+            }
+
+            purple::InputEvent event;
+            event.device = i;
+            event.kind = purple::InputEventKind::Press;
+            event.timestamp = producerClock.Now();
+            while (!ring->TryPush(event))
+            {
+                ++localRetries;
+                std::this_thread::yield();
+            }
+        }
+        retries.store(localRetries, std::memory_order_relaxed);
+        done.store(true, std::memory_order_release);
+    });
+
+    unsigned long long expected = 0;
+    const auto consume = [&](const purple::InputEvent& event)
+    {
+        const purple::Ticks now = clock.Now();
+        if (event.device != expected)
+        {
+            ++result.outOfOrder;
+        }
+        expected = event.device + 1;
+        ++result.received;
+        result.latencyUs.push_back(purple::TicksToMilliseconds(now - event.timestamp, clock.Frequency()) * 1000.0);
+    };
+
+    for (;;)
+    {
+        const bool finished = done.load(std::memory_order_acquire);
+        if (purple::DrainRing(*ring, consume) == 0)
+        {
+            if (finished)
+            {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    result.seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+    result.producerRetries = retries.load(std::memory_order_relaxed);
+    std::sort(result.latencyUs.begin(), result.latencyUs.end());
+    return result;
+}
+
+bool Report(const char* mode, unsigned long long sent, const RingRunResult& result)
+{
+    const bool lossless = result.received == sent && result.outOfOrder == 0;
+    std::printf("%-6s sent=%llu received=%llu out_of_order=%llu producer_retries=%llu %s\n",
+        mode,
+        sent,
+        result.received,
+        result.outOfOrder,
+        result.producerRetries,
+        lossless ? "OK" : "LOSS");
+    std::printf("       %.2f Mevents/s, enqueue->dequeue latency p50=%.2f us p99=%.2f us p99.9=%.2f us max=%.2f us\n",
+        result.seconds > 0.0 ? static_cast<double>(result.received) / result.seconds / 1e6 : 0.0,
+        bench::SortedPercentile(result.latencyUs, 50.0),
+        bench::SortedPercentile(result.latencyUs, 99.0),
+        bench::SortedPercentile(result.latencyUs, 99.9),
+        result.latencyUs.empty() ? 0.0 : result.latencyUs.back());
+    return lossless;
+}
+} // namespace
+
+namespace bench
+{
+int RunRingBench(int argc, char** argv)
+{
+    int burstCount = 1000000;
+    int pacedCount = 20000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--events") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], burstCount))
+            {
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--paced-events") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], pacedCount))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            std::printf("Usage: purple_bench ring [--events n] [--paced-events n]\n");
+            return 1;
+        }
+    }
+
+    std::printf("SPSC input ring, capacity %zu\n", purple::InputRing::capacity());
+
+    // Burst: producer pushes back-to-back, exercising the full-ring path.
+    const RingRunResult burst = RunRing(static_cast<unsigned long long>(burstCount), 0);
+    const bool burstOk = Report("burst", static_cast<unsigned long long>(burstCount), burst);
+
+    // Paced: one event every ~50 us, closer to a real input device; latency is the interesting number.
+    purple::MonotonicClock clock;
+    const RingRunResult paced = RunRing(static_cast<unsigned long long>(pacedCount), clock.Frequency() / 20000);
+    const bool pacedOk = Report("paced", static_cast<unsigned long long>(pacedCount), paced);
+
+    return (burstOk && pacedOk) ? 0 : 2;
+}
+} // namespace bench
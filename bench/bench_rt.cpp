@@ -0,0 +1,223 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/realtime.h"
+#include "core/wait.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+namespace
+{
+struct RtBenchOptions
+{
+    double seconds = 2.0;        // tight-loop sampling per profile
+    int waits = 200;             // 2 ms foreperiod waits per profile
+    bool background = true;      // one busy thread per CPU competes with the timing thread
+};
+
+int CurrentCpu()
+{
+#if defined(_WIN32)
+    return static_cast<int>(GetCurrentProcessorNumber());
+#else
+    return sched_getcpu();
+#endif
+}
+
+constexpr double kStallUs = 2.0;  // a gap above this between two clock reads is a stall, not loop cost
+
+struct ProfileSample
+{
+    unsigned long long reads = 0;
+    std::vector<double> stallUs;       // gaps between consecutive clock reads above kStallUs
+    std::vector<double> overshootUs;   // wait-engine onset overshoot
+    unsigned long long migrations = 0;
+    purple::RealtimeReport report;
+};
+
+// Samples the clock in a tight loop like the response phase does, then times foreperiod waits, all under
+// the profile. A gap well above the clock read cost is time the thread lost: preemption, an interrupt or a
+// migration to another core.
+ProfileSample MeasureProfile(purple::MonotonicClock& clock, purple::RealtimeProfile profile, const RtBenchOptions& options)
+{
+    ProfileSample sample;
+    purple::RealtimeConfig config;
+    config.profile = profile;
+    purple::RealtimeScope scope;
+    scope.Enter(config);
+    sample.report = scope.Report();
+
+    const purple::Ticks freq = clock.Frequency();
+    const purple::Ticks stallTicks = purple::SecondsToTicks(kStallUs * 1e-6, freq);
+    const double usPerTick = 1e6 / static_cast<double>(freq);
+    sample.stallUs.reserve(1000000);  // only stalls are kept; a tight loop reads the clock tens of millions of times
+    const purple::Ticks end = clock.Now() + purple::SecondsToTicks(options.seconds, freq);
+    int cpu = CurrentCpu();
+    purple::Ticks last = clock.Now();
+    while (last < end)
+    {
+        const purple::Ticks now = clock.Now();
+        if (now - last > stallTicks && sample.stallUs.size() < sample.stallUs.capacity())
+        {
+            sample.stallUs.push_back(static_cast<double>(now - last) * usPerTick);
+        }
+        last = now;
+        if ((++sample.reads & 255) == 0)
+        {
+            const int current = CurrentCpu();
+            sample.migrations += current != cpu ? 1 : 0;
+            cpu = current;
+        }
+    }
+
+    purple::ForeperiodWaiter<purple::MonotonicClock> waiter(clock, purple::WaitConfig{});
+    waiter.Calibrate();
+    sample.overshootUs.reserve(static_cast<size_t>(options.waits));
+    for (int i = 0; i < options.waits; ++i)
+    {
+        const purple::Ticks deadline = clock.Now() + purple::SecondsToTicks(0.002, freq);
+        while (!waiter.WaitStep(deadline))
+        {
+        }
+        sample.overshootUs.push_back(purple::TicksToMilliseconds(waiter.LastOvershootTicks(), freq) * 1000.0);
+    }
+    scope.Leave();
+
+    std::sort(sample.stallUs.begin(), sample.stallUs.end());
+    std::sort(sample.overshootUs.begin(), sample.overshootUs.end());
+    return sample;
+}
+
+size_t CountAbove(const std::vector<double>& sorted, double limit)
+{
+    return static_cast<size_t>(sorted.end() - std::upper_bound(sorted.begin(), sorted.end(), limit));
+}
+
+void PrintProfile(purple::RealtimeProfile profile, const ProfileSample& sample)
+{
+    double lostUs = 0.0;
+    for (const double gap : sample.stallUs)
+    {
+        lostUs += gap;
+    }
+    std::printf("%-9s %8zu %7zu %7zu %10.1f %9.2f %6llu %9.1f %9.1f %9.1f\n",
+        purple::RealtimeProfileName(profile),
+        sample.stallUs.size(),
+        CountAbove(sample.stallUs, 10.0),
+        CountAbove(sample.stallUs, 100.0),
+        sample.stallUs.empty() ? 0.0 : sample.stallUs.back(),
+        lostUs / 1000.0,
+        sample.migrations,
+        bench::SortedPercentile(sample.overshootUs, 50.0),
+        bench::SortedPercentile(sample.overshootUs, 99.0),
+        sample.overshootUs.empty() ? 0.0 : sample.overshootUs.back());
+}
+
+void PrintReport(purple::RealtimeProfile profile, const purple::RealtimeReport& report)
+{
+    std::printf("  %-9s priority %s, timing CPUs [%s], MMCSS [%s], SCHED_FIFO %d, memory locked %s, power throttling off %s,\n"
+                "            cpu_dma_latency held %s\n",
+        purple::RealtimeProfileName(profile),
+        report.priorityRaised ? "raised" : "unchanged",
+        report.timingCpus.c_str(),
+        report.mmcssTask.c_str(),
+        report.fifoPriority,
+        report.memoryLocked ? "yes" : "no",
+        report.powerThrottlingOff ? "yes" : "no",
+        report.cpuDmaLatencyHeld ? "yes" : "no");
+}
+} // namespace
+
+namespace bench
+{
+int RunRtBench(int argc, char** argv)
+{
+    RtBenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        bool ok = false;
+        if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.seconds) && options.seconds > 0.0 && options.seconds <= 60.0;
+        }
+        else if (std::strcmp(argv[i], "--waits") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.waits) && options.waits > 0;
+        }
+        else if (std::strcmp(argv[i], "--quiet") == 0)
+        {
+            options.background = false;
+            ok = true;
+        }
+        if (!ok)
+        {
+            std::printf("Usage: purple_bench rt [--seconds s] [--waits n] [--quiet]\n");
+            return 1;
+        }
+    }
+
+    // Competing load at normal priority, so the profiles differ in what they protect the thread from.
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> load;
+    if (options.background)
+    {
+        const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < count; ++i)
+        {
+            load.emplace_back([&stop]
+            {
+                volatile unsigned long long spin = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    spin = spin + 1;
+                }
+            });
+        }
+    }
+
+    purple::MonotonicClock clock;
+    static constexpr purple::RealtimeProfile kProfiles[] = {
+        purple::RealtimeProfile::None, purple::RealtimeProfile::Standard, purple::RealtimeProfile::Isolated};
+    ProfileSample samples[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        samples[i] = MeasureProfile(clock, kProfiles[i], options);
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : load)
+    {
+        thread.join();
+    }
+
+    std::printf("Timing-thread jitter per --rt-profile, %.1f s tight loop + %d waits of 2 ms each, %s:\n",
+        options.seconds,
+        options.waits,
+        options.background ? "one busy thread per CPU" : "idle machine");
+    std::printf("%-9s %8s %7s %7s %10s %9s %6s %9s %9s %9s\n",
+        "profile", ">2us", ">10us", ">100us", "stall max", "lost ms", "moves", "wait p50", "wait p99", "wait max");
+    for (size_t i = 0; i < 3; ++i)
+    {
+        PrintProfile(kProfiles[i], samples[i]);
+    }
+    std::printf("(stalls: gaps between clock reads of a tight loop; times in us unless noted; moves: CPU changes)\n");
+    std::printf("Applied:\n");
+    for (size_t i = 0; i < 3; ++i)
+    {
+        PrintReport(kProfiles[i], samples[i].report);
+    }
+    return 0;
+}
+} // namespace bench
@@ -0,0 +1,442 @@
+#include "bench.h"
+
+#include "core/device.h"
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/simulate.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+struct SimulateOptions
+{
+    int sessions = 64;
+    int trialsPerSession = 50000;
+    int threads = 0;  // 0: one per hardware thread
+    std::uint64_t seed = 12345;
+    double minDelaySeconds = 2.0;
+    double maxDelaySeconds = 5.0;
+    purple::ResponderModel model;
+};
+
+// Ex-Gaussian method-of-moments estimate from the first three central moments.
+struct ExGaussianEstimate
+{
+    double mu = 0.0;
+    double sigma = 0.0;
+    double tau = 0.0;
+};
+
+// Power sums of reaction times, shifted so the cubes stay well conditioned; mergeable across sessions.
+struct MomentSums
+{
+    static constexpr double kShiftMs = 300.0;
+
+    double n = 0.0;
+    double s1 = 0.0;
+    double s2 = 0.0;
+    double s3 = 0.0;
+
+    void Add(double x)
+    {
+        const double d = x - kShiftMs;
+        n += 1.0;
+        s1 += d;
+        s2 += d * d;
+        s3 += d * d * d;
+    }
+
+    void Merge(const MomentSums& other)
+    {
+        n += other.n;
+        s1 += other.s1;
+        s2 += other.s2;
+        s3 += other.s3;
+    }
+
+    // Removes the latency model's known mean and (uniform-jitter) variance before fitting; uniform noise
+    // adds no third central moment.
+    ExGaussianEstimate Estimate(const purple::ResponderModel& model) const
+    {
+        const double m = s1 / n;
+        const double variance = s2 / n - m * m;
+        const double third = s3 / n - 3.0 * m * (s2 / n) + 2.0 * m * m * m;
+
+        double latencyMean = model.displayLatencyMs + model.displayJitterMs / 2.0 + model.inputLatencyMs +
+            model.inputJitterMs / 2.0;
+        double latencyVariance =
+            (model.displayJitterMs * model.displayJitterMs + model.inputJitterMs * model.inputJitterMs) / 12.0;
+        // A uniformly drawn device lag is one more independent term: its cumulants add to the latency's.
+        double lagThird = 0.0;
+        if (!model.deviceLagMs.empty())
+        {
+            const double count = static_cast<double>(model.deviceLagMs.size());
+            double lagMean = 0.0;
+            for (const double lag : model.deviceLagMs)
+            {
+                lagMean += lag / count;
+            }
+            for (const double lag : model.deviceLagMs)
+            {
+                const double d = lag - lagMean;
+                latencyVariance += d * d / count;
+                lagThird += d * d * d / count;
+            }
+            latencyMean += lagMean;
+        }
+
+        ExGaussianEstimate estimate;
+        estimate.tau = std::cbrt(std::max(0.0, third - lagThird) / 2.0);
+        estimate.sigma = std::sqrt(std::max(0.0, variance - latencyVariance - estimate.tau * estimate.tau));
+        estimate.mu = m + kShiftMs - latencyMean - estimate.tau;
+        return estimate;
+    }
+};
+
+struct SessionTally
+{
+    long long trials = 0;
+    long long incomplete = 0;          // sessions that did not finish with trialCount results
+    long long mismatches = 0;          // results that differ from the responder's ground truth
+    long long falseStarts = 0;
+    long long expectedFalseStarts = 0;
+    long long anticipations = 0;
+    long long lapses = 0;
+    long long statsDisagreements = 0;  // sessions whose RunningStats differ from their results
+    long long misattributed = 0;       // results whose device is not the one that pressed
+    long long deviceComparisons = 0;   // per-session device mean differences (--devices)
+    long long deviceCovered = 0;       // ... whose 95% interval covers the true lag difference
+    MomentSums moments;                // valid, non-lapse, non-anticipated trials
+    std::vector<ExGaussianEstimate> perSession;
+
+    void Merge(const SessionTally& other)
+    {
+        trials += other.trials;
+        incomplete += other.incomplete;
+        mismatches += other.mismatches;
+        falseStarts += other.falseStarts;
+        expectedFalseStarts += other.expectedFalseStarts;
+        anticipations += other.anticipations;
+        lapses += other.lapses;
+        statsDisagreements += other.statsDisagreements;
+        misattributed += other.misattributed;
+        deviceComparisons += other.deviceComparisons;
+        deviceCovered += other.deviceCovered;
+        moments.Merge(other.moments);
+        perSession.insert(perSession.end(), other.perSession.begin(), other.perSession.end());
+    }
+};
+
+// Runs one simulated session through the real trial loop and checks every result against ground truth.
+void RunSimulatedSession(const SimulateOptions& options, int index, SessionTally& tally)
+{
+    purple::Session session;
+    session.config.trialCount = options.trialsPerSession;
+    session.config.minDelaySeconds = options.minDelaySeconds;
+    session.config.maxDelaySeconds = options.maxDelaySeconds;
+    session.config.logTrials = false;
+    // No spinning on a virtual clock, and no foreperiod polling: the responder wakes the loop itself.
+    session.config.wait.spinBudgetSeconds = 0.0;
+    session.config.wait.pollIntervalSeconds = 3600.0;
+    session.config.foreperiod.seeded = true;
+    session.config.foreperiod.seed = options.seed + 2 * static_cast<std::uint64_t>(index);
+    purple::ResetSessionState(session);
+    session.results.reserve(static_cast<size_t>(options.trialsPerSession));
+
+    purple::VirtualClock clock;
+    purple::NullDisplay display;
+    purple::SimulatedResponder responder(clock, options.model, options.seed + 2 * static_cast<std::uint64_t>(index) + 1);
+    responder.Reserve(static_cast<size_t>(options.trialsPerSession));
+
+    const purple::SessionOutcome outcome = purple::RunTrialLoop(session, clock, display, responder);
+
+    const std::vector<purple::SimulatedTrial>& truth = responder.Trials();
+    if (outcome != purple::SessionOutcome::Completed || session.trialIndex != options.trialsPerSession ||
+        session.results.size() != static_cast<size_t>(options.trialsPerSession) || truth.size() != session.results.size())
+    {
+        ++tally.incomplete;
+        return;
+    }
+
+    MomentSums sessionMoments;
+    double validSum = 0.0;
+    size_t validCount = 0;
+    const purple::Ticks freq = clock.Frequency();
+    for (size_t i = 0; i < truth.size(); ++i)
+    {
+        const purple::SimulatedTrial& expected = truth[i];
+        const purple::TrialResult& result = session.results[i];
+        tally.anticipations += expected.anticipated ? 1 : 0;
+        tally.lapses += expected.lapse ? 1 : 0;
+        tally.expectedFalseStarts += expected.ExpectFalseStart() ? 1 : 0;
+        tally.falseStarts += result.falseStart ? 1 : 0;
+
+        const bool matches = result.falseStart == expected.ExpectFalseStart() &&
+            (result.falseStart ||
+                result.reactionMs == purple::TicksToMilliseconds(expected.captureTicks - expected.onsetTicks, freq));
+        tally.mismatches += matches ? 0 : 1;
+        const bool attributed = result.device >= 0 && static_cast<size_t>(result.device) < session.devices.size() &&
+            session.devices[static_cast<size_t>(result.device)].handle == expected.device;
+        tally.misattributed += attributed ? 0 : 1;
+
+        if (!result.falseStart)
+        {
+            validSum += result.reactionMs;
+            ++validCount;
+            if (!expected.anticipated && !expected.lapse)
+            {
+                sessionMoments.Add(result.reactionMs);
+            }
+        }
+    }
+
+    const purple::ReactionSummary summary = session.stats.Summary();
+    const bool statsAgree = summary.validCount == validCount &&
+        summary.falseStartCount == session.results.size() - validCount &&
+        (validCount == 0 || std::fabs(summary.meanMs - validSum / static_cast<double>(validCount)) < 1e-6);
+    tally.statsDisagreements += statsAgree ? 0 : 1;
+
+    if (!options.model.deviceLagMs.empty())
+    {
+        const std::vector<purple::ReactionSummary> devices = purple::SummarizeDevices(session.results, session.devices.size());
+        const auto lagOf = [&](size_t device)
+        {
+            const std::uint64_t handle = session.devices[device].handle;
+            return handle == 0 ? 0.0 : options.model.deviceLagMs[handle - 1];
+        };
+        for (const purple::DeviceComparison& comparison : purple::CompareDevices(devices))
+        {
+            const double truth = lagOf(comparison.device) - lagOf(comparison.reference);
+            ++tally.deviceComparisons;
+            tally.deviceCovered += comparison.difference.lowMs <= truth && truth <= comparison.difference.highMs ? 1 : 0;
+        }
+    }
+
+    tally.trials += static_cast<long long>(session.results.size());
+    tally.moments.Merge(sessionMoments);
+    if (sessionMoments.n > 2.0)
+    {
+        tally.perSession.push_back(sessionMoments.Estimate(options.model));
+    }
+}
+
+// Standard error of a pooled estimate from the spread of the per-session estimates.
+double StandardError(const std::vector<ExGaussianEstimate>& estimates, double ExGaussianEstimate::*field)
+{
+    double mean = 0.0;
+    for (const ExGaussianEstimate& e : estimates)
+    {
+        mean += e.*field;
+    }
+    mean /= static_cast<double>(estimates.size());
+    double ss = 0.0;
+    for (const ExGaussianEstimate& e : estimates)
+    {
+        ss += (e.*field - mean) * (e.*field - mean);
+    }
+    const double n = static_cast<double>(estimates.size());
+    return std::sqrt(ss / (n - 1.0)) / std::sqrt(n);
+}
+
+bool ParseOptions(int argc, char** argv, SimulateOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = hasValue;
+        if (std::strcmp(arg, "--sessions") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.sessions) && options.sessions > 0;
+        }
+        else if (std::strcmp(arg, "--trials") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.trialsPerSession) && options.trialsPerSession > 0;
+        }
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.threads) && options.threads >= 0;
+        }
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue)
+        {
+            int seed = 0;
+            ok = purple::TryParseIntNarrow(argv[++i], seed);
+            options.seed = static_cast<std::uint64_t>(seed);
+        }
+        else if (std::strcmp(arg, "--min-delay") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.minDelaySeconds);
+        }
+        else if (std::strcmp(arg, "--max-delay") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.maxDelaySeconds);
+        }
+        else if (std::strcmp(arg, "--mu") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.model.muMs);
+        }
+        else if (std::strcmp(arg, "--sigma") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.model.sigmaMs) && options.model.sigmaMs > 0.0;
+        }
+        else if (std::strcmp(arg, "--tau") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.model.tauMs) && options.model.tauMs > 0.0;
+        }
+        else if (std::strcmp(arg, "--anticipate") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.model.anticipationProbability);
+        }
+        else if (std::strcmp(arg, "--miss") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.model.missProbability);
+        }
+        else if (std::strcmp(arg, "--devices") == 0 && hasValue)
+        {
+            ok = purple::ParseDeviceLagList(argv[++i], options.model.deviceLagMs);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return options.minDelaySeconds > 0.0 && options.minDelaySeconds < options.maxDelaySeconds;
+}
+} // namespace
+
+namespace bench
+{
+int RunSimulateBench(int argc, char** argv)
+{
+    SimulateOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::printf(
+            "Usage: purple_bench simulate [--sessions n] [--trials n] [--threads n] [--seed n]\n"
+            "         [--min-delay s] [--max-delay s] [--mu ms] [--sigma ms] [--tau ms] [--anticipate p] [--miss p]\n"
+            "         [--devices ms,ms,...]\n");
+        return 1;
+    }
+
+    int threadCount = options.threads;
+    if (threadCount == 0)
+    {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threadCount = std::min(threadCount, options.sessions);
+
+    // Sessions are independent; workers pull the next index and fold into a private tally.
+    std::atomic<int> nextSession{0};
+    std::mutex mergeMutex;
+    SessionTally total;
+    purple::MonotonicClock wallClock;
+    const purple::Ticks start = wallClock.Now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&]()
+        {
+            SessionTally local;
+            for (int index = nextSession.fetch_add(1); index < options.sessions; index = nextSession.fetch_add(1))
+            {
+                RunSimulatedSession(options, index, local);
+            }
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            total.Merge(local);
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    const double wallSeconds = purple::TicksToSeconds(wallClock.Now() - start, wallClock.Frequency());
+
+    const double trialsPerSecond = static_cast<double>(total.trials) / wallSeconds;
+    std::printf("Simulated %d sessions x %d trials on %d threads: %.2f s, %.0f trials/s (%.0f per thread)\n",
+        options.sessions,
+        options.trialsPerSession,
+        threadCount,
+        wallSeconds,
+        trialsPerSecond,
+        trialsPerSecond / threadCount);
+
+    char detail[160];
+    bool ok = true;
+    std::snprintf(detail, sizeof(detail), "%lld incomplete", total.incomplete);
+    ok &= PrintCheck("sessions complete every trial", total.incomplete == 0, detail);
+    std::snprintf(detail, sizeof(detail), "%lld of %lld differ", total.mismatches, total.trials);
+    ok &= PrintCheck("results match ground truth", total.mismatches == 0, detail);
+    std::snprintf(detail,
+        sizeof(detail),
+        "%lld recorded, %lld expected (%lld anticipations)",
+        total.falseStarts,
+        total.expectedFalseStarts,
+        total.anticipations);
+    ok &= PrintCheck("false starts", total.falseStarts == total.expectedFalseStarts, detail);
+    std::snprintf(detail, sizeof(detail), "%lld sessions disagree", total.statsDisagreements);
+    ok &= PrintCheck("RunningStats agree with results", total.statsDisagreements == 0, detail);
+    std::snprintf(detail, sizeof(detail), "%lld of %lld misattributed", total.misattributed, total.trials);
+    ok &= PrintCheck("presses attributed to their device", total.misattributed == 0, detail);
+
+    // Drawn rates against their binomial expectation (4 standard errors).
+    const auto checkRate = [&](const char* name, long long count, double probability)
+    {
+        const double n = static_cast<double>(std::max(1LL, total.trials));
+        const double rate = static_cast<double>(count) / n;
+        std::snprintf(detail, sizeof(detail), "%.5f vs %.5f", rate, probability);
+        return PrintCheck(name, std::fabs(rate - probability) <= 4.0 * std::sqrt(probability * (1.0 - probability) / n) + 1e-12, detail);
+    };
+    ok &= checkRate("anticipation rate", total.anticipations, options.model.anticipationProbability);
+    ok &= checkRate("lapse rate", total.lapses, options.model.missProbability * (1.0 - options.model.anticipationProbability));
+    if (total.deviceComparisons > 0)
+    {
+        const double n = static_cast<double>(total.deviceComparisons);
+        const double coverage = static_cast<double>(total.deviceCovered) / n;
+        std::snprintf(detail, sizeof(detail), "%.4f of %lld vs 0.95", coverage, total.deviceComparisons);
+        ok &= PrintCheck("device 95% CI coverage", std::fabs(coverage - 0.95) <= 4.0 * std::sqrt(0.95 * 0.05 / n), detail);
+    }
+
+    if (total.moments.n < 3.0)
+    {
+        std::printf("  too few responses to recover the ex-Gaussian parameters\n");
+        return ok ? 0 : 2;
+    }
+
+    // Pooled estimate, judged against the spread of per-session estimates (4 standard errors).
+    const ExGaussianEstimate pooled = total.moments.Estimate(options.model);
+    const struct
+    {
+        const char* name;
+        double ExGaussianEstimate::*field;
+        double generated;
+    } parameters[] = {
+        {"ex-Gaussian mu (ms)", &ExGaussianEstimate::mu, options.model.muMs},
+        {"ex-Gaussian sigma (ms)", &ExGaussianEstimate::sigma, options.model.sigmaMs},
+        {"ex-Gaussian tau (ms)", &ExGaussianEstimate::tau, options.model.tauMs},
+    };
+    for (const auto& parameter : parameters)
+    {
+        const double estimate = pooled.*parameter.field;
+        if (total.perSession.size() < 2)
+        {
+            std::printf("  --   %-34s %.3f vs %.3f (needs 2+ sessions to judge)\n", parameter.name, estimate, parameter.generated);
+            continue;
+        }
+        const double se = StandardError(total.perSession, parameter.field);
+        std::snprintf(detail, sizeof(detail), "%.3f vs %.3f (se %.3f)", estimate, parameter.generated, se);
+        ok &= PrintCheck(parameter.name, std::fabs(estimate - parameter.generated) <= 4.0 * se, detail);
+    }
+    return ok ? 0 : 2;
+}
+} // namespace bench
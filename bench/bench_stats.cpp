@@ -0,0 +1,119 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/stats.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+struct ExactSummary
+{
+    double mean = 0.0;
+    double sd = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double trimmedMean = 0.0;
+    double mad = 0.0;
+};
+
+ExactSummary ComputeExact(std::vector<double> values)
+{
+    ExactSummary exact;
+    const double n = static_cast<double>(values.size());
+    exact.mean = std::accumulate(values.begin(), values.end(), 0.0) / n;
+    double ss = 0.0;
+    for (const double v : values)
+    {
+        ss += (v - exact.mean) * (v - exact.mean);
+    }
+    exact.sd = std::sqrt(ss / (n - 1.0));
+
+    std::sort(values.begin(), values.end());
+    exact.p50 = bench::SortedPercentile(values, 50.0);
+    exact.p90 = bench::SortedPercentile(values, 90.0);
+    exact.p95 = bench::SortedPercentile(values, 95.0);
+    exact.p99 = bench::SortedPercentile(values, 99.0);
+
+    const size_t trim = static_cast<size_t>(n * purple::RunningStats::kTrimFraction);
+    exact.trimmedMean = std::accumulate(values.begin() + trim, values.end() - trim, 0.0) /
+        static_cast<double>(values.size() - 2 * trim);
+
+    std::vector<double> deviations;
+    deviations.reserve(values.size());
+    for (const double v : values)
+    {
+        deviations.push_back(std::fabs(v - exact.p50));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    exact.mad = bench::SortedPercentile(deviations, 50.0);
+    return exact;
+}
+
+void PrintRow(const char* name, double streaming, double exact)
+{
+    std::printf("  %-14s streaming=%10.3f exact=%10.3f error=%8.3f ms\n", name, streaming, exact, streaming - exact);
+}
+} // namespace
+
+namespace bench
+{
+int RunStatsBench(int argc, char** argv)
+{
+    int count = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--trials") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], count))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            std::printf("Usage: purple_bench stats [--trials n]\n");
+            return 1;
+        }
+    }
+
+    std::vector<double> values = ExGaussianSample(static_cast<size_t>(count), 12345);
+    for (double& v : values)
+    {
+        v = std::max(0.0, v);
+    }
+
+    purple::MonotonicClock clock;
+    purple::RunningStats stats;
+    const purple::Ticks start = clock.Now();
+    for (const double v : values)
+    {
+        stats.AddReaction(v);
+    }
+    const purple::Ticks addTicks = clock.Now() - start;
+    const purple::ReactionSummary summary = stats.Summary();
+    const purple::Ticks summaryTicks = clock.Now() - start - addTicks;
+
+    const ExactSummary exact = ComputeExact(values);
+
+    std::printf("RunningStats over %d ex-Gaussian trials: %.1f ns/update, summary %.1f us\n",
+        count,
+        purple::TicksToMilliseconds(addTicks, clock.Frequency()) * 1e6 / static_cast<double>(count),
+        purple::TicksToMilliseconds(summaryTicks, clock.Frequency()) * 1000.0);
+    PrintRow("mean", summary.meanMs, exact.mean);
+    PrintRow("sd", summary.sdMs, exact.sd);
+    PrintRow("p50", summary.p50Ms, exact.p50);
+    PrintRow("p90", summary.p90Ms, exact.p90);
+    PrintRow("p95", summary.p95Ms, exact.p95);
+    PrintRow("p99", summary.p99Ms, exact.p99);
+    PrintRow("trimmed_mean", summary.trimmedMeanMs, exact.trimmedMean);
+    PrintRow("mad", summary.madMs, exact.mad);
+    return 0;
+}
+} // namespace bench
@@ -0,0 +1,298 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/simulate.h"
+#include "core/stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+struct StoppingOptions
+{
+    int sessions = 2000;
+    int maxTrials = 400;
+    int truthTrials = 1000000;  // one unstopped session whose valid reactions stand in for the population
+    std::uint64_t seed = 4242;
+    purple::StoppingRule rule;
+    purple::ResponderModel model;
+
+    StoppingOptions()
+    {
+        rule.halfWidthMs = 12.0;
+        // Lapses add 2 s outliers that no interval of a few dozen trials describes; --miss puts them back.
+        model.missProbability = 0.0;
+    }
+};
+
+purple::Session MakeSession(const StoppingOptions& options, int trialCount, std::uint64_t seed, bool withRule)
+{
+    purple::Session session;
+    session.config.trialCount = trialCount;
+    session.config.minDelaySeconds = 2.0;
+    session.config.maxDelaySeconds = 5.0;
+    session.config.logTrials = false;
+    // Virtual clock: no spinning and no foreperiod polling (see bench_simulate.cpp).
+    session.config.wait.spinBudgetSeconds = 0.0;
+    session.config.wait.pollIntervalSeconds = 3600.0;
+    session.config.foreperiod.seeded = true;
+    session.config.foreperiod.seed = seed;
+    if (withRule)
+    {
+        session.config.stopping = options.rule;
+    }
+    return session;
+}
+
+// Runs one simulated session to its end; false when the loop did not complete.
+bool RunSession(purple::Session& session, const purple::ResponderModel& model, std::uint64_t seed)
+{
+    purple::ResetSessionState(session);
+    session.results.reserve(static_cast<size_t>(session.config.trialCount));
+    purple::VirtualClock clock;
+    purple::NullDisplay display;
+    purple::SimulatedResponder responder(clock, model, seed);
+    responder.Reserve(static_cast<size_t>(session.config.trialCount));
+    return purple::RunTrialLoop(session, clock, display, responder) == purple::SessionOutcome::Completed;
+}
+
+// Mean or median of the valid reactions of a long unstopped session.
+double PopulationValue(const purple::Session& session, purple::PrecisionStatistic statistic)
+{
+    std::vector<double> valid;
+    valid.reserve(session.results.size());
+    for (const purple::TrialResult& result : session.results)
+    {
+        if (!result.falseStart)
+        {
+            valid.push_back(result.reactionMs);
+        }
+    }
+    if (valid.empty())
+    {
+        return 0.0;
+    }
+    if (statistic == purple::PrecisionStatistic::Median)
+    {
+        std::sort(valid.begin(), valid.end());
+        const size_t n = valid.size();
+        return n % 2 == 1 ? valid[n / 2] : (valid[n / 2 - 1] + valid[n / 2]) / 2.0;
+    }
+    double sum = 0.0;
+    for (const double value : valid)
+    {
+        sum += value;
+    }
+    return sum / static_cast<double>(valid.size());
+}
+
+struct StoppingTally
+{
+    int sessions = 0;
+    int incomplete = 0;
+    int precisionStops = 0;
+    int covered = 0;                // precision stops whose interval covers the population value
+    int ruleViolations = 0;         // precision stops above the target or below the minimum
+    int countMismatches = 0;        // trial-count ends short of the maximum, or runs past it
+    int estimateMismatches = 0;     // mean estimates that differ from RunningStats
+    long long trials = 0;
+    long long precisionTrials = 0;
+};
+
+void RunStatistic(const StoppingOptions& options, purple::PrecisionStatistic statistic, double truth, StoppingTally& tally)
+{
+    StoppingOptions local = options;
+    local.rule.statistic = statistic;
+    for (int i = 0; i < options.sessions; ++i)
+    {
+        const std::uint64_t seed = options.seed + 2 * static_cast<std::uint64_t>(i + 1);
+        purple::Session session = MakeSession(local, options.maxTrials, seed, true);
+        ++tally.sessions;
+        if (!RunSession(session, options.model, seed + 1))
+        {
+            ++tally.incomplete;
+            continue;
+        }
+
+        const purple::StoppingReport report = purple::MakeStoppingReport(session);
+        tally.trials += report.trials;
+        if (report.reason == purple::StopReason::Precision)
+        {
+            ++tally.precisionStops;
+            tally.precisionTrials += report.trials;
+            tally.covered += std::fabs(report.estimateMs - truth) <= report.halfWidthMs ? 1 : 0;
+            tally.ruleViolations += report.halfWidthMs <= options.rule.halfWidthMs &&
+                report.validTrials >= static_cast<size_t>(options.rule.minValidTrials) ? 0 : 1;
+            tally.countMismatches += report.trials < options.maxTrials ? 0 : 1;
+        }
+        else
+        {
+            tally.countMismatches += report.reason == purple::StopReason::TrialCount && report.trials == options.maxTrials ? 0 : 1;
+        }
+        tally.countMismatches += static_cast<size_t>(report.trials) == session.results.size() ? 0 : 1;
+        if (statistic == purple::PrecisionStatistic::Mean)
+        {
+            const purple::ReactionSummary summary = session.stats.QuickSummary();
+            tally.estimateMismatches += summary.validCount == report.validTrials &&
+                std::fabs(summary.meanMs - report.estimateMs) < 1e-6 ? 0 : 1;
+        }
+    }
+}
+
+// PrecisionEstimator::Add plus the HalfWidthMs check FinishTrial makes after it, over back-to-back sessions
+// of `sessionTrials` ex-Gaussian reactions, in ns per reaction.
+double MeasureAddNs(purple::PrecisionStatistic statistic, size_t count, size_t sessionTrials)
+{
+    const std::vector<double> values = bench::ExGaussianSample(count, 7);
+
+    purple::PrecisionEstimator estimator;
+    estimator.Reset(statistic, 0.95);
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    volatile double sink = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i % sessionTrials == 0)
+        {
+            estimator.Reset(statistic, 0.95);
+        }
+        estimator.Add(values[i]);
+        sink = estimator.HalfWidthMs();
+    }
+    const double seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+    (void)sink;
+    return seconds * 1e9 / static_cast<double>(count);
+}
+
+bool ParseOptions(int argc, char** argv, StoppingOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = hasValue;
+        if (std::strcmp(arg, "--sessions") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.sessions) && options.sessions > 0;
+        }
+        else if (std::strcmp(arg, "--max-trials") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.maxTrials) && options.maxTrials > 0;
+        }
+        else if (std::strcmp(arg, "--truth-trials") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.truthTrials) && options.truthTrials > 0;
+        }
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue)
+        {
+            int seed = 0;
+            ok = purple::TryParseIntNarrow(argv[++i], seed);
+            options.seed = static_cast<std::uint64_t>(seed);
+        }
+        else if (std::strcmp(arg, "--stop-ci-ms") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.rule.halfWidthMs) && options.rule.halfWidthMs > 0.0;
+        }
+        else if (std::strcmp(arg, "--min-trials") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], options.rule.minValidTrials) && options.rule.minValidTrials >= 2;
+        }
+        else if (std::strcmp(arg, "--miss") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], options.model.missProbability);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+namespace bench
+{
+int RunStoppingBench(int argc, char** argv)
+{
+    StoppingOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::printf(
+            "Usage: purple_bench stopping [--sessions n] [--max-trials n] [--truth-trials n] [--seed n]\n"
+            "         [--stop-ci-ms ms] [--min-trials n] [--miss p]\n");
+        return 1;
+    }
+
+    purple::Session population = MakeSession(options, options.truthTrials, options.seed, false);
+    if (!RunSession(population, options.model, options.seed + 1))
+    {
+        std::printf("population session did not complete\n");
+        return 2;
+    }
+
+    std::printf("Stopping rule: %.1f ms half-width at %.0f%%, at least %d valid trials, at most %d trials; %d sessions\n",
+        options.rule.halfWidthMs,
+        options.rule.confidence * 100.0,
+        options.rule.minValidTrials,
+        options.maxTrials,
+        options.sessions);
+
+    bool ok = true;
+    char detail[160];
+    const purple::PrecisionStatistic statistics[] = {purple::PrecisionStatistic::Mean, purple::PrecisionStatistic::Median};
+    for (const purple::PrecisionStatistic statistic : statistics)
+    {
+        const double truth = PopulationValue(population, statistic);
+        StoppingTally tally;
+        RunStatistic(options, statistic, truth, tally);
+
+        const double stops = static_cast<double>(std::max(1, tally.precisionStops));
+        std::printf("%s (population %.3f ms): %d of %d stopped on precision, %.1f trials on average (%.1f%% of the maximum)\n",
+            purple::PrecisionStatisticName(statistic),
+            truth,
+            tally.precisionStops,
+            tally.sessions,
+            static_cast<double>(tally.trials) / std::max(1, tally.sessions),
+            100.0 * static_cast<double>(tally.trials) / (static_cast<double>(tally.sessions) * options.maxTrials));
+
+        std::snprintf(detail, sizeof(detail), "%d incomplete", tally.incomplete);
+        ok &= PrintCheck("sessions complete", tally.incomplete == 0, detail);
+        std::snprintf(detail, sizeof(detail), "%d of %d stops", tally.ruleViolations, tally.precisionStops);
+        ok &= PrintCheck("stops meet target and minimum", tally.ruleViolations == 0, detail);
+        std::snprintf(detail, sizeof(detail), "%d mismatches", tally.countMismatches);
+        ok &= PrintCheck("trial counts within the maximum", tally.countMismatches == 0, detail);
+        if (statistic == purple::PrecisionStatistic::Mean)
+        {
+            std::snprintf(detail, sizeof(detail), "%d sessions differ", tally.estimateMismatches);
+            ok &= PrintCheck("estimate agrees with RunningStats", tally.estimateMismatches == 0, detail);
+        }
+        // Stopping on the interval's width (not its position) keeps coverage near nominal, but the width is
+        // itself estimated and the rule stops where it came out narrow: 3 points of slack plus 4 standard errors.
+        if (tally.precisionStops > 0)
+        {
+            const double coverage = static_cast<double>(tally.covered) / stops;
+            const double nominal = options.rule.confidence;
+            const double floor = nominal - 0.03 - 4.0 * std::sqrt(nominal * (1.0 - nominal) / stops);
+            std::snprintf(detail, sizeof(detail), "%.4f of %d vs %.2f (floor %.4f)", coverage, tally.precisionStops, nominal, floor);
+            ok &= PrintCheck("CI coverage at precision stops", coverage >= floor, detail);
+        }
+    }
+
+    const size_t addCount = 1000000;
+    const size_t sessionTrials = static_cast<size_t>(options.maxTrials);
+    std::printf("PrecisionEstimator Add + HalfWidthMs over %zu-trial sessions: mean %.1f ns, median %.1f ns\n",
+        sessionTrials,
+        MeasureAddNs(purple::PrecisionStatistic::Mean, addCount, sessionTrials),
+        MeasureAddNs(purple::PrecisionStatistic::Median, addCount, sessionTrials));
+    return ok ? 0 : 2;
+}
+} // namespace bench
@@ -0,0 +1,298 @@
+#include "bench.h"
+
+#include "core/export.h"
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/session.h"
+#include "core/wait.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace
+{
+struct SuiteOptions
+{
+    std::string outputPath = "purple_bench_suite.json";
+    int waitIterations = 200;
+    int clockBatches = 20000;
+    int loopTrials = 40;
+    int exportTrials = 100000;
+    int exportRepeats = 20;
+};
+
+// One machine-readable result line: a sample distribution plus identifying fields.
+class ResultWriter
+{
+public:
+    explicit ResultWriter(std::FILE* out)
+        : out_(out)
+    {
+    }
+
+    void Begin(const char* name, const char* unit)
+    {
+        std::fprintf(out_, "%s\n    {\"name\": \"%s\", \"unit\": \"%s\"", count_ == 0 ? "" : ",", name, unit);
+        ++count_;
+    }
+
+    void Field(const char* key, double value) { std::fprintf(out_, ", \"%s\": %.6f", key, value); }
+    void Field(const char* key, const char* value) { std::fprintf(out_, ", \"%s\": \"%s\"", key, value); }
+    void Count(const char* key, size_t value) { std::fprintf(out_, ", \"%s\": %zu", key, value); }
+
+    // Sorts `samples` and writes samples/p50/p99/p99_9/max.
+    void Distribution(std::vector<double>& samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        Count("samples", samples.size());
+        Field("p50", bench::SortedPercentile(samples, 50.0));
+        Field("p99", bench::SortedPercentile(samples, 99.0));
+        Field("p99_9", bench::SortedPercentile(samples, 99.9));
+        Field("max", samples.empty() ? 0.0 : samples.back());
+    }
+
+    void End() { std::fprintf(out_, "}"); }
+
+private:
+    std::FILE* out_;
+    size_t count_ = 0;
+};
+
+// Foreperiod wait engine overshoot past the deadline, per target delay.
+void MeasureWaitOvershoot(purple::MonotonicClock& clock, const SuiteOptions& options, ResultWriter& writer)
+{
+    purple::WaitConfig config;
+    purple::ForeperiodWaiter<purple::MonotonicClock> waiter(clock, config);
+    waiter.Calibrate();
+
+    const purple::Ticks freq = clock.Frequency();
+    static constexpr double kTargetsMs[] = {0.5, 1.0, 2.0, 5.0, 10.0, 20.0, 50.0};
+    std::vector<double> overshootUs;
+    for (const double targetMs : kTargetsMs)
+    {
+        overshootUs.clear();
+        for (int i = 0; i < options.waitIterations; ++i)
+        {
+            const purple::Ticks deadline = clock.Now() + purple::SecondsToTicks(targetMs / 1000.0, freq);
+            while (!waiter.WaitStep(deadline))
+            {
+            }
+            overshootUs.push_back(purple::TicksToMilliseconds(waiter.LastOvershootTicks(), freq) * 1000.0);
+        }
+
+        writer.Begin("wait_overshoot", "us");
+        writer.Field("target_ms", targetMs);
+        writer.Field("spin_budget_us", config.spinBudgetSeconds * 1000000.0);
+        writer.Distribution(overshootUs);
+        writer.End();
+    }
+}
+
+// Cost of one Clock::Now(), from batches of back-to-back reads (so the distribution is per-call averages
+// over a batch; single reads are below the clock's own resolution).
+void MeasureClockRead(purple::MonotonicClock& clock, const SuiteOptions& options, ResultWriter& writer)
+{
+    constexpr int kReadsPerBatch = 64;
+    const purple::Ticks freq = clock.Frequency();
+    std::vector<double> perCallNs;
+    perCallNs.reserve(static_cast<size_t>(options.clockBatches));
+
+    volatile purple::Ticks sink = 0;
+    for (int batch = 0; batch < options.clockBatches; ++batch)
+    {
+        const purple::Ticks start = clock.Now();
+        for (int i = 0; i < kReadsPerBatch; ++i)
+        {
+            sink = clock.Now();
+        }
+        const purple::Ticks end = clock.Now();
+        perCallNs.push_back(purple::TicksToSeconds(end - start, freq) * 1e9 / kReadsPerBatch);
+    }
+    (void)sink;
+
+    writer.Begin("clock_read", "ns");
+    writer.Count("reads_per_batch", kReadsPerBatch);
+    writer.Distribution(perCallNs);
+    writer.End();
+}
+
+// Input policy that timestamps every loop iteration (Pump runs once per iteration) and answers each
+// stimulus after a fixed latency. Gap buffers are reserved up front so recording does not allocate.
+class GapProbeInput
+{
+public:
+    GapProbeInput(purple::MonotonicClock& clock, size_t capacity)
+        : clock_(clock),
+          latencyTicks_(purple::SecondsToTicks(0.02, clock.Frequency()))
+    {
+        foreperiodGaps_.reserve(capacity);
+        responseGaps_.reserve(capacity);
+    }
+
+    void Pump(purple::Session& session)
+    {
+        const purple::Ticks now = clock_.Now();
+        const bool waiting =
+            session.phase == purple::Phase::WaitingForStimulus || session.phase == purple::Phase::WaitingForResponse;
+        if (last_ != 0 && waiting)
+        {
+            const double gapUs = purple::TicksToMilliseconds(now - last_, clock_.Frequency()) * 1000.0;
+            std::vector<double>& gaps =
+                session.phase == purple::Phase::WaitingForStimulus ? foreperiodGaps_ : responseGaps_;
+            if (gaps.size() < gaps.capacity())
+            {
+                gaps.push_back(gapUs);
+            }
+        }
+        last_ = now;
+
+        if (session.phase == purple::Phase::WaitingForResponse && !session.hasInput &&
+            now >= session.stimulusTicks + latencyTicks_)
+        {
+            purple::RecordPress(session, now);
+        }
+    }
+
+    std::vector<double>& ForeperiodGaps() { return foreperiodGaps_; }
+    std::vector<double>& ResponseGaps() { return responseGaps_; }
+
+private:
+    purple::MonotonicClock& clock_;
+    purple::Ticks latencyTicks_;
+    purple::Ticks last_ = 0;
+    std::vector<double> foreperiodGaps_;
+    std::vector<double> responseGaps_;
+};
+
+// Gap between consecutive trial-loop iterations of a headless run, split by phase: the foreperiod
+// sleeps in poll-interval steps, the response phase should turn around in microseconds.
+void MeasureLoopGap(purple::MonotonicClock& clock, const SuiteOptions& options, ResultWriter& writer)
+{
+    purple::Session session;
+    session.config.trialCount = options.loopTrials;
+    session.config.minDelaySeconds = 0.02;
+    session.config.maxDelaySeconds = 0.05;
+    session.config.logTrials = false;
+    purple::ResetSessionState(session);
+
+    purple::NullDisplay display;
+    GapProbeInput input(clock, 2000000);
+    purple::RunTrialLoop(session, clock, display, input);
+
+    writer.Begin("loop_gap", "us");
+    writer.Field("phase", "foreperiod");
+    writer.Field("poll_interval_us", session.config.wait.pollIntervalSeconds * 1000000.0);
+    writer.Distribution(input.ForeperiodGaps());
+    writer.End();
+
+    writer.Begin("loop_gap", "us");
+    writer.Field("phase", "response");
+    writer.Distribution(input.ResponseGaps());
+    writer.End();
+}
+
+// Wall time of one CSV+JSON export of a synthetic session.
+void MeasureExport(purple::MonotonicClock& clock, const SuiteOptions& options, ResultWriter& writer)
+{
+    const std::vector<purple::TrialResult> results = bench::MakeSyntheticResults(static_cast<size_t>(options.exportTrials));
+    const purple::RunningStats stats = purple::ComputeRunningStats(results);
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string csv = (dir / "purple_bench_suite_export.csv").string();
+    const std::string json = (dir / "purple_bench_suite_export.json").string();
+
+    std::vector<double> runMs;
+    for (int r = 0; r < options.exportRepeats; ++r)
+    {
+        const purple::Ticks start = clock.Now();
+        purple::ExportResults(results, stats, csv, json);
+        runMs.push_back(purple::TicksToMilliseconds(clock.Now() - start, clock.Frequency()));
+    }
+    const double megabytes = static_cast<double>(std::filesystem::file_size(csv) + std::filesystem::file_size(json)) / 1e6;
+
+    std::error_code ignored;
+    std::filesystem::remove(csv, ignored);
+    std::filesystem::remove(json, ignored);
+
+    writer.Begin("export", "ms");
+    writer.Count("trials", results.size());
+    writer.Field("megabytes", megabytes);
+    writer.Distribution(runMs);
+    writer.Field("p50_mb_per_s", megabytes / (bench::SortedPercentile(runMs, 50.0) / 1000.0));
+    writer.End();
+}
+} // namespace
+
+namespace bench
+{
+int RunSuiteBench(int argc, char** argv)
+{
+    SuiteOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            options.outputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--quick") == 0)
+        {
+            options.waitIterations = 20;
+            options.clockBatches = 2000;
+            options.loopTrials = 5;
+            options.exportTrials = 10000;
+            options.exportRepeats = 5;
+        }
+        else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], options.waitIterations))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            std::printf("Usage: purple_bench suite [--out path] [--quick] [--iterations n]\n");
+            return 1;
+        }
+    }
+
+    // A file rather than stdout: the export step prints its own status lines.
+    std::FILE* out = std::fopen(options.outputPath.c_str(), "w");
+    if (out == nullptr)
+    {
+        std::printf("Failed to open output path: %s\n", options.outputPath.c_str());
+        return 2;
+    }
+
+    purple::MonotonicClock clock;
+    std::fprintf(out, "{\n  \"suite\": \"purple_bench\",\n  \"schema_version\": 1,\n");
+#if defined(_WIN32)
+    std::fprintf(out, "  \"platform\": \"windows\",\n");
+#else
+    std::fprintf(out, "  \"platform\": \"posix\",\n");
+#endif
+    std::fprintf(out, "  \"tick_frequency\": %lld,\n  \"results\": [", static_cast<long long>(clock.Frequency()));
+
+    ResultWriter writer(out);
+    std::printf("clock read cost...\n");
+    MeasureClockRead(clock, options, writer);
+    std::printf("wait overshoot sweep...\n");
+    MeasureWaitOvershoot(clock, options, writer);
+    std::printf("trial loop gaps (%d headless trials)...\n", options.loopTrials);
+    MeasureLoopGap(clock, options, writer);
+    std::printf("export throughput (%d trials x %d)...\n", options.exportTrials, options.exportRepeats);
+    MeasureExport(clock, options, writer);
+
+    std::fprintf(out, "\n  ]\n}\n");
+    const bool ok = std::ferror(out) == 0;
+    if (std::fclose(out) != 0 || !ok)
+    {
+        std::printf("Failed while writing %s\n", options.outputPath.c_str());
+        return 2;
+    }
+    std::printf("Suite results written: %s\n", options.outputPath.c_str());
+    return 0;
+}
+} // namespace bench
@@ -0,0 +1,376 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/simulate.h"
+#include "core/telemetry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+struct TelemetryBenchOptions
+{
+    int readers = 4;
+    int publishes = 1000000;  // per Publish cost measurement
+    int trials = 20000;       // simulated session
+};
+
+// Synthetic snapshot k: every field derives from k, so a reader that mixes two publishes sees fields that
+// disagree.
+void FillSynthetic(purple::TelemetrySnapshot& snapshot, std::int64_t k)
+{
+    snapshot.runs = k;
+    snapshot.trialIndex = k;
+    snapshot.trialCount = k + 1;
+    snapshot.validCount = 3 * k;
+    snapshot.falseStartCount = k ^ 0x5555;
+    snapshot.lastReactionMs = 0.5 * static_cast<double>(k);
+    snapshot.meanMs = 0.25 * static_cast<double>(k);
+    snapshot.maxMs = static_cast<double>(k) + 0.75;
+    snapshot.loopIterations = static_cast<std::uint64_t>(k) * 7;
+    snapshot.logDropped = ~static_cast<std::uint64_t>(k);
+}
+
+bool SyntheticConsistent(const purple::TelemetrySnapshot& snapshot)
+{
+    purple::TelemetrySnapshot expected;
+    FillSynthetic(expected, snapshot.trialIndex);
+    return snapshot.runs == expected.runs && snapshot.trialCount == expected.trialCount &&
+        snapshot.validCount == expected.validCount && snapshot.falseStartCount == expected.falseStartCount &&
+        snapshot.lastReactionMs == expected.lastReactionMs && snapshot.meanMs == expected.meanMs &&
+        snapshot.maxMs == expected.maxMs && snapshot.loopIterations == expected.loopIterations &&
+        snapshot.logDropped == expected.logDropped;
+}
+
+// What the session hooks guarantee in every snapshot they publish.
+bool SessionConsistent(const purple::TelemetrySnapshot& snapshot)
+{
+    const bool counts = snapshot.validCount + snapshot.falseStartCount == snapshot.trialIndex &&
+        snapshot.trialIndex <= snapshot.trialCount && snapshot.trialIndex >= 0;
+    const bool range = snapshot.validCount == 0 ||
+        (snapshot.minMs <= snapshot.meanMs && snapshot.meanMs <= snapshot.maxMs && snapshot.minMs <= snapshot.p50Ms &&
+            snapshot.p50Ms <= snapshot.p90Ms && snapshot.p90Ms <= snapshot.maxMs);
+    return counts && range && (snapshot.running == 1 || snapshot.outcome >= 0 || snapshot.runs == 0);
+}
+
+// Publish cost call by call on the real clock, with the snapshot changing every time.
+std::vector<double> TimePublishes(purple::TelemetryWriter& writer, int publishes, std::int64_t& next)
+{
+    purple::MonotonicClock clock;
+    const double nsPerTick = 1e9 / static_cast<double>(clock.Frequency());
+    std::vector<double> ns(static_cast<size_t>(publishes));
+    purple::TelemetrySnapshot snapshot;
+    for (double& sample : ns)
+    {
+        FillSynthetic(snapshot, next++);
+        const purple::Ticks t0 = clock.Now();
+        writer.Publish(snapshot);
+        sample = static_cast<double>(clock.Now() - t0) * nsPerTick;
+    }
+    return ns;
+}
+
+// Seeded virtual-clock session, optionally publishing to `writer`; returns the session's wall time.
+double RunSession(purple::Session& session, int trials, purple::TelemetryWriter* writer)
+{
+    session.config.trialCount = trials;
+    session.config.logTrials = false;
+    session.config.wait.spinBudgetSeconds = 0.0;
+    session.config.wait.pollIntervalSeconds = 3600.0;
+    session.config.foreperiod.seeded = true;
+    session.config.foreperiod.seed = 20260301;
+    session.telemetry = writer;
+    purple::ResetSessionState(session);
+
+    purple::VirtualClock clock;
+    purple::NullDisplay display;
+    purple::SimulatedResponder responder(clock, purple::ResponderModel{}, 7);
+    responder.Reserve(static_cast<size_t>(trials));
+    purple::MonotonicClock wall;
+    const purple::Ticks start = wall.Now();
+    purple::RunTrialLoop(session, clock, display, responder);
+    return purple::TicksToSeconds(wall.Now() - start, wall.Frequency());
+}
+
+#if !defined(_WIN32)
+constexpr int kMaxReaders = 64;
+
+struct ReaderTally
+{
+    unsigned long long reads = 0;
+    unsigned long long failed = 0;       // Read gave up or found nothing
+    unsigned long long inconsistent = 0; // snapshot fields from different publishes
+    unsigned long long regressions = 0;  // `publishes` went backwards
+    unsigned long long retries = 0;
+    double seconds = 0.0;
+};
+
+// Shared with the reader processes (MAP_SHARED | MAP_ANONYMOUS, inherited across fork).
+struct ReaderControl
+{
+    std::atomic<int> ready{0};
+    std::atomic<int> stop{0};
+    ReaderTally tallies[kMaxReaders];
+};
+
+// Reader process: polls as fast as it can until told to stop.
+void ReaderMain(const std::string& name, bool session, ReaderControl& control, ReaderTally& tally)
+{
+    purple::TelemetryReader reader;
+    const bool opened = reader.Open(name);
+    control.ready.fetch_add(1, std::memory_order_acq_rel);
+    if (!opened)
+    {
+        tally.failed = 1;
+        return;
+    }
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    std::uint64_t lastPublishes = 0;
+    purple::TelemetrySnapshot snapshot;
+    while (control.stop.load(std::memory_order_acquire) == 0)
+    {
+        if (!reader.Read(snapshot))
+        {
+            ++tally.failed;
+            continue;
+        }
+        ++tally.reads;
+        tally.inconsistent += (session ? SessionConsistent(snapshot) : SyntheticConsistent(snapshot)) ? 0 : 1;
+        tally.regressions += snapshot.publishes < lastPublishes ? 1 : 0;
+        lastPublishes = snapshot.publishes;
+    }
+    tally.retries = reader.Retries();
+    tally.seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+}
+
+class ReaderPool
+{
+public:
+    ReaderPool()
+    {
+        void* shared = mmap(nullptr, sizeof(ReaderControl), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        control_ = shared != MAP_FAILED ? new (shared) ReaderControl() : nullptr;
+    }
+
+    ~ReaderPool()
+    {
+        Stop();
+        if (control_ != nullptr)
+        {
+            munmap(control_, sizeof(ReaderControl));
+        }
+    }
+
+    // Forks `count` readers and waits until every one has mapped the block.
+    bool Start(const std::string& name, bool session, int count)
+    {
+        if (control_ == nullptr)
+        {
+            return false;
+        }
+        control_->ready.store(0);
+        control_->stop.store(0);
+        for (int i = 0; i < count; ++i)
+        {
+            control_->tallies[i] = ReaderTally{};
+            const pid_t child = fork();
+            if (child == 0)
+            {
+                ReaderMain(name, session, *control_, control_->tallies[i]);
+                _exit(0);
+            }
+            if (child < 0)
+            {
+                return false;
+            }
+            children_.push_back(child);
+        }
+        while (control_->ready.load(std::memory_order_acquire) < count)
+        {
+            sched_yield();
+        }
+        return true;
+    }
+
+    // Stops the readers and sums their tallies; false when one did not exit cleanly.
+    bool Stop(ReaderTally* total = nullptr)
+    {
+        if (control_ == nullptr)
+        {
+            return false;
+        }
+        control_->stop.store(1, std::memory_order_release);
+        bool clean = true;
+        for (const pid_t child : children_)
+        {
+            int status = 0;
+            clean = waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0 && clean;
+        }
+        if (total != nullptr)
+        {
+            *total = ReaderTally{};
+            for (size_t i = 0; i < children_.size(); ++i)
+            {
+                const ReaderTally& tally = control_->tallies[i];
+                total->reads += tally.reads;
+                total->failed += tally.failed;
+                total->inconsistent += tally.inconsistent;
+                total->regressions += tally.regressions;
+                total->retries += tally.retries;
+                total->seconds = std::max(total->seconds, tally.seconds);
+            }
+        }
+        children_.clear();
+        return clean;
+    }
+
+private:
+    ReaderControl* control_ = nullptr;
+    std::vector<pid_t> children_;
+};
+
+bool CheckReaders(const char* what, const ReaderTally& total, bool clean, int readers)
+{
+    char name[64];
+    char detail[160];
+    std::snprintf(detail, sizeof(detail), "%llu reads, %.1f M reads/s per reader, %llu retries",
+        total.reads,
+        total.seconds > 0.0 ? static_cast<double>(total.reads) / readers / total.seconds / 1e6 : 0.0,
+        total.retries);
+    std::snprintf(name, sizeof(name), "%s: readers exited cleanly", what);
+    bool ok = bench::PrintCheck(name, clean && total.reads > 0, detail, 38);
+    std::snprintf(detail, sizeof(detail), "%llu torn, %llu out of order", total.inconsistent, total.regressions);
+    std::snprintf(name, sizeof(name), "%s: every snapshot consistent", what);
+    ok &= bench::PrintCheck(name, total.inconsistent == 0 && total.regressions == 0, detail, 38);
+    return ok;
+}
+#endif
+} // namespace
+
+namespace bench
+{
+int RunTelemetryBench(int argc, char** argv)
+{
+    TelemetryBenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        int* target = nullptr;
+        if (std::strcmp(argv[i], "--readers") == 0 && hasValue)
+        {
+            target = &options.readers;
+        }
+        else if (std::strcmp(argv[i], "--publishes") == 0 && hasValue)
+        {
+            target = &options.publishes;
+        }
+        else if (std::strcmp(argv[i], "--trials") == 0 && hasValue)
+        {
+            target = &options.trials;
+        }
+        if (target == nullptr || !purple::TryParseIntNarrow(argv[++i], *target) || options.readers > 64)
+        {
+            std::printf("Usage: purple_bench telemetry [--readers n (max 64)] [--publishes n] [--trials n]\n");
+            return 1;
+        }
+    }
+
+#if defined(_WIN32)
+    const std::string name = "bench";
+#else
+    const std::string name = "bench-" + std::to_string(getpid());
+#endif
+    purple::TelemetryWriter writer;
+    if (!writer.Open(name))
+    {
+        std::printf("Could not create telemetry block %s\n", name.c_str());
+        return 1;
+    }
+
+    std::int64_t next = 1;
+    std::printf("Publish cost, %d snapshots of %zu bytes (ns):\n", options.publishes, sizeof(purple::TelemetrySnapshot));
+    std::printf("  %-24s %9s %9s %9s %11s\n", "", "p50", "p99", "p99.9", "max");
+    std::vector<double> alone = TimePublishes(writer, options.publishes, next);
+    ReportLatency("no readers", alone, 24);
+
+    char detail[160];
+    bool ok = true;
+#if defined(_WIN32)
+    std::printf("Reader processes: needs fork(); run it on Linux.\n");
+#else
+    ReaderPool pool;
+    ReaderTally total;
+    bool started = pool.Start(name, false, options.readers);
+    std::vector<double> contended = TimePublishes(writer, options.publishes, next);
+    bool clean = pool.Stop(&total) && started;
+    char label[64];
+    std::snprintf(label, sizeof(label), "%d polling readers", options.readers);
+    ReportLatency(label, contended, 24);
+    ok &= CheckReaders("synthetic", total, clean, options.readers);
+#endif
+
+    // A real trial loop publishing through the session hooks, timed without and with telemetry.
+    purple::Session plain;
+    const double plainSeconds = RunSession(plain, options.trials, nullptr);
+    purple::Session unread;
+    const double unreadSeconds = RunSession(unread, options.trials, &writer);
+    purple::Session session;
+    purple::TelemetrySnapshot idle;  // the block as a fresh writer leaves it, before the run starts
+    writer.Publish(idle);
+#if !defined(_WIN32)
+    started = pool.Start(name, true, options.readers);
+#endif
+    const double telemetrySeconds = RunSession(session, options.trials, &writer);
+#if !defined(_WIN32)
+    clean = pool.Stop(&total) && started;
+#endif
+    // On a machine with fewer cores than readers + 1, the last figure mostly measures the readers' CPU share.
+    std::printf("Simulated session, %d trials: %.0f trials/s plain, %.0f publishing, %.0f publishing to %d readers\n",
+        options.trials,
+        options.trials / plainSeconds,
+        options.trials / unreadSeconds,
+        options.trials / telemetrySeconds,
+        options.readers);
+#if !defined(_WIN32)
+    ok &= CheckReaders("session", total, clean, options.readers);
+#endif
+
+    // The last snapshot describes the finished run exactly.
+    purple::TelemetryReader reader;
+    purple::TelemetrySnapshot last;
+    const purple::ReactionSummary summary = session.stats.QuickSummary();
+    const purple::TrialResult& lastTrial = session.results.back();
+    const bool read = reader.Open(name) && reader.Read(last);
+    const bool matches = read && last.running == 0 && last.outcome == static_cast<int>(purple::SessionOutcome::Completed) &&
+        last.trialIndex == options.trials && last.trialCount == options.trials &&
+        last.validCount == static_cast<std::int64_t>(summary.validCount) &&
+        last.falseStartCount == static_cast<std::int64_t>(summary.falseStartCount) && last.meanMs == summary.meanMs &&
+        last.sdMs == summary.sdMs && last.p90Ms == summary.p90Ms &&
+        last.lastResult == (lastTrial.falseStart ? 2 : 1) &&
+        (lastTrial.falseStart || last.lastReactionMs == lastTrial.reactionMs);
+    std::snprintf(detail, sizeof(detail), "%lld valid, mean %.3f ms, %lld publishes", static_cast<long long>(last.validCount),
+        last.meanMs, static_cast<long long>(last.publishes));
+    ok &= PrintCheck("final snapshot matches the session", matches, detail, 38);
+    ok &= PrintCheck("plain session results unchanged",
+        plain.results.size() == session.results.size() &&
+            std::equal(plain.results.begin(), plain.results.end(), session.results.begin(),
+                [](const purple::TrialResult& a, const purple::TrialResult& b) { return a.reactionMs == b.reactionMs; }),
+        "", 38);
+    return ok ? 0 : 2;
+}
+} // namespace bench
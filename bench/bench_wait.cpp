@@ -0,0 +1,135 @@
+#include "bench.h"
+
+#include "core/headless.h"
+#include "core/parse.h"
+#include "core/wait.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+struct WaitSample
+{
+    std::vector<double> overshootUs;
+    double cpuSeconds = 0.0;
+    double wallSeconds = 0.0;
+};
+
+// The pre-engine strategy: Sleep(1) until 3 ms remain, then yield until the deadline.
+purple::Ticks LegacyWait(purple::MonotonicClock& clock, purple::Ticks deadline)
+{
+    const purple::Ticks freq = clock.Frequency();
+    for (;;)
+    {
+        const purple::Ticks now = clock.Now();
+        if (now >= deadline)
+        {
+            return now - deadline;
+        }
+        if (purple::TicksToSeconds(deadline - now, freq) > 0.003)
+        {
+            clock.SleepUntil(now + freq / 1000);
+        }
+        else
+        {
+            clock.YieldThread();
+        }
+    }
+}
+
+template <typename WaitFn>
+WaitSample Measure(purple::MonotonicClock& clock, double targetSeconds, int iterations, WaitFn&& wait)
+{
+    WaitSample sample;
+    sample.overshootUs.reserve(static_cast<size_t>(iterations));
+
+    const purple::Ticks freq = clock.Frequency();
+    const double cpuStart = bench::ThreadCpuSeconds();
+    const purple::Ticks wallStart = clock.Now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        const purple::Ticks deadline = clock.Now() + purple::SecondsToTicks(targetSeconds, freq);
+        const purple::Ticks overshoot = wait(deadline);
+        sample.overshootUs.push_back(purple::TicksToMilliseconds(overshoot, freq) * 1000.0);
+    }
+    sample.wallSeconds = purple::TicksToSeconds(clock.Now() - wallStart, freq);
+    sample.cpuSeconds = bench::ThreadCpuSeconds() - cpuStart;
+
+    std::sort(sample.overshootUs.begin(), sample.overshootUs.end());
+    return sample;
+}
+
+void PrintRow(const char* strategy, double targetMs, const WaitSample& sample)
+{
+    std::printf("%-8s %9.2f %10.1f %10.1f %10.1f %8.1f%%\n",
+        strategy,
+        targetMs,
+        bench::SortedPercentile(sample.overshootUs, 50.0),
+        bench::SortedPercentile(sample.overshootUs, 99.0),
+        sample.overshootUs.empty() ? 0.0 : sample.overshootUs.back(),
+        sample.wallSeconds > 0.0 ? 100.0 * sample.cpuSeconds / sample.wallSeconds : 0.0);
+}
+} // namespace
+
+namespace bench
+{
+int RunWaitBench(int argc, char** argv)
+{
+    int iterations = 50;
+    purple::WaitConfig config;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], iterations))
+            {
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--spin-us") == 0 && i + 1 < argc)
+        {
+            double spinUs = 0.0;
+            if (!purple::TryParseDoubleNarrow(argv[++i], spinUs) || spinUs < 0.0)
+            {
+                return 1;
+            }
+            config.spinBudgetSeconds = spinUs / 1000000.0;
+        }
+        else
+        {
+            std::printf("Usage: purple_bench wait [--iterations n] [--spin-us microseconds]\n");
+            return 1;
+        }
+    }
+
+    purple::MonotonicClock clock;
+    purple::ForeperiodWaiter<purple::MonotonicClock> waiter(clock, config);
+    waiter.Calibrate();
+    std::printf("Calibrated spin lead: %.1f us (budget %.1f us)\n",
+        purple::TicksToMilliseconds(waiter.SpinLeadTicks(), clock.Frequency()) * 1000.0,
+        config.spinBudgetSeconds * 1000000.0);
+
+    std::printf("%-8s %9s %10s %10s %10s %9s\n", "strategy", "target_ms", "p50_us", "p99_us", "max_us", "cpu");
+    static constexpr double kTargetsMs[] = {0.5, 1.0, 2.0, 5.0, 10.0, 20.0};
+    for (const double targetMs : kTargetsMs)
+    {
+        const WaitSample engine = Measure(clock, targetMs / 1000.0, iterations, [&](purple::Ticks deadline)
+        {
+            while (!waiter.WaitStep(deadline))
+            {
+            }
+            return waiter.LastOvershootTicks();
+        });
+        PrintRow("engine", targetMs, engine);
+
+        const WaitSample legacy = Measure(clock, targetMs / 1000.0, iterations, [&](purple::Ticks deadline)
+        {
+            return LegacyWait(clock, deadline);
+        });
+        PrintRow("legacy", targetMs, legacy);
+    }
+    return 0;
+}
+} // namespace bench
@@ -0,0 +1,335 @@
+#include "core/aggregate.h"
+#include "core/buffered_writer.h"
+#include "core/headless.h"
+#include "core/parse.h"
+
+#include <cstdio>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct AggregateCliOptions
+{
+    purple::AggregateOptions aggregate;
+    bool perFile = false;
+    std::string csvOutputPath;
+    std::string distributionOutputPath;
+    std::vector<std::string> inputs;
+};
+
+void PrintUsage()
+{
+    std::printf("Usage: purple_aggregate [--threads n] [--group none|date|dir] [--group-regex pattern]\n");
+    std::printf("                        [--per-file] [--csv-out path] [--distribution-out path] [--bin-ms w]\n");
+    std::printf("                        file-or-directory...\n");
+    std::printf("Summarizes PurpleReaction results (CSV/JSON exports and columnar .prr files): pooled over all files,\n");
+    std::printf("per group, and with --per-file per file. Directories are searched recursively for *.csv, *.json and\n");
+    std::printf("*.prr; --journal files (.prj, interrupted ones too) are read when named directly. --group-regex\n");
+    std::printf("groups by the first capture group of the pattern in each file name.\n");
+    std::printf("--distribution-out writes the pooled trials' histograms (200 bins of --bin-ms, default 10, from\n");
+    std::printf("0 ms; 20 log bins per decade from 10 ms to 10 s), Gaussian KDE and ECDF as CSV.\n");
+}
+
+bool ParseArgs(int argc, char** argv, AggregateCliOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--threads") == 0 && hasValue)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], options.aggregate.threads))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--group") == 0 && hasValue)
+        {
+            const std::string value = argv[++i];
+            if (value == "none")
+            {
+                options.aggregate.grouping = purple::AggregateGrouping::None;
+            }
+            else if (value == "date")
+            {
+                options.aggregate.grouping = purple::AggregateGrouping::Date;
+            }
+            else if (value == "dir")
+            {
+                options.aggregate.grouping = purple::AggregateGrouping::Directory;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--group-regex") == 0 && hasValue)
+        {
+            options.aggregate.grouping = purple::AggregateGrouping::Regex;
+            options.aggregate.groupRegex = argv[++i];
+        }
+        else if (std::strcmp(arg, "--per-file") == 0)
+        {
+            options.perFile = true;
+        }
+        else if (std::strcmp(arg, "--csv-out") == 0 && hasValue)
+        {
+            options.csvOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--distribution-out") == 0 && hasValue)
+        {
+            options.distributionOutputPath = argv[++i];
+            options.aggregate.pooledDistribution = true;
+        }
+        else if (std::strcmp(arg, "--bin-ms") == 0 && hasValue)
+        {
+            if (!purple::TryParseDoubleNarrow(argv[++i], options.aggregate.distribution.binMs) ||
+                !(options.aggregate.distribution.binMs > 0.0))
+            {
+                return false;
+            }
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+double FalseStartRate(const purple::ReactionSummary& summary)
+{
+    return summary.trialCount == 0 ? 0.0
+                                   : static_cast<double>(summary.falseStartCount) / static_cast<double>(summary.trialCount);
+}
+
+void PrintSummaryHeader()
+{
+    std::printf("%-8s %-32s %6s %8s %8s %6s %9s %8s %9s %9s %9s %9s\n",
+        "scope", "name", "files", "trials", "valid", "fs%", "mean", "sd", "p50", "p90", "p99", "max");
+}
+
+void PrintSummaryRow(const char* scope, const std::string& name, size_t files, const purple::ReactionSummary& summary)
+{
+    std::printf("%-8s %-32s %6zu %8zu %8zu %6.2f %9.3f %8.3f %9.3f %9.3f %9.3f %9.3f\n",
+        scope,
+        name.c_str(),
+        files,
+        summary.trialCount,
+        summary.validCount,
+        100.0 * FalseStartRate(summary),
+        summary.meanMs,
+        summary.sdMs,
+        summary.p50Ms,
+        summary.p90Ms,
+        summary.p99Ms,
+        summary.maxMs);
+}
+
+void AppendCsvRow(purple::BufferedFileWriter& writer,
+    const char* scope,
+    const std::string& name,
+    size_t files,
+    const purple::ReactionSummary& summary)
+{
+    writer.AppendString(scope);
+    writer.Append(",");
+    writer.AppendString(name.c_str());
+    writer.Append(",");
+    writer.AppendUnsigned(files);
+    writer.Append(",");
+    writer.AppendUnsigned(summary.trialCount);
+    writer.Append(",");
+    writer.AppendUnsigned(summary.validCount);
+    writer.Append(",");
+    writer.AppendFixed6(FalseStartRate(summary));
+    for (const double value : {summary.meanMs,
+             summary.sdMs,
+             summary.minMs,
+             summary.p50Ms,
+             summary.p90Ms,
+             summary.p95Ms,
+             summary.p99Ms,
+             summary.maxMs,
+             summary.trimmedMeanMs,
+             summary.madMs})
+    {
+        writer.Append(",");
+        writer.AppendFixed6(value);
+    }
+    writer.Append("\n");
+}
+
+bool WriteCsv(const std::string& path, const purple::AggregateReport& report, bool perFile)
+{
+    purple::BufferedFileWriter writer;
+    if (!writer.Open(path))
+    {
+        return false;
+    }
+    writer.Append("scope,name,files,trials,valid,false_start_rate,mean_ms,sd_ms,min_ms,p50_ms,p90_ms,p95_ms,p99_ms,"
+                  "max_ms,trimmed_mean_ms,mad_ms\n");
+    AppendCsvRow(writer, "pooled", report.pooled.name, report.pooled.fileCount, report.pooled.summary);
+    for (const purple::GroupSummary& group : report.groups)
+    {
+        AppendCsvRow(writer, "group", group.name, group.fileCount, group.summary);
+    }
+    if (perFile)
+    {
+        for (const purple::FileSummary& file : report.files)
+        {
+            if (file.parsed)
+            {
+                AppendCsvRow(writer, "file", file.path, 1, file.summary);
+            }
+        }
+    }
+    return writer.Close();
+}
+
+// Histogram rows carry their bin's edges (none below the first or above the last) and count.
+void AppendHistogramRows(purple::BufferedFileWriter& writer,
+    const char* series,
+    const std::vector<double>& edges,
+    const std::vector<std::uint64_t>& bins)
+{
+    for (size_t b = 0; b < bins.size(); ++b)
+    {
+        writer.AppendString(series);
+        writer.Append(",");
+        if (b > 0)
+        {
+            writer.AppendFixed6(edges[b - 1]);
+        }
+        writer.Append(",");
+        if (b < edges.size())
+        {
+            writer.AppendFixed6(edges[b]);
+        }
+        writer.Append(",");
+        writer.AppendUnsigned(bins[b]);
+        writer.Append("\n");
+    }
+}
+
+void AppendCurveRows(purple::BufferedFileWriter& writer,
+    const char* series,
+    const std::vector<double>& grid,
+    const std::vector<double>& values)
+{
+    char text[32];
+    for (size_t i = 0; i < grid.size(); ++i)
+    {
+        writer.AppendString(series);
+        writer.Append(",");
+        writer.AppendFixed6(grid[i]);
+        writer.Append(",,");
+        const int length = std::snprintf(text, sizeof(text), "%.9g", values[i]);
+        writer.Append(text, static_cast<size_t>(length));
+        writer.Append("\n");
+    }
+}
+
+bool WriteDistributionCsv(const std::string& path, const purple::DistributionReport& distribution,
+    const purple::DistributionOptions& options)
+{
+    purple::BufferedFileWriter writer;
+    if (!writer.Open(path))
+    {
+        return false;
+    }
+    std::vector<double> edges(options.binCount + 1);
+    for (size_t b = 0; b <= options.binCount; ++b)
+    {
+        edges[b] = options.lowMs + static_cast<double>(b) * options.binMs;
+    }
+    writer.Append("series,x_ms,x_high_ms,value\n");
+    AppendHistogramRows(writer, "histogram", edges, distribution.bins);
+    AppendHistogramRows(writer, "log_histogram", distribution.logEdges, distribution.logBins);
+    AppendCurveRows(writer, "kde", distribution.grid, distribution.density);
+    AppendCurveRows(writer, "ecdf", distribution.grid, distribution.cdf);
+    return writer.Close();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    AggregateCliOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (options.aggregate.grouping == purple::AggregateGrouping::Regex)
+    {
+        try
+        {
+            std::regex check(options.aggregate.groupRegex);
+        }
+        catch (const std::regex_error&)
+        {
+            std::printf("Invalid --group-regex pattern: %s\n", options.aggregate.groupRegex.c_str());
+            return 1;
+        }
+    }
+
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    const std::vector<std::string> files = purple::CollectResultFiles(options.inputs);
+    if (files.empty())
+    {
+        std::printf("No result files found.\n");
+        return 1;
+    }
+    const purple::AggregateReport report = purple::AggregateResultFiles(files, options.aggregate);
+    const double seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+
+    PrintSummaryHeader();
+    PrintSummaryRow("pooled", report.pooled.name, report.pooled.fileCount, report.pooled.summary);
+    for (const purple::GroupSummary& group : report.groups)
+    {
+        PrintSummaryRow("group", group.name, group.fileCount, group.summary);
+    }
+    for (const purple::FileSummary& file : report.files)
+    {
+        if (!file.parsed)
+        {
+            std::printf("Could not read results: %s\n", file.path.c_str());
+        }
+        else if (options.perFile)
+        {
+            PrintSummaryRow("file", file.path, 1, file.summary);
+        }
+    }
+    std::printf("Aggregated %zu files in %.3f s; %zu failed.\n", files.size(), seconds, report.failedFiles);
+
+    if (!options.csvOutputPath.empty())
+    {
+        if (!WriteCsv(options.csvOutputPath, report, options.perFile))
+        {
+            std::printf("Failed to write CSV: %s\n", options.csvOutputPath.c_str());
+            return 2;
+        }
+        std::printf("Summary CSV written: %s\n", options.csvOutputPath.c_str());
+    }
+    if (!options.distributionOutputPath.empty())
+    {
+        if (!WriteDistributionCsv(options.distributionOutputPath, report.distribution, options.aggregate.distribution))
+        {
+            std::printf("Failed to write distribution CSV: %s\n", options.distributionOutputPath.c_str());
+            return 2;
+        }
+        std::printf("Distribution CSV written: %s (%s kernels, KDE bandwidth %.3f ms)\n",
+            options.distributionOutputPath.c_str(),
+            purple::SimdLevelName(purple::DetectSimdLevel()),
+            report.distribution.bandwidthMs);
+    }
+    return report.failedFiles == 0 ? 0 : 2;
+}
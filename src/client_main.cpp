@@ -0,0 +1,271 @@
+#include "core/event_stream.h"
+#include "core/foreperiod.h"
+#include "core/ipc.h"
+#include "core/parse.h"
+#include "core/telemetry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void PrintUsage()
+{
+    std::printf("Usage:\n");
+    std::printf("  purple_client <endpoint> run [--trials count] [--min-delay seconds] [--max-delay seconds]\n");
+    std::printf("                               [--spin-us microseconds] [--seed n]\n");
+    std::printf("                               [--foreperiod uniform|exponential|geometric]\n");
+    std::printf("  purple_client <endpoint> status|cancel|shutdown\n");
+    std::printf("  purple_client <endpoint> send <json-command>\n");
+    std::printf("  purple_client <name> telemetry [--interval ms] [--count n]\n");
+    std::printf("Prints every reply line. A run prints its events until the summary (exit 0) or abort (exit 3).\n");
+    std::printf("telemetry reads the shared-memory block of a runner started with --telemetry <name> and prints a\n");
+    std::printf("snapshot line every interval (default 500 ms) whenever it changed, forever unless --count is given.\n");
+}
+
+// Builds the command line for `run`; numeric values are passed through unchanged after validation, the
+// foreperiod name is quoted.
+bool BuildRunCommand(int argc, char** argv, std::string& command)
+{
+    command = "{\"cmd\": \"run\"";
+    for (int i = 0; i < argc; ++i)
+    {
+        const char* key = nullptr;
+        if (std::strcmp(argv[i], "--trials") == 0)
+        {
+            key = "trials";
+        }
+        else if (std::strcmp(argv[i], "--min-delay") == 0)
+        {
+            key = "min_delay";
+        }
+        else if (std::strcmp(argv[i], "--max-delay") == 0)
+        {
+            key = "max_delay";
+        }
+        else if (std::strcmp(argv[i], "--spin-us") == 0)
+        {
+            key = "spin_us";
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0)
+        {
+            key = "seed";
+        }
+        else if (std::strcmp(argv[i], "--foreperiod") == 0)
+        {
+            purple::ForeperiodDistribution distribution;
+            if (i + 1 >= argc || !purple::ParseForeperiodDistribution(argv[i + 1], distribution))
+            {
+                return false;
+            }
+            command += ", \"foreperiod\": \"";
+            command += argv[++i];
+            command += "\"";
+            continue;
+        }
+
+        double value = 0.0;
+        if (key == nullptr || i + 1 >= argc || !purple::TryParseDoubleNarrow(argv[i + 1], value))
+        {
+            return false;
+        }
+        command += ", \"";
+        command += key;
+        command += "\": ";
+        command += argv[++i];
+    }
+    command += "}";
+    return true;
+}
+
+// True when `line` is an event that ends the reply to `cmd`.
+bool IsFinalReply(const std::string& cmd, const std::string& line, int& exitCode)
+{
+    std::vector<purple::FlatJsonField> fields;
+    const purple::FlatJsonField* event = nullptr;
+    if (purple::ParseFlatJsonObject(line, fields))
+    {
+        event = purple::FindJsonField(fields, "event");
+    }
+    if (event == nullptr)
+    {
+        return false;
+    }
+    if (event->value == "error")
+    {
+        exitCode = 1;
+        return true;
+    }
+    if (cmd != "run")
+    {
+        return true;
+    }
+    if (event->value == "aborted")
+    {
+        exitCode = 3;
+        return true;
+    }
+    return event->value == "summary";
+}
+void PrintSnapshot(const purple::TelemetrySnapshot& snapshot)
+{
+    purple::StreamRecord record;
+    purple::NdjsonLineBuilder line(record, "telemetry");
+    line.Int("publishes", static_cast<std::int64_t>(snapshot.publishes));
+    line.Int("pid", snapshot.writerPid);
+    line.Int("runs", snapshot.runs);
+    line.Bool("running", snapshot.running != 0);
+    line.Int("outcome", snapshot.outcome);
+    line.Int("phase", snapshot.phase);
+    line.Int("trial", snapshot.trialIndex);
+    line.Int("trials", snapshot.trialCount);
+    line.Int("block", snapshot.blockIndex);
+    if (snapshot.lastResult == 1)
+    {
+        line.Number("last_rt_ms", snapshot.lastReactionMs);
+    }
+    else
+    {
+        line.Null("last_rt_ms");
+    }
+    line.Bool("last_false_start", snapshot.lastResult == 2);
+    line.Int("valid", snapshot.validCount);
+    line.Int("false_starts", snapshot.falseStartCount);
+    line.Number("mean_ms", snapshot.meanMs);
+    line.Number("sd_ms", snapshot.sdMs);
+    line.Number("min_ms", snapshot.minMs);
+    line.Number("max_ms", snapshot.maxMs);
+    line.Number("p50_ms", snapshot.p50Ms);
+    line.Number("p90_ms", snapshot.p90Ms);
+    line.Int("loop_iterations", static_cast<std::int64_t>(snapshot.loopIterations));
+    line.Number("max_response_gap_ms", snapshot.maxResponseGapMs);
+    line.Number("last_overshoot_ms", snapshot.lastOvershootMs);
+    line.Int("stream_dropped", static_cast<std::int64_t>(snapshot.streamDropped));
+    line.Int("log_dropped", static_cast<std::int64_t>(snapshot.logDropped));
+    line.End();
+    std::fwrite(record.text, 1, record.length, stdout);
+    std::fflush(stdout);
+}
+
+// `telemetry`: polls the block and prints the snapshots that changed since the last poll.
+int WatchTelemetry(const std::string& name, int argc, char** argv)
+{
+    double intervalMs = 500.0;
+    int count = 0;
+    for (int i = 0; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        bool ok = false;
+        if (std::strcmp(argv[i], "--interval") == 0 && hasValue)
+        {
+            ok = purple::TryParseDoubleNarrow(argv[++i], intervalMs) && intervalMs >= 1.0;
+        }
+        else if (std::strcmp(argv[i], "--count") == 0 && hasValue)
+        {
+            ok = purple::TryParseIntNarrow(argv[++i], count);
+        }
+        if (!ok)
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    purple::TelemetryReader reader;
+    if (!reader.Open(name))
+    {
+        std::printf("No telemetry block named %s (start the runner with --telemetry %s).\n", name.c_str(), name.c_str());
+        return 2;
+    }
+    std::uint64_t lastPublishes = 0;
+    for (int printed = 0; count == 0 || printed < count;)
+    {
+        purple::TelemetrySnapshot snapshot;
+        if (reader.Read(snapshot) && snapshot.publishes != lastPublishes)
+        {
+            lastPublishes = snapshot.publishes;
+            PrintSnapshot(snapshot);
+            ++printed;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(intervalMs));
+    }
+    return 0;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string endpoint = argv[1];
+    std::string cmd = argv[2];
+    if (cmd == "telemetry")
+    {
+        return WatchTelemetry(endpoint, argc - 3, argv + 3);
+    }
+    std::string command;
+    if (cmd == "run")
+    {
+        if (!BuildRunCommand(argc - 3, argv + 3, command))
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    else if ((cmd == "status" || cmd == "cancel" || cmd == "shutdown") && argc == 3)
+    {
+        command = "{\"cmd\": \"" + cmd + "\"}";
+    }
+    else if (cmd == "send" && argc == 4)
+    {
+        command = argv[3];
+        std::vector<purple::FlatJsonField> fields;
+        const purple::FlatJsonField* sent = nullptr;
+        if (purple::ParseFlatJsonObject(command, fields))
+        {
+            sent = purple::FindJsonField(fields, "cmd");
+        }
+        cmd = sent != nullptr ? sent->value : std::string();
+    }
+    else
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    purple::IpcConnection connection;
+    if (!connection.Connect(endpoint))
+    {
+        std::printf("Failed to connect to %s\n", endpoint.c_str());
+        return 2;
+    }
+    command += "\n";
+    if (!connection.WriteAll(command.data(), command.size()))
+    {
+        std::printf("Failed to send command.\n");
+        return 2;
+    }
+
+    int exitCode = 0;
+    std::string line;
+    while (connection.ReadLine(line))
+    {
+        std::printf("%s\n", line.c_str());
+        std::fflush(stdout);
+        if (IsFinalReply(cmd, line, exitCode))
+        {
+            return exitCode;
+        }
+    }
+
+    std::printf("Connection closed before the reply completed.\n");
+    return 2;
+}
@@ -0,0 +1,234 @@
+#include "core/aggregate.h"
+#include "core/buffered_writer.h"
+#include "core/compare.h"
+#include "core/foreperiod.h"
+#include "core/headless.h"
+#include "core/parallel.h"
+#include "core/parse.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct CompareCliOptions
+{
+    purple::CompareOptions compare;
+    std::string csvOutputPath;
+    std::vector<std::string> inputs;
+};
+
+// Valid reactions of every result file under one input, pooled.
+struct ResultSet
+{
+    std::string path;
+    size_t files = 0;
+    size_t failedFiles = 0;
+    size_t falseStarts = 0;
+    std::vector<double> validMs;
+};
+
+void PrintUsage()
+{
+    std::printf("Usage: purple_compare [--resamples n] [--permutations n] [--percentiles list] [--confidence c]\n");
+    std::printf("                      [--seed n] [--threads n] [--csv-out path] a b\n");
+    std::printf("Compares the valid reaction times of two result sets, B - A: mean, median and the --percentiles\n");
+    std::printf("(default 90), each with a percentile bootstrap interval and a two-sided permutation p-value.\n");
+    std::printf("a and b are CSV/JSON exports, .prr files or journals, or directories of them (pooled). Defaults:\n");
+    std::printf("--resamples 100000 --permutations 100000 --confidence 0.95 --seed 1; the same seed gives the same\n");
+    std::printf("result on any number of threads. --permutations 0 skips the test.\n");
+}
+
+bool ParseArgs(int argc, char** argv, CompareCliOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--resamples") == 0 && hasValue)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], options.compare.resamples))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--permutations") == 0 && hasValue)
+        {
+            const std::string value = argv[++i];
+            if (value == "0")
+            {
+                options.compare.permutations = 0;
+            }
+            else if (!purple::TryParseIntNarrow(value, options.compare.permutations))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--percentiles") == 0 && hasValue)
+        {
+            if (!purple::ParsePercentileList(argv[++i], options.compare.percentiles))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--confidence") == 0 && hasValue)
+        {
+            if (!purple::TryParseDoubleNarrow(argv[++i], options.compare.confidence) ||
+                !(options.compare.confidence > 0.0 && options.compare.confidence < 1.0))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue)
+        {
+            if (!purple::TryParseSeed(argv[++i], options.compare.seed))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue)
+        {
+            if (!purple::TryParseIntNarrow(argv[++i], options.compare.threads))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--csv-out") == 0 && hasValue)
+        {
+            options.csvOutputPath = argv[++i];
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.push_back(arg);
+        }
+    }
+    return options.inputs.size() == 2;
+}
+
+bool LoadResultSet(const std::string& path, ResultSet& set)
+{
+    set.path = path;
+    for (const std::string& file : purple::CollectResultFiles({path}))
+    {
+        purple::ParsedResults results;
+        if (!purple::LoadParsedResults(file, results))
+        {
+            std::printf("Could not read results: %s\n", file.c_str());
+            ++set.failedFiles;
+            continue;
+        }
+        ++set.files;
+        set.falseStarts += results.falseStartCount;
+        set.validMs.insert(set.validMs.end(), results.validReactionsMs.begin(), results.validReactionsMs.end());
+    }
+    if (set.validMs.empty())
+    {
+        std::printf("No valid reactions in %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void PrintSet(const char* label, const ResultSet& set)
+{
+    std::printf("%s: %s (%zu files, %zu valid trials, %zu false starts)\n",
+        label,
+        set.path.c_str(),
+        set.files,
+        set.validMs.size(),
+        set.falseStarts);
+}
+
+bool WriteCsv(const std::string& path, const purple::ComparisonReport& report)
+{
+    purple::BufferedFileWriter writer;
+    if (!writer.Open(path))
+    {
+        return false;
+    }
+    writer.Append("statistic,a_ms,b_ms,difference_ms,ci_low_ms,ci_high_ms,p_value\n");
+    for (const purple::StatisticComparison& statistic : report.statistics)
+    {
+        writer.AppendString(statistic.name.c_str());
+        for (const double value : {statistic.aMs, statistic.bMs, statistic.differenceMs, statistic.lowMs, statistic.highMs})
+        {
+            writer.Append(",");
+            writer.AppendFixed6(value);
+        }
+        writer.Append(",");
+        if (!std::isnan(statistic.pValue))
+        {
+            writer.AppendFixed6(statistic.pValue);
+        }
+        writer.Append("\n");
+    }
+    return writer.Close();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    CompareCliOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    ResultSet a;
+    ResultSet b;
+    if (!LoadResultSet(options.inputs[0], a) || !LoadResultSet(options.inputs[1], b))
+    {
+        return 2;
+    }
+
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    const purple::ComparisonReport report = purple::CompareSamples(a.validMs, b.validMs, options.compare);
+    const double seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+
+    PrintSet("A", a);
+    PrintSet("B", b);
+    const double confidencePercent = 100.0 * options.compare.confidence;
+    std::printf("%-10s %10s %10s %10s  %4.4g%% CI %-14s %9s\n", "statistic", "A ms", "B ms", "B - A", confidencePercent, "", "p");
+    for (const purple::StatisticComparison& statistic : report.statistics)
+    {
+        char pValue[32] = "-";
+        if (!std::isnan(statistic.pValue))
+        {
+            std::snprintf(pValue, sizeof(pValue), "%.5f", statistic.pValue);
+        }
+        std::printf("%-10s %10.3f %10.3f %+10.3f  [%+9.3f, %+9.3f] %9s\n",
+            statistic.name.c_str(),
+            statistic.aMs,
+            statistic.bMs,
+            statistic.differenceMs,
+            statistic.lowMs,
+            statistic.highMs,
+            pValue);
+    }
+    std::printf("%d resamples, %d permutations, seed %llu, %d threads: %.3f s\n",
+        options.compare.resamples,
+        options.compare.permutations,
+        static_cast<unsigned long long>(options.compare.seed),
+        purple::ResolveThreadCount(options.compare.threads),
+        seconds);
+
+    if (!options.csvOutputPath.empty())
+    {
+        if (!WriteCsv(options.csvOutputPath, report))
+        {
+            std::printf("Failed to write CSV: %s\n", options.csvOutputPath.c_str());
+            return 2;
+        }
+        std::printf("Comparison CSV written: %s\n", options.csvOutputPath.c_str());
+    }
+    return a.failedFiles + b.failedFiles == 0 ? 0 : 2;
+}
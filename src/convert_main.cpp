@@ -0,0 +1,245 @@
+#include "core/aggregate.h"
+#include "core/columnar.h"
+#include "core/export.h"
+#include "core/journal.h"
+#include "core/mapped_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct ConvertOptions
+{
+    std::string csvOutputPath;
+    std::string jsonOutputPath;
+    bool jsonDistribution = false;  // --json-distribution
+    purple::DistributionOptions distribution;
+    std::string binaryOutputPath;
+    bool toBinary = false;
+    std::string outputDirectory;
+    std::vector<std::string> inputs;
+};
+
+// A results file of any format, ready to export again.
+struct LoadedResults
+{
+    std::vector<purple::TrialResult> results;
+    purple::SessionConfig config;
+    purple::Ticks frequency = 0;
+    bool fromText = false;
+    bool hasForeperiod = false;                // config.foreperiod of .prr files and version 2 journals
+    std::vector<purple::InputDevice> devices;  // text exports and .prr files; journals carry no device ids
+    bool hasRealtime = false;                  // .prr files only
+    purple::RealtimeReport realtime;
+    bool hasStopping = false;
+    purple::StoppingReport stopping;
+};
+
+void PrintUsage()
+{
+    std::printf("Usage:\n");
+    std::printf("  purple_convert [--csv-out path] [--json-out path] [--json-distribution] [--bin-out path] input\n");
+    std::printf("  purple_convert --to-bin [--out-dir directory] input...\n");
+    std::printf("Converts between CSV/JSON exports and columnar .prr results. --to-bin writes <name>.prr next to\n");
+    std::printf("each input (or into --out-dir). Text inputs carry six decimals, so their .prr ticks are 1 ns.\n");
+    std::printf("--journal files are accepted as input too, including the .interrupted ones left by a crashed run.\n");
+}
+
+bool ParseArgs(int argc, char** argv, ConvertOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--csv-out") == 0 && hasValue)
+        {
+            options.csvOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--json-out") == 0 && hasValue)
+        {
+            options.jsonOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--json-distribution") == 0)
+        {
+            options.jsonDistribution = true;
+        }
+        else if (std::strcmp(arg, "--bin-out") == 0 && hasValue)
+        {
+            options.binaryOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--to-bin") == 0)
+        {
+            options.toBinary = true;
+        }
+        else if (std::strcmp(arg, "--out-dir") == 0 && hasValue)
+        {
+            options.outputDirectory = argv[++i];
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    const bool singleOutputs =
+        !options.csvOutputPath.empty() || !options.jsonOutputPath.empty() || !options.binaryOutputPath.empty();
+    if (options.inputs.empty() || singleOutputs == options.toBinary)
+    {
+        return false;
+    }
+    return options.toBinary || (options.inputs.size() == 1 && options.outputDirectory.empty());
+}
+
+// Session config for results read back from text: the run's own settings are not exported, so the
+// trial count and delay range are taken from the trials themselves.
+void DeriveTextConfig(LoadedResults& loaded, std::vector<purple::PlanBlock>& plan)
+{
+    purple::SessionConfig& config = loaded.config;
+    config.trialCount = static_cast<int>(loaded.results.size());
+    config.minDelaySeconds = loaded.results.front().delaySeconds;
+    config.maxDelaySeconds = loaded.results.front().delaySeconds;
+    for (const purple::TrialResult& trial : loaded.results)
+    {
+        config.minDelaySeconds = std::min(config.minDelaySeconds, trial.delaySeconds);
+        config.maxDelaySeconds = std::max(config.maxDelaySeconds, trial.delaySeconds);
+        config.recordTiming = config.recordTiming || trial.timing.loopIterations > 0;
+    }
+    config.plan = std::move(plan);
+}
+
+bool LoadJournalResults(const std::string& path, LoadedResults& loaded)
+{
+    purple::JournalContents journal;
+    if (!purple::LoadJournal(path, journal))
+    {
+        return false;
+    }
+    if (!journal.closed)
+    {
+        std::printf("Journal %s: recovered %zu trials from an interrupted run.\n", path.c_str(), journal.results.size());
+    }
+    loaded.results = std::move(journal.results);
+    loaded.config = std::move(journal.config);
+    loaded.hasForeperiod = journal.hasForeperiod;
+    loaded.frequency = journal.tickFrequency;
+    return !loaded.results.empty();
+}
+
+bool LoadResults(const std::string& path, LoadedResults& loaded)
+{
+    const std::string extension = std::filesystem::path(path).extension().string();
+    if (extension == ".prr")
+    {
+        purple::ColumnarResults columnar;
+        if (!columnar.Open(path))
+        {
+            std::printf("Not a columnar results file: %s\n", path.c_str());
+            return false;
+        }
+        loaded.results = columnar.ToTrialResults();
+        loaded.config = columnar.Config();
+        loaded.hasForeperiod = columnar.Foreperiod(loaded.config.foreperiod);
+        loaded.devices = columnar.Devices();
+        loaded.hasRealtime = columnar.Realtime(loaded.realtime);
+        loaded.hasStopping = columnar.Stopping(loaded.stopping);
+        loaded.frequency = columnar.Header().tickFrequency;
+        loaded.fromText = (columnar.Header().flags & purple::ColumnarFileHeader::kFlagFromText) != 0;
+        return !loaded.results.empty();
+    }
+
+    purple::MappedFile file;
+    if (!file.Open(path))
+    {
+        std::printf("Failed to open: %s\n", path.c_str());
+        return false;
+    }
+    if (purple::IsJournal(file.View()))
+    {
+        file.Close();
+        return LoadJournalResults(path, loaded);
+    }
+    std::vector<purple::PlanBlock> plan;
+    const bool parsed = extension == ".json" ? purple::ParseResultRowsJson(file.View(), loaded.results, plan, loaded.devices)
+                                             : purple::ParseResultRowsCsv(file.View(), loaded.results, plan, loaded.devices);
+    if (!parsed || loaded.results.empty())
+    {
+        std::printf("Not a PurpleReaction export: %s\n", path.c_str());
+        return false;
+    }
+    DeriveTextConfig(loaded, plan);
+    purple::SynthesizeTrialTicks(loaded.results);
+    loaded.frequency = purple::kTextTickFrequency;
+    loaded.fromText = true;
+    return true;
+}
+
+bool WriteOutputs(const LoadedResults& loaded, const std::string& csvPath, const std::string& jsonPath, const std::string& binaryPath,
+    const purple::DistributionOptions* distribution)
+{
+    bool ok = true;
+    purple::ExportMetadata metadata;
+    metadata.foreperiod = loaded.hasForeperiod ? &loaded.config.foreperiod : nullptr;
+    metadata.realtime = loaded.hasRealtime ? &loaded.realtime : nullptr;
+    metadata.devices = &loaded.devices;
+    metadata.stopping = loaded.hasStopping ? &loaded.stopping : nullptr;
+    metadata.distribution = distribution;
+    if (!csvPath.empty() || !jsonPath.empty())
+    {
+        const purple::RunningStats stats = purple::ComputeRunningStats(loaded.results);
+        ok = purple::ExportResults(loaded.results, stats, csvPath, jsonPath, loaded.config.plan, metadata);
+    }
+    if (!binaryPath.empty())
+    {
+        const std::uint32_t flags = loaded.fromText ? purple::ColumnarFileHeader::kFlagFromText : 0;
+        ok = purple::ExportResultsColumnar(loaded.results, loaded.config, loaded.frequency, binaryPath, metadata, flags) && ok;
+    }
+    return ok;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ConvertOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    size_t failed = 0;
+    for (const std::string& path : options.inputs)
+    {
+        LoadedResults loaded;
+        if (!LoadResults(path, loaded))
+        {
+            ++failed;
+            continue;
+        }
+
+        std::string binaryPath = options.binaryOutputPath;
+        if (options.toBinary)
+        {
+            std::filesystem::path target = std::filesystem::path(path).replace_extension(".prr");
+            if (!options.outputDirectory.empty())
+            {
+                target = std::filesystem::path(options.outputDirectory) / target.filename();
+            }
+            binaryPath = target.string();
+        }
+        if (!WriteOutputs(loaded, options.csvOutputPath, options.jsonOutputPath, binaryPath,
+                options.jsonDistribution ? &options.distribution : nullptr))
+        {
+            ++failed;
+        }
+    }
+    return failed == 0 ? 0 : 2;
+}
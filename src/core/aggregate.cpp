@@ -0,0 +1,789 @@
+#include "core/aggregate.h"
+
+#include "core/columnar.h"
+#include "core/journal.h"
+#include "core/mapped_file.h"
+#include "core/parallel.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <regex>
+#include <system_error>
+#include <utility>
+
+namespace purple
+{
+namespace
+{
+// Splits `text` into lines without copying; a trailing '\r' is dropped from each.
+class LineCursor
+{
+public:
+    explicit LineCursor(std::string_view text)
+        : text_(text)
+    {
+    }
+
+    bool Next(std::string_view& line)
+    {
+        if (position_ >= text_.size())
+        {
+            return false;
+        }
+        size_t end = text_.find('\n', position_);
+        if (end == std::string_view::npos)
+        {
+            end = text_.size();
+        }
+        line = text_.substr(position_, end - position_);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        position_ = end + 1;
+        return true;
+    }
+
+private:
+    std::string_view text_;
+    size_t position_ = 0;
+};
+
+bool ParseNumber(std::string_view text, double& value)
+{
+    const std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr != text.data();
+}
+
+size_t SkipSpace(std::string_view text, size_t position)
+{
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\r' ||
+        text[position] == '\n'))
+    {
+        ++position;
+    }
+    return position;
+}
+
+// The text after `"key":` in a flat JSON object, or an empty view.
+std::string_view JsonValue(std::string_view object, std::string_view quotedKey)
+{
+    const size_t key = object.find(quotedKey);
+    if (key == std::string_view::npos)
+    {
+        return std::string_view();
+    }
+    size_t position = SkipSpace(object, key + quotedKey.size());
+    if (position >= object.size() || object[position] != ':')
+    {
+        return std::string_view();
+    }
+    position = SkipSpace(object, position + 1);
+    return object.substr(position);
+}
+
+// Calls fn(object) for each flat object of the JSON array whose '[' is at or after `position`; stops at
+// the first object fn rejects. Objects are flat (no nesting or braces inside strings), so each ends at
+// the next '}'.
+template <typename Fn>
+bool ForEachJsonObject(std::string_view text, size_t position, Fn fn)
+{
+    position = text.find('[', position);
+    if (position == std::string_view::npos)
+    {
+        return false;
+    }
+    ++position;
+    for (;;)
+    {
+        position = SkipSpace(text, position);
+        if (position < text.size() && text[position] == ',')
+        {
+            position = SkipSpace(text, position + 1);
+        }
+        if (position >= text.size())
+        {
+            return false;
+        }
+        if (text[position] == ']')
+        {
+            return true;
+        }
+        if (text[position] != '{')
+        {
+            return false;
+        }
+        const size_t end = text.find('}', position);
+        if (end == std::string_view::npos || !fn(text.substr(position, end - position)))
+        {
+            return false;
+        }
+        position = end + 1;
+    }
+}
+
+// Contents of a JSON string value as returned by JsonValue (exports do not escape block ids).
+std::string_view JsonString(std::string_view value)
+{
+    if (value.empty() || value[0] != '"')
+    {
+        return std::string_view();
+    }
+    const size_t end = value.find('"', 1);
+    return end == std::string_view::npos ? std::string_view() : value.substr(1, end - 1);
+}
+
+// Optional number: true with `value` unchanged for an empty CSV field or a JSON null.
+bool ParseOptionalNumber(std::string_view text, double& value)
+{
+    if (text.empty() || text.substr(0, 4) == "null")
+    {
+        return true;
+    }
+    return ParseNumber(text, value);
+}
+
+bool ParseCount(std::string_view text, std::uint32_t& value)
+{
+    const std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr != text.data();
+}
+
+// Index of the plan block with `id`, appending one with default settings the first time it is seen.
+int BlockIndex(std::vector<PlanBlock>& plan, std::string_view id)
+{
+    for (size_t i = 0; i < plan.size(); ++i)
+    {
+        if (plan[i].id == id)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    PlanBlock block;
+    block.id = std::string(id);
+    block.trialCount = 0;
+    plan.push_back(block);
+    return static_cast<int>(plan.size() - 1);
+}
+
+// Index of the device with `id`, appending one the first time it is seen.
+int DeviceIndex(std::vector<InputDevice>& devices, std::string_view id)
+{
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        if (devices[i].id == id)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    InputDevice device;
+    device.id = std::string(id);
+    devices.push_back(device);
+    return static_cast<int>(devices.size() - 1);
+}
+
+// Fields of one CSV line (no quoting in exports); at most `maxFields`, the rest is ignored.
+size_t SplitCsvLine(std::string_view line, std::string_view* fields, size_t maxFields)
+{
+    size_t count = 0;
+    for (size_t start = 0; start <= line.size() && count < maxFields; ++count)
+    {
+        size_t end = line.find(',', start);
+        if (end == std::string_view::npos)
+        {
+            end = line.size();
+        }
+        fields[count] = line.substr(start, end - start);
+        start = end + 1;
+    }
+    return count;
+}
+
+std::string DateGroup(const std::string& path)
+{
+    // First run of exactly eight digits in the file name, as in PurpleReaction_YYYYMMDD_HHMMSS.csv.
+    const std::string name = std::filesystem::path(path).filename().string();
+    size_t run = 0;
+    for (size_t i = 0; i <= name.size(); ++i)
+    {
+        if (i < name.size() && name[i] >= '0' && name[i] <= '9')
+        {
+            ++run;
+            continue;
+        }
+        if (run == 8)
+        {
+            const std::string digits = name.substr(i - 8, 8);
+            return digits.substr(0, 4) + "-" + digits.substr(4, 2) + "-" + digits.substr(6, 2);
+        }
+        run = 0;
+    }
+    return "undated";
+}
+
+std::string GroupFor(const std::string& path, const AggregateOptions& options, const std::regex* pattern)
+{
+    switch (options.grouping)
+    {
+    case AggregateGrouping::None:
+        return std::string();
+    case AggregateGrouping::Date:
+        return DateGroup(path);
+    case AggregateGrouping::Directory:
+    {
+        const std::string parent = std::filesystem::path(path).parent_path().string();
+        return parent.empty() ? "." : parent;
+    }
+    case AggregateGrouping::Regex:
+    {
+        const std::string name = std::filesystem::path(path).filename().string();
+        std::smatch match;
+        if (pattern == nullptr || !std::regex_search(name, match, *pattern))
+        {
+            return "unmatched";
+        }
+        return match.size() > 1 ? match[1].str() : match[0].str();
+    }
+    }
+    return std::string();
+}
+
+bool HasResultExtension(const std::filesystem::path& path)
+{
+    const std::string extension = path.extension().string();
+    return extension == ".csv" || extension == ".json" || extension == ".prr";
+}
+
+// Sorts `values` on up to `threads` workers: contiguous chunks are sorted in parallel, then merged
+// pairwise, so the pooled summary over millions of trials does not serialize the run.
+void ParallelSort(std::vector<double>& values, int threads)
+{
+    const size_t chunks = std::max<size_t>(1, std::min(static_cast<size_t>(threads), values.size() / 4096));
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c)
+    {
+        bounds[c] = values.size() * c / chunks;
+    }
+    ParallelFor(chunks, threads, [&](size_t chunk, int /*worker*/)
+    {
+        std::sort(values.begin() + static_cast<std::ptrdiff_t>(bounds[chunk]),
+            values.begin() + static_cast<std::ptrdiff_t>(bounds[chunk + 1]));
+    });
+    for (size_t width = 1; width < chunks; width *= 2)
+    {
+        const size_t merges = (chunks + 2 * width - 1) / (2 * width);
+        ParallelFor(merges, threads, [&](size_t merge, int /*worker*/)
+        {
+            const size_t first = merge * 2 * width;
+            const size_t middle = std::min(first + width, chunks);
+            const size_t last = std::min(first + 2 * width, chunks);
+            std::inplace_merge(values.begin() + static_cast<std::ptrdiff_t>(bounds[first]),
+                values.begin() + static_cast<std::ptrdiff_t>(bounds[middle]),
+                values.begin() + static_cast<std::ptrdiff_t>(bounds[last]));
+        });
+    }
+}
+
+// Summary over the concatenated valid reactions of `members`; `sorted` receives them in order when given.
+ReactionSummary SummarizeFiles(const std::vector<ParsedResults>& parsed,
+    const std::vector<size_t>& members,
+    int threads,
+    std::vector<double>* sorted = nullptr)
+{
+    size_t total = 0;
+    size_t falseStarts = 0;
+    for (const size_t index : members)
+    {
+        total += parsed[index].validReactionsMs.size();
+        falseStarts += parsed[index].falseStartCount;
+    }
+    std::vector<double> values;
+    values.reserve(total);
+    for (const size_t index : members)
+    {
+        const std::vector<double>& file = parsed[index].validReactionsMs;
+        values.insert(values.end(), file.begin(), file.end());
+    }
+    ParallelSort(values, threads);
+    const ReactionSummary summary = SummarizeSorted(values, falseStarts);
+    if (sorted != nullptr)
+    {
+        *sorted = std::move(values);
+    }
+    return summary;
+}
+} // namespace
+
+bool ParseResultsCsv(std::string_view text, ParsedResults& results)
+{
+    results.validReactionsMs.clear();
+    results.falseStartCount = 0;
+
+    LineCursor lines(text);
+    std::string_view header;
+    if (!lines.Next(header) || header.substr(0, 6) != "trial,")
+    {
+        return false;
+    }
+    size_t reactionColumn = std::string_view::npos;
+    size_t falseStartColumn = std::string_view::npos;
+    size_t column = 0;
+    for (size_t start = 0; start <= header.size(); ++column)
+    {
+        size_t end = header.find(',', start);
+        if (end == std::string_view::npos)
+        {
+            end = header.size();
+        }
+        const std::string_view name = header.substr(start, end - start);
+        if (name == "reaction_ms")
+        {
+            reactionColumn = column;
+        }
+        else if (name == "false_start")
+        {
+            falseStartColumn = column;
+        }
+        start = end + 1;
+    }
+    if (reactionColumn == std::string_view::npos || falseStartColumn == std::string_view::npos)
+    {
+        return false;
+    }
+
+    std::string_view line;
+    while (lines.Next(line))
+    {
+        // Trial rows start with their number; footer rows (average, sd, ...) with a label.
+        if (line.empty() || line[0] < '0' || line[0] > '9')
+        {
+            continue;
+        }
+
+        std::string_view reaction;
+        std::string_view falseStart;
+        column = 0;
+        for (size_t start = 0; start <= line.size() && column <= std::max(reactionColumn, falseStartColumn); ++column)
+        {
+            size_t end = line.find(',', start);
+            if (end == std::string_view::npos)
+            {
+                end = line.size();
+            }
+            if (column == reactionColumn)
+            {
+                reaction = line.substr(start, end - start);
+            }
+            else if (column == falseStartColumn)
+            {
+                falseStart = line.substr(start, end - start);
+            }
+            start = end + 1;
+        }
+
+        if (falseStart == "1")
+        {
+            ++results.falseStartCount;
+            continue;
+        }
+        double value = 0.0;
+        if (falseStart != "0" || !ParseNumber(reaction, value))
+        {
+            return false;
+        }
+        results.validReactionsMs.push_back(value);
+    }
+    return true;
+}
+
+bool ParseResultsJson(std::string_view text, ParsedResults& results)
+{
+    results.validReactionsMs.clear();
+    results.falseStartCount = 0;
+
+    const size_t key = text.find("\"trials\"");
+    if (key == std::string_view::npos)
+    {
+        return false;
+    }
+    return ForEachJsonObject(text, key, [&results](std::string_view object)
+    {
+        const std::string_view falseStart = JsonValue(object, "\"false_start\"");
+        if (falseStart.substr(0, 4) == "true")
+        {
+            ++results.falseStartCount;
+            return true;
+        }
+        double value = 0.0;
+        if (falseStart.substr(0, 5) != "false" || !ParseNumber(JsonValue(object, "\"reaction_ms\""), value))
+        {
+            return false;
+        }
+        results.validReactionsMs.push_back(value);
+        return true;
+    });
+}
+
+bool ParseResultRowsCsv(
+    std::string_view text,
+    std::vector<TrialResult>& results,
+    std::vector<PlanBlock>& plan,
+    std::vector<InputDevice>& devices)
+{
+    results.clear();
+    plan.clear();
+    devices.clear();
+
+    enum class Field
+    {
+        Other,
+        Delay,
+        Reaction,
+        FalseStart,
+        OnsetCorrection,
+        Foreperiod,
+        Present,
+        InputLag,
+        LoopIterations,
+        MaxLoopGap,
+        Block,
+        Device
+    };
+    constexpr size_t kMaxFields = 16;
+    std::string_view fields[kMaxFields];
+    Field kinds[kMaxFields] = {};
+
+    LineCursor lines(text);
+    std::string_view header;
+    if (!lines.Next(header) || header.substr(0, 6) != "trial,")
+    {
+        return false;
+    }
+    const size_t columns = SplitCsvLine(header, fields, kMaxFields);
+    bool hasFalseStart = false;
+    for (size_t i = 0; i < columns; ++i)
+    {
+        const std::string_view name = fields[i];
+        kinds[i] = name == "random_delay_seconds" ? Field::Delay
+            : name == "reaction_ms"              ? Field::Reaction
+            : name == "false_start"              ? Field::FalseStart
+            : name == "onset_correction_ms"      ? Field::OnsetCorrection
+            : name == "foreperiod_ms"            ? Field::Foreperiod
+            : name == "present_ms"               ? Field::Present
+            : name == "input_lag_ms"             ? Field::InputLag
+            : name == "loop_iterations"          ? Field::LoopIterations
+            : name == "max_loop_gap_ms"          ? Field::MaxLoopGap
+            : name == "block"                    ? Field::Block
+            : name == "device"                   ? Field::Device
+                                                 : Field::Other;
+        hasFalseStart = hasFalseStart || kinds[i] == Field::FalseStart;
+    }
+    if (!hasFalseStart)
+    {
+        return false;
+    }
+
+    std::string_view line;
+    while (lines.Next(line))
+    {
+        if (line.empty() || line[0] < '0' || line[0] > '9')
+        {
+            continue;
+        }
+        const size_t count = SplitCsvLine(line, fields, columns);
+        TrialResult trial;
+        double correction = 0.0;
+        bool ok = count == columns;
+        for (size_t i = 0; i < count && ok; ++i)
+        {
+            const std::string_view field = fields[i];
+            switch (kinds[i])
+            {
+            case Field::Delay:
+                ok = ParseNumber(field, trial.delaySeconds);
+                break;
+            case Field::Reaction:
+                ok = ParseOptionalNumber(field, trial.reactionMs);
+                break;
+            case Field::FalseStart:
+                ok = field == "0" || field == "1";
+                trial.falseStart = field == "1";
+                break;
+            case Field::OnsetCorrection:
+                ok = ParseOptionalNumber(field, correction);
+                trial.onsetSource = field.empty() ? OnsetSource::Midpoint : OnsetSource::Scanout;
+                break;
+            case Field::Foreperiod:
+                ok = ParseOptionalNumber(field, trial.timing.foreperiodMs);
+                break;
+            case Field::Present:
+                ok = ParseOptionalNumber(field, trial.timing.presentMs);
+                break;
+            case Field::InputLag:
+                ok = ParseNumber(field, trial.timing.inputLagMs);
+                break;
+            case Field::LoopIterations:
+                ok = ParseCount(field, trial.timing.loopIterations);
+                break;
+            case Field::MaxLoopGap:
+                ok = ParseNumber(field, trial.timing.maxIterationGapMs);
+                break;
+            case Field::Block:
+                trial.block = BlockIndex(plan, field);
+                ++plan[static_cast<size_t>(trial.block)].trialCount;
+                break;
+            case Field::Device:
+                trial.device = field.empty() ? -1 : DeviceIndex(devices, field);
+                break;
+            case Field::Other:
+                break;
+            }
+        }
+        if (!ok)
+        {
+            return false;
+        }
+        trial.onsetCorrectionMs = correction;
+        results.push_back(trial);
+    }
+    return true;
+}
+
+bool ParseResultRowsJson(
+    std::string_view text,
+    std::vector<TrialResult>& results,
+    std::vector<PlanBlock>& plan,
+    std::vector<InputDevice>& devices)
+{
+    results.clear();
+    plan.clear();
+    devices.clear();
+
+    const size_t trialsKey = text.find("\"trials\"");
+    if (trialsKey == std::string_view::npos)
+    {
+        return false;
+    }
+    const size_t blocksKey = text.substr(0, trialsKey).find("\"blocks\"");
+    if (blocksKey != std::string_view::npos &&
+        !ForEachJsonObject(text.substr(0, trialsKey), blocksKey, [&plan](std::string_view object)
+        {
+            PlanBlock block;
+            block.id = std::string(JsonString(JsonValue(object, "\"block\"")));
+            block.trialCount = 0;
+            plan.push_back(block);
+            PlanBlock& entry = plan.back();
+            return ParseNumber(JsonValue(object, "\"min_delay_seconds\""), entry.minDelaySeconds) &&
+                ParseNumber(JsonValue(object, "\"max_delay_seconds\""), entry.maxDelaySeconds) &&
+                ParseNumber(JsonValue(object, "\"rest_seconds\""), entry.restSeconds);
+        }))
+    {
+        return false;
+    }
+
+    return ForEachJsonObject(text, trialsKey, [&](std::string_view object)
+    {
+        TrialResult trial;
+        const std::string_view falseStart = JsonValue(object, "\"false_start\"");
+        trial.falseStart = falseStart.substr(0, 4) == "true";
+        if (!trial.falseStart && falseStart.substr(0, 5) != "false")
+        {
+            return false;
+        }
+        if (!ParseNumber(JsonValue(object, "\"random_delay_seconds\""), trial.delaySeconds) ||
+            !ParseOptionalNumber(JsonValue(object, "\"reaction_ms\""), trial.reactionMs))
+        {
+            return false;
+        }
+
+        const std::string_view correction = JsonValue(object, "\"onset_correction_ms\"");
+        if (!correction.empty() && correction.substr(0, 4) != "null")
+        {
+            trial.onsetSource = OnsetSource::Scanout;
+            if (!ParseNumber(correction, trial.onsetCorrectionMs))
+            {
+                return false;
+            }
+        }
+
+        const std::string_view iterations = JsonValue(object, "\"loop_iterations\"");
+        if (!iterations.empty())
+        {
+            TrialTiming& timing = trial.timing;
+            if (!ParseCount(iterations, timing.loopIterations) ||
+                !ParseOptionalNumber(JsonValue(object, "\"foreperiod_ms\""), timing.foreperiodMs) ||
+                !ParseOptionalNumber(JsonValue(object, "\"present_ms\""), timing.presentMs) ||
+                !ParseNumber(JsonValue(object, "\"input_lag_ms\""), timing.inputLagMs) ||
+                !ParseNumber(JsonValue(object, "\"max_loop_gap_ms\""), timing.maxIterationGapMs))
+            {
+                return false;
+            }
+        }
+
+        const std::string_view block = JsonValue(object, "\"block\"");
+        if (!block.empty())
+        {
+            trial.block = BlockIndex(plan, JsonString(block));
+            ++plan[static_cast<size_t>(trial.block)].trialCount;
+        }
+        const std::string_view device = JsonString(JsonValue(object, "\"device\""));
+        if (!device.empty())
+        {
+            trial.device = DeviceIndex(devices, device);
+        }
+        results.push_back(trial);
+        return true;
+    });
+}
+
+bool LoadParsedResults(const std::string& path, ParsedResults& results)
+{
+    results = ParsedResults{};
+    const std::filesystem::path extension = std::filesystem::path(path).extension();
+    if (extension == ".prr")
+    {
+        // Columnar files need no parsing: reactions come straight from the mapped tick columns.
+        ColumnarResults columnar;
+        if (!columnar.Open(path))
+        {
+            return false;
+        }
+        columnar.ReactionsMs(results.validReactionsMs, results.falseStartCount);
+        return true;
+    }
+    MappedFile mapped;
+    if (!mapped.Open(path))
+    {
+        return false;
+    }
+    if (IsJournal(mapped.View()))
+    {
+        mapped.Close();
+        JournalContents journal;
+        if (!LoadJournal(path, journal))
+        {
+            return false;
+        }
+        for (const TrialResult& trial : journal.results)
+        {
+            if (trial.falseStart)
+            {
+                ++results.falseStartCount;
+            }
+            else
+            {
+                results.validReactionsMs.push_back(trial.reactionMs);
+            }
+        }
+        return true;
+    }
+    const bool parsed = extension == ".json" ? ParseResultsJson(mapped.View(), results) : ParseResultsCsv(mapped.View(), results);
+    if (!parsed)
+    {
+        results = ParsedResults{};
+    }
+    return parsed;
+}
+
+std::vector<std::string> CollectResultFiles(const std::vector<std::string>& paths)
+{
+    std::vector<std::string> files;
+    for (const std::string& path : paths)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(path, error))
+        {
+            files.push_back(path);
+            continue;
+        }
+        for (std::filesystem::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+        {
+            if (it->is_regular_file(error) && HasResultExtension(it->path()))
+            {
+                files.push_back(it->path().string());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+AggregateReport AggregateResultFiles(const std::vector<std::string>& files, const AggregateOptions& options)
+{
+    AggregateReport report;
+    report.files.resize(files.size());
+    std::vector<ParsedResults> parsed(files.size());
+    const int threads = ResolveThreadCount(options.threads);
+
+    ParallelFor(files.size(), threads, [&](size_t index, int /*worker*/)
+    {
+        FileSummary& file = report.files[index];
+        file.path = files[index];
+        ParsedResults& results = parsed[index];
+        file.parsed = LoadParsedResults(file.path, results);
+        if (!file.parsed)
+        {
+            return;
+        }
+        std::sort(results.validReactionsMs.begin(), results.validReactionsMs.end());
+        file.summary = SummarizeSorted(results.validReactionsMs, results.falseStartCount);
+    });
+
+    std::regex pattern;
+    if (options.grouping == AggregateGrouping::Regex)
+    {
+        pattern = std::regex(options.groupRegex);
+    }
+    std::map<std::string, std::vector<size_t>> groups;
+    std::vector<size_t> all;
+    all.reserve(files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        FileSummary& file = report.files[i];
+        if (!file.parsed)
+        {
+            ++report.failedFiles;
+            continue;
+        }
+        all.push_back(i);
+        if (options.grouping != AggregateGrouping::None)
+        {
+            file.group = GroupFor(file.path, options, &pattern);
+            groups[file.group].push_back(i);
+        }
+    }
+
+    // Members indexed like report.groups, so the workers below only read plain vectors.
+    std::vector<std::vector<size_t>> groupMembers;
+    groupMembers.reserve(groups.size());
+    for (auto& group : groups)
+    {
+        GroupSummary summary;
+        summary.name = group.first;
+        summary.fileCount = group.second.size();
+        report.groups.push_back(summary);
+        groupMembers.push_back(std::move(group.second));
+    }
+    ParallelFor(report.groups.size(), threads, [&](size_t index, int /*worker*/)
+    {
+        report.groups[index].summary = SummarizeFiles(parsed, groupMembers[index], 1);
+    });
+
+    report.pooled.name = "pooled";
+    report.pooled.fileCount = all.size();
+    if (options.pooledDistribution)
+    {
+        std::vector<double> sorted;
+        report.pooled.summary = SummarizeFiles(parsed, all, threads, &sorted);
+        report.distribution = ComputeDistribution(sorted, options.distribution);
+    }
+    else
+    {
+        report.pooled.summary = SummarizeFiles(parsed, all, threads);
+    }
+    return report;
+}
+} // namespace purple
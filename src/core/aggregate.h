@@ -0,0 +1,96 @@
+#pragma once
+
+#include "core/analytics.h"
+#include "core/session.h"
+#include "core/stats.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace purple
+{
+// Trials read back from one exported results file.
+struct ParsedResults
+{
+    std::vector<double> validReactionsMs;
+    size_t falseStartCount = 0;
+};
+
+// Zero-copy parsers for the exporters' own output, reading straight from the mapped bytes. They accept
+// every schema variant ExportResults writes (optional columns, plan block column, CRLF line endings) and
+// return false when the text does not look like a results file.
+bool ParseResultsCsv(std::string_view text, ParsedResults& results);
+bool ParseResultsJson(std::string_view text, ParsedResults& results);
+
+// Reads the valid reactions and false starts of one results file in any format the runners write: columnar
+// .prr files, CSV and JSON exports, and --journal files (recognized by their header, so renamed .interrupted
+// journals work too). False when the file cannot be opened or is none of these (LoadJournal prints why
+// for broken journals).
+bool LoadParsedResults(const std::string& path, ParsedResults& results);
+
+// Every per-trial field an export carries, for converting it back into TrialResults (TrialResult::ticks
+// stay zero). `plan` receives the block ids in first-seen order, with their delay settings when a JSON
+// export lists them; `devices` the device ids in first-seen order (ids only, see ExportMetadata::devices).
+bool ParseResultRowsCsv(
+    std::string_view text,
+    std::vector<TrialResult>& results,
+    std::vector<PlanBlock>& plan,
+    std::vector<InputDevice>& devices);
+bool ParseResultRowsJson(
+    std::string_view text,
+    std::vector<TrialResult>& results,
+    std::vector<PlanBlock>& plan,
+    std::vector<InputDevice>& devices);
+
+enum class AggregateGrouping
+{
+    None,       // pooled only
+    Date,       // YYYY-MM-DD from a PurpleReaction_YYYYMMDD_HHMMSS file name ("undated" otherwise)
+    Directory,  // parent directory
+    Regex       // first capture group (or the whole match) of groupRegex in the file name ("unmatched" otherwise)
+};
+
+struct AggregateOptions
+{
+    int threads = 0;  // 0: one per hardware thread
+    AggregateGrouping grouping = AggregateGrouping::None;
+    std::string groupRegex;
+    bool pooledDistribution = false;  // fill AggregateReport::distribution
+    DistributionOptions distribution;
+};
+
+struct FileSummary
+{
+    std::string path;
+    std::string group;
+    bool parsed = false;
+    ReactionSummary summary;
+};
+
+struct GroupSummary
+{
+    std::string name;
+    size_t fileCount = 0;
+    ReactionSummary summary;
+};
+
+struct AggregateReport
+{
+    std::vector<FileSummary> files;    // input order
+    std::vector<GroupSummary> groups;  // sorted by name; empty for AggregateGrouping::None
+    GroupSummary pooled;
+    DistributionReport distribution;   // of the pooled trials, with AggregateOptions::pooledDistribution
+    size_t failedFiles = 0;
+};
+
+// *.csv, *.json and columnar *.prr files named directly or found under directories (recursively), sorted by path.
+std::vector<std::string> CollectResultFiles(const std::vector<std::string>& paths);
+
+// Maps and parses every file in parallel (columnar files are read without parsing), then summarizes each
+// file, each group and the pooled trials with exact statistics (SummarizeSorted). Files that fail to open
+// or parse are counted, not summarized. The pooled distribution, when asked for, reuses the sorted pooled
+// trials and runs on the best kernels of the CPU (DetectSimdLevel).
+AggregateReport AggregateResultFiles(const std::vector<std::string>& files, const AggregateOptions& options);
+} // namespace purple
@@ -0,0 +1,202 @@
+#include "core/analytics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+bool CpuHasAvx2()
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    // AVX2 needs the OS to save the YMM state (OSXSAVE and XCR0 bits 1-2) as well as the CPUID bit.
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    // libgcc checks the XCR0 state too.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+void SumSquaresScalar(const double* values, size_t count, double& sum, double& sumSquares)
+{
+    double s = 0.0;
+    double q = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        s += values[i];
+        q += values[i] * values[i];
+    }
+    sum = s;
+    sumSquares = q;
+}
+
+void FixedHistogramScalar(const double* values, size_t count, double low, double inverseWidth, size_t binCount,
+    std::uint64_t* bins)
+{
+    // Clamped the way the AVX2 min/max instructions clamp, so both versions bin every value alike.
+    const double top = static_cast<double>(binCount);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double position = std::floor((values[i] - low) * inverseWidth);
+        position = position < top ? position : top;
+        position = position > -1.0 ? position : -1.0;
+        ++bins[static_cast<size_t>(position + 1.0)];
+    }
+}
+
+void EdgeHistogramScalar(const double* values, size_t count, const double* edges, size_t edgeCount, std::uint64_t* bins)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        ++bins[static_cast<size_t>(std::upper_bound(edges, edges + edgeCount, values[i]) - edges)];
+    }
+}
+
+void GaussianKdeScalar(const double* sorted, size_t count, double bandwidth, const double* grid, size_t gridCount,
+    double* density)
+{
+    const double inverse = 1.0 / bandwidth;
+    const double scale = count == 0 ? 0.0 : inverse / (static_cast<double>(count) * std::sqrt(2.0 * 3.14159265358979323846));
+    for (size_t g = 0; g < gridCount; ++g)
+    {
+        const double* first = std::lower_bound(sorted, sorted + count, grid[g] - kKdeReach * bandwidth);
+        const double* last = std::lower_bound(first, sorted + count, grid[g] + kKdeReach * bandwidth);
+        double sum = 0.0;
+        for (const double* value = first; value < last; ++value)
+        {
+            const double u = (*value - grid[g]) * inverse;
+            sum += std::exp(-0.5 * u * u);
+        }
+        density[g] = sum * scale;
+    }
+}
+
+void EcdfScalar(const double* sorted, size_t count, const double* queries, size_t queryCount, double* fractions)
+{
+    const double inverse = count == 0 ? 0.0 : 1.0 / static_cast<double>(count);
+    for (size_t q = 0; q < queryCount; ++q)
+    {
+        fractions[q] = static_cast<double>(std::upper_bound(sorted, sorted + count, queries[q]) - sorted) * inverse;
+    }
+}
+
+const AnalyticsKernels kScalarKernels = {
+    SumSquaresScalar,
+    FixedHistogramScalar,
+    EdgeHistogramScalar,
+    GaussianKdeScalar,
+    EcdfScalar,
+};
+
+// Nearest-rank quantile of the ascending, non-empty `sorted`.
+double SortedQuantile(const std::vector<double>& sorted, double fraction)
+{
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+} // namespace
+
+SimdLevel DetectSimdLevel()
+{
+    static const SimdLevel level = CpuHasAvx2() && Avx2AnalyticsKernels() != nullptr ? SimdLevel::Avx2 : SimdLevel::Scalar;
+    return level;
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+    return level == SimdLevel::Avx2 ? "avx2" : "scalar";
+}
+
+const AnalyticsKernels& GetAnalyticsKernels(SimdLevel level)
+{
+    if (level == SimdLevel::Avx2 && DetectSimdLevel() == SimdLevel::Avx2)
+    {
+        return *Avx2AnalyticsKernels();
+    }
+    return kScalarKernels;
+}
+
+DistributionReport ComputeDistribution(const std::vector<double>& sorted, const DistributionOptions& options, SimdLevel level)
+{
+    const AnalyticsKernels& kernels = GetAnalyticsKernels(level);
+    DistributionReport report;
+    const size_t count = sorted.size();
+    report.count = count;
+
+    report.bins.assign(options.binCount + 2, 0);
+    kernels.fixedHistogram(sorted.data(), count, options.lowMs, 1.0 / options.binMs, options.binCount, report.bins.data());
+
+    const double decades = std::log10(options.logHighMs / options.logLowMs);
+    const size_t logBinCount = std::max<size_t>(1, static_cast<size_t>(std::lround(decades * static_cast<double>(options.logBinsPerDecade))));
+    report.logEdges.resize(logBinCount + 1);
+    for (size_t i = 0; i < logBinCount; ++i)
+    {
+        report.logEdges[i] = options.logLowMs * std::pow(10.0, decades * static_cast<double>(i) / static_cast<double>(logBinCount));
+    }
+    report.logEdges[logBinCount] = options.logHighMs;
+    report.logBins.assign(logBinCount + 2, 0);
+    kernels.edgeHistogram(sorted.data(), count, report.logEdges.data(), report.logEdges.size(), report.logBins.data());
+
+    const size_t points = std::max<size_t>(2, options.gridPoints);
+    const double span = static_cast<double>(options.binCount) * options.binMs;
+    report.grid.resize(points);
+    for (size_t i = 0; i < points; ++i)
+    {
+        report.grid[i] = options.lowMs + span * static_cast<double>(i) / static_cast<double>(points - 1);
+    }
+    report.density.assign(points, 0.0);
+    report.cdf.assign(points, 0.0);
+    if (count == 0)
+    {
+        return report;
+    }
+
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    kernels.sumSquares(sorted.data(), count, sum, sumSquares);
+    const double n = static_cast<double>(count);
+    report.meanMs = sum / n;
+    report.sdMs = count < 2 ? 0.0 : std::sqrt(std::max(0.0, (sumSquares - sum * report.meanMs) / (n - 1.0)));
+
+    report.bandwidthMs = options.bandwidthMs;
+    if (report.bandwidthMs <= 0.0)
+    {
+        const double iqrSpread = (SortedQuantile(sorted, 0.75) - SortedQuantile(sorted, 0.25)) / 1.34;
+        double spread = std::min(report.sdMs, iqrSpread);
+        if (spread <= 0.0)
+        {
+            spread = std::max(report.sdMs, iqrSpread);
+        }
+        report.bandwidthMs = 0.9 * spread * std::pow(n, -0.2);
+        if (report.bandwidthMs <= 0.0)
+        {
+            report.bandwidthMs = options.binMs;  // every value the same
+        }
+    }
+    kernels.gaussianKde(sorted.data(), count, report.bandwidthMs, report.grid.data(), points, report.density.data());
+    kernels.ecdf(sorted.data(), count, report.grid.data(), points, report.cdf.data());
+    return report;
+}
+} // namespace purple
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace purple
+{
+// Distribution kernels over contiguous reaction-time arrays, for reports on archives of millions of trials
+// (purple_aggregate --distribution-out) and single runs (--json-distribution, export.h). Every kernel has a scalar version and an AVX2 one; the AVX2 table
+// is used when the CPU and OS support it (DetectSimdLevel) and the build targets x86-64. Histogram and ECDF
+// results are identical between the two; sums and KDE densities differ only in rounding.
+enum class SimdLevel
+{
+    Scalar,
+    Avx2
+};
+
+// Best level this process can run, detected once.
+SimdLevel DetectSimdLevel();
+const char* SimdLevelName(SimdLevel level);
+
+struct AnalyticsKernels
+{
+    // Sum and sum of squares of `values`.
+    void (*sumSquares)(const double* values, size_t count, double& sum, double& sumSquares);
+    // bins[0] counts values below `low`, bins[1 + i] values in [low + i * width, low + (i + 1) * width)
+    // (width = 1 / inverseWidth), bins[binCount + 1] the rest. Adds to `bins`.
+    void (*fixedHistogram)(const double* values, size_t count, double low, double inverseWidth, size_t binCount,
+        std::uint64_t* bins);
+    // Same layout over ascending `edges` (edgeCount - 1 bins): bins[0] below edges[0], bins[edgeCount] at or
+    // above the last edge. Any edges work; log bins are geometric ones.
+    void (*edgeHistogram)(const double* values, size_t count, const double* edges, size_t edgeCount, std::uint64_t* bins);
+    // Gaussian kernel density at each grid point, over the ascending `sorted` values within 6 bandwidths of it.
+    void (*gaussianKde)(const double* sorted, size_t count, double bandwidth, const double* grid, size_t gridCount,
+        double* density);
+    // Fraction of the ascending `sorted` values at or below each query point (queries in any order).
+    void (*ecdf)(const double* sorted, size_t count, const double* queries, size_t queryCount, double* fractions);
+};
+
+// The kernels of `level`; the scalar table when that level is not available.
+const AnalyticsKernels& GetAnalyticsKernels(SimdLevel level);
+
+// The AVX2 table (analytics_avx2.cpp); null unless the build targets x86-64.
+const AnalyticsKernels* Avx2AnalyticsKernels();
+
+// Both KDE kernels sum over the values within this many bandwidths of each grid point (exp(-18) of the peak
+// is left out beyond it).
+constexpr double kKdeReach = 6.0;
+
+struct DistributionOptions
+{
+    double lowMs = 0.0;              // fixed bins, KDE and ECDF grid start
+    double binMs = 10.0;
+    size_t binCount = 200;           // fixed bins up to lowMs + binCount * binMs
+    double logLowMs = 10.0;          // log bins from here to logHighMs
+    double logHighMs = 10000.0;
+    size_t logBinsPerDecade = 20;
+    size_t gridPoints = 401;         // KDE and ECDF points, evenly over the fixed-bin range
+    double bandwidthMs = 0.0;        // 0: Silverman's rule, 0.9 min(sd, IQR / 1.34) n^-1/5
+};
+
+struct DistributionReport
+{
+    size_t count = 0;
+    double meanMs = 0.0;
+    double sdMs = 0.0;
+    double bandwidthMs = 0.0;
+    std::vector<std::uint64_t> bins;     // fixed bins, with the below/above counts at the ends
+    std::vector<double> logEdges;
+    std::vector<std::uint64_t> logBins;  // log bins, the same way
+    std::vector<double> grid;
+    std::vector<double> density;         // per ms
+    std::vector<double> cdf;
+};
+
+// Histograms, KDE and ECDF of the ascending `sorted` values.
+DistributionReport ComputeDistribution(const std::vector<double>& sorted, const DistributionOptions& options,
+    SimdLevel level = DetectSimdLevel());
+} // namespace purple
@@ -0,0 +1,359 @@
+#include "core/analytics.h"
+
+// Only ever called after DetectSimdLevel has seen AVX2 on the running CPU. The file is built for the baseline
+// target: each kernel opts into AVX2 code generation on its own (MSVC compiles the intrinsics without /arch),
+// so the standard library code instantiated here, which the linker may pick over other files' copies, never
+// holds AVX2 instructions.
+#if defined(_M_X64) || defined(__x86_64__)
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define PURPLE_AVX2
+#else
+#define PURPLE_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace purple
+{
+namespace
+{
+// e^x for x in [-708, 0]: x = n ln 2 + r with |r| <= ln 2 / 2, e^r from its degree-11 Taylor polynomial
+// (error below 1e-14) and 2^n built in the exponent bits.
+PURPLE_AVX2 __m256d Exp(__m256d x)
+{
+    const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(6.93147180369123816490e-01)));
+    r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(1.90821492927058770002e-10)));
+    static const double kInverseFactorials[] = {1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0,
+        1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0};
+    __m256d p = _mm256_set1_pd(kInverseFactorials[0]);
+    for (size_t i = 1; i < sizeof(kInverseFactorials) / sizeof(kInverseFactorials[0]); ++i)
+    {
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(kInverseFactorials[i]));
+    }
+    // n + 1.5 * 2^52 holds n in its low mantissa bits; rebias them into the exponent field.
+    const __m256i shifted = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(6755399441055744.0)));
+    const __m256i exponent = _mm256_slli_epi64(_mm256_sub_epi64(shifted, _mm256_set1_epi64x(0x4338000000000000LL - 1023)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(exponent));
+}
+
+// Per lane of each x, how many of the ascending sorted[0, count) are at or below it (count >= 1): the
+// branch-free halving search, every lane probing through a gather. Searching several vectors together
+// keeps that many more cache misses in flight.
+template <size_t kVectors>
+PURPLE_AVX2 void UpperBounds(const double* sorted, size_t count, const __m256d (&x)[kVectors], __m256i (&below)[kVectors])
+{
+    for (size_t v = 0; v < kVectors; ++v)
+    {
+        below[v] = _mm256_setzero_si256();
+    }
+    size_t length = count;
+    while (length > 1)
+    {
+        const size_t half = length / 2;
+        const __m256i halfVector = _mm256_set1_epi64x(static_cast<long long>(half));
+        for (size_t v = 0; v < kVectors; ++v)
+        {
+            const __m256d probe = _mm256_i64gather_pd(sorted, _mm256_add_epi64(below[v], halfVector), 8);
+            const __m256i atOrBelow = _mm256_castpd_si256(_mm256_cmp_pd(probe, x[v], _CMP_LE_OQ));
+            below[v] = _mm256_add_epi64(below[v], _mm256_and_si256(atOrBelow, halfVector));
+        }
+        length -= half;
+    }
+    for (size_t v = 0; v < kVectors; ++v)
+    {
+        const __m256d last = _mm256_i64gather_pd(sorted, below[v], 8);
+        below[v] = _mm256_sub_epi64(below[v], _mm256_castpd_si256(_mm256_cmp_pd(last, x[v], _CMP_LE_OQ)));
+    }
+}
+
+PURPLE_AVX2 double HorizontalSum(__m256d v)
+{
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+PURPLE_AVX2 void SumSquaresAvx2(const double* values, size_t count, double& sum, double& sumSquares)
+{
+    // Two accumulators each, so consecutive adds do not wait on one another.
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d q0 = _mm256_setzero_pd();
+    __m256d q1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256d a = _mm256_loadu_pd(values + i);
+        const __m256d b = _mm256_loadu_pd(values + i + 4);
+        s0 = _mm256_add_pd(s0, a);
+        s1 = _mm256_add_pd(s1, b);
+        q0 = _mm256_add_pd(q0, _mm256_mul_pd(a, a));
+        q1 = _mm256_add_pd(q1, _mm256_mul_pd(b, b));
+    }
+    double s = HorizontalSum(_mm256_add_pd(s0, s1));
+    double q = HorizontalSum(_mm256_add_pd(q0, q1));
+    for (; i < count; ++i)
+    {
+        s += values[i];
+        q += values[i] * values[i];
+    }
+    sum = s;
+    sumSquares = q;
+}
+
+PURPLE_AVX2 void FixedHistogramAvx2(const double* values, size_t count, double low, double inverseWidth, size_t binCount,
+    std::uint64_t* bins)
+{
+    // Bin indices four at a time; each lane counts into its own copy of the bins, so runs of trials landing
+    // in the same bin do not stall on one counter.
+    const size_t stride = binCount + 2;
+    std::vector<std::uint64_t> lanes(4 * stride, 0);
+    const __m256d lowVector = _mm256_set1_pd(low);
+    const __m256d inverseVector = _mm256_set1_pd(inverseWidth);
+    const __m256d top = _mm256_set1_pd(static_cast<double>(binCount));
+    const __m256d minusOne = _mm256_set1_pd(-1.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    alignas(16) std::int32_t index[4];
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d position = _mm256_floor_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(values + i), lowVector), inverseVector));
+        position = _mm256_max_pd(_mm256_min_pd(position, top), minusOne);
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm256_cvttpd_epi32(_mm256_add_pd(position, one)));
+        ++lanes[static_cast<size_t>(index[0])];
+        ++lanes[stride + static_cast<size_t>(index[1])];
+        ++lanes[2 * stride + static_cast<size_t>(index[2])];
+        ++lanes[3 * stride + static_cast<size_t>(index[3])];
+    }
+    for (size_t b = 0; b < stride; ++b)
+    {
+        bins[b] += lanes[b] + lanes[stride + b] + lanes[2 * stride + b] + lanes[3 * stride + b];
+    }
+    for (; i < count; ++i)
+    {
+        double position = std::floor((values[i] - low) * inverseWidth);
+        position = position < static_cast<double>(binCount) ? position : static_cast<double>(binCount);
+        position = position > -1.0 ? position : -1.0;
+        ++bins[static_cast<size_t>(position + 1.0)];
+    }
+}
+
+// Edge lookup by the bit pattern of positive doubles, which orders them like their values: the top
+// exponent and mantissa bits split the edge range into cells of nearly equal log width, and a table gives
+// the edges at or below each cell's start. When no cell holds more than one edge, a value's bin is that
+// entry plus one compare against the next edge, exact and independent of the edge count.
+struct EdgeCells
+{
+    int shift = 0;                     // bits dropped from the pattern
+    long long firstKey = 0;            // key of table[0], the cell below the first edge's
+    __m256d lowest;                    // start of table[0]'s cell
+    __m256d highest;                   // start of the last cell, past every edge
+    std::vector<std::int64_t> table;
+    std::vector<double> edges;         // the edges and a NaN sentinel, at or below no value
+};
+
+double CellStart(long long key, int shift)
+{
+    const std::uint64_t bits = static_cast<std::uint64_t>(key) << shift;
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+long long CellKey(double value, int shift)
+{
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return static_cast<long long>(bits >> shift);
+}
+
+// False when the edges are not positive and finite or need too many cells to keep one edge per cell.
+PURPLE_AVX2 bool BuildEdgeCells(const double* edges, size_t edgeCount, EdgeCells& cells)
+{
+    constexpr size_t kMaxCells = 1 << 14;
+    if (!(edges[0] > 0.0) || !std::isfinite(edges[edgeCount - 1]))
+    {
+        return false;
+    }
+    for (int mantissaBits = 4; mantissaBits <= 12; ++mantissaBits)
+    {
+        const int shift = 52 - mantissaBits;
+        const long long firstKey = CellKey(edges[0], shift) - 1;
+        const long long lastKey = CellKey(edges[edgeCount - 1], shift) + 1;
+        if (firstKey < 1 || static_cast<size_t>(lastKey - firstKey + 1) > kMaxCells)
+        {
+            return false;
+        }
+        cells.table.resize(static_cast<size_t>(lastKey - firstKey + 1));
+        bool oneEdgePerCell = true;
+        for (size_t c = 0; c < cells.table.size() && oneEdgePerCell; ++c)
+        {
+            const double start = CellStart(firstKey + static_cast<long long>(c), shift);
+            cells.table[c] = std::upper_bound(edges, edges + edgeCount, start) - edges;
+            oneEdgePerCell = c == 0 || cells.table[c] - cells.table[c - 1] <= 1;
+        }
+        if (oneEdgePerCell)
+        {
+            cells.shift = shift;
+            cells.firstKey = firstKey;
+            cells.lowest = _mm256_set1_pd(CellStart(firstKey, shift));
+            cells.highest = _mm256_set1_pd(CellStart(lastKey, shift));
+            cells.edges.assign(edges, edges + edgeCount);
+            cells.edges.push_back(std::numeric_limits<double>::quiet_NaN());
+            return true;
+        }
+    }
+    return false;
+}
+
+PURPLE_AVX2 void EdgeHistogramAvx2(const double* values, size_t count, const double* edges, size_t edgeCount, std::uint64_t* bins)
+{
+    if (edgeCount == 0)
+    {
+        bins[0] += count;
+        return;
+    }
+    alignas(32) std::int64_t index[8];
+    size_t i = 0;
+    EdgeCells cells;
+    if (count >= 4096 && BuildEdgeCells(edges, edgeCount, cells))
+    {
+        // Values outside the table clamp to its end cells, whose entries are 0 and edgeCount; the compare
+        // uses the unclamped value, and the sentinel never counts.
+        const size_t stride = edgeCount + 1;
+        std::vector<std::uint64_t> lanes(4 * stride, 0);
+        const __m256i firstKey = _mm256_set1_epi64x(cells.firstKey);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m256d x = _mm256_loadu_pd(values + i);
+            const __m256d clamped = _mm256_min_pd(_mm256_max_pd(x, cells.lowest), cells.highest);
+            const __m256i cell = _mm256_sub_epi64(_mm256_srli_epi64(_mm256_castpd_si256(clamped), cells.shift), firstKey);
+            const __m256i below = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(cells.table.data()), cell, 8);
+            const __m256d next = _mm256_i64gather_pd(cells.edges.data(), below, 8);
+            const __m256i bin = _mm256_sub_epi64(below, _mm256_castpd_si256(_mm256_cmp_pd(next, x, _CMP_LE_OQ)));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(index), bin);
+            ++lanes[static_cast<size_t>(index[0])];
+            ++lanes[stride + static_cast<size_t>(index[1])];
+            ++lanes[2 * stride + static_cast<size_t>(index[2])];
+            ++lanes[3 * stride + static_cast<size_t>(index[3])];
+        }
+        for (size_t b = 0; b < stride; ++b)
+        {
+            bins[b] += lanes[b] + lanes[stride + b] + lanes[2 * stride + b] + lanes[3 * stride + b];
+        }
+    }
+    else
+    {
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256d x[2] = {_mm256_loadu_pd(values + i), _mm256_loadu_pd(values + i + 4)};
+            __m256i below[2];
+            UpperBounds(edges, edgeCount, x, below);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(index), below[0]);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(index + 4), below[1]);
+            for (size_t lane = 0; lane < 8; ++lane)
+            {
+                ++bins[static_cast<size_t>(index[lane])];
+            }
+        }
+    }
+    for (; i < count; ++i)
+    {
+        ++bins[static_cast<size_t>(std::upper_bound(edges, edges + edgeCount, values[i]) - edges)];
+    }
+}
+
+PURPLE_AVX2 void GaussianKdeAvx2(const double* sorted, size_t count, double bandwidth, const double* grid, size_t gridCount,
+    double* density)
+{
+    const double inverse = 1.0 / bandwidth;
+    const double scale = count == 0 ? 0.0 : inverse / (static_cast<double>(count) * std::sqrt(2.0 * 3.14159265358979323846));
+    const __m256d inverseVector = _mm256_set1_pd(inverse);
+    const __m256d minusHalf = _mm256_set1_pd(-0.5);
+    for (size_t g = 0; g < gridCount; ++g)
+    {
+        const double* first = std::lower_bound(sorted, sorted + count, grid[g] - kKdeReach * bandwidth);
+        const double* last = std::lower_bound(first, sorted + count, grid[g] + kKdeReach * bandwidth);
+        const __m256d center = _mm256_set1_pd(grid[g]);
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        const double* value = first;
+        for (; last - value >= 8; value += 8)
+        {
+            const __m256d u0 = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(value), center), inverseVector);
+            const __m256d u1 = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(value + 4), center), inverseVector);
+            sum0 = _mm256_add_pd(sum0, Exp(_mm256_mul_pd(minusHalf, _mm256_mul_pd(u0, u0))));
+            sum1 = _mm256_add_pd(sum1, Exp(_mm256_mul_pd(minusHalf, _mm256_mul_pd(u1, u1))));
+        }
+        double sum = HorizontalSum(_mm256_add_pd(sum0, sum1));
+        for (; value < last; ++value)
+        {
+            const double u = (*value - grid[g]) * inverse;
+            sum += std::exp(-0.5 * u * u);
+        }
+        density[g] = sum * scale;
+    }
+}
+
+PURPLE_AVX2 void EcdfAvx2(const double* sorted, size_t count, const double* queries, size_t queryCount, double* fractions)
+{
+    if (count == 0)
+    {
+        std::fill(fractions, fractions + queryCount, 0.0);
+        return;
+    }
+    const double inverse = 1.0 / static_cast<double>(count);
+    alignas(32) std::int64_t below[8];
+    size_t q = 0;
+    for (; q + 8 <= queryCount; q += 8)
+    {
+        const __m256d x[2] = {_mm256_loadu_pd(queries + q), _mm256_loadu_pd(queries + q + 4)};
+        __m256i counts[2];
+        UpperBounds(sorted, count, x, counts);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(below), counts[0]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(below + 4), counts[1]);
+        for (size_t lane = 0; lane < 8; ++lane)
+        {
+            fractions[q + lane] = static_cast<double>(below[lane]) * inverse;
+        }
+    }
+    for (; q < queryCount; ++q)
+    {
+        fractions[q] = static_cast<double>(std::upper_bound(sorted, sorted + count, queries[q]) - sorted) * inverse;
+    }
+}
+
+const AnalyticsKernels kAvx2Kernels = {
+    SumSquaresAvx2,
+    FixedHistogramAvx2,
+    EdgeHistogramAvx2,
+    GaussianKdeAvx2,
+    EcdfAvx2,
+};
+} // namespace
+
+const AnalyticsKernels* Avx2AnalyticsKernels()
+{
+    return &kAvx2Kernels;
+}
+} // namespace purple
+
+#else
+
+namespace purple
+{
+const AnalyticsKernels* Avx2AnalyticsKernels()
+{
+    return nullptr;
+}
+} // namespace purple
+
+#endif
@@ -0,0 +1,103 @@
+#include "core/buffered_writer.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace purple
+{
+namespace
+{
+// Longest std::chars_format::fixed text for a double at precision 6: sign, 309 integer digits, point, six decimals.
+constexpr size_t kMaxFixed6Chars = 320;
+} // namespace
+
+BufferedFileWriter::~BufferedFileWriter()
+{
+    Close();
+}
+
+bool BufferedFileWriter::Open(const std::string& path)
+{
+    Close();
+    failed_ = false;
+    used_ = 0;
+
+    // Text mode like the std::ofstream it replaces, so Windows line endings stay identical.
+    file_ = std::fopen(path.c_str(), "w");
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+    // Whole chunks go straight to the OS; a second stdio buffer would only add a copy.
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    return true;
+}
+
+void BufferedFileWriter::Append(const char* text, size_t length)
+{
+    while (length > 0)
+    {
+        if (used_ == kChunkBytes)
+        {
+            FlushChunk();
+        }
+        const size_t take = (length < kChunkBytes - used_) ? length : kChunkBytes - used_;
+        std::memcpy(chunk_ + used_, text, take);
+        used_ += take;
+        text += take;
+        length -= take;
+    }
+}
+
+void BufferedFileWriter::AppendString(const char* text)
+{
+    Append(text, std::strlen(text));
+}
+
+void BufferedFileWriter::AppendUnsigned(std::uint64_t value)
+{
+    Reserve(20);
+    const std::to_chars_result result = std::to_chars(chunk_ + used_, chunk_ + kChunkBytes, value);
+    used_ = static_cast<size_t>(result.ptr - chunk_);
+}
+
+void BufferedFileWriter::AppendFixed6(double value)
+{
+    Reserve(kMaxFixed6Chars);
+    const std::to_chars_result result =
+        std::to_chars(chunk_ + used_, chunk_ + kChunkBytes, value, std::chars_format::fixed, 6);
+    used_ = static_cast<size_t>(result.ptr - chunk_);
+}
+
+bool BufferedFileWriter::Close()
+{
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+    FlushChunk();
+    if (std::fclose(file_) != 0)
+    {
+        failed_ = true;
+    }
+    file_ = nullptr;
+    return !failed_;
+}
+
+void BufferedFileWriter::Reserve(size_t bytes)
+{
+    if (kChunkBytes - used_ < bytes)
+    {
+        FlushChunk();
+    }
+}
+
+void BufferedFileWriter::FlushChunk()
+{
+    if (used_ > 0 && std::fwrite(chunk_, 1, used_, file_) != used_)
+    {
+        failed_ = true;
+    }
+    used_ = 0;
+}
+} // namespace purple
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace purple
+{
+// Append-only text file writer for the exporters. Fields are formatted with std::to_chars into a fixed
+// chunk buffer (no locale, no heap allocation) and written out in kChunkBytes blocks. Doubles use the
+// same text as an ostream with std::fixed and setprecision(6), so exported files stay byte-identical.
+class BufferedFileWriter
+{
+public:
+    static constexpr size_t kChunkBytes = 64 * 1024;
+
+    BufferedFileWriter() = default;
+    ~BufferedFileWriter();
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    bool Open(const std::string& path);
+    bool IsOpen() const { return file_ != nullptr; }
+
+    template <size_t N>
+    void Append(const char (&literal)[N])
+    {
+        Append(literal, N - 1);
+    }
+    void Append(const char* text, size_t length);
+    void AppendString(const char* text);
+    void AppendUnsigned(std::uint64_t value);
+    void AppendFixed6(double value);
+
+    // Flushes and closes; false if any write failed since Open.
+    bool Close();
+
+private:
+    void Reserve(size_t bytes);
+    void FlushChunk();
+
+    std::FILE* file_ = nullptr;
+    bool failed_ = false;
+    size_t used_ = 0;
+    char chunk_[kChunkBytes];
+};
+} // namespace purple
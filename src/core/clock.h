@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace purple
+{
+// Raw clock ticks; the frequency belongs to the clock policy that produced them (QPC, CLOCK_MONOTONIC ns, ...).
+using Ticks = std::int64_t;
+
+inline double TicksToMilliseconds(Ticks delta, Ticks freq)
+{
+    return static_cast<double>(delta) * 1000.0 / static_cast<double>(freq);
+}
+
+inline double TicksToSeconds(Ticks delta, Ticks freq)
+{
+    return static_cast<double>(delta) / static_cast<double>(freq);
+}
+
+inline Ticks SecondsToTicks(double seconds, Ticks freq)
+{
+    return static_cast<Ticks>(seconds * static_cast<double>(freq));
+}
+} // namespace purple
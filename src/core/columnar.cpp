@@ -0,0 +1,513 @@
+#include "core/columnar.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(PURPLE_BUILD_ID)
+#define PURPLE_BUILD_ID "unknown"
+#endif
+
+namespace purple
+{
+namespace
+{
+constexpr std::uint64_t kColumnAlignment = 64;
+
+std::uint64_t AlignColumn(std::uint64_t offset)
+{
+    return (offset + kColumnAlignment - 1) / kColumnAlignment * kColumnAlignment;
+}
+
+// One column gathered from the results before writing.
+struct PendingColumn
+{
+    ColumnId id;
+    std::uint32_t elementBytes;
+    std::vector<unsigned char> bytes;
+};
+
+template <typename T, typename Field>
+PendingColumn GatherColumn(ColumnId id, const std::vector<TrialResult>& results, Field field)
+{
+    PendingColumn column{id, static_cast<std::uint32_t>(sizeof(T)), std::vector<unsigned char>(results.size() * sizeof(T))};
+    unsigned char* out = column.bytes.data();
+    for (const TrialResult& trial : results)
+    {
+        const T value = field(trial);
+        std::memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
+    return column;
+}
+
+Ticks MillisecondsToTextTicks(double ms)
+{
+    return static_cast<Ticks>(std::llround(ms * 1e6));
+}
+
+template <size_t N>
+void CopyFixedString(char (&out)[N], const std::string& text)
+{
+    std::memcpy(out, text.data(), std::min(text.size(), N));
+}
+
+template <size_t N>
+std::string ReadFixedString(const char (&text)[N])
+{
+    return std::string(text, std::find(text, text + N, '\0'));
+}
+
+ColumnarRunSettings MakeRunSettings(const ExportMetadata& metadata)
+{
+    ColumnarRunSettings settings;
+    if (metadata.foreperiod != nullptr)
+    {
+        const ForeperiodConfig& foreperiod = *metadata.foreperiod;
+        settings.present |= ColumnarRunSettings::kHasForeperiod;
+        settings.foreperiodDistribution = static_cast<std::uint32_t>(foreperiod.distribution);
+        settings.foreperiodSeed = foreperiod.seed;
+        settings.foreperiodMeanSeconds = foreperiod.meanSeconds;
+        settings.foreperiodStepSeconds = foreperiod.stepSeconds;
+    }
+    if (metadata.realtime != nullptr)
+    {
+        const RealtimeReport& realtime = *metadata.realtime;
+        settings.present |= ColumnarRunSettings::kHasRealtime;
+        settings.realtimeProfile = static_cast<std::uint32_t>(realtime.profile);
+        settings.realtimeFlags = (realtime.priorityRaised ? ColumnarRunSettings::kPriorityRaised : 0) |
+            (realtime.inputPriorityRaised ? ColumnarRunSettings::kInputPriorityRaised : 0) |
+            (realtime.memoryLocked ? ColumnarRunSettings::kMemoryLocked : 0) |
+            (realtime.powerThrottlingOff ? ColumnarRunSettings::kPowerThrottlingOff : 0) |
+            (realtime.cpuDmaLatencyHeld ? ColumnarRunSettings::kCpuDmaLatencyHeld : 0);
+        settings.fifoPriority = realtime.fifoPriority;
+        CopyFixedString(settings.timingCpus, realtime.timingCpus);
+        CopyFixedString(settings.inputCpus, realtime.inputCpus);
+        CopyFixedString(settings.mmcssTask, realtime.mmcssTask);
+    }
+    if (metadata.stopping != nullptr)
+    {
+        const StoppingReport& stopping = *metadata.stopping;
+        settings.present |= ColumnarRunSettings::kHasStopping;
+        settings.stopStatistic = static_cast<std::uint32_t>(stopping.rule.statistic);
+        settings.stopReason = static_cast<std::uint32_t>(stopping.reason);
+        settings.stopMinValidTrials = stopping.rule.minValidTrials;
+        settings.stopTrials = stopping.trials;
+        settings.stopValidTrials = stopping.validTrials;
+        settings.stopTargetMs = stopping.rule.halfWidthMs;
+        settings.stopConfidence = stopping.rule.confidence;
+        settings.stopEstimateMs = stopping.estimateMs;
+        settings.stopHalfWidthMs = stopping.halfWidthMs;
+    }
+    return settings;
+}
+} // namespace
+
+const char* ColumnarBuildId()
+{
+    return PURPLE_BUILD_ID;
+}
+
+bool ExportResultsColumnar(
+    const std::vector<TrialResult>& results,
+    const SessionConfig& config,
+    Ticks frequency,
+    const std::string& path,
+    const ExportMetadata& metadata,
+    std::uint32_t extraFlags)
+{
+    if (results.empty())
+    {
+        std::printf("No results to export.\n");
+        return false;
+    }
+
+    std::vector<PendingColumn> columns;
+    columns.push_back(GatherColumn<double>(ColumnId::DelaySeconds, results, [](const TrialResult& t) { return t.delaySeconds; }));
+    columns.push_back(GatherColumn<std::int64_t>(ColumnId::TrialStartTicks, results, [](const TrialResult& t) { return t.ticks.trialStart; }));
+    columns.push_back(GatherColumn<std::int64_t>(ColumnId::DelayTicks, results, [](const TrialResult& t) { return t.ticks.delay; }));
+    columns.push_back(GatherColumn<std::int64_t>(ColumnId::StimulusTicks, results, [](const TrialResult& t) { return t.ticks.stimulus; }));
+    columns.push_back(GatherColumn<std::int64_t>(ColumnId::MidpointTicks, results, [](const TrialResult& t) { return t.ticks.stimulusMidpoint; }));
+    columns.push_back(GatherColumn<std::int64_t>(ColumnId::InputTicks, results, [](const TrialResult& t) { return t.ticks.input; }));
+    columns.push_back(GatherColumn<std::int64_t>(ColumnId::OvershootTicks, results, [](const TrialResult& t) { return t.ticks.onsetOvershoot; }));
+    columns.push_back(GatherColumn<std::uint32_t>(ColumnId::Flags, results, [](const TrialResult& t)
+    {
+        return (t.falseStart ? kRowFalseStart : 0u) | (t.onsetSource == OnsetSource::Scanout ? kRowScanoutOnset : 0u);
+    }));
+    columns.push_back(GatherColumn<std::uint32_t>(ColumnId::Block, results, [](const TrialResult& t) { return static_cast<std::uint32_t>(t.block); }));
+    columns.push_back(GatherColumn<std::uint32_t>(ColumnId::Device, results, [](const TrialResult& t)
+    {
+        return t.device < 0 ? kNoDevice : static_cast<std::uint32_t>(t.device);
+    }));
+    if (config.recordTiming)
+    {
+        columns.push_back(GatherColumn<double>(ColumnId::ForeperiodMs, results, [](const TrialResult& t) { return t.timing.foreperiodMs; }));
+        columns.push_back(GatherColumn<double>(ColumnId::PresentMs, results, [](const TrialResult& t) { return t.timing.presentMs; }));
+        columns.push_back(GatherColumn<double>(ColumnId::InputLagMs, results, [](const TrialResult& t) { return t.timing.inputLagMs; }));
+        columns.push_back(GatherColumn<double>(ColumnId::MaxLoopGapMs, results, [](const TrialResult& t) { return t.timing.maxIterationGapMs; }));
+        columns.push_back(GatherColumn<std::uint32_t>(ColumnId::LoopIterations, results, [](const TrialResult& t) { return t.timing.loopIterations; }));
+    }
+
+    ColumnarFileHeader header;
+    header.flags = (config.recordTiming ? ColumnarFileHeader::kFlagRecordTiming : 0) | extraFlags;
+    header.tickFrequency = frequency;
+    header.rowCount = results.size();
+    header.columnCount = static_cast<std::uint32_t>(columns.size());
+    header.planBlocks = static_cast<std::uint32_t>(config.plan.size());
+    header.trialCount = config.trialCount;
+    const std::vector<InputDevice> noDevices;
+    const std::vector<InputDevice>& devices = metadata.devices != nullptr ? *metadata.devices : noDevices;
+    header.deviceCount = static_cast<std::uint32_t>(devices.size());
+    header.minDelaySeconds = config.minDelaySeconds;
+    header.maxDelaySeconds = config.maxDelaySeconds;
+    std::strncpy(header.buildId, ColumnarBuildId(), sizeof(header.buildId));
+
+    std::vector<ColumnarPlanBlock> plan(config.plan.size());
+    for (size_t i = 0; i < config.plan.size(); ++i)
+    {
+        const PlanBlock& block = config.plan[i];
+        std::memcpy(plan[i].id, block.id.data(), std::min(block.id.size(), sizeof(plan[i].id)));
+        plan[i].trialCount = block.trialCount;
+        plan[i].minDelaySeconds = block.minDelaySeconds;
+        plan[i].maxDelaySeconds = block.maxDelaySeconds;
+        plan[i].restSeconds = block.restSeconds;
+    }
+    const ColumnarRunSettings settings = MakeRunSettings(metadata);
+    std::vector<ColumnarDevice> deviceTable(devices.size());
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        deviceTable[i].handle = devices[i].handle;
+        deviceTable[i].vendorId = devices[i].vendorId;
+        deviceTable[i].productId = devices[i].productId;
+        CopyFixedString(deviceTable[i].id, devices[i].id);
+        CopyFixedString(deviceTable[i].name, devices[i].name);
+    }
+
+    std::vector<ColumnarColumnEntry> entries(columns.size());
+    const std::uint64_t tableBytes = sizeof(ColumnarFileHeader) + plan.size() * sizeof(ColumnarPlanBlock) +
+        sizeof(ColumnarRunSettings) + deviceTable.size() * sizeof(ColumnarDevice) +
+        entries.size() * sizeof(ColumnarColumnEntry);
+    std::uint64_t offset = tableBytes;
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        offset = AlignColumn(offset);
+        entries[i].id = columns[i].id;
+        entries[i].elementBytes = columns[i].elementBytes;
+        entries[i].offset = offset;
+        offset += columns[i].bytes.size();
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        std::printf("Failed to open columnar path: %s\n", path.c_str());
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && (plan.empty() || std::fwrite(plan.data(), sizeof(ColumnarPlanBlock), plan.size(), file) == plan.size());
+    ok = ok && std::fwrite(&settings, sizeof(settings), 1, file) == 1;
+    ok = ok && (deviceTable.empty() ||
+        std::fwrite(deviceTable.data(), sizeof(ColumnarDevice), deviceTable.size(), file) == deviceTable.size());
+    ok = ok && std::fwrite(entries.data(), sizeof(ColumnarColumnEntry), entries.size(), file) == entries.size();
+    std::uint64_t written = tableBytes;
+    const unsigned char padding[kColumnAlignment] = {};
+    for (size_t i = 0; i < columns.size() && ok; ++i)
+    {
+        const size_t gap = static_cast<size_t>(entries[i].offset - written);
+        ok = (gap == 0 || std::fwrite(padding, 1, gap, file) == gap) &&
+            std::fwrite(columns[i].bytes.data(), 1, columns[i].bytes.size(), file) == columns[i].bytes.size();
+        written = entries[i].offset + columns[i].bytes.size();
+    }
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        std::printf("Failed while writing columnar results: %s\n", path.c_str());
+        return false;
+    }
+    std::printf("Columnar results exported: %s\n", path.c_str());
+    return true;
+}
+
+void SynthesizeTrialTicks(std::vector<TrialResult>& results)
+{
+    // Trials laid end to end: foreperiod, response, then a one-second gap before the next trial starts.
+    Ticks now = kTextTickFrequency;
+    for (TrialResult& trial : results)
+    {
+        TrialTicks& ticks = trial.ticks;
+        ticks = TrialTicks{};
+        ticks.trialStart = now;
+        ticks.delay = SecondsToTicks(trial.delaySeconds, kTextTickFrequency);
+        now += ticks.delay;
+        if (!trial.falseStart)
+        {
+            ticks.stimulusMidpoint = now;
+            ticks.stimulus = now + (trial.onsetSource == OnsetSource::Scanout ? MillisecondsToTextTicks(trial.onsetCorrectionMs) : 0);
+            ticks.input = ticks.stimulus + MillisecondsToTextTicks(trial.reactionMs);
+            ticks.onsetOvershoot = MillisecondsToTextTicks(trial.onsetOvershootMs);
+            now = ticks.input;
+        }
+        now += kTextTickFrequency;
+    }
+}
+
+bool ColumnarResults::Open(const std::string& path)
+{
+    Close();
+    if (!file_.Open(path))
+    {
+        return false;
+    }
+
+    const std::string_view bytes = file_.View();
+    const ColumnarFileHeader expected;
+    if (bytes.size() < sizeof(ColumnarFileHeader))
+    {
+        Close();
+        return false;
+    }
+    const ColumnarFileHeader* header = reinterpret_cast<const ColumnarFileHeader*>(bytes.data());
+    if (std::memcmp(header->magic, expected.magic, sizeof(expected.magic)) != 0 ||
+        header->version < 1 || header->version > ColumnarFileHeader::kVersion || header->tickFrequency <= 0 ||
+        header->planBlocks > 1000 || header->columnCount > 64 || header->deviceCount > 4096)
+    {
+        Close();
+        return false;
+    }
+
+    const bool hasSettings = header->version >= 2;
+    const std::uint32_t deviceCount = hasSettings ? header->deviceCount : 0;
+    const std::uint64_t tableEnd = sizeof(ColumnarFileHeader) + header->planBlocks * sizeof(ColumnarPlanBlock) +
+        (hasSettings ? sizeof(ColumnarRunSettings) : 0) + deviceCount * sizeof(ColumnarDevice) +
+        header->columnCount * sizeof(ColumnarColumnEntry);
+    if (tableEnd > bytes.size())
+    {
+        Close();
+        return false;
+    }
+    const ColumnarPlanBlock* plan = reinterpret_cast<const ColumnarPlanBlock*>(bytes.data() + sizeof(ColumnarFileHeader));
+    const char* next = reinterpret_cast<const char*>(plan + header->planBlocks);
+    const ColumnarRunSettings* settings = hasSettings ? reinterpret_cast<const ColumnarRunSettings*>(next) : nullptr;
+    next += hasSettings ? sizeof(ColumnarRunSettings) : 0;
+    const ColumnarDevice* devices = reinterpret_cast<const ColumnarDevice*>(next);
+    const ColumnarColumnEntry* columns = reinterpret_cast<const ColumnarColumnEntry*>(devices + deviceCount);
+    for (std::uint32_t i = 0; i < header->columnCount; ++i)
+    {
+        const ColumnarColumnEntry& column = columns[i];
+        const bool sized = column.elementBytes == 4 || column.elementBytes == 8;
+        if (!sized || column.offset % column.elementBytes != 0 || column.offset < tableEnd ||
+            header->rowCount > (bytes.size() - std::min<std::uint64_t>(column.offset, bytes.size())) / column.elementBytes)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    header_ = header;
+    plan_ = plan;
+    settings_ = settings;
+    devices_ = deviceCount > 0 ? devices : nullptr;
+    columns_ = columns;
+    return true;
+}
+
+void ColumnarResults::Close()
+{
+    file_.Close();
+    header_ = nullptr;
+    plan_ = nullptr;
+    settings_ = nullptr;
+    devices_ = nullptr;
+    columns_ = nullptr;
+}
+
+SessionConfig ColumnarResults::Config() const
+{
+    SessionConfig config;
+    config.trialCount = header_->trialCount;
+    config.minDelaySeconds = header_->minDelaySeconds;
+    config.maxDelaySeconds = header_->maxDelaySeconds;
+    config.recordTiming = (header_->flags & ColumnarFileHeader::kFlagRecordTiming) != 0;
+    for (std::uint32_t i = 0; i < header_->planBlocks; ++i)
+    {
+        const ColumnarPlanBlock& entry = plan_[i];
+        PlanBlock block;
+        block.id.assign(entry.id, std::find(entry.id, entry.id + sizeof(entry.id), '\0'));
+        block.trialCount = entry.trialCount;
+        block.minDelaySeconds = entry.minDelaySeconds;
+        block.maxDelaySeconds = entry.maxDelaySeconds;
+        block.restSeconds = entry.restSeconds;
+        config.plan.push_back(block);
+    }
+    Foreperiod(config.foreperiod);
+    return config;
+}
+
+bool ColumnarResults::Foreperiod(ForeperiodConfig& foreperiod) const
+{
+    if (settings_ == nullptr || (settings_->present & ColumnarRunSettings::kHasForeperiod) == 0)
+    {
+        return false;
+    }
+    foreperiod.distribution = static_cast<ForeperiodDistribution>(settings_->foreperiodDistribution);
+    foreperiod.meanSeconds = settings_->foreperiodMeanSeconds;
+    foreperiod.stepSeconds = settings_->foreperiodStepSeconds;
+    foreperiod.seeded = true;  // replaying the recorded run means drawing from its seed
+    foreperiod.seed = settings_->foreperiodSeed;
+    return true;
+}
+
+std::vector<InputDevice> ColumnarResults::Devices() const
+{
+    std::vector<InputDevice> devices;
+    for (std::uint32_t i = 0; devices_ != nullptr && i < header_->deviceCount; ++i)
+    {
+        const ColumnarDevice& entry = devices_[i];
+        InputDevice device;
+        device.handle = entry.handle;
+        device.id = ReadFixedString(entry.id);
+        device.name = ReadFixedString(entry.name);
+        device.vendorId = entry.vendorId;
+        device.productId = entry.productId;
+        devices.push_back(device);
+    }
+    return devices;
+}
+
+bool ColumnarResults::Realtime(RealtimeReport& report) const
+{
+    if (settings_ == nullptr || (settings_->present & ColumnarRunSettings::kHasRealtime) == 0)
+    {
+        return false;
+    }
+    report = RealtimeReport{};
+    report.profile = static_cast<RealtimeProfile>(settings_->realtimeProfile);
+    report.priorityRaised = (settings_->realtimeFlags & ColumnarRunSettings::kPriorityRaised) != 0;
+    report.inputPriorityRaised = (settings_->realtimeFlags & ColumnarRunSettings::kInputPriorityRaised) != 0;
+    report.timingCpus = ReadFixedString(settings_->timingCpus);
+    report.inputCpus = ReadFixedString(settings_->inputCpus);
+    report.mmcssTask = ReadFixedString(settings_->mmcssTask);
+    report.fifoPriority = settings_->fifoPriority;
+    report.memoryLocked = (settings_->realtimeFlags & ColumnarRunSettings::kMemoryLocked) != 0;
+    report.powerThrottlingOff = (settings_->realtimeFlags & ColumnarRunSettings::kPowerThrottlingOff) != 0;
+    report.cpuDmaLatencyHeld = (settings_->realtimeFlags & ColumnarRunSettings::kCpuDmaLatencyHeld) != 0;
+    return true;
+}
+
+bool ColumnarResults::Stopping(StoppingReport& report) const
+{
+    if (settings_ == nullptr || (settings_->present & ColumnarRunSettings::kHasStopping) == 0)
+    {
+        return false;
+    }
+    report = StoppingReport{};
+    report.rule.halfWidthMs = settings_->stopTargetMs;
+    report.rule.statistic = static_cast<PrecisionStatistic>(settings_->stopStatistic);
+    report.rule.confidence = settings_->stopConfidence;
+    report.rule.minValidTrials = settings_->stopMinValidTrials;
+    report.reason = static_cast<StopReason>(settings_->stopReason);
+    report.trials = settings_->stopTrials;
+    report.validTrials = static_cast<size_t>(settings_->stopValidTrials);
+    report.estimateMs = settings_->stopEstimateMs;
+    report.halfWidthMs = settings_->stopHalfWidthMs;
+    return true;
+}
+
+const void* ColumnarResults::Find(ColumnId id, std::uint32_t elementBytes) const
+{
+    for (std::uint32_t i = 0; i < header_->columnCount; ++i)
+    {
+        if (columns_[i].id == id && columns_[i].elementBytes == elementBytes)
+        {
+            return file_.View().data() + columns_[i].offset;
+        }
+    }
+    return nullptr;
+}
+
+void ColumnarResults::ReactionsMs(std::vector<double>& validMs, size_t& falseStartCount) const
+{
+    validMs.clear();
+    falseStartCount = 0;
+    const std::int64_t* stimulus = Int64Column(ColumnId::StimulusTicks);
+    const std::int64_t* input = Int64Column(ColumnId::InputTicks);
+    const std::uint32_t* flags = UInt32Column(ColumnId::Flags);
+    if (stimulus == nullptr || input == nullptr || flags == nullptr)
+    {
+        return;
+    }
+
+    const size_t rows = RowCount();
+    const Ticks frequency = header_->tickFrequency;
+    validMs.reserve(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if ((flags[i] & kRowFalseStart) != 0)
+        {
+            ++falseStartCount;
+        }
+        else
+        {
+            validMs.push_back(TicksToMilliseconds(input[i] - stimulus[i], frequency));
+        }
+    }
+}
+
+std::vector<TrialResult> ColumnarResults::ToTrialResults() const
+{
+    const size_t rows = RowCount();
+    const Ticks frequency = header_->tickFrequency;
+    const double* delaySeconds = DoubleColumn(ColumnId::DelaySeconds);
+    const std::int64_t* trialStart = Int64Column(ColumnId::TrialStartTicks);
+    const std::int64_t* delay = Int64Column(ColumnId::DelayTicks);
+    const std::int64_t* stimulus = Int64Column(ColumnId::StimulusTicks);
+    const std::int64_t* midpoint = Int64Column(ColumnId::MidpointTicks);
+    const std::int64_t* input = Int64Column(ColumnId::InputTicks);
+    const std::int64_t* overshoot = Int64Column(ColumnId::OvershootTicks);
+    const std::uint32_t* flags = UInt32Column(ColumnId::Flags);
+    const std::uint32_t* block = UInt32Column(ColumnId::Block);
+    const double* foreperiod = DoubleColumn(ColumnId::ForeperiodMs);
+    const double* present = DoubleColumn(ColumnId::PresentMs);
+    const double* inputLag = DoubleColumn(ColumnId::InputLagMs);
+    const double* maxGap = DoubleColumn(ColumnId::MaxLoopGapMs);
+    const std::uint32_t* iterations = UInt32Column(ColumnId::LoopIterations);
+    const std::uint32_t* device = UInt32Column(ColumnId::Device);
+    const std::uint32_t deviceCount = settings_ != nullptr ? header_->deviceCount : 0;
+    if (delaySeconds == nullptr || trialStart == nullptr || delay == nullptr || stimulus == nullptr ||
+        midpoint == nullptr || input == nullptr || overshoot == nullptr || flags == nullptr || block == nullptr)
+    {
+        return {};
+    }
+    const bool timing = foreperiod != nullptr && present != nullptr && inputLag != nullptr && maxGap != nullptr &&
+        iterations != nullptr;
+
+    std::vector<TrialResult> results(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        TrialResult& trial = results[i];
+        trial.ticks = TrialTicks{trialStart[i], delay[i], stimulus[i], midpoint[i], input[i], overshoot[i]};
+        trial.delaySeconds = delaySeconds[i];
+        trial.falseStart = (flags[i] & kRowFalseStart) != 0;
+        trial.block = static_cast<int>(std::min<std::uint32_t>(block[i], header_->planBlocks > 0 ? header_->planBlocks - 1 : 0));
+        trial.device = device != nullptr && device[i] < deviceCount ? static_cast<int>(device[i]) : -1;
+        if (!trial.falseStart)
+        {
+            // Same expressions as RecordReaction.
+            trial.reactionMs = TicksToMilliseconds(input[i] - stimulus[i], frequency);
+            trial.onsetOvershootMs = TicksToMilliseconds(overshoot[i], frequency);
+            trial.onsetSource = (flags[i] & kRowScanoutOnset) != 0 ? OnsetSource::Scanout : OnsetSource::Midpoint;
+            trial.onsetCorrectionMs = TicksToMilliseconds(stimulus[i] - midpoint[i], frequency);
+        }
+        if (timing)
+        {
+            trial.timing.foreperiodMs = foreperiod[i];
+            trial.timing.presentMs = present[i];
+            trial.timing.inputLagMs = inputLag[i];
+            trial.timing.maxIterationGapMs = maxGap[i];
+            trial.timing.loopIterations = iterations[i];
+        }
+    }
+    return results;
+}
+} // namespace purple
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "core/clock.h"
+#include "core/export.h"
+#include "core/mapped_file.h"
+#include "core/session.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Columnar binary results (`.prr`): a run's raw clock readings, kept losslessly and laid out so readers
+// can map the file and compute over whole columns without parsing.
+//
+// File layout (native little-endian): ColumnarFileHeader, header.planBlocks ColumnarPlanBlock entries,
+// a ColumnarRunSettings and header.deviceCount ColumnarDevice entries (version 2), header.columnCount
+// ColumnarColumnEntry entries, then each column as header.rowCount packed values, starting on a 64-byte
+// boundary. Version 1 files (no settings, devices or Device column) are still read.
+enum class ColumnId : std::uint32_t
+{
+    DelaySeconds = 1,     // f64, scheduled foreperiod as drawn
+    TrialStartTicks = 2,  // i64
+    DelayTicks = 3,       // i64, scheduled foreperiod
+    StimulusTicks = 4,    // i64, onset the reaction is measured from (0 before the stimulus)
+    MidpointTicks = 5,    // i64, Present midpoint (0 before the stimulus)
+    InputTicks = 6,       // i64
+    OvershootTicks = 7,   // i64, wait engine overshoot at onset
+    Flags = 8,            // u32, kRowFalseStart | kRowScanoutOnset
+    Block = 9,            // u32, index into the plan blocks
+    ForeperiodMs = 10,    // f64, --trial-timing columns (only with kFlagRecordTiming)
+    PresentMs = 11,       // f64
+    InputLagMs = 12,      // f64
+    MaxLoopGapMs = 13,    // f64
+    LoopIterations = 14,  // u32
+    Device = 15           // u32, index into the device table (kNoDevice: not attributed)
+};
+
+struct ColumnarFileHeader
+{
+    static constexpr std::uint32_t kVersion = 2;
+    static constexpr std::uint32_t kFlagRecordTiming = 1;  // timing columns present
+    static constexpr std::uint32_t kFlagFromText = 2;      // converted from a CSV/JSON export; 1 ns ticks
+
+    char magic[8] = {'P', 'R', 'C', 'O', 'L', 'S', '\0', '\0'};
+    std::uint32_t version = kVersion;
+    std::uint32_t flags = 0;
+    std::int64_t tickFrequency = 0;
+    std::uint64_t rowCount = 0;
+    std::uint32_t columnCount = 0;
+    std::uint32_t planBlocks = 0;
+    std::int32_t trialCount = 0;  // SessionConfig of the run
+    std::uint32_t deviceCount = 0;  // version 2; reserved (0) in version 1
+    double minDelaySeconds = 0.0;
+    double maxDelaySeconds = 0.0;
+    char buildId[48] = {};  // build that wrote the file; not NUL-terminated at 48 characters
+};
+static_assert(sizeof(ColumnarFileHeader) == 112, "columnar header is 112 bytes on disk");
+
+struct ColumnarPlanBlock
+{
+    char id[64] = {};  // not NUL-terminated at 64 characters
+    std::int32_t trialCount = 0;
+    std::uint32_t reserved = 0;
+    double minDelaySeconds = 0.0;
+    double maxDelaySeconds = 0.0;
+    double restSeconds = 0.0;
+};
+static_assert(sizeof(ColumnarPlanBlock) == 96, "columnar plan blocks are 96 bytes on disk");
+
+// Run context the exports carry beyond the trials (ExportMetadata): the foreperiod schedule and its seed,
+// the realtime report and how a run with a stopping rule ended. Strings are not NUL-terminated at their
+// full length.
+struct ColumnarRunSettings
+{
+    static constexpr std::uint32_t kHasRealtime = 1;
+    static constexpr std::uint32_t kHasStopping = 2;
+    static constexpr std::uint32_t kHasForeperiod = 4;
+    static constexpr std::uint32_t kPriorityRaised = 1;  // realtimeFlags
+    static constexpr std::uint32_t kMemoryLocked = 2;
+    static constexpr std::uint32_t kPowerThrottlingOff = 4;
+    static constexpr std::uint32_t kCpuDmaLatencyHeld = 8;
+    static constexpr std::uint32_t kInputPriorityRaised = 16;
+
+    std::uint32_t present = 0;          // kHas* bits
+    std::uint32_t realtimeProfile = 0;  // RealtimeProfile
+    std::uint32_t realtimeFlags = 0;
+    std::int32_t fifoPriority = 0;
+    char timingCpus[32] = {};
+    char inputCpus[32] = {};
+    char mmcssTask[32] = {};
+    std::uint32_t stopStatistic = 0;    // PrecisionStatistic
+    std::uint32_t stopReason = 0;       // StopReason
+    std::int32_t stopMinValidTrials = 0;
+    std::int32_t stopTrials = 0;
+    std::uint64_t stopValidTrials = 0;
+    double stopTargetMs = 0.0;
+    double stopConfidence = 0.0;
+    double stopEstimateMs = 0.0;
+    double stopHalfWidthMs = 0.0;       // infinite when too few reactions
+    std::uint32_t foreperiodDistribution = 0;  // ForeperiodDistribution; a List's values are not stored
+    std::uint32_t reserved = 0;
+    std::uint64_t foreperiodSeed = 0;
+    double foreperiodMeanSeconds = 0.0;
+    double foreperiodStepSeconds = 0.0;
+};
+static_assert(sizeof(ColumnarRunSettings) == 200, "columnar run settings are 200 bytes on disk");
+
+// One entry of the device table (ExportMetadata::devices, ids assigned).
+struct ColumnarDevice
+{
+    std::uint64_t handle = 0;
+    std::uint16_t vendorId = 0;
+    std::uint16_t productId = 0;
+    std::uint32_t reserved = 0;
+    char id[64] = {};     // not NUL-terminated at 64 characters
+    char name[240] = {};  // not NUL-terminated at 240 characters
+};
+static_assert(sizeof(ColumnarDevice) == 320, "columnar device entries are 320 bytes on disk");
+
+struct ColumnarColumnEntry
+{
+    ColumnId id = ColumnId::Flags;
+    std::uint32_t elementBytes = 0;
+    std::uint64_t offset = 0;  // from the start of the file
+};
+static_assert(sizeof(ColumnarColumnEntry) == 16, "columnar column entries are 16 bytes on disk");
+
+constexpr std::uint32_t kRowFalseStart = 1;
+constexpr std::uint32_t kRowScanoutOnset = 2;
+constexpr std::uint32_t kNoDevice = 0xFFFFFFFFu;
+
+// Build identifier stored in written files (the git revision when the build system provides one).
+const char* ColumnarBuildId();
+
+// Writes `results` (with their TrialResult::ticks), the run's config and the foreperiod, devices, realtime
+// report and stopping outcome of `metadata`. `frequency` is the session clock's tick rate. Prints the
+// reason and returns false on failure.
+bool ExportResultsColumnar(
+    const std::vector<TrialResult>& results,
+    const SessionConfig& config,
+    Ticks frequency,
+    const std::string& path,
+    const ExportMetadata& metadata = {},
+    std::uint32_t extraFlags = 0);
+
+// Fills TrialResult::ticks for results read back from a text export, on a 1 ns timeline (frequency
+// kTextTickFrequency). Reaction times and onset corrections keep their six exported decimals exactly.
+constexpr Ticks kTextTickFrequency = 1000000000;
+void SynthesizeTrialTicks(std::vector<TrialResult>& results);
+
+// Read-only view of a mapped columnar file. Column pointers stay valid until Close or the next Open.
+class ColumnarResults
+{
+public:
+    // False for files that cannot be mapped or are not valid columnar results.
+    bool Open(const std::string& path);
+    void Close();
+
+    const ColumnarFileHeader& Header() const { return *header_; }
+    size_t RowCount() const { return static_cast<size_t>(header_->rowCount); }
+    // Trial count, delays, plan and recordTiming, plus the foreperiod when the file has one.
+    SessionConfig Config() const;
+    // The run context of a version 2 file; empty or false when it was not recorded.
+    bool Foreperiod(ForeperiodConfig& foreperiod) const;
+    std::vector<InputDevice> Devices() const;
+    bool Realtime(RealtimeReport& report) const;
+    bool Stopping(StoppingReport& report) const;
+
+    // Column values, or nullptr when the file has no such column.
+    const std::int64_t* Int64Column(ColumnId id) const { return static_cast<const std::int64_t*>(Find(id, 8)); }
+    const double* DoubleColumn(ColumnId id) const { return static_cast<const double*>(Find(id, 8)); }
+    const std::uint32_t* UInt32Column(ColumnId id) const { return static_cast<const std::uint32_t*>(Find(id, 4)); }
+
+    // Valid reactions in milliseconds straight from the tick columns, and the false-start count.
+    void ReactionsMs(std::vector<double>& validMs, size_t& falseStartCount) const;
+
+    // Rebuilds the TrialResults the writer was given, device attribution included (the millisecond fields
+    // are recomputed from the ticks with the session's own formulas). Exported with Foreperiod, Devices,
+    // Realtime and Stopping, they match the original run's CSV and JSON byte for byte.
+    std::vector<TrialResult> ToTrialResults() const;
+
+private:
+    const void* Find(ColumnId id, std::uint32_t elementBytes) const;
+
+    MappedFile file_;
+    const ColumnarFileHeader* header_ = nullptr;
+    const ColumnarPlanBlock* plan_ = nullptr;
+    const ColumnarRunSettings* settings_ = nullptr;  // null in version 1 files
+    const ColumnarDevice* devices_ = nullptr;
+    const ColumnarColumnEntry* columns_ = nullptr;
+};
+} // namespace purple
@@ -0,0 +1,365 @@
+#include "core/compare.h"
+
+#include "core/parallel.h"
+#include "core/parse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+namespace purple
+{
+namespace
+{
+constexpr std::uint64_t kGamma = 0x9E3779B97F4A7C15ull;
+constexpr std::uint64_t kBootstrapDomain = 1;
+constexpr std::uint64_t kPermutationDomain = 2;
+// Resamples or permutations per ParallelFor item: enough to amortize the stealing, few enough to balance.
+constexpr size_t kBlock = 64;
+// Permuted differences within this of the observed one count as "at least as large" (ties in quantiles).
+constexpr double kTieMs = 1e-9;
+
+std::uint64_t Mix64(std::uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// SplitMix64 in counter mode: draw i of a stream is Mix64(key + i * gamma), so a stream depends only on
+// its key, never on which thread runs it or what ran before.
+class CounterStream
+{
+public:
+    CounterStream(std::uint64_t seed, std::uint64_t domain, std::uint64_t index)
+        : key_(Mix64(Mix64(seed ^ (domain * kGamma)) + index * kGamma))
+    {
+    }
+
+    // Uniform in [0, bound) for bound < 2^32: multiply-shift on the high 32 bits (bias below 2^-32 * bound).
+    std::uint32_t Below(std::uint32_t bound)
+    {
+        const std::uint64_t bits = Mix64(key_ + ++counter_ * kGamma) >> 32;
+        return static_cast<std::uint32_t>((bits * bound) >> 32);
+    }
+
+private:
+    std::uint64_t key_;
+    std::uint64_t counter_ = 0;
+};
+
+size_t NearestRank(double p, size_t n)
+{
+    return std::min(static_cast<size_t>(p * static_cast<double>(n - 1) + 0.5), n - 1);
+}
+
+// Quantile `output` (index into the statistics, after the mean) sits at sorted position `rank`.
+struct QuantileSlot
+{
+    size_t rank = 0;
+    size_t output = 0;
+};
+
+struct Sample
+{
+    std::vector<double> sorted;
+    std::vector<QuantileSlot> slots;  // ascending rank
+};
+
+Sample MakeSample(const std::vector<double>& values, const std::vector<double>& probabilities)
+{
+    Sample sample;
+    sample.sorted = values;
+    std::sort(sample.sorted.begin(), sample.sorted.end());
+    for (size_t i = 0; i < probabilities.size(); ++i)
+    {
+        sample.slots.push_back(QuantileSlot{NearestRank(probabilities[i], sample.sorted.size()), i + 1});
+    }
+    std::sort(sample.slots.begin(), sample.slots.end(), [](const QuantileSlot& x, const QuantileSlot& y)
+    {
+        return x.rank < y.rank;
+    });
+    return sample;
+}
+
+// Mean and quantiles of the sample itself.
+void SampleStatistics(const Sample& sample, double* out)
+{
+    double sum = 0.0;
+    for (const double value : sample.sorted)
+    {
+        sum += value;
+    }
+    out[0] = sum / static_cast<double>(sample.sorted.size());
+    for (const QuantileSlot& slot : sample.slots)
+    {
+        out[slot.output] = sample.sorted[slot.rank];
+    }
+}
+
+// One bootstrap resample as multiplicities of the sorted values: the draws only count, and a single pass
+// over the counts yields every quantile with no sort or selection per resample.
+void ResampleStatistics(const Sample& sample, CounterStream& stream, std::vector<std::uint32_t>& counts, double* out)
+{
+    const size_t n = sample.sorted.size();
+    const std::uint32_t bound = static_cast<std::uint32_t>(n);
+    std::fill(counts.begin(), counts.begin() + static_cast<std::ptrdiff_t>(n), 0u);
+    // Four partial sums, so the additions do not wait on each other.
+    double sums[4] = {};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            const std::uint32_t j = stream.Below(bound);
+            ++counts[j];
+            sums[lane] += sample.sorted[j];
+        }
+    }
+    for (; i < n; ++i)
+    {
+        const std::uint32_t j = stream.Below(bound);
+        ++counts[j];
+        sums[0] += sample.sorted[j];
+    }
+    out[0] = ((sums[0] + sums[1]) + (sums[2] + sums[3])) / static_cast<double>(n);
+
+    size_t cumulative = 0;
+    size_t slot = 0;
+    for (size_t j = 0; slot < sample.slots.size(); ++j)
+    {
+        cumulative += counts[j];
+        while (slot < sample.slots.size() && cumulative > sample.slots[slot].rank)
+        {
+            out[sample.slots[slot].output] = sample.sorted[j];
+            ++slot;
+        }
+    }
+}
+
+// Per-worker buffers, sized once.
+struct Scratch
+{
+    std::vector<std::uint32_t> counts;
+    std::vector<std::uint32_t> order;
+    std::vector<std::uint8_t> inA;
+    std::vector<double> a;
+    std::vector<double> b;
+    std::vector<std::uint64_t> exceed;  // permutations at least as extreme, per statistic
+};
+
+// One label permutation of the pooled sorted values: a partial Fisher-Yates shuffle picks A's members and
+// sums them, then one pass in sorted order finds both groups' quantiles. Membership is random, so the pass
+// counts ranks without branching on it; only the few quantile hits branch.
+void PermutationStatistics(const std::vector<double>& pooled, double pooledSum, const Sample& a, const Sample& b,
+    CounterStream& stream, Scratch& scratch)
+{
+    constexpr size_t kDone = static_cast<size_t>(-1);
+    const size_t total = pooled.size();
+    const size_t aCount = a.sorted.size();
+    for (size_t i = 0; i < total; ++i)
+    {
+        scratch.order[i] = static_cast<std::uint32_t>(i);
+    }
+    double sumA = 0.0;
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        const size_t j = i + stream.Below(static_cast<std::uint32_t>(total - i));
+        std::swap(scratch.order[i], scratch.order[j]);
+        const std::uint32_t chosen = scratch.order[i];
+        scratch.inA[chosen] = 1;
+        sumA += pooled[chosen];
+    }
+    scratch.a[0] = sumA / static_cast<double>(aCount);
+    scratch.b[0] = (pooledSum - sumA) / static_cast<double>(total - aCount);
+
+    size_t rankA = 0;
+    size_t rankB = 0;
+    size_t slotA = 0;
+    size_t slotB = 0;
+    size_t nextA = a.slots.empty() ? kDone : a.slots[0].rank;
+    size_t nextB = b.slots.empty() ? kDone : b.slots[0].rank;
+    for (size_t j = 0; j < total; ++j)
+    {
+        const size_t member = scratch.inA[j];
+        scratch.inA[j] = 0;
+        const size_t hitA = member & static_cast<size_t>(rankA == nextA);
+        const size_t hitB = (1 - member) & static_cast<size_t>(rankB == nextB);
+        if ((hitA | hitB) != 0)
+        {
+            if (member != 0)
+            {
+                for (; slotA < a.slots.size() && a.slots[slotA].rank == rankA; ++slotA)
+                {
+                    scratch.a[a.slots[slotA].output] = pooled[j];
+                }
+                nextA = slotA < a.slots.size() ? a.slots[slotA].rank : kDone;
+            }
+            else
+            {
+                for (; slotB < b.slots.size() && b.slots[slotB].rank == rankB; ++slotB)
+                {
+                    scratch.b[b.slots[slotB].output] = pooled[j];
+                }
+                nextB = slotB < b.slots.size() ? b.slots[slotB].rank : kDone;
+            }
+        }
+        rankA += member;
+        rankB += 1 - member;
+    }
+}
+
+std::string StatisticName(double percentile)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "p%g", percentile);
+    return name;
+}
+} // namespace
+
+bool ParsePercentileList(const std::string& text, std::vector<double>& percentiles)
+{
+    percentiles.clear();
+    size_t position = 0;
+    while (position <= text.size() && percentiles.size() < kMaxComparePercentiles)
+    {
+        const size_t end = std::min(text.find(',', position), text.size());
+        double percentile = 0.0;
+        if (!TryParseDoubleNarrow(text.substr(position, end - position), percentile) ||
+            !(percentile > 0.0 && percentile < 100.0))
+        {
+            return false;
+        }
+        percentiles.push_back(percentile);
+        position = end + 1;
+    }
+    return position > text.size();
+}
+
+ComparisonReport CompareSamples(const std::vector<double>& a, const std::vector<double>& b, const CompareOptions& options)
+{
+    ComparisonReport report;
+    report.aCount = a.size();
+    report.bCount = b.size();
+    if (a.empty() || b.empty())
+    {
+        return report;
+    }
+
+    std::vector<double> probabilities = {0.5};
+    report.statistics.resize(2 + options.percentiles.size());
+    report.statistics[0].name = "mean";
+    report.statistics[1].name = "median";
+    for (size_t i = 0; i < options.percentiles.size(); ++i)
+    {
+        probabilities.push_back(options.percentiles[i] / 100.0);
+        report.statistics[2 + i].name = StatisticName(options.percentiles[i]);
+    }
+    const size_t statisticCount = report.statistics.size();
+
+    const Sample sampleA = MakeSample(a, probabilities);
+    const Sample sampleB = MakeSample(b, probabilities);
+    std::vector<double> observedA(statisticCount);
+    std::vector<double> observedB(statisticCount);
+    SampleStatistics(sampleA, observedA.data());
+    SampleStatistics(sampleB, observedB.data());
+    for (size_t s = 0; s < statisticCount; ++s)
+    {
+        StatisticComparison& statistic = report.statistics[s];
+        statistic.aMs = observedA[s];
+        statistic.bMs = observedB[s];
+        statistic.differenceMs = observedB[s] - observedA[s];
+        statistic.lowMs = statistic.differenceMs;
+        statistic.highMs = statistic.differenceMs;
+    }
+
+    std::vector<double> pooled;
+    pooled.reserve(a.size() + b.size());
+    std::merge(sampleA.sorted.begin(), sampleA.sorted.end(), sampleB.sorted.begin(), sampleB.sorted.end(),
+        std::back_inserter(pooled));
+    double pooledSum = 0.0;
+    for (const double value : pooled)
+    {
+        pooledSum += value;
+    }
+
+    const int threads = ResolveThreadCount(options.threads);
+    std::vector<Scratch> scratch(static_cast<size_t>(threads));
+    for (Scratch& buffers : scratch)
+    {
+        buffers.counts.resize(std::max(a.size(), b.size()));
+        buffers.order.resize(pooled.size());
+        buffers.inA.assign(pooled.size(), 0);
+        buffers.a.resize(statisticCount);
+        buffers.b.resize(statisticCount);
+        buffers.exceed.assign(statisticCount, 0);
+    }
+
+    // Bootstrap: resample r writes its differences to column r, so the intervals do not depend on the split.
+    const size_t resamples = static_cast<size_t>(std::max(0, options.resamples));
+    std::vector<double> differences(statisticCount * resamples);
+    ParallelFor((resamples + kBlock - 1) / kBlock, threads, [&](size_t block, int worker)
+    {
+        Scratch& buffers = scratch[static_cast<size_t>(worker)];
+        const size_t end = std::min(resamples, (block + 1) * kBlock);
+        for (size_t r = block * kBlock; r < end; ++r)
+        {
+            CounterStream stream(options.seed, kBootstrapDomain, r);
+            ResampleStatistics(sampleA, stream, buffers.counts, buffers.a.data());
+            ResampleStatistics(sampleB, stream, buffers.counts, buffers.b.data());
+            for (size_t s = 0; s < statisticCount; ++s)
+            {
+                differences[s * resamples + r] = buffers.b[s] - buffers.a[s];
+            }
+        }
+    });
+    if (resamples > 0)
+    {
+        const size_t lowRank = NearestRank((1.0 - options.confidence) / 2.0, resamples);
+        const size_t highRank = NearestRank((1.0 + options.confidence) / 2.0, resamples);
+        for (size_t s = 0; s < statisticCount; ++s)
+        {
+            const auto first = differences.begin() + static_cast<std::ptrdiff_t>(s * resamples);
+            const auto last = first + static_cast<std::ptrdiff_t>(resamples);
+            std::nth_element(first, first + static_cast<std::ptrdiff_t>(lowRank), last);
+            report.statistics[s].lowMs = first[static_cast<std::ptrdiff_t>(lowRank)];
+            std::nth_element(first + static_cast<std::ptrdiff_t>(lowRank), first + static_cast<std::ptrdiff_t>(highRank), last);
+            report.statistics[s].highMs = first[static_cast<std::ptrdiff_t>(highRank)];
+        }
+    }
+
+    // Permutation test: exceedance counts are integers, so summing them per worker is order-independent.
+    const size_t permutations = static_cast<size_t>(std::max(0, options.permutations));
+    ParallelFor((permutations + kBlock - 1) / kBlock, threads, [&](size_t block, int worker)
+    {
+        Scratch& buffers = scratch[static_cast<size_t>(worker)];
+        const size_t end = std::min(permutations, (block + 1) * kBlock);
+        for (size_t p = block * kBlock; p < end; ++p)
+        {
+            CounterStream stream(options.seed, kPermutationDomain, p);
+            PermutationStatistics(pooled, pooledSum, sampleA, sampleB, stream, buffers);
+            for (size_t s = 0; s < statisticCount; ++s)
+            {
+                const double permuted = std::fabs(buffers.b[s] - buffers.a[s]);
+                buffers.exceed[s] += permuted >= std::fabs(report.statistics[s].differenceMs) - kTieMs ? 1 : 0;
+            }
+        }
+    });
+    for (size_t s = 0; s < statisticCount && permutations == 0; ++s)
+    {
+        report.statistics[s].pValue = std::numeric_limits<double>::quiet_NaN();
+    }
+    for (size_t s = 0; s < statisticCount && permutations > 0; ++s)
+    {
+        std::uint64_t exceed = 0;
+        for (const Scratch& buffers : scratch)
+        {
+            exceed += buffers.exceed[s];
+        }
+        report.statistics[s].pValue = static_cast<double>(exceed + 1) / static_cast<double>(permutations + 1);
+    }
+    return report;
+}
+} // namespace purple
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Two-sample comparison of reaction times (purple_compare): percentile bootstrap intervals and two-sided
+// permutation p-values for B - A differences in the mean, the median and chosen percentiles.
+struct CompareOptions
+{
+    int resamples = 100000;          // bootstrap resamples
+    int permutations = 100000;       // label permutations; 0 skips the test
+    double confidence = 0.95;
+    std::vector<double> percentiles = {90.0};  // besides the median, each in (0, 100)
+    std::uint64_t seed = 1;
+    int threads = 0;                 // 0: one per hardware thread; the results do not depend on it
+};
+
+struct StatisticComparison
+{
+    std::string name;            // "mean", "median", "p90", ...
+    double aMs = 0.0;
+    double bMs = 0.0;
+    double differenceMs = 0.0;   // bMs - aMs
+    double lowMs = 0.0;          // bootstrap interval of the difference
+    double highMs = 0.0;
+    double pValue = 0.0;         // (1 + permuted differences at least as large) / (1 + permutations); NaN
+                                 // without permutations
+};
+
+struct ComparisonReport
+{
+    size_t aCount = 0;
+    size_t bCount = 0;
+    std::vector<StatisticComparison> statistics;  // mean, median, then the percentiles in order
+};
+
+// Comma-separated percentiles, each in (0, 100), at most kMaxComparePercentiles ("90,95,99").
+constexpr size_t kMaxComparePercentiles = 16;
+bool ParsePercentileList(const std::string& text, std::vector<double>& percentiles);
+
+// `a` and `b` are the valid reactions of each set, in any order; both need at least one value. Quantiles
+// use the nearest-rank rule of SummarizeSorted. Every resample and permutation draws from its own
+// counter-based random stream keyed by the seed and its index, so the work can be split across threads
+// in any way and still give bit-identical results. Cost grows with (resamples + permutations) x trials.
+ComparisonReport CompareSamples(const std::vector<double>& a, const std::vector<double>& b, const CompareOptions& options);
+} // namespace purple
@@ -0,0 +1,167 @@
+#include "core/device.h"
+
+#include "core/parse.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace purple
+{
+namespace
+{
+constexpr const char* kSyntheticPrefix = "synthetic device ";
+
+char ToLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+int HexDigit(char c)
+{
+    c = ToLower(c);
+    return (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+// Value of the 4-digit hex field after `key` (lowercase, e.g. "vid_"), matched case-insensitively.
+bool FindHexField(const std::string& name, const char* key, std::uint16_t& value)
+{
+    const size_t keyLength = std::strlen(key);
+    for (size_t i = 0; i + keyLength + 4 <= name.size(); ++i)
+    {
+        size_t k = 0;
+        while (k < keyLength && ToLower(name[i + k]) == key[k])
+        {
+            ++k;
+        }
+        if (k < keyLength)
+        {
+            continue;
+        }
+        unsigned parsed = 0;
+        for (k = 0; k < 4 && HexDigit(name[i + keyLength + k]) >= 0; ++k)
+        {
+            parsed = parsed * 16 + static_cast<unsigned>(HexDigit(name[i + keyLength + k]));
+        }
+        if (k == 4)
+        {
+            value = static_cast<std::uint16_t>(parsed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// FNV-1a of the name, case-folded: Windows device paths differ in case between APIs.
+std::uint32_t HashName(const std::string& name)
+{
+    std::uint32_t hash = 2166136261u;
+    for (const char c : name)
+    {
+        hash = (hash ^ static_cast<unsigned char>(ToLower(c))) * 16777619u;
+    }
+    return hash;
+}
+
+std::string BaseDeviceId(const InputDevice& device)
+{
+    char id[32];
+    if (device.vendorId != 0 || device.productId != 0)
+    {
+        std::snprintf(id, sizeof(id), "%04x:%04x", device.vendorId, device.productId);
+        return id;
+    }
+    if (device.name.rfind(kSyntheticPrefix, 0) == 0)
+    {
+        return "synthetic:" + device.name.substr(std::strlen(kSyntheticPrefix));
+    }
+    if (device.name.empty())
+    {
+        return "unknown";
+    }
+    std::snprintf(id, sizeof(id), "hid:%08x", HashName(device.name));
+    return id;
+}
+} // namespace
+
+void DescribeInputDevice(InputDevice& device, const std::string& name)
+{
+    device.name.clear();
+    for (const char c : name)
+    {
+        if (static_cast<unsigned char>(c) >= 0x20 && c != ',' && c != '"' && c != 0x7f)
+        {
+            device.name += c;
+        }
+    }
+    device.vendorId = 0;
+    device.productId = 0;
+    std::uint16_t vendorId = 0;
+    std::uint16_t productId = 0;
+    if (FindHexField(device.name, "vid_", vendorId) && FindHexField(device.name, "pid_", productId))
+    {
+        device.vendorId = vendorId;
+        device.productId = productId;
+    }
+}
+
+void DescribeSyntheticDevice(InputDevice& device, int number)
+{
+    device.name = kSyntheticPrefix + std::to_string(number);
+    device.vendorId = 0;
+    device.productId = 0;
+}
+
+void AssignDeviceIds(std::vector<InputDevice>& devices)
+{
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        const std::string base = BaseDeviceId(devices[i]);
+        int earlier = 0;
+        for (size_t j = 0; j < i; ++j)
+        {
+            earlier += BaseDeviceId(devices[j]) == base ? 1 : 0;
+        }
+        devices[i].id = earlier == 0 ? base : base + "#" + std::to_string(earlier + 1);
+    }
+}
+
+bool ParseDeviceLagList(const std::string& text, std::vector<double>& lagsMs)
+{
+    lagsMs.clear();
+    size_t position = 0;
+    while (position <= text.size() && lagsMs.size() < Session::kReservedInputDevices)
+    {
+        const size_t end = std::min(text.find(',', position), text.size());
+        double lagMs = 0.0;
+        if (!TryParseDoubleNarrow(text.substr(position, end - position), lagMs) || lagMs < 0.0)
+        {
+            return false;
+        }
+        lagsMs.push_back(lagMs);
+        position = end + 1;
+    }
+    return position > text.size();
+}
+
+std::vector<DeviceComparison> CompareDevices(const std::vector<ReactionSummary>& summaries, double confidence)
+{
+    std::vector<DeviceComparison> comparisons;
+    for (size_t device = 1; device < summaries.size(); ++device)
+    {
+        for (size_t reference = 0; reference < device; ++reference)
+        {
+            DeviceComparison comparison;
+            comparison.device = device;
+            comparison.reference = reference;
+            comparison.difference = CompareMeans(summaries[device], summaries[reference], confidence);
+            if (comparison.difference.valid)
+            {
+                comparisons.push_back(comparison);
+            }
+        }
+    }
+    return comparisons;
+}
+} // namespace purple
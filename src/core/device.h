@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core/session.h"
+#include "core/stats.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Fills a device's identity from its OS device path (the Raw Input device name on Windows). USB HID paths
+// carry "VID_xxxx" and "PID_xxxx" (any case); other devices keep vendor and product 0.
+// Characters that would need quoting in the exports (',', '"', control characters) are dropped.
+void DescribeInputDevice(InputDevice& device, const std::string& name);
+
+// Synthetic device `number` (1-based), for headless and simulated runs.
+void DescribeSyntheticDevice(InputDevice& device, int number);
+
+// Sets InputDevice::id for every device: "vvvv:pppp" (lowercase hex VID:PID) when the path has them,
+// "synthetic:N" for synthetic devices, "unknown" for presses without a device handle, otherwise
+// "hid:" plus the name's hash. Ids only depend on the device, not on the run's handles or press order,
+// so the same peripheral keeps its id across runs; identical devices get "#2", "#3", ... in use order.
+void AssignDeviceIds(std::vector<InputDevice>& devices);
+
+// Comma-separated per-device extra input lags in ms ("0,4,8") for synthetic devices 1..n; at most
+// Session::kReservedInputDevices entries, none negative.
+bool ParseDeviceLagList(const std::string& text, std::vector<double>& lagsMs);
+
+// Device comparison of one run: each device's mean reaction against every device used before it.
+struct DeviceComparison
+{
+    size_t device = 0;     // index into the run's devices
+    size_t reference = 0;  // earlier device; difference = device mean - reference mean
+    MeanDifference difference;
+};
+
+// `summaries` from SummarizeDevices. Pairs where either device has fewer than 2 valid trials are skipped.
+std::vector<DeviceComparison> CompareDevices(const std::vector<ReactionSummary>& summaries, double confidence = 0.95);
+} // namespace purple
@@ -0,0 +1,218 @@
+#include "core/event_stream.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+
+namespace purple
+{
+NdjsonLineBuilder::NdjsonLineBuilder(StreamRecord& record, const char* eventName)
+    : record_(record)
+{
+    record_.length = 0;
+    record_.truncated = false;
+    String("event", eventName);
+}
+
+void NdjsonLineBuilder::Int(const char* key, std::int64_t value)
+{
+    Key(key);
+    char digits[24];
+    const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    Raw(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+void NdjsonLineBuilder::Number(const char* key, double value)
+{
+    Key(key);
+    char digits[330];
+    const std::to_chars_result result =
+        std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+    Raw(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+void NdjsonLineBuilder::Null(const char* key)
+{
+    Key(key);
+    Raw("null", 4);
+}
+
+void NdjsonLineBuilder::Bool(const char* key, bool value)
+{
+    Key(key);
+    if (value)
+    {
+        Raw("true", 4);
+    }
+    else
+    {
+        Raw("false", 5);
+    }
+}
+
+void NdjsonLineBuilder::String(const char* key, const char* value)
+{
+    Key(key);
+    Raw("\"", 1);
+    Raw(value, std::strlen(value));
+    Raw("\"", 1);
+}
+
+void NdjsonLineBuilder::End()
+{
+    Raw("}\n", 2);
+}
+
+void NdjsonLineBuilder::Key(const char* key)
+{
+    if (record_.length == 0)
+    {
+        Raw("{\"", 2);
+    }
+    else
+    {
+        Raw(", \"", 3);
+    }
+    Raw(key, std::strlen(key));
+    Raw("\": ", 3);
+}
+
+void NdjsonLineBuilder::Raw(const char* text, size_t length)
+{
+    if (record_.truncated || length > StreamRecord::kMaxBytes - record_.length)
+    {
+        record_.truncated = true;
+        return;
+    }
+    std::memcpy(record_.text + record_.length, text, length);
+    record_.length += static_cast<std::uint32_t>(length);
+}
+
+EventStream::~EventStream()
+{
+    Close();
+}
+
+bool EventStream::Open(const std::string& target)
+{
+    Close();
+    if (target == "-")
+    {
+        file_ = stdout;
+    }
+    else
+    {
+        file_ = std::fopen(target.c_str(), "w");
+        if (file_ == nullptr)
+        {
+            return false;
+        }
+    }
+    StartWriter();
+    return true;
+}
+
+void EventStream::OpenSink(SinkFn sink, void* context)
+{
+    Close();
+    sink_ = sink;
+    sinkContext_ = context;
+    StartWriter();
+}
+
+void EventStream::StartWriter()
+{
+    ring_ = std::make_unique<Ring>();
+    stopping_.store(false, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    open_ = true;
+    writer_ = std::thread([this] { WriterMain(); });
+}
+
+bool EventStream::Publish(const StreamRecord& record)
+{
+    if (!open_ || record.truncated || !ring_->TryPush(record))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    wake_.notify_one();
+    return true;
+}
+
+bool EventStream::PublishWhenSpace(const StreamRecord& record)
+{
+    if (!open_ || record.truncated)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    while (!ring_->TryPush(record))
+    {
+        wake_.notify_one();
+        std::this_thread::yield();
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void EventStream::Close()
+{
+    if (!open_)
+    {
+        return;
+    }
+
+    stopping_.store(true, std::memory_order_release);
+    wake_.notify_one();
+    writer_.join();
+
+    if (file_ != nullptr && file_ != stdout)
+    {
+        std::fclose(file_);
+    }
+    file_ = nullptr;
+    sink_ = nullptr;
+    sinkContext_ = nullptr;
+    open_ = false;
+    ring_.reset();
+}
+
+void EventStream::WriterMain()
+{
+    for (;;)
+    {
+        const bool stopping = stopping_.load(std::memory_order_acquire);
+        const size_t written = DrainRing(*ring_, [this](const StreamRecord& record) { Write(record); });
+
+        if (written > 0)
+        {
+            // Consumers read line by line while the run is in progress.
+            if (file_ != nullptr)
+            {
+                std::fflush(file_);
+            }
+            continue;
+        }
+        if (stopping)
+        {
+            return;
+        }
+
+        // Publish notifies without taking the lock, so a wakeup can be missed; the timeout bounds that delay.
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wake_.wait_for(lock, std::chrono::milliseconds(5));
+    }
+}
+
+void EventStream::Write(const StreamRecord& record)
+{
+    if (sink_ != nullptr)
+    {
+        // A failed sink write (peer gone) is not retried; the ring keeps draining so producers never notice.
+        sink_(sinkContext_, record.text, record.length);
+        return;
+    }
+    std::fwrite(record.text, 1, record.length, file_);
+}
+} // namespace purple
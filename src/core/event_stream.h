@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/spsc_ring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace purple
+{
+// One complete NDJSON line, built on the session thread without allocating.
+struct StreamRecord
+{
+    static constexpr size_t kMaxBytes = 1016;
+
+    std::uint32_t length = 0;
+    bool truncated = false;
+    char text[kMaxBytes];
+};
+
+// Appends `"key": value` pairs to a StreamRecord. A line that would not fit is marked truncated and is
+// never published, so consumers only ever see whole JSON objects.
+class NdjsonLineBuilder
+{
+public:
+    NdjsonLineBuilder(StreamRecord& record, const char* eventName);
+
+    void Int(const char* key, std::int64_t value);
+    void Number(const char* key, double value);
+    void Null(const char* key);
+    void Bool(const char* key, bool value);
+    void String(const char* key, const char* value);  // value must not need escaping
+    void End();
+
+private:
+    void Key(const char* key);
+    void Raw(const char* text, size_t length);
+
+    StreamRecord& record_;
+};
+
+// Live event stream (`--stream-out`). Publish is called from the session thread and never blocks: records
+// go into a lock-free SPSC ring and a writer thread moves them to the file or stdout. If a slow consumer
+// lets the ring fill, records are dropped and counted instead of stalling the timing loop.
+class EventStream
+{
+public:
+    using Ring = SpscRing<StreamRecord, 256>;
+    // Custom destination, called on the writer thread with whole lines; returns false once the sink is gone.
+    using SinkFn = bool (*)(void* context, const char* data, size_t length);
+
+    EventStream() = default;
+    ~EventStream();
+
+    EventStream(const EventStream&) = delete;
+    EventStream& operator=(const EventStream&) = delete;
+
+    // "-" streams to stdout; anything else is opened (truncated) as a file path or pipe.
+    bool Open(const std::string& target);
+    void OpenSink(SinkFn sink, void* context);
+    bool IsOpen() const { return open_; }
+    bool WritesToStdout() const { return file_ == stdout; }
+
+    bool Publish(const StreamRecord& record);
+    // For events after the timed part of a run (summary/abort): waits for ring space instead of dropping.
+    bool PublishWhenSpace(const StreamRecord& record);
+    unsigned long long Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Writes everything still queued, then stops the writer thread.
+    void Close();
+
+private:
+    void StartWriter();
+    void WriterMain();
+    void Write(const StreamRecord& record);
+
+    std::unique_ptr<Ring> ring_;
+    bool open_ = false;
+    std::FILE* file_ = nullptr;
+    SinkFn sink_ = nullptr;
+    void* sinkContext_ = nullptr;
+    std::thread writer_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<unsigned long long> dropped_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+};
+} // namespace purple
@@ -0,0 +1,956 @@
+#include "core/export.h"
+
+#include "core/buffered_writer.h"
+#include "core/device.h"
+#include "core/foreperiod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+namespace purple
+{
+namespace
+{
+void PrintOnsetOvershoot(const std::vector<TrialResult>& results)
+{
+    std::vector<double> overshootUs;
+    overshootUs.reserve(results.size());
+    for (const TrialResult& trial : results)
+    {
+        if (!trial.falseStart)
+        {
+            overshootUs.push_back(trial.onsetOvershootMs * 1000.0);
+        }
+    }
+    if (overshootUs.empty())
+    {
+        return;
+    }
+
+    std::sort(overshootUs.begin(), overshootUs.end());
+    const size_t p50 = (overshootUs.size() - 1) / 2;
+    const size_t p99 = ((overshootUs.size() - 1) * 99) / 100;
+    std::printf("Onset overshoot: p50=%.1f us, p99=%.1f us, max=%.1f us\n",
+        overshootUs[p50],
+        overshootUs[p99],
+        overshootUs.back());
+}
+
+// Scanout-corrected onsets minus the Present midpoint, i.e. the bias the correction removed.
+void PrintOnsetCorrection(const std::vector<TrialResult>& results)
+{
+    std::vector<double> correctionMs;
+    size_t validCount = 0;
+    for (const TrialResult& trial : results)
+    {
+        if (trial.falseStart)
+        {
+            continue;
+        }
+        ++validCount;
+        if (trial.onsetSource == OnsetSource::Scanout)
+        {
+            correctionMs.push_back(trial.onsetCorrectionMs);
+        }
+    }
+    if (correctionMs.empty())
+    {
+        return;
+    }
+
+    std::sort(correctionMs.begin(), correctionMs.end());
+    const size_t p50 = (correctionMs.size() - 1) / 2;
+    const size_t p99 = ((correctionMs.size() - 1) * 99) / 100;
+    std::printf("Scanout correction (%zu/%zu trials): p50=%.3f ms, p99=%.3f ms, max=%.3f ms\n",
+        correctionMs.size(),
+        validCount,
+        correctionMs[p50],
+        correctionMs[p99],
+        correctionMs.back());
+}
+
+// Sequential stopping: why the run ended and the precision it reached.
+void PrintStopping(const StoppingReport& stopping)
+{
+    const char* statistic = PrecisionStatisticName(stopping.rule.statistic);
+    if (stopping.reason == StopReason::Precision)
+    {
+        std::printf("Stopped after %d trials: %s %.0f%% CI half-width %.3f ms reached the %.3f ms target\n",
+            stopping.trials, statistic, stopping.rule.confidence * 100.0, stopping.halfWidthMs, stopping.rule.halfWidthMs);
+    }
+    else if (std::isfinite(stopping.halfWidthMs))
+    {
+        std::printf("Ran all %d trials: %s %.0f%% CI half-width %.3f ms, target %.3f ms not reached\n",
+            stopping.trials, statistic, stopping.rule.confidence * 100.0, stopping.halfWidthMs, stopping.rule.halfWidthMs);
+    }
+    else
+    {
+        std::printf("Ran all %d trials: too few valid trials for a %s CI (target %.3f ms)\n",
+            stopping.trials, statistic, stopping.rule.halfWidthMs);
+    }
+}
+
+// --trial-timing: worst Present, input pickup and loop gap over the run, to spot trials worth a closer look.
+void PrintTrialTiming(const std::vector<TrialResult>& results)
+{
+    const TrialResult* worstPresent = nullptr;
+    const TrialResult* worstInputLag = nullptr;
+    const TrialResult* worstGap = nullptr;
+    for (const TrialResult& trial : results)
+    {
+        if (trial.timing.loopIterations == 0)
+        {
+            continue;
+        }
+        if (worstPresent == nullptr || trial.timing.presentMs > worstPresent->timing.presentMs)
+        {
+            worstPresent = &trial;
+        }
+        if (worstInputLag == nullptr || trial.timing.inputLagMs > worstInputLag->timing.inputLagMs)
+        {
+            worstInputLag = &trial;
+        }
+        if (worstGap == nullptr || trial.timing.maxIterationGapMs > worstGap->timing.maxIterationGapMs)
+        {
+            worstGap = &trial;
+        }
+    }
+    if (worstPresent == nullptr)
+    {
+        return;
+    }
+
+    std::printf("Trial timing: max present %.3f ms (trial %zu), max input lag %.3f ms (trial %zu), max loop gap %.3f ms (trial %zu)\n",
+        worstPresent->timing.presentMs,
+        static_cast<size_t>(worstPresent - results.data()) + 1,
+        worstInputLag->timing.inputLagMs,
+        static_cast<size_t>(worstInputLag - results.data()) + 1,
+        worstGap->timing.maxIterationGapMs,
+        static_cast<size_t>(worstGap - results.data()) + 1);
+}
+
+// Columns that only appear when the run produced them, so plain exports keep the original schema. In
+// the CSV they follow false_start, in this order:
+//   onsetCorrection: onset_correction_ms (empty for false starts and midpoint onsets)
+//   timing:          --trial-timing breakdown (foreperiod/present empty for trials without an onset)
+struct OptionalColumns
+{
+    bool onsetCorrection = false;
+    bool timing = false;
+};
+
+OptionalColumns DetectOptionalColumns(const std::vector<TrialResult>& results)
+{
+    OptionalColumns columns;
+    for (const TrialResult& trial : results)
+    {
+        columns.onsetCorrection = columns.onsetCorrection || trial.onsetSource == OnsetSource::Scanout;
+        columns.timing = columns.timing || trial.timing.loopIterations > 0;
+    }
+    return columns;
+}
+
+// Plan runs add a trailing block column: the block id on trial rows and per-block footer rows, empty on
+// the overall footer rows. Runs with attributed devices add a device column after it the same way, with
+// per-device footer rows. Each is null when the column is absent, so plain exports keep the original schema.
+void EndCsvRow(BufferedFileWriter& out, const char* block, const char* device)
+{
+    if (block != nullptr)
+    {
+        out.Append(",");
+        out.AppendString(block);
+    }
+    if (device != nullptr)
+    {
+        out.Append(",");
+        out.AppendString(device);
+    }
+    out.Append("\n");
+}
+
+void WriteCsvFooterRow(
+    BufferedFileWriter& out,
+    const char* label,
+    double value,
+    bool hasValue,
+    const OptionalColumns& columns,
+    const char* block,
+    const char* device)
+{
+    out.AppendString(label);
+    out.Append(",,");
+    if (hasValue)
+    {
+        out.AppendFixed6(value);
+    }
+    out.Append(",");
+    if (columns.onsetCorrection)
+    {
+        out.Append(",");
+    }
+    if (columns.timing)
+    {
+        out.Append(",,,,,");
+    }
+    EndCsvRow(out, block, device);
+}
+
+void WriteCsvRow(
+    BufferedFileWriter& out,
+    size_t index,
+    const TrialResult& trial,
+    const OptionalColumns& columns,
+    const char* block,
+    const char* device)
+{
+    out.AppendUnsigned(index + 1);
+    out.Append(",");
+    out.AppendFixed6(trial.delaySeconds);
+    if (trial.falseStart)
+    {
+        out.Append(",,1");
+    }
+    else
+    {
+        out.Append(",");
+        out.AppendFixed6(trial.reactionMs);
+        out.Append(",0");
+    }
+    if (columns.onsetCorrection)
+    {
+        out.Append(",");
+        if (!trial.falseStart && trial.onsetSource == OnsetSource::Scanout)
+        {
+            out.AppendFixed6(trial.onsetCorrectionMs);
+        }
+    }
+    if (columns.timing)
+    {
+        const TrialTiming& timing = trial.timing;
+        out.Append(",");
+        if (timing.foreperiodMs > 0.0)
+        {
+            out.AppendFixed6(timing.foreperiodMs);
+            out.Append(",");
+            out.AppendFixed6(timing.presentMs);
+        }
+        else
+        {
+            out.Append(",");
+        }
+        out.Append(",");
+        out.AppendFixed6(timing.inputLagMs);
+        out.Append(",");
+        out.AppendUnsigned(timing.loopIterations);
+        out.Append(",");
+        out.AppendFixed6(timing.maxIterationGapMs);
+    }
+    EndCsvRow(out, block, device);
+}
+
+void WriteCsvFooter(
+    BufferedFileWriter& out,
+    const ReactionSummary& summary,
+    const OptionalColumns& columns,
+    const char* block,
+    const char* device)
+{
+    WriteCsvFooterRow(out, "average", summary.meanMs, true, columns, block, device);
+    WriteCsvFooterRow(out, "sd", summary.sdMs, summary.validCount > 1, columns, block, device);
+    WriteCsvFooterRow(out, "median", summary.p50Ms, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "p90", summary.p90Ms, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "p95", summary.p95Ms, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "p99", summary.p99Ms, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "min", summary.minMs, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "max", summary.maxMs, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "trimmed_mean_10", summary.trimmedMeanMs, summary.validCount > 0, columns, block, device);
+    WriteCsvFooterRow(out, "mad", summary.madMs, summary.validCount > 0, columns, block, device);
+}
+
+void WriteJsonNumber(BufferedFileWriter& out, double value, bool hasValue)
+{
+    if (hasValue)
+    {
+        out.AppendFixed6(value);
+    }
+    else
+    {
+        out.Append("null");
+    }
+}
+
+void WriteJsonNumberField(BufferedFileWriter& out, const char* name, double value, bool hasValue)
+{
+    out.Append("  \"");
+    out.AppendString(name);
+    out.Append("\": ");
+    WriteJsonNumber(out, value, hasValue);
+    out.Append(",\n");
+}
+
+void WriteJsonInlineField(BufferedFileWriter& out, const char* name, double value, bool hasValue)
+{
+    out.Append(", \"");
+    out.AppendString(name);
+    out.Append("\": ");
+    WriteJsonNumber(out, value, hasValue);
+}
+
+void WriteJsonHeader(BufferedFileWriter& out, size_t trialCount, const ReactionSummary& summary)
+{
+    out.Append("{\n  \"trial_count\": ");
+    out.AppendUnsigned(trialCount);
+    out.Append(",\n  \"valid_count\": ");
+    out.AppendUnsigned(summary.validCount);
+    out.Append(",\n  \"false_start_count\": ");
+    out.AppendUnsigned(summary.falseStartCount);
+    out.Append(",\n");
+    WriteJsonNumberField(out, "average_reaction_ms", summary.meanMs, summary.validCount > 0);
+    WriteJsonNumberField(out, "reaction_sd_ms", summary.sdMs, summary.validCount > 1);
+    WriteJsonNumberField(out, "median_reaction_ms", summary.p50Ms, summary.validCount > 0);
+    WriteJsonNumberField(out, "p90_reaction_ms", summary.p90Ms, summary.validCount > 0);
+    WriteJsonNumberField(out, "p95_reaction_ms", summary.p95Ms, summary.validCount > 0);
+    WriteJsonNumberField(out, "p99_reaction_ms", summary.p99Ms, summary.validCount > 0);
+    WriteJsonNumberField(out, "min_reaction_ms", summary.minMs, summary.validCount > 0);
+    WriteJsonNumberField(out, "max_reaction_ms", summary.maxMs, summary.validCount > 0);
+    WriteJsonNumberField(out, "trimmed_mean_reaction_ms", summary.trimmedMeanMs, summary.validCount > 0);
+    WriteJsonNumberField(out, "mad_reaction_ms", summary.madMs, summary.validCount > 0);
+}
+
+void WriteJsonForeperiod(BufferedFileWriter& out, const ForeperiodConfig& foreperiod)
+{
+    out.Append("  \"foreperiod\": {\"distribution\": \"");
+    out.AppendString(ForeperiodDistributionName(foreperiod.distribution));
+    out.Append("\"");
+    if (foreperiod.distribution != ForeperiodDistribution::List)
+    {
+        out.Append(", \"seed\": ");
+        out.AppendUnsigned(foreperiod.seed);
+    }
+    out.Append("},\n");
+}
+
+void WriteJsonStopping(BufferedFileWriter& out, const StoppingReport& stopping)
+{
+    out.Append("  \"stopping\": {\"statistic\": \"");
+    out.AppendString(PrecisionStatisticName(stopping.rule.statistic));
+    out.Append("\", \"target_half_width_ms\": ");
+    out.AppendFixed6(stopping.rule.halfWidthMs);
+    out.Append(", \"confidence\": ");
+    out.AppendFixed6(stopping.rule.confidence);
+    out.Append(", \"min_valid_trials\": ");
+    out.AppendUnsigned(static_cast<std::uint64_t>(stopping.rule.minValidTrials));
+    out.Append(", \"reason\": \"");
+    out.AppendString(StopReasonName(stopping.reason));
+    out.Append("\", \"trials\": ");
+    out.AppendUnsigned(static_cast<std::uint64_t>(stopping.trials));
+    out.Append(", \"estimate_ms\": ");
+    if (stopping.validTrials > 0)
+    {
+        out.AppendFixed6(stopping.estimateMs);
+    }
+    else
+    {
+        out.Append("null");
+    }
+    out.Append(", \"half_width_ms\": ");
+    if (std::isfinite(stopping.halfWidthMs))
+    {
+        out.AppendFixed6(stopping.halfWidthMs);
+    }
+    else
+    {
+        out.Append("null");
+    }
+    out.Append("},\n");
+}
+
+void WriteJsonRealtime(BufferedFileWriter& out, const RealtimeReport& realtime)
+{
+    out.Append("  \"realtime\": {\"profile\": \"");
+    out.AppendString(RealtimeProfileName(realtime.profile));
+    out.Append("\", \"priority_raised\": ");
+    out.AppendString(realtime.priorityRaised ? "true" : "false");
+    out.Append(", \"input_priority_raised\": ");
+    out.AppendString(realtime.inputPriorityRaised ? "true" : "false");
+    out.Append(", \"timing_cpus\": \"");
+    out.AppendString(realtime.timingCpus.c_str());
+    out.Append("\", \"input_cpus\": \"");
+    out.AppendString(realtime.inputCpus.c_str());
+    out.Append("\", \"mmcss_task\": \"");
+    out.AppendString(realtime.mmcssTask.c_str());
+    out.Append("\", \"sched_fifo_priority\": ");
+    out.AppendUnsigned(static_cast<std::uint64_t>(realtime.fifoPriority));
+    out.Append(", \"memory_locked\": ");
+    out.AppendString(realtime.memoryLocked ? "true" : "false");
+    out.Append(", \"power_throttling_off\": ");
+    out.AppendString(realtime.powerThrottlingOff ? "true" : "false");
+    out.Append(", \"cpu_dma_latency_held\": ");
+    out.AppendString(realtime.cpuDmaLatencyHeld ? "true" : "false");
+    out.Append("},\n");
+}
+
+void WriteJsonCounts(BufferedFileWriter& out, const char* name, const std::vector<std::uint64_t>& counts)
+{
+    out.Append(", \"");
+    out.AppendString(name);
+    out.Append("\": [");
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        if (i > 0)
+        {
+            out.Append(", ");
+        }
+        out.AppendUnsigned(counts[i]);
+    }
+    out.Append("]");
+}
+
+// Fixed six decimals, or nine significant digits for values that small ones would flatten (densities).
+void WriteJsonValues(BufferedFileWriter& out, const char* name, const std::vector<double>& values, bool significant)
+{
+    out.Append(", \"");
+    out.AppendString(name);
+    out.Append("\": [");
+    char text[32];
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i > 0)
+        {
+            out.Append(", ");
+        }
+        if (significant)
+        {
+            const int length = std::snprintf(text, sizeof(text), "%.9g", values[i]);
+            out.Append(text, static_cast<size_t>(length));
+        }
+        else
+        {
+            out.AppendFixed6(values[i]);
+        }
+    }
+    out.Append("]");
+}
+
+// Histogram counts carry the below/above counts at their ends, as in purple_aggregate --distribution-out.
+void WriteJsonDistribution(BufferedFileWriter& out, const std::vector<TrialResult>& results, const DistributionOptions& options)
+{
+    std::vector<double> valid;
+    valid.reserve(results.size());
+    for (const TrialResult& trial : results)
+    {
+        if (!trial.falseStart)
+        {
+            valid.push_back(trial.reactionMs);
+        }
+    }
+    std::sort(valid.begin(), valid.end());
+    const DistributionReport report = ComputeDistribution(valid, options);
+
+    out.Append("  \"distribution\": {\"low_ms\": ");
+    out.AppendFixed6(options.lowMs);
+    out.Append(", \"bin_ms\": ");
+    out.AppendFixed6(options.binMs);
+    WriteJsonCounts(out, "histogram", report.bins);
+    WriteJsonValues(out, "log_edges_ms", report.logEdges, false);
+    WriteJsonCounts(out, "log_histogram", report.logBins);
+    out.Append(", \"kde_bandwidth_ms\": ");
+    out.AppendFixed6(report.bandwidthMs);
+    WriteJsonValues(out, "grid_ms", report.grid, false);
+    WriteJsonValues(out, "kde", report.density, true);
+    WriteJsonValues(out, "ecdf", report.cdf, false);
+    out.Append("},\n");
+}
+
+void WriteJsonBlocks(BufferedFileWriter& out, const std::vector<PlanBlock>& plan, const std::vector<ReactionSummary>& summaries)
+{
+    out.Append("  \"blocks\": [\n");
+    for (size_t i = 0; i < plan.size(); ++i)
+    {
+        const PlanBlock& block = plan[i];
+        const ReactionSummary& summary = summaries[i];
+        out.Append("    {\"block\": \"");
+        out.AppendString(block.id.c_str());
+        out.Append("\", \"trial_count\": ");
+        out.AppendUnsigned(summary.trialCount);
+        out.Append(", \"valid_count\": ");
+        out.AppendUnsigned(summary.validCount);
+        out.Append(", \"false_start_count\": ");
+        out.AppendUnsigned(summary.falseStartCount);
+        WriteJsonInlineField(out, "min_delay_seconds", block.minDelaySeconds, true);
+        WriteJsonInlineField(out, "max_delay_seconds", block.maxDelaySeconds, true);
+        WriteJsonInlineField(out, "rest_seconds", block.restSeconds, true);
+        WriteJsonInlineField(out, "average_reaction_ms", summary.meanMs, summary.validCount > 0);
+        WriteJsonInlineField(out, "reaction_sd_ms", summary.sdMs, summary.validCount > 1);
+        WriteJsonInlineField(out, "median_reaction_ms", summary.p50Ms, summary.validCount > 0);
+        WriteJsonInlineField(out, "p90_reaction_ms", summary.p90Ms, summary.validCount > 0);
+        WriteJsonInlineField(out, "p95_reaction_ms", summary.p95Ms, summary.validCount > 0);
+        WriteJsonInlineField(out, "p99_reaction_ms", summary.p99Ms, summary.validCount > 0);
+        WriteJsonInlineField(out, "min_reaction_ms", summary.minMs, summary.validCount > 0);
+        WriteJsonInlineField(out, "max_reaction_ms", summary.maxMs, summary.validCount > 0);
+        WriteJsonInlineField(out, "trimmed_mean_reaction_ms", summary.trimmedMeanMs, summary.validCount > 0);
+        WriteJsonInlineField(out, "mad_reaction_ms", summary.madMs, summary.validCount > 0);
+        if (i + 1 < plan.size())
+        {
+            out.Append("},\n");
+        }
+        else
+        {
+            out.Append("}\n");
+        }
+    }
+    out.Append("  ],\n");
+}
+
+void WriteJsonSummaryFields(BufferedFileWriter& out, const ReactionSummary& summary)
+{
+    out.Append(", \"trial_count\": ");
+    out.AppendUnsigned(summary.trialCount);
+    out.Append(", \"valid_count\": ");
+    out.AppendUnsigned(summary.validCount);
+    out.Append(", \"false_start_count\": ");
+    out.AppendUnsigned(summary.falseStartCount);
+    WriteJsonInlineField(out, "average_reaction_ms", summary.meanMs, summary.validCount > 0);
+    WriteJsonInlineField(out, "reaction_sd_ms", summary.sdMs, summary.validCount > 1);
+    WriteJsonInlineField(out, "median_reaction_ms", summary.p50Ms, summary.validCount > 0);
+    WriteJsonInlineField(out, "p90_reaction_ms", summary.p90Ms, summary.validCount > 0);
+    WriteJsonInlineField(out, "p95_reaction_ms", summary.p95Ms, summary.validCount > 0);
+    WriteJsonInlineField(out, "p99_reaction_ms", summary.p99Ms, summary.validCount > 0);
+    WriteJsonInlineField(out, "min_reaction_ms", summary.minMs, summary.validCount > 0);
+    WriteJsonInlineField(out, "max_reaction_ms", summary.maxMs, summary.validCount > 0);
+    WriteJsonInlineField(out, "trimmed_mean_reaction_ms", summary.trimmedMeanMs, summary.validCount > 0);
+    WriteJsonInlineField(out, "mad_reaction_ms", summary.madMs, summary.validCount > 0);
+}
+
+// Device names are sanitized (DescribeInputDevice); Windows paths still need their backslashes escaped.
+void WriteJsonDeviceName(BufferedFileWriter& out, const std::string& name)
+{
+    size_t start = 0;
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        if (name[i] == '\\')
+        {
+            out.Append(name.data() + start, i - start);
+            out.Append("\\\\");
+            start = i + 1;
+        }
+    }
+    out.Append(name.data() + start, name.size() - start);
+}
+
+void WriteJsonDevices(BufferedFileWriter& out, const std::vector<InputDevice>& devices, const std::vector<ReactionSummary>& summaries)
+{
+    out.Append("  \"devices\": [\n");
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        const InputDevice& device = devices[i];
+        char vendorId[8];
+        char productId[8];
+        std::snprintf(vendorId, sizeof(vendorId), "%04x", device.vendorId);
+        std::snprintf(productId, sizeof(productId), "%04x", device.productId);
+        out.Append("    {\"device\": \"");
+        out.AppendString(device.id.c_str());
+        out.Append("\", \"name\": \"");
+        WriteJsonDeviceName(out, device.name);
+        out.Append("\", \"vendor_id\": \"");
+        out.AppendString(vendorId);
+        out.Append("\", \"product_id\": \"");
+        out.AppendString(productId);
+        out.Append("\"");
+        WriteJsonSummaryFields(out, summaries[i]);
+        out.AppendString(i + 1 < devices.size() ? "},\n" : "}\n");
+    }
+    out.Append("  ],\n");
+
+    // Every pair, later device minus earlier one, with a 95% Welch interval.
+    const std::vector<DeviceComparison> comparisons = CompareDevices(summaries);
+    out.Append("  \"device_comparisons\": [\n");
+    for (size_t i = 0; i < comparisons.size(); ++i)
+    {
+        const DeviceComparison& comparison = comparisons[i];
+        out.Append("    {\"device\": \"");
+        out.AppendString(devices[comparison.device].id.c_str());
+        out.Append("\", \"reference\": \"");
+        out.AppendString(devices[comparison.reference].id.c_str());
+        out.Append("\"");
+        WriteJsonInlineField(out, "mean_difference_ms", comparison.difference.differenceMs, true);
+        WriteJsonInlineField(out, "ci95_low_ms", comparison.difference.lowMs, true);
+        WriteJsonInlineField(out, "ci95_high_ms", comparison.difference.highMs, true);
+        WriteJsonInlineField(out, "degrees_of_freedom", comparison.difference.degreesOfFreedom, true);
+        out.AppendString(i + 1 < comparisons.size() ? "},\n" : "}\n");
+    }
+    out.Append("  ],\n");
+}
+
+void WriteJsonTrial(
+    BufferedFileWriter& out,
+    size_t index,
+    const TrialResult& trial,
+    const OptionalColumns& columns,
+    const char* block,
+    const char* device,
+    bool last)
+{
+    out.Append("    {\"trial\": ");
+    out.AppendUnsigned(index + 1);
+    out.Append(", \"random_delay_seconds\": ");
+    out.AppendFixed6(trial.delaySeconds);
+    out.Append(", \"reaction_ms\": ");
+    if (trial.falseStart)
+    {
+        out.Append("null, \"false_start\": true");
+    }
+    else
+    {
+        out.AppendFixed6(trial.reactionMs);
+        out.Append(", \"false_start\": false");
+    }
+    if (columns.onsetCorrection)
+    {
+        const bool scanout = !trial.falseStart && trial.onsetSource == OnsetSource::Scanout;
+        out.Append(", \"onset_correction_ms\": ");
+        WriteJsonNumber(out, trial.onsetCorrectionMs, scanout);
+    }
+    if (columns.timing)
+    {
+        const TrialTiming& timing = trial.timing;
+        const bool shown = timing.foreperiodMs > 0.0;
+        WriteJsonInlineField(out, "foreperiod_ms", timing.foreperiodMs, shown);
+        WriteJsonInlineField(out, "present_ms", timing.presentMs, shown);
+        WriteJsonInlineField(out, "input_lag_ms", timing.inputLagMs, true);
+        out.Append(", \"loop_iterations\": ");
+        out.AppendUnsigned(timing.loopIterations);
+        WriteJsonInlineField(out, "max_loop_gap_ms", timing.maxIterationGapMs, true);
+    }
+    if (block != nullptr)
+    {
+        out.Append(", \"block\": \"");
+        out.AppendString(block);
+        out.Append("\"");
+    }
+    if (device != nullptr)
+    {
+        out.Append(", \"device\": \"");
+        out.AppendString(device);
+        out.Append("\"");
+    }
+    if (last)
+    {
+        out.Append("}\n");
+    }
+    else
+    {
+        out.Append("},\n");
+    }
+}
+
+void WriteJsonFooter(BufferedFileWriter& out)
+{
+    out.Append("  ]\n}\n");
+}
+
+const char* BlockId(const std::vector<PlanBlock>& plan, const TrialResult& trial)
+{
+    if (plan.empty())
+    {
+        return nullptr;
+    }
+    return plan[static_cast<size_t>(trial.block)].id.c_str();
+}
+
+// The trial's device id for the device column: null without one, empty for a trial no device pressed.
+const char* DeviceId(const std::vector<InputDevice>* devices, const TrialResult& trial)
+{
+    if (devices == nullptr)
+    {
+        return nullptr;
+    }
+    if (trial.device < 0 || static_cast<size_t>(trial.device) >= devices->size())
+    {
+        return "";
+    }
+    return (*devices)[static_cast<size_t>(trial.device)].id.c_str();
+}
+
+void PrintDevices(const std::vector<TrialResult>& results, const std::vector<InputDevice>& devices)
+{
+    const std::vector<ReactionSummary> summaries = SummarizeDevices(results, devices.size());
+    for (size_t d = 0; d < devices.size(); ++d)
+    {
+        const ReactionSummary& device = summaries[d];
+        std::printf("Device %s: valid %zu, false starts %zu", devices[d].id.c_str(), device.validCount, device.falseStartCount);
+        if (device.validCount > 0)
+        {
+            std::printf(", average %.3f ms, median %.3f ms", device.meanMs, device.p50Ms);
+        }
+        std::printf("\n");
+    }
+    for (const DeviceComparison& comparison : CompareDevices(summaries))
+    {
+        std::printf("Device %s - %s: %+.3f ms (95%% CI %+.3f to %+.3f ms)\n",
+            devices[comparison.device].id.c_str(),
+            devices[comparison.reference].id.c_str(),
+            comparison.difference.differenceMs,
+            comparison.difference.lowMs,
+            comparison.difference.highMs);
+    }
+}
+} // namespace
+
+void PrintResults(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::vector<PlanBlock>& plan,
+    const std::vector<InputDevice>& devices,
+    const StoppingReport* stopping)
+{
+    std::printf("\n=== Results ===\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (!plan.empty() && (i == 0 || results[i].block != results[i - 1].block))
+        {
+            std::printf("Block %s:\n", BlockId(plan, results[i]));
+        }
+        if (results[i].falseStart)
+        {
+            std::printf("Trial %zu: delay=%.3f s, FALSE START\n",
+                i + 1,
+                results[i].delaySeconds);
+        }
+        else
+        {
+            std::printf("Trial %zu: delay=%.3f s, reaction=%.3f ms\n",
+                i + 1,
+                results[i].delaySeconds,
+                results[i].reactionMs);
+        }
+    }
+
+    if (!plan.empty())
+    {
+        const std::vector<ReactionSummary> blockSummaries = SummarizeBlocks(results, plan.size());
+        for (size_t b = 0; b < plan.size(); ++b)
+        {
+            const ReactionSummary& block = blockSummaries[b];
+            std::printf("Block %s: valid %zu, false starts %zu", plan[b].id.c_str(), block.validCount, block.falseStartCount);
+            if (block.validCount > 0)
+            {
+                std::printf(", average %.3f ms, median %.3f ms", block.meanMs, block.p50Ms);
+            }
+            std::printf("\n");
+        }
+    }
+    if (devices.size() > 1)
+    {
+        PrintDevices(results, devices);
+    }
+    const ReactionSummary summary = stats.Summary();
+    if (summary.validCount > 0)
+    {
+        std::printf("Average reaction (valid only): %.3f ms\n", summary.meanMs);
+        if (summary.validCount > 1)
+        {
+            std::printf("SD: %.3f ms\n", summary.sdMs);
+        }
+        std::printf("Median: %.3f ms, p90: %.3f ms, p95: %.3f ms, p99: %.3f ms\n",
+            summary.p50Ms,
+            summary.p90Ms,
+            summary.p95Ms,
+            summary.p99Ms);
+        std::printf("Min: %.3f ms, max: %.3f ms\n", summary.minMs, summary.maxMs);
+        std::printf("Trimmed mean (10%%): %.3f ms, MAD: %.3f ms\n", summary.trimmedMeanMs, summary.madMs);
+    }
+    std::printf("Valid trials: %zu, false starts: %zu\n", summary.validCount, summary.falseStartCount);
+    if (stopping != nullptr)
+    {
+        PrintStopping(*stopping);
+    }
+    PrintOnsetOvershoot(results);
+    PrintOnsetCorrection(results);
+    PrintTrialTiming(results);
+    std::printf("================\n");
+}
+
+std::string BuildDefaultCsvPath()
+{
+    const std::time_t now = std::time(nullptr);
+    std::tm localTime{};
+#if defined(_WIN32)
+    localtime_s(&localTime, &now);
+#else
+    localtime_r(&now, &localTime);
+#endif
+
+    char fileName[128]{};
+    std::snprintf(
+        fileName,
+        sizeof(fileName),
+        "PurpleReaction_%04u%02u%02u_%02u%02u%02u.csv",
+        static_cast<unsigned>(localTime.tm_year + 1900),
+        static_cast<unsigned>(localTime.tm_mon + 1),
+        static_cast<unsigned>(localTime.tm_mday),
+        static_cast<unsigned>(localTime.tm_hour),
+        static_cast<unsigned>(localTime.tm_min),
+        static_cast<unsigned>(localTime.tm_sec));
+
+    return std::string(fileName);
+}
+
+bool ExportResults(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::string& csvPath,
+    const std::string& jsonPath,
+    const std::vector<PlanBlock>& plan,
+    const ExportMetadata& metadata)
+{
+    if (results.empty())
+    {
+        std::printf("No results to export.\n");
+        return false;
+    }
+
+    bool ok = true;
+    BufferedFileWriter csv;
+    if (!csvPath.empty() && !csv.Open(csvPath))
+    {
+        std::printf("Failed to open CSV path: %s\n", csvPath.c_str());
+        ok = false;
+    }
+    BufferedFileWriter json;
+    if (!jsonPath.empty() && !json.Open(jsonPath))
+    {
+        std::printf("Failed to open JSON path: %s\n", jsonPath.c_str());
+        ok = false;
+    }
+    if (!csv.IsOpen() && !json.IsOpen())
+    {
+        return false;
+    }
+
+    const ReactionSummary summary = stats.Summary();
+    const std::vector<ReactionSummary> blockSummaries = SummarizeBlocks(results, plan.size());
+    const OptionalColumns columns = DetectOptionalColumns(results);
+    const std::vector<InputDevice>* devices =
+        metadata.devices != nullptr && !metadata.devices->empty() ? metadata.devices : nullptr;
+    const std::vector<ReactionSummary> deviceSummaries =
+        devices != nullptr ? SummarizeDevices(results, devices->size()) : std::vector<ReactionSummary>();
+    if (csv.IsOpen())
+    {
+        csv.Append("trial,random_delay_seconds,reaction_ms,false_start");
+        if (columns.onsetCorrection)
+        {
+            csv.Append(",onset_correction_ms");
+        }
+        if (columns.timing)
+        {
+            csv.Append(",foreperiod_ms,present_ms,input_lag_ms,loop_iterations,max_loop_gap_ms");
+        }
+        EndCsvRow(csv, plan.empty() ? nullptr : "block", devices != nullptr ? "device" : nullptr);
+    }
+    if (json.IsOpen())
+    {
+        WriteJsonHeader(json, results.size(), summary);
+        if (metadata.foreperiod != nullptr)
+        {
+            WriteJsonForeperiod(json, *metadata.foreperiod);
+        }
+        if (metadata.realtime != nullptr)
+        {
+            WriteJsonRealtime(json, *metadata.realtime);
+        }
+        if (metadata.stopping != nullptr)
+        {
+            WriteJsonStopping(json, *metadata.stopping);
+        }
+        if (!plan.empty())
+        {
+            WriteJsonBlocks(json, plan, blockSummaries);
+        }
+        if (devices != nullptr)
+        {
+            WriteJsonDevices(json, *devices, deviceSummaries);
+        }
+        if (metadata.distribution != nullptr)
+        {
+            WriteJsonDistribution(json, results, *metadata.distribution);
+        }
+        json.Append("  \"trials\": [\n");
+    }
+
+    // One pass over the results feeds both files.
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const char* block = BlockId(plan, results[i]);
+        const char* device = DeviceId(devices, results[i]);
+        if (csv.IsOpen())
+        {
+            WriteCsvRow(csv, i, results[i], columns, block, device);
+        }
+        if (json.IsOpen())
+        {
+            WriteJsonTrial(json, i, results[i], columns, block, device, i + 1 == results.size());
+        }
+    }
+
+    if (csv.IsOpen())
+    {
+        const char* noBlock = plan.empty() ? nullptr : "";
+        const char* noDevice = devices != nullptr ? "" : nullptr;
+        WriteCsvFooter(csv, summary, columns, noBlock, noDevice);
+        for (size_t b = 0; b < plan.size(); ++b)
+        {
+            WriteCsvFooter(csv, blockSummaries[b], columns, plan[b].id.c_str(), noDevice);
+        }
+        for (size_t d = 0; d < deviceSummaries.size(); ++d)
+        {
+            WriteCsvFooter(csv, deviceSummaries[d], columns, noBlock, (*devices)[d].id.c_str());
+        }
+        if (csv.Close())
+        {
+            std::printf("CSV exported: %s\n", csvPath.c_str());
+        }
+        else
+        {
+            std::printf("Failed while writing CSV: %s\n", csvPath.c_str());
+            ok = false;
+        }
+    }
+    if (json.IsOpen())
+    {
+        WriteJsonFooter(json);
+        if (json.Close())
+        {
+            std::printf("JSON exported: %s\n", jsonPath.c_str());
+        }
+        else
+        {
+            std::printf("Failed while writing JSON: %s\n", jsonPath.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool ExportResultsCsv(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::string& path,
+    const std::vector<PlanBlock>& plan,
+    const ExportMetadata& metadata)
+{
+    return ExportResults(results, stats, path, std::string(), plan, metadata);
+}
+
+bool ExportResultsJson(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::string& path,
+    const std::vector<PlanBlock>& plan,
+    const ExportMetadata& metadata)
+{
+    return ExportResults(results, stats, std::string(), path, plan, metadata);
+}
+} // namespace purple
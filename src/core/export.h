@@ -0,0 +1,60 @@
+#pragma once
+
+#include "core/analytics.h"
+#include "core/realtime.h"
+#include "core/session.h"
+#include "core/stats.h"
+
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// `stats` must describe `results` (Session::stats, or ComputeRunningStats for a loaded list). `plan` is the
+// run's SessionConfig::plan; when non-empty every output also carries block ids and per-block statistics.
+// `devices` (Session::devices with ids assigned) adds per-device statistics and device comparisons, and
+// `stopping` (MakeStoppingReport, runs with a stopping rule) why the run ended and the precision it reached.
+void PrintResults(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::vector<PlanBlock>& plan = {},
+    const std::vector<InputDevice>& devices = {},
+    const StoppingReport* stopping = nullptr);
+
+// PurpleReaction_YYYYMMDD_HHMMSS.csv in local time.
+std::string BuildDefaultCsvPath();
+
+// Run context recorded in the exports; null members are left out. Only `devices` reaches the CSV.
+struct ExportMetadata
+{
+    const ForeperiodConfig* foreperiod = nullptr;  // distribution and seed
+    const RealtimeReport* realtime = nullptr;      // scheduling profile the run got
+    // Session::devices with ids assigned (device.h): a device column, per-device statistics and, in the
+    // JSON, device comparisons. Left out when empty.
+    const std::vector<InputDevice>* devices = nullptr;
+    const StoppingReport* stopping = nullptr;      // runs with a stopping rule (MakeStoppingReport)
+    // --json-distribution: histograms, KDE and ECDF of the valid reactions (analytics.h). JSON only.
+    const DistributionOptions* distribution = nullptr;
+};
+
+// Writes the CSV and/or JSON schema (an empty path skips that file) in a single pass over `results`.
+bool ExportResults(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::string& csvPath,
+    const std::string& jsonPath,
+    const std::vector<PlanBlock>& plan = {},
+    const ExportMetadata& metadata = {});
+bool ExportResultsCsv(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::string& path,
+    const std::vector<PlanBlock>& plan = {},
+    const ExportMetadata& metadata = {});
+bool ExportResultsJson(
+    const std::vector<TrialResult>& results,
+    const RunningStats& stats,
+    const std::string& path,
+    const std::vector<PlanBlock>& plan = {},
+    const ExportMetadata& metadata = {});
+} // namespace purple
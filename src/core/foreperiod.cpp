@@ -0,0 +1,247 @@
+#include "core/foreperiod.h"
+
+#include "core/parse.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+namespace purple
+{
+namespace
+{
+constexpr size_t kMaxListDelays = 1000000;
+// Truncated draws are rejected and redrawn this many times before the last one is wrapped into the range.
+// Rejection alone keeps every schedule seeded before the wrap existed; the wrap bounds the work.
+constexpr int kTruncationTries = 16;
+
+// [0, 1) from the top 53 bits: exact, so every platform sees the same doubles.
+double UnitInterval(std::mt19937_64& rng)
+{
+    return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Exponential(1) by von Neumann's method: compares uniforms only, so it needs no log(). Draws u, then
+// counts how long the sequence u > u2 > u3 > ... keeps falling; an odd length accepts k + u, an even one
+// moves on to the next unit interval.
+double StandardExponential(std::mt19937_64& rng)
+{
+    double k = 0.0;
+    for (;;)
+    {
+        const double u = UnitInterval(rng);
+        double previous = u;
+        int length = 1;
+        for (;;)
+        {
+            const double next = UnitInterval(rng);
+            if (next >= previous)
+            {
+                break;
+            }
+            previous = next;
+            ++length;
+        }
+        if (length % 2 == 1)
+        {
+            return k + u;
+        }
+        k += 1.0;
+    }
+}
+
+double DrawDelay(const ForeperiodConfig& foreperiod, double minDelay, double maxDelay, std::mt19937_64& rng)
+{
+    const double range = maxDelay - minDelay;
+    const double mean = foreperiod.meanSeconds > 0.0 ? foreperiod.meanSeconds : range / 4.0;
+    switch (foreperiod.distribution)
+    {
+    case ForeperiodDistribution::Exponential:
+        for (int attempt = 1;; ++attempt)
+        {
+            const double draw = mean * StandardExponential(rng);
+            if (minDelay + draw <= maxDelay)
+            {
+                return minDelay + draw;
+            }
+            if (attempt == kTruncationTries)
+            {
+                // An exponential draw modulo the range is exactly the truncated exponential (memorylessness),
+                // so a mean far above the range still costs a bounded number of draws. fmod is exact.
+                return minDelay + std::fmod(draw, range);
+            }
+        }
+
+    case ForeperiodDistribution::Geometric:
+    {
+        // The step count is truncated rather than the delay, so rounding in min + step * k never decides
+        // whether the top step of the range is reachable.
+        const double maxSteps = std::floor(range / foreperiod.stepSeconds + 1e-9);
+        for (int attempt = 1;; ++attempt)
+        {
+            double steps = std::floor(mean * StandardExponential(rng) / foreperiod.stepSeconds);
+            if (attempt == kTruncationTries)
+            {
+                steps = std::fmod(steps, maxSteps + 1.0);  // the geometric counterpart of the wrap above
+            }
+            if (steps <= maxSteps)
+            {
+                return std::min(minDelay + foreperiod.stepSeconds * steps, maxDelay);
+            }
+        }
+    }
+
+    case ForeperiodDistribution::Uniform:
+    case ForeperiodDistribution::List:
+        break;
+    }
+    return minDelay + range * UnitInterval(rng);
+}
+} // namespace
+
+std::vector<double> BuildForeperiodSchedule(const SessionConfig& config)
+{
+    const ForeperiodConfig& foreperiod = config.foreperiod;
+    std::vector<double> schedule;
+    schedule.reserve(static_cast<size_t>(PlannedTrialCount(config)));
+
+    if (foreperiod.distribution == ForeperiodDistribution::List)
+    {
+        for (int i = 0; i < PlannedTrialCount(config) && !foreperiod.list.empty(); ++i)
+        {
+            schedule.push_back(foreperiod.list[static_cast<size_t>(i) % foreperiod.list.size()]);
+        }
+        return schedule;
+    }
+
+    std::mt19937_64 rng(foreperiod.seed);
+    if (config.plan.empty())
+    {
+        for (int i = 0; i < config.trialCount; ++i)
+        {
+            schedule.push_back(DrawDelay(foreperiod, config.minDelaySeconds, config.maxDelaySeconds, rng));
+        }
+        return schedule;
+    }
+    for (const PlanBlock& block : config.plan)
+    {
+        for (int i = 0; i < block.trialCount; ++i)
+        {
+            schedule.push_back(DrawDelay(foreperiod, block.minDelaySeconds, block.maxDelaySeconds, rng));
+        }
+    }
+    return schedule;
+}
+
+std::uint64_t DrawSeed()
+{
+    std::random_device device;
+    const std::uint64_t high = device();
+    return ((high << 32) ^ device()) & kMaxForeperiodSeed;
+}
+
+bool TryParseSeed(const std::string& value, std::uint64_t& out)
+{
+    if (value.empty() || value.size() > 16)
+    {
+        return false;
+    }
+    std::uint64_t parsed = 0;
+    for (const char c : value)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        parsed = parsed * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    if (parsed > kMaxForeperiodSeed)
+    {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+const char* ForeperiodDistributionName(ForeperiodDistribution distribution)
+{
+    switch (distribution)
+    {
+    case ForeperiodDistribution::Exponential:
+        return "exponential";
+    case ForeperiodDistribution::Geometric:
+        return "geometric";
+    case ForeperiodDistribution::List:
+        return "list";
+    case ForeperiodDistribution::Uniform:
+        break;
+    }
+    return "uniform";
+}
+
+bool ParseForeperiodDistribution(const std::string& name, ForeperiodDistribution& out)
+{
+    if (name == "uniform")
+    {
+        out = ForeperiodDistribution::Uniform;
+    }
+    else if (name == "exponential")
+    {
+        out = ForeperiodDistribution::Exponential;
+    }
+    else if (name == "geometric")
+    {
+        out = ForeperiodDistribution::Geometric;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool LoadForeperiodList(const std::string& path, std::vector<double>& delays)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        std::printf("Failed to open foreperiod list: %s\n", path.c_str());
+        return false;
+    }
+
+    delays.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        const size_t last = line.find_last_not_of(" \t\r");
+        double delay = 0.0;
+        if (!TryParseDoubleNarrow(line.substr(first, last - first + 1), delay) || !(delay > 0.0))
+        {
+            std::printf("Foreperiod list %s line %d: expected a delay in seconds greater than 0\n", path.c_str(), lineNumber);
+            return false;
+        }
+        if (delays.size() >= kMaxListDelays)
+        {
+            std::printf("Foreperiod list %s line %d: more than %zu delays\n", path.c_str(), lineNumber, kMaxListDelays);
+            return false;
+        }
+        delays.push_back(delay);
+    }
+
+    if (delays.empty())
+    {
+        std::printf("Foreperiod list %s has no delays.\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+} // namespace purple
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/session.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Foreperiod schedules: a run's delays are all drawn before it starts, from one seed. The draws use only
+// the raw output of std::mt19937_64 (fully specified by the standard) and basic IEEE arithmetic (no std
+// distributions, no libm beyond fmod, which is exact), so a seed gives the same schedule on every compiler
+// and platform.
+//
+// Uniform:     min + (max - min) * u
+// Exponential: min + mean * E, with E ~ Exponential(1) by von Neumann's comparison method; draws above
+//              max are redrawn, so the hazard stays flat over the range (non-aging). After 16 rejections
+//              the draw is taken modulo the range instead, which has the same truncated distribution, so
+//              a mean far above the range cannot stall the schedule
+// Geometric:   min + step * floor(mean * E / step), redrawn above max (the discrete non-aging schedule),
+//              with the step count wrapped the same way after 16 rejections
+// List:        the configured delays in order, repeated from the start when the run is longer
+// With a plan, each block's trials use the block's own delay range.
+
+// Seeds are limited to 53 bits so they survive JSON readers that hold numbers as doubles.
+constexpr std::uint64_t kMaxForeperiodSeed = (std::uint64_t{1} << 53) - 1;
+
+// PlannedTrialCount(config) delays from config.foreperiod (its seed included).
+std::vector<double> BuildForeperiodSchedule(const SessionConfig& config);
+
+// A fresh seed from std::random_device, for runs without --seed.
+std::uint64_t DrawSeed();
+
+// Accepts decimal integers in 0..kMaxForeperiodSeed.
+bool TryParseSeed(const std::string& value, std::uint64_t& out);
+
+// "uniform", "exponential", "geometric" or "list".
+const char* ForeperiodDistributionName(ForeperiodDistribution distribution);
+// Parses the names above, except "list" (a list comes with its file, see LoadForeperiodList).
+bool ParseForeperiodDistribution(const std::string& name, ForeperiodDistribution& out);
+
+// Reads a --foreperiod-list file: one delay in seconds per line; blank lines and lines starting with
+// '#' are skipped. At most 1000000 delays, each greater than 0. Prints the first problem and returns
+// false on error.
+bool LoadForeperiodList(const std::string& path, std::vector<double>& delays);
+} // namespace purple
@@ -0,0 +1,146 @@
+#include "core/headless.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sched.h>
+#include <time.h>
+#endif
+
+namespace purple
+{
+Ticks MonotonicClock::Now() const
+{
+#if defined(_WIN32)
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<Ticks>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void MonotonicClock::SleepUntil(Ticks deadline)
+{
+#if defined(_WIN32)
+    const Ticks remaining = deadline - Now();
+    if (remaining > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+    }
+#else
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(deadline / 1000000000);
+    ts.tv_nsec = static_cast<long>(deadline % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {
+    }
+#endif
+}
+
+void MonotonicClock::YieldThread()
+{
+#if defined(_WIN32)
+    std::this_thread::yield();
+#else
+    sched_yield();
+#endif
+}
+
+SimulatedVsyncDisplay::SimulatedVsyncDisplay(MonotonicClock& clock, const VsyncModel& model)
+    : clock_(clock),
+      periodTicks_(static_cast<double>(clock.Frequency()) / model.refreshHz),
+      phaseTicks_(model.phaseMs * static_cast<double>(clock.Frequency()) / 1000.0),
+      queueDepth_(std::max(1, model.queueDepth))
+{
+}
+
+long long SimulatedVsyncDisplay::LastVblankIndex(Ticks t) const
+{
+    long long index = static_cast<long long>(std::floor((static_cast<double>(t) - phaseTicks_) / periodTicks_));
+    if (VblankTicks(index) > t)
+    {
+        --index;
+    }
+    return index;
+}
+
+Ticks SimulatedVsyncDisplay::VblankTicks(long long index) const
+{
+    return static_cast<Ticks>(std::llround(phaseTicks_ + static_cast<double>(index) * periodTicks_));
+}
+
+Ticks SimulatedVsyncDisplay::RefreshPeriodTicks() const
+{
+    return static_cast<Ticks>(std::llround(periodTicks_));
+}
+
+void SimulatedVsyncDisplay::PresentSolidColor(float gray)
+{
+    lastGray = gray;
+    const Ticks now = clock_.Now();
+    const long long nextVblank = LastVblankIndex(now) + 1;
+
+    long long flip = nextVblank + queueDepth_ - 1;
+    if (presentCount_ > 0)
+    {
+        flip = std::max(flip, flipIndex_[presentCount_ % kHistory] + 1);
+    }
+    ++presentCount_;
+    flipIndex_[presentCount_ % kHistory] = flip;
+
+    if (queueDepth_ > 1)
+    {
+        clock_.SleepUntil(VblankTicks(nextVblank));
+    }
+}
+
+bool SimulatedVsyncDisplay::GetFrameStatistics(FrameStatistics& stats) const
+{
+    const long long syncIndex = LastVblankIndex(clock_.Now());
+    const std::uint32_t oldest = presentCount_ > kHistory ? presentCount_ - kHistory + 1 : 1;
+    for (std::uint32_t count = presentCount_; count >= oldest && count > 0; --count)
+    {
+        const long long flip = flipIndex_[count % kHistory];
+        if (flip <= syncIndex)
+        {
+            stats.presentCount = count;
+            stats.presentRefreshCount = static_cast<std::uint32_t>(flip);
+            stats.syncRefreshCount = static_cast<std::uint32_t>(syncIndex);
+            stats.syncTicks = VblankTicks(syncIndex);
+            return true;
+        }
+    }
+    return false;
+}
+
+Ticks SimulatedVsyncDisplay::LastScanoutTicks() const
+{
+    return presentCount_ > 0 ? VblankTicks(flipIndex_[presentCount_ % kHistory]) : 0;
+}
+
+void InjectedInput::Pump(Session& session)
+{
+    for (const InjectedEvent& event : pending_)
+    {
+        switch (event.kind)
+        {
+        case InjectedEventKind::Press:
+            RecordPress(session, event.timestamp, event.device);
+            break;
+        case InjectedEventKind::Escape:
+            session.escapePressed = true;
+            break;
+        case InjectedEventKind::Quit:
+            session.quitRequested = true;
+            break;
+        }
+    }
+    pending_.clear();
+}
+} // namespace purple
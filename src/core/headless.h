@@ -0,0 +1,103 @@
+#pragma once
+
+#include "core/onset.h"
+#include "core/session.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace purple
+{
+// CLOCK_MONOTONIC in nanoseconds (steady_clock where POSIX clocks are unavailable).
+struct MonotonicClock
+{
+    Ticks Now() const;
+    Ticks Frequency() const { return 1000000000; }
+    // Absolute clock_nanosleep on CLOCK_MONOTONIC; returns immediately when the deadline has passed.
+    void SleepUntil(Ticks deadline);
+    void YieldThread();
+};
+
+// Accepts presents and remembers the last gray level; nothing is drawn.
+struct NullDisplay
+{
+    void PresentSolidColor(float gray)
+    {
+        lastGray = gray;
+        ++presentCount;
+    }
+
+    float lastGray = 0.0f;
+    unsigned long long presentCount = 0;
+};
+
+struct VsyncModel
+{
+    double refreshHz = 60.0;
+    double phaseMs = 0.0;  // vblank 0 sits at clock tick 0 plus this offset
+    int queueDepth = 1;    // a present is shown at the queueDepth-th vblank after it is queued
+};
+
+// Display with a simulated vsync present queue on MonotonicClock. Vblanks fall at phase + k * period.
+// A present reaches the screen at the queueDepth-th vblank after the call (never before the previous
+// present); with queueDepth > 1 the queue is full and the call blocks until the next vblank frees a slot,
+// as a vsync Present does. Frame statistics mirror IDXGISwapChain::GetFrameStatistics, so the same
+// FrameStatisticsOnset correction runs against it as against DXGI.
+class SimulatedVsyncDisplay
+{
+public:
+    SimulatedVsyncDisplay(MonotonicClock& clock, const VsyncModel& model);
+
+    void PresentSolidColor(float gray);
+
+    bool GetFrameStatistics(FrameStatistics& stats) const;
+    std::uint32_t LastPresentCount() const { return presentCount_; }
+    Ticks RefreshPeriodTicks() const;
+
+    // Ground truth: when the most recent present reaches (or reached) the screen.
+    Ticks LastScanoutTicks() const;
+
+    float lastGray = 0.0f;
+
+private:
+    static constexpr size_t kHistory = 8;
+
+    long long LastVblankIndex(Ticks t) const;  // latest vblank at or before t
+    Ticks VblankTicks(long long index) const;
+
+    MonotonicClock& clock_;
+    double periodTicks_;
+    double phaseTicks_;
+    int queueDepth_;
+    std::uint32_t presentCount_ = 0;
+    long long flipIndex_[kHistory]{};  // vblank index of the last kHistory presents, by presentCount
+};
+
+enum class InjectedEventKind
+{
+    Press,
+    Escape,
+    Quit
+};
+
+struct InjectedEvent
+{
+    Ticks timestamp = 0;
+    InjectedEventKind kind = InjectedEventKind::Press;
+    std::uint64_t device = 0;  // Press: synthetic device handle (0: none)
+};
+
+// Input policy fed by the caller; queued events are delivered on the next Pump.
+class InjectedInput
+{
+public:
+    void InjectPress(Ticks timestamp, std::uint64_t device = 0) { pending_.push_back({timestamp, InjectedEventKind::Press, device}); }
+    void InjectEscape() { pending_.push_back({0, InjectedEventKind::Escape}); }
+    void InjectQuit() { pending_.push_back({0, InjectedEventKind::Quit}); }
+
+    void Pump(Session& session);
+
+private:
+    std::vector<InjectedEvent> pending_;
+};
+} // namespace purple
@@ -0,0 +1,17 @@
+#include "core/input.h"
+
+namespace purple
+{
+void ApplyInputEvent(Session& session, const InputEvent& event)
+{
+    switch (event.kind)
+    {
+    case InputEventKind::Press:
+        RecordPress(session, event.timestamp, event.device);
+        break;
+    case InputEventKind::Escape:
+        session.escapePressed = true;
+        break;
+    }
+}
+} // namespace purple
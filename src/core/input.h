@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/clock.h"
+#include "core/session.h"
+#include "core/spsc_ring.h"
+
+#include <cstdint>
+
+namespace purple
+{
+enum class InputEventKind : std::uint32_t
+{
+    Press,
+    Escape
+};
+
+// One captured key/button-down, stamped by the capture thread the moment it arrived.
+struct InputEvent
+{
+    Ticks timestamp = 0;
+    std::uint64_t device = 0;
+    InputEventKind kind = InputEventKind::Press;
+};
+
+using InputRing = SpscRing<InputEvent, 1024>;
+
+void ApplyInputEvent(Session& session, const InputEvent& event);
+
+// Applies every queued event to the session in capture order.
+inline size_t DrainInputEvents(InputRing& ring, Session& session)
+{
+    return DrainRing(ring, [&session](const InputEvent& event) { ApplyInputEvent(session, event); });
+}
+} // namespace purple
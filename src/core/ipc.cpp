@@ -0,0 +1,390 @@
+#include "core/ipc.h"
+
+#include "core/parse.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+#if defined(_WIN32)
+// Overlapped I/O on the pipe handle, so a read blocked on one thread never holds up a write on another.
+bool OverlappedTransfer(HANDLE pipe, HANDLE event, bool write, void* data, DWORD length, DWORD& transferred)
+{
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = event;
+    ResetEvent(event);
+    const BOOL started = write
+        ? WriteFile(pipe, data, length, nullptr, &overlapped)
+        : ReadFile(pipe, data, length, nullptr, &overlapped);
+    if (!started && GetLastError() != ERROR_IO_PENDING)
+    {
+        return false;
+    }
+    return GetOverlappedResult(pipe, &overlapped, &transferred, TRUE) != FALSE;
+}
+#else
+bool FillUnixAddress(const std::string& path, sockaddr_un& address)
+{
+    address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+#endif
+} // namespace
+
+IpcConnection::~IpcConnection()
+{
+    Close();
+}
+
+bool IpcConnection::ReadLine(std::string& line)
+{
+    for (;;)
+    {
+        const size_t newline = pending_.find('\n');
+        if (newline != std::string::npos)
+        {
+            line.assign(pending_, 0, newline);
+            pending_.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            return true;
+        }
+
+        char buffer[4096];
+#if defined(_WIN32)
+        DWORD received = 0;
+        if (pipe_ == nullptr || !OverlappedTransfer(pipe_, readEvent_, false, buffer, sizeof(buffer), received) || received == 0)
+        {
+            return false;
+        }
+#else
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        const ssize_t received = recv(fd_, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return false;
+        }
+#endif
+        pending_.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+bool IpcConnection::WriteAll(const char* data, size_t length)
+{
+    while (length > 0)
+    {
+#if defined(_WIN32)
+        DWORD written = 0;
+        if (pipe_ == nullptr ||
+            !OverlappedTransfer(pipe_, writeEvent_, true, const_cast<char*>(data), static_cast<DWORD>(length), written))
+        {
+            return false;
+        }
+#else
+        if (fd_ < 0)
+        {
+            return false;
+        }
+#if defined(MSG_NOSIGNAL)
+        const ssize_t written = send(fd_, data, length, MSG_NOSIGNAL);
+#else
+        const ssize_t written = send(fd_, data, length, 0);
+#endif
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+#endif
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+#if defined(_WIN32)
+bool IpcConnection::Connect(const std::string& endpoint)
+{
+    Close();
+    const std::wstring name = Utf8ToWide(endpoint);
+    for (int attempt = 0; attempt < 10; ++attempt)
+    {
+        HANDLE pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE)
+        {
+            pipe_ = pipe;
+            readEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            writeEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            return true;
+        }
+        if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(name.c_str(), 1000))
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+void IpcConnection::Shutdown()
+{
+    if (pipe_ != nullptr)
+    {
+        CancelIoEx(pipe_, nullptr);
+    }
+}
+
+void IpcConnection::Close()
+{
+    if (pipe_ != nullptr)
+    {
+        CloseHandle(pipe_);
+        pipe_ = nullptr;
+    }
+    if (readEvent_ != nullptr)
+    {
+        CloseHandle(readEvent_);
+        readEvent_ = nullptr;
+    }
+    if (writeEvent_ != nullptr)
+    {
+        CloseHandle(writeEvent_);
+        writeEvent_ = nullptr;
+    }
+    pending_.clear();
+}
+
+IpcListener::~IpcListener()
+{
+    Close();
+}
+
+bool IpcListener::Listen(const std::string& endpoint)
+{
+    Close();
+    pipeName_ = Utf8ToWide(endpoint);
+    stopEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    stopping_.store(false, std::memory_order_relaxed);
+    return !pipeName_.empty() && stopEvent_ != nullptr;
+}
+
+bool IpcListener::Accept(IpcConnection& connection)
+{
+    // One pipe instance per client; a fresh one is created for every Accept.
+    HANDLE pipe = CreateNamedPipeW(
+        pipeName_.c_str(),
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        PIPE_UNLIMITED_INSTANCES,
+        64 * 1024,
+        64 * 1024,
+        0,
+        nullptr);
+    if (pipe == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    HANDLE connectEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = connectEvent;
+    bool connected = ConnectNamedPipe(pipe, &overlapped) != FALSE || GetLastError() == ERROR_PIPE_CONNECTED;
+    if (!connected && GetLastError() == ERROR_IO_PENDING)
+    {
+        const HANDLE waits[2] = {connectEvent, stopEvent_};
+        if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) == WAIT_OBJECT_0)
+        {
+            DWORD ignored = 0;
+            connected = GetOverlappedResult(pipe, &overlapped, &ignored, FALSE) != FALSE;
+        }
+        else
+        {
+            CancelIo(pipe);
+            DWORD ignored = 0;
+            GetOverlappedResult(pipe, &overlapped, &ignored, TRUE);
+        }
+    }
+    CloseHandle(connectEvent);
+
+    if (!connected || stopping_.load(std::memory_order_acquire))
+    {
+        CloseHandle(pipe);
+        return false;
+    }
+
+    connection.Close();
+    connection.pipe_ = pipe;
+    connection.readEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    connection.writeEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    return true;
+}
+
+void IpcListener::Stop()
+{
+    stopping_.store(true, std::memory_order_release);
+    if (stopEvent_ != nullptr)
+    {
+        SetEvent(stopEvent_);
+    }
+}
+
+void IpcListener::Close()
+{
+    if (stopEvent_ != nullptr)
+    {
+        CloseHandle(stopEvent_);
+        stopEvent_ = nullptr;
+    }
+    pipeName_.clear();
+}
+#else
+bool IpcConnection::Connect(const std::string& endpoint)
+{
+    Close();
+    sockaddr_un address{};
+    if (!FillUnixAddress(endpoint, address))
+    {
+        return false;
+    }
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    if (connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void IpcConnection::Shutdown()
+{
+    if (fd_ >= 0)
+    {
+        shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+void IpcConnection::Close()
+{
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+    pending_.clear();
+}
+
+IpcListener::~IpcListener()
+{
+    Close();
+}
+
+bool IpcListener::Listen(const std::string& endpoint)
+{
+    Close();
+    sockaddr_un address{};
+    if (!FillUnixAddress(endpoint, address))
+    {
+        return false;
+    }
+
+    // A socket file left behind by a previous server would make bind fail.
+    unlink(endpoint.c_str());
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    if (bind(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd_, 8) != 0)
+    {
+        Close();
+        return false;
+    }
+    path_ = endpoint;
+    stopping_.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+bool IpcListener::Accept(IpcConnection& connection)
+{
+    // Poll with a short timeout so Stop never depends on closing a descriptor another thread is blocked on.
+    while (!stopping_.load(std::memory_order_acquire))
+    {
+        pollfd entry{};
+        entry.fd = fd_;
+        entry.events = POLLIN;
+        const int ready = poll(&entry, 1, 100);
+        if (ready < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        const int client = accept(fd_, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            return false;
+        }
+        connection.Close();
+        connection.fd_ = client;
+        return true;
+    }
+    return false;
+}
+
+void IpcListener::Stop()
+{
+    stopping_.store(true, std::memory_order_release);
+}
+
+void IpcListener::Close()
+{
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        fd_ = -1;
+        unlink(path_.c_str());
+    }
+    path_.clear();
+}
+#endif
+} // namespace purple
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace purple
+{
+// Local byte-stream channel for --serve: a named pipe (\\.\pipe\name) on Windows, a Unix domain socket path
+// elsewhere. Messages are newline-terminated lines.
+//
+// ReadLine and WriteAll may run at the same time on different threads; concurrent WriteAll calls must be
+// serialized by the caller.
+class IpcConnection
+{
+public:
+    IpcConnection() = default;
+    ~IpcConnection();
+
+    IpcConnection(const IpcConnection&) = delete;
+    IpcConnection& operator=(const IpcConnection&) = delete;
+
+    // Client side: connects to a listening endpoint.
+    bool Connect(const std::string& endpoint);
+
+    // Blocks for the next line (terminator stripped); false on disconnect, error or Shutdown.
+    bool ReadLine(std::string& line);
+    bool WriteAll(const char* data, size_t length);
+
+    // Wakes a ReadLine blocked on another thread and makes further I/O fail.
+    void Shutdown();
+    void Close();
+
+private:
+    friend class IpcListener;
+
+#if defined(_WIN32)
+    void* pipe_ = nullptr;
+    void* readEvent_ = nullptr;
+    void* writeEvent_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    std::string pending_;
+};
+
+class IpcListener
+{
+public:
+    IpcListener() = default;
+    ~IpcListener();
+
+    IpcListener(const IpcListener&) = delete;
+    IpcListener& operator=(const IpcListener&) = delete;
+
+    bool Listen(const std::string& endpoint);
+
+    // Blocks until a client connects (true) or Stop is called (false).
+    bool Accept(IpcConnection& connection);
+
+    // Callable from any thread; makes a blocked Accept return false.
+    void Stop();
+    void Close();
+
+private:
+    std::atomic<bool> stopping_{false};
+#if defined(_WIN32)
+    std::wstring pipeName_;
+    void* stopEvent_ = nullptr;
+#else
+    int fd_ = -1;
+    std::string path_;
+#endif
+};
+} // namespace purple
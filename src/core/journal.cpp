@@ -0,0 +1,500 @@
+#include "core/journal.h"
+
+#include "core/columnar.h"
+#include "core/mapped_file.h"
+#include "core/parse.h"
+#include "core/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+// Record windows start on this boundary: the Windows allocation granularity, a page multiple elsewhere.
+constexpr std::uint64_t kWindowAlign = 65536;
+constexpr size_t kPageBytes = 4096;
+
+JournalRecord ToRecord(const TrialResult& trial, std::uint64_t sequence)
+{
+    JournalRecord record;
+    record.delaySeconds = trial.delaySeconds;
+    record.reactionMs = trial.reactionMs;
+    record.onsetOvershootMs = trial.onsetOvershootMs;
+    record.onsetCorrectionMs = trial.onsetCorrectionMs;
+    record.sequence = static_cast<std::uint32_t>(sequence);
+    record.flags = (trial.falseStart ? kRowFalseStart : 0) | (trial.onsetSource == OnsetSource::Scanout ? kRowScanoutOnset : 0) |
+        (static_cast<std::uint32_t>(trial.device + 1) << 16);
+    record.block = trial.block;
+    record.loopIterations = trial.timing.loopIterations;
+    record.foreperiodMs = trial.timing.foreperiodMs;
+    record.presentMs = trial.timing.presentMs;
+    record.inputLagMs = trial.timing.inputLagMs;
+    record.maxIterationGapMs = trial.timing.maxIterationGapMs;
+    record.ticks = trial.ticks;
+    return record;
+}
+
+TrialResult FromRecord(const JournalRecord& record)
+{
+    TrialResult trial;
+    trial.delaySeconds = record.delaySeconds;
+    trial.reactionMs = record.reactionMs;
+    trial.falseStart = (record.flags & kRowFalseStart) != 0;
+    trial.onsetOvershootMs = record.onsetOvershootMs;
+    trial.block = record.block;
+    trial.onsetSource = (record.flags & kRowScanoutOnset) != 0 ? OnsetSource::Scanout : OnsetSource::Midpoint;
+    trial.onsetCorrectionMs = record.onsetCorrectionMs;
+    trial.device = static_cast<int>(record.flags >> 16) - 1;
+    trial.timing.foreperiodMs = record.foreperiodMs;
+    trial.timing.presentMs = record.presentMs;
+    trial.timing.inputLagMs = record.inputLagMs;
+    trial.timing.maxIterationGapMs = record.maxIterationGapMs;
+    trial.timing.loopIterations = record.loopIterations;
+    trial.ticks = record.ticks;
+    return trial;
+}
+
+// Header of a mapped journal, or false when the bytes do not start with one.
+bool ReadHeader(std::string_view bytes, JournalFileHeader& header)
+{
+    const JournalFileHeader expected;
+    if (bytes.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    return std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0;
+}
+
+// Touches every page so the loop never takes a page fault (or a first-write fault) in the window.
+void Prefault(void* data, size_t bytes)
+{
+    volatile char* bytesOut = static_cast<volatile char*>(data);
+    for (size_t offset = 0; offset < bytes; offset += kPageBytes)
+    {
+        bytesOut[offset] = 0;
+    }
+}
+} // namespace
+
+TrialJournal::~TrialJournal()
+{
+    Release();
+}
+
+bool TrialJournal::Open(const std::string& path, const SessionConfig& config, Ticks frequency)
+{
+    Release();
+    failed_ = false;
+    capacity_ = static_cast<std::uint64_t>(std::max(PlannedTrialCount(config), 1));
+    const size_t headerBytes = sizeof(JournalFileHeader) + config.plan.size() * sizeof(JournalPlanBlock);
+    const std::uint64_t recordOffset = (headerBytes + kWindowAlign - 1) / kWindowAlign * kWindowAlign;
+    if (!CreateMapping(path, recordOffset + capacity_ * sizeof(JournalRecord), recordOffset))
+    {
+        Release();
+        return false;
+    }
+
+    *header_ = JournalFileHeader{};
+    header_->flags = config.recordTiming ? JournalFileHeader::kFlagRecordTiming : 0;
+    header_->tickFrequency = frequency;
+    header_->capacity = static_cast<std::uint32_t>(capacity_);
+    header_->recordOffset = static_cast<std::uint32_t>(recordOffset);
+    header_->trialCount = config.trialCount;
+    header_->planBlocks = static_cast<std::uint32_t>(config.plan.size());
+    header_->minDelaySeconds = config.minDelaySeconds;
+    header_->maxDelaySeconds = config.maxDelaySeconds;
+    header_->foreperiodDistribution = static_cast<std::uint32_t>(config.foreperiod.distribution);
+    header_->foreperiodSeed = config.foreperiod.seed;
+    header_->foreperiodMeanSeconds = config.foreperiod.meanSeconds;
+    header_->foreperiodStepSeconds = config.foreperiod.stepSeconds;
+    JournalPlanBlock* blocks = reinterpret_cast<JournalPlanBlock*>(header_ + 1);
+    for (size_t i = 0; i < config.plan.size(); ++i)
+    {
+        const PlanBlock& block = config.plan[i];
+        JournalPlanBlock entry;
+        std::memcpy(entry.id, block.id.data(), std::min(block.id.size(), sizeof(entry.id)));
+        entry.trialCount = block.trialCount;
+        entry.minDelaySeconds = block.minDelaySeconds;
+        entry.maxDelaySeconds = block.maxDelaySeconds;
+        entry.restSeconds = block.restSeconds;
+        blocks[i] = entry;
+    }
+
+    committed_ = 0;
+    if (!MapWindow(0))
+    {
+        Release();
+        return false;
+    }
+    return true;
+}
+
+#if defined(_WIN32)
+bool TrialJournal::CreateMapping(const std::string& path, std::uint64_t fileBytes, std::uint64_t headerBytes)
+{
+    HANDLE file = CreateFileW(Utf8ToWide(path).c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::printf("Failed to create journal: %s\n", path.c_str());
+        return false;
+    }
+    file_ = file;
+
+    LARGE_INTEGER size{};
+    size.QuadPart = static_cast<LONGLONG>(fileBytes);
+    if (!SetFilePointerEx(file, size, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+    {
+        std::printf("Failed to allocate %llu bytes for journal: %s\n", static_cast<unsigned long long>(fileBytes), path.c_str());
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file,
+        nullptr,
+        PAGE_READWRITE,
+        static_cast<DWORD>(fileBytes >> 32),
+        static_cast<DWORD>(fileBytes & 0xffffffffu),
+        nullptr);
+    if (mapping != nullptr)
+    {
+        mapping_ = mapping;
+        header_ = static_cast<JournalFileHeader*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(headerBytes)));
+    }
+    if (header_ == nullptr)
+    {
+        std::printf("Failed to map journal: %s\n", path.c_str());
+        return false;
+    }
+    headerBytes_ = static_cast<size_t>(headerBytes);
+    return true;
+}
+#else
+bool TrialJournal::CreateMapping(const std::string& path, std::uint64_t fileBytes, std::uint64_t headerBytes)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        std::printf("Failed to create journal: %s\n", path.c_str());
+        return false;
+    }
+    bool allocated = ::ftruncate(fd_, static_cast<off_t>(fileBytes)) == 0;
+#if defined(__linux__)
+    // Reserve the blocks now so a full disk fails here rather than as SIGBUS mid-run.
+    const int reserveError = allocated ? ::posix_fallocate(fd_, 0, static_cast<off_t>(fileBytes)) : 0;
+    allocated = allocated && (reserveError == 0 || reserveError == EOPNOTSUPP || reserveError == EINVAL);
+#endif
+    if (!allocated)
+    {
+        std::printf("Failed to allocate %llu bytes for journal: %s\n", static_cast<unsigned long long>(fileBytes), path.c_str());
+        return false;
+    }
+    void* header = ::mmap(nullptr, static_cast<size_t>(headerBytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (header == MAP_FAILED)
+    {
+        std::printf("Failed to map journal: %s\n", path.c_str());
+        return false;
+    }
+    header_ = static_cast<JournalFileHeader*>(header);
+    headerBytes_ = static_cast<size_t>(headerBytes);
+    return true;
+}
+#endif
+
+void TrialJournal::Append(const TrialResult& trial)
+{
+    if (failed_ || header_ == nullptr || committed_ >= capacity_)
+    {
+        return;
+    }
+    if (committed_ == windowEnd_ && !MapWindow(committed_))
+    {
+        return;
+    }
+
+    window_[committed_ - windowFirst_] = ToRecord(trial, committed_ + 1);
+    ++committed_;
+    // The record's stores may not move past the counter's: a reader that sees the count sees the record.
+    std::atomic_thread_fence(std::memory_order_release);
+    *static_cast<volatile std::uint64_t*>(&header_->committed) = committed_;
+}
+
+void TrialJournal::PrepareNext()
+{
+    if (!failed_ && header_ != nullptr && committed_ == windowEnd_ && committed_ < capacity_)
+    {
+        MapWindow(committed_);
+    }
+}
+
+bool TrialJournal::MapWindow(std::uint64_t firstRecord)
+{
+    UnmapWindow();
+    const std::uint64_t count = std::min<std::uint64_t>(kWindowRecords, capacity_ - firstRecord);
+    const std::uint64_t offset = header_->recordOffset + firstRecord * sizeof(JournalRecord);
+    const size_t bytes = static_cast<size_t>(count * sizeof(JournalRecord));
+#if defined(_WIN32)
+    void* window = MapViewOfFile(static_cast<HANDLE>(mapping_),
+        FILE_MAP_WRITE,
+        static_cast<DWORD>(offset >> 32),
+        static_cast<DWORD>(offset & 0xffffffffu),
+        bytes);
+#else
+    void* window = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, static_cast<off_t>(offset));
+    window = window != MAP_FAILED ? window : nullptr;
+#endif
+    if (window == nullptr)
+    {
+        std::printf("Warning: journal window at trial %llu could not be mapped; journaling stopped.\n",
+            static_cast<unsigned long long>(firstRecord + 1));
+        failed_ = true;
+        return false;
+    }
+    Prefault(window, bytes);
+    window_ = static_cast<JournalRecord*>(window);
+    windowBytes_ = bytes;
+    windowFirst_ = firstRecord;
+    windowEnd_ = firstRecord + count;
+    return true;
+}
+
+void TrialJournal::UnmapWindow()
+{
+    if (window_ == nullptr)
+    {
+        return;
+    }
+#if defined(_WIN32)
+    FlushViewOfFile(window_, 0);
+    UnmapViewOfFile(window_);
+#else
+    // Start writeback of the finished window; unmapping does not discard the dirty pages either way.
+    ::msync(window_, windowBytes_, MS_ASYNC);
+    ::munmap(window_, windowBytes_);
+#endif
+    window_ = nullptr;
+    windowBytes_ = 0;
+}
+
+bool TrialJournal::Close(SessionOutcome outcome)
+{
+    if (header_ == nullptr)
+    {
+        return !failed_;
+    }
+
+    // Records reach the disk before the header that declares the run closed.
+#if defined(_WIN32)
+    failed_ |= window_ != nullptr && !FlushViewOfFile(window_, 0);
+    header_->state = JournalFileHeader::kStateClosed + static_cast<std::uint32_t>(outcome);
+    failed_ |= !FlushViewOfFile(header_, 0);
+    failed_ |= !FlushFileBuffers(static_cast<HANDLE>(file_));
+#else
+    failed_ |= window_ != nullptr && ::msync(window_, windowBytes_, MS_SYNC) != 0;
+    header_->state = JournalFileHeader::kStateClosed + static_cast<std::uint32_t>(outcome);
+    failed_ |= ::msync(header_, headerBytes_, MS_SYNC) != 0;
+    failed_ |= ::fsync(fd_) != 0;
+#endif
+    Release();
+    return !failed_;
+}
+
+void TrialJournal::Release()
+{
+#if defined(_WIN32)
+    if (window_ != nullptr)
+    {
+        UnmapViewOfFile(window_);
+    }
+    if (header_ != nullptr)
+    {
+        UnmapViewOfFile(header_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+    if (file_ != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(file_));
+    }
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (window_ != nullptr)
+    {
+        ::munmap(window_, windowBytes_);
+    }
+    if (header_ != nullptr)
+    {
+        ::munmap(header_, headerBytes_);
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+    fd_ = -1;
+#endif
+    window_ = nullptr;
+    windowBytes_ = 0;
+    header_ = nullptr;
+    headerBytes_ = 0;
+    windowFirst_ = 0;
+    windowEnd_ = 0;
+    committed_ = 0;
+    capacity_ = 0;
+}
+
+bool LoadJournal(const std::string& path, JournalContents& contents)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::printf("Failed to open journal: %s\n", path.c_str());
+        return false;
+    }
+    const std::string_view bytes = file.View();
+    JournalFileHeader header;
+    if (!ReadHeader(bytes, header))
+    {
+        std::printf("Journal %s: not a journal file.\n", path.c_str());
+        return false;
+    }
+    const std::uint64_t planBytes = static_cast<std::uint64_t>(header.planBlocks) * sizeof(JournalPlanBlock);
+    if (header.version < 1 || header.version > JournalFileHeader::kVersion || header.tickFrequency <= 0 || header.planBlocks > 1000 ||
+        header.recordOffset < sizeof(header) + planBytes || header.committed > header.capacity ||
+        bytes.size() < header.recordOffset + static_cast<std::uint64_t>(header.capacity) * sizeof(JournalRecord))
+    {
+        std::printf("Journal %s: unsupported version %u or bad header.\n", path.c_str(), header.version);
+        return false;
+    }
+
+    contents.tickFrequency = header.tickFrequency;
+    contents.config = SessionConfig{};
+    contents.config.trialCount = header.trialCount;
+    contents.config.minDelaySeconds = header.minDelaySeconds;
+    contents.config.maxDelaySeconds = header.maxDelaySeconds;
+    contents.config.recordTiming = (header.flags & JournalFileHeader::kFlagRecordTiming) != 0;
+    // Version 1 journals kept no foreperiod; their header bytes are zero.
+    contents.hasForeperiod = header.version >= 2;
+    if (contents.hasForeperiod)
+    {
+        contents.config.foreperiod.distribution = static_cast<ForeperiodDistribution>(header.foreperiodDistribution);
+        contents.config.foreperiod.meanSeconds = header.foreperiodMeanSeconds;
+        contents.config.foreperiod.stepSeconds = header.foreperiodStepSeconds;
+        contents.config.foreperiod.seeded = true;
+        contents.config.foreperiod.seed = header.foreperiodSeed;
+    }
+    for (std::uint32_t i = 0; i < header.planBlocks; ++i)
+    {
+        JournalPlanBlock entry;
+        std::memcpy(&entry, bytes.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        PlanBlock block;
+        block.id.assign(entry.id, std::find(entry.id, entry.id + sizeof(entry.id), '\0'));
+        block.trialCount = entry.trialCount;
+        block.minDelaySeconds = entry.minDelaySeconds;
+        block.maxDelaySeconds = entry.maxDelaySeconds;
+        block.restSeconds = entry.restSeconds;
+        contents.config.plan.push_back(std::move(block));
+    }
+
+    contents.results.clear();
+    contents.results.reserve(static_cast<size_t>(header.committed));
+    const char* records = bytes.data() + header.recordOffset;
+    for (std::uint64_t i = 0; i < header.committed; ++i)
+    {
+        JournalRecord record;
+        std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+        if (record.sequence != i + 1 || (!contents.config.plan.empty() &&
+            (record.block < 0 || static_cast<size_t>(record.block) >= contents.config.plan.size())))
+        {
+            std::printf("Journal %s: record %llu is damaged; keeping the %llu before it.\n",
+                path.c_str(),
+                static_cast<unsigned long long>(i + 1),
+                static_cast<unsigned long long>(i));
+            break;
+        }
+        contents.results.push_back(FromRecord(record));
+    }
+
+    contents.closed = header.state >= JournalFileHeader::kStateClosed &&
+        header.state <= JournalFileHeader::kStateClosed + static_cast<std::uint32_t>(SessionOutcome::QuitRequested);
+    contents.outcome = contents.closed ? static_cast<SessionOutcome>(header.state - JournalFileHeader::kStateClosed)
+                                       : SessionOutcome::Aborted;
+    return true;
+}
+
+bool IsJournal(std::string_view bytes)
+{
+    JournalFileHeader header;
+    return ReadHeader(bytes, header);
+}
+
+bool PreserveInterruptedJournal(const std::string& path)
+{
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error))
+    {
+        return true;
+    }
+    JournalFileHeader header;
+    {
+        MappedFile file;
+        if (!file.Open(path) || !ReadHeader(file.View(), header) || header.state != JournalFileHeader::kStateOpen)
+        {
+            return true;
+        }
+    }
+
+    std::string target;
+    for (int n = 1;; ++n)
+    {
+        target = NumberedTracePath(path + ".interrupted", n);
+        if (!std::filesystem::exists(target, error))
+        {
+            break;
+        }
+    }
+    std::filesystem::rename(path, target, error);
+    if (error)
+    {
+        std::printf("Journal %s is from an interrupted run and could not be moved aside: %s\n",
+            path.c_str(),
+            error.message().c_str());
+        return false;
+    }
+    std::printf("Journal %s is from an interrupted run (%llu trials); kept as %s (recover with purple_convert).\n",
+        path.c_str(),
+        static_cast<unsigned long long>(header.committed),
+        target.c_str());
+    return true;
+}
+
+void JournalTrial(const Session& session, const TrialResult& trial)
+{
+    if (session.journal != nullptr)
+    {
+        session.journal->Append(trial);
+    }
+}
+} // namespace purple
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "core/clock.h"
+#include "core/session.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace purple
+{
+// Crash-safe trial journal (`--journal`, `.prj`): each result is written into a preallocated, memory-mapped
+// file the moment it is recorded, and the header's commit counter is bumped after the record, so a run
+// that is killed or crashes keeps every trial it finished. Records are fixed-size, only a window of the
+// file is mapped at a time, and a journaled session does not keep its results in memory.
+//
+// File layout (native little-endian): JournalFileHeader (the commit counter leads its second cache line;
+// the foreperiod fields after it are written once, before any record), header.planBlocks JournalPlanBlock entries, then header.capacity JournalRecord slots starting at
+// header.recordOffset. Records [0, committed) are complete; the rest are zero or a record being written.
+struct JournalFileHeader
+{
+    static constexpr std::uint32_t kVersion = 2;
+    static constexpr std::uint32_t kFlagRecordTiming = 1;
+    // state: kStateOpen until the runner closes the journal, then kStateClosed + SessionOutcome.
+    static constexpr std::uint32_t kStateOpen = 0;
+    static constexpr std::uint32_t kStateClosed = 1;
+
+    char magic[8] = {'P', 'R', 'J', 'O', 'U', 'R', 'N', '\0'};
+    std::uint32_t version = kVersion;
+    std::uint32_t flags = 0;
+    std::int64_t tickFrequency = 0;
+    std::uint32_t capacity = 0;      // record slots (the run's planned trial count)
+    std::uint32_t recordOffset = 0;  // from the start of the file
+    std::int32_t trialCount = 0;     // SessionConfig of the run
+    std::uint32_t planBlocks = 0;
+    double minDelaySeconds = 0.0;
+    double maxDelaySeconds = 0.0;
+    std::uint32_t state = kStateOpen;
+    std::uint32_t foreperiodDistribution = 0;  // version 2; ForeperiodDistribution (a List's values are not stored)
+    // Written after each record (release order); readers trust exactly this many records.
+    std::uint64_t committed = 0;
+    std::uint64_t foreperiodSeed = 0;  // version 2: the run's seed, drawn or --seed
+    double foreperiodMeanSeconds = 0.0;
+    double foreperiodStepSeconds = 0.0;
+    char padding[32] = {};
+};
+static_assert(sizeof(JournalFileHeader) == 128, "journal header is 128 bytes on disk");
+
+struct JournalPlanBlock
+{
+    char id[64] = {};  // not NUL-terminated at 64 characters
+    std::int32_t trialCount = 0;
+    std::uint32_t reserved = 0;
+    double minDelaySeconds = 0.0;
+    double maxDelaySeconds = 0.0;
+    double restSeconds = 0.0;
+};
+static_assert(sizeof(JournalPlanBlock) == 96, "journal plan blocks are 96 bytes on disk");
+
+// One TrialResult, field for field, so results read back export byte-identically.
+struct JournalRecord
+{
+    double delaySeconds = 0.0;
+    double reactionMs = 0.0;
+    double onsetOvershootMs = 0.0;
+    double onsetCorrectionMs = 0.0;
+    std::uint32_t sequence = 0;  // 1-based trial number, checked on load
+    // kRowFalseStart | kRowScanoutOnset (columnar.h); bits 16-31 hold TrialResult::device + 1 (0: none).
+    std::uint32_t flags = 0;
+    std::int32_t block = 0;
+    std::uint32_t loopIterations = 0;
+    double foreperiodMs = 0.0;
+    double presentMs = 0.0;
+    double inputLagMs = 0.0;
+    double maxIterationGapMs = 0.0;
+    TrialTicks ticks;
+};
+static_assert(sizeof(JournalRecord) == 128, "journal records are 128 bytes on disk");
+
+// Journal writer owned by the runner and attached as Session::journal. Append is a 128-byte copy and a
+// counter store into memory that is already mapped and faulted in; mapping the next window of the file
+// (and faulting it in) happens in PrepareNext, between trials.
+class TrialJournal
+{
+public:
+    TrialJournal() = default;
+    ~TrialJournal();
+
+    TrialJournal(const TrialJournal&) = delete;
+    TrialJournal& operator=(const TrialJournal&) = delete;
+
+    // Creates `path` (replacing any file there) with room for every planned trial of `config` and maps
+    // its header and first window. Prints the reason and returns false on failure.
+    bool Open(const std::string& path, const SessionConfig& config, Ticks frequency);
+    bool IsOpen() const { return header_ != nullptr; }
+
+    void Append(const TrialResult& trial);
+    // Maps the next window once the current one is full; called between trials.
+    void PrepareNext();
+
+    std::uint64_t Committed() const { return committed_; }
+
+    // Flushes the file, marks it closed with the run's outcome and unmaps it; false if flushing failed.
+    // A journal destroyed without Close stays marked open, like one whose process died.
+    bool Close(SessionOutcome outcome);
+
+    static constexpr std::uint32_t kWindowRecords = 8192;  // 1 MB mapped at a time
+
+private:
+    // Creates and sizes the file and maps its first headerBytes (header and plan blocks).
+    bool CreateMapping(const std::string& path, std::uint64_t fileBytes, std::uint64_t headerBytes);
+    bool MapWindow(std::uint64_t firstRecord);
+    void UnmapWindow();
+    void Release();
+
+    JournalFileHeader* header_ = nullptr;
+    size_t headerBytes_ = 0;
+    JournalRecord* window_ = nullptr;
+    size_t windowBytes_ = 0;
+    std::uint64_t windowFirst_ = 0;
+    std::uint64_t windowEnd_ = 0;
+    std::uint64_t committed_ = 0;
+    std::uint64_t capacity_ = 0;
+    bool failed_ = false;
+#if defined(_WIN32)
+    void* file_ = nullptr;     // HANDLE
+    void* mapping_ = nullptr;  // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
+
+struct JournalContents
+{
+    Ticks tickFrequency = 0;
+    SessionConfig config;              // trial count, delays, plan, recordTiming and foreperiod of the run
+    bool hasForeperiod = false;        // version 2 journals; config.foreperiod is the default otherwise
+    std::vector<TrialResult> results;  // the committed trials
+    bool closed = false;               // false: the run was interrupted (crash, kill, power loss)
+    SessionOutcome outcome = SessionOutcome::Aborted;  // how a closed run ended
+};
+
+// Reads a journal's committed trials; prints the reason and returns false for files that are not valid
+// journals. Works on interrupted journals: that is what it is for.
+bool LoadJournal(const std::string& path, JournalContents& contents);
+
+// True when `bytes` start with a journal header, whatever the file is called (renamed `.interrupted` files).
+bool IsJournal(std::string_view bytes);
+
+// Before a run reuses `path`: an interrupted journal there is renamed to the first free
+// `path.interrupted[.N]` instead of being overwritten. False when it could not be moved.
+bool PreserveInterruptedJournal(const std::string& path);
+
+// Appends the result to session.journal when one is attached.
+void JournalTrial(const Session& session, const TrialResult& trial);
+} // namespace purple
@@ -0,0 +1,130 @@
+#include "core/mapped_file.h"
+
+#include "core/parse.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace purple
+{
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    HANDLE file = CreateFileW(Utf8ToWide(path).c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    file_ = file;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size))
+    {
+        Close();
+        return false;
+    }
+    if (size.QuadPart == 0)
+    {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+    mapping_ = mapping;
+    data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr)
+    {
+        Close();
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+    if (file_ != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(file_));
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = nullptr;
+    file_ = nullptr;
+}
+#else
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    // The mapping keeps the file referenced; the descriptor is not needed past mmap.
+    void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    ::madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+    size_ = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+#endif
+} // namespace purple
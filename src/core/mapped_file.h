@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace purple
+{
+// Read-only memory map of a whole file (mmap / CreateFileMapping). Empty files open successfully with an
+// empty view and no mapping.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    std::string_view View() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    void* file_ = nullptr;     // HANDLE
+    void* mapping_ = nullptr;  // HANDLE
+#endif
+};
+} // namespace purple
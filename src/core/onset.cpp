@@ -0,0 +1,30 @@
+#include "core/onset.h"
+
+namespace purple
+{
+ScanoutLookup ScanoutTicksForPresent(
+    const FrameStatistics& stats,
+    std::uint32_t presentCount,
+    Ticks refreshPeriodTicks,
+    Ticks& scanoutTicks)
+{
+    // Signed 32-bit differences keep the comparisons right across counter wrap.
+    const std::int32_t presentsAhead = static_cast<std::int32_t>(stats.presentCount - presentCount);
+    if (presentsAhead < 0)
+    {
+        return ScanoutLookup::NotYet;
+    }
+    if (presentsAhead > 0)
+    {
+        return ScanoutLookup::Missed;
+    }
+
+    const std::int32_t refreshesSince = static_cast<std::int32_t>(stats.syncRefreshCount - stats.presentRefreshCount);
+    if (refreshesSince < 0)
+    {
+        return ScanoutLookup::NotYet;
+    }
+    scanoutTicks = stats.syncTicks - static_cast<Ticks>(refreshesSince) * refreshPeriodTicks;
+    return ScanoutLookup::Found;
+}
+} // namespace purple
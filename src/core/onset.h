@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/clock.h"
+
+#include <cstdint>
+
+namespace purple
+{
+enum class OnsetSource : std::uint8_t
+{
+    Midpoint,  // (before + after) / 2 around the stimulus Present call
+    Scanout    // vblank that put the stimulus frame on screen, from frame statistics
+};
+
+enum class OnsetPoll
+{
+    Pending,   // not known yet; poll again
+    Scanout,   // `onset` holds the scanout time of the stimulus frame
+    Midpoint   // no better estimate; use the Present midpoint
+};
+
+// Stimulus-onset provider used by RunTrialLoop when none is given: the Present midpoint.
+struct MidpointOnset
+{
+    void StimulusPresented(Ticks /*before*/, Ticks /*after*/) {}
+    OnsetPoll Poll(Ticks /*now*/, Ticks& /*onset*/) { return OnsetPoll::Midpoint; }
+};
+
+// The DXGI_FRAME_STATISTICS fields the scanout correction uses. Counts are 32-bit and wrap like DXGI's.
+struct FrameStatistics
+{
+    std::uint32_t presentCount = 0;         // last Present call that reached the screen
+    std::uint32_t presentRefreshCount = 0;  // vblank count at which that present was shown
+    std::uint32_t syncRefreshCount = 0;     // vblank count of the sample
+    Ticks syncTicks = 0;                    // time of that vblank
+};
+
+enum class ScanoutLookup
+{
+    NotYet,   // the present has not reached the screen at the sampled vblank
+    Found,
+    Missed    // a later present already replaced it in the statistics
+};
+
+// Scanout time of Present call number `presentCount` from one statistics sample: the sampled vblank
+// minus the refreshes that elapsed since the present was shown.
+ScanoutLookup ScanoutTicksForPresent(
+    const FrameStatistics& stats,
+    std::uint32_t presentCount,
+    Ticks refreshPeriodTicks,
+    Ticks& scanoutTicks);
+
+// Onset provider for displays that expose frame statistics:
+//   bool GetFrameStatistics(FrameStatistics&)   false while unavailable (e.g. DXGI disjoint)
+//   std::uint32_t LastPresentCount()            Present calls so far, including the stimulus
+//   Ticks RefreshPeriodTicks()
+// Falls back to the midpoint when the stimulus frame is missed or not reported within `timeoutTicks`.
+template <typename Display>
+class FrameStatisticsOnset
+{
+public:
+    FrameStatisticsOnset(Display& display, Ticks timeoutTicks)
+        : display_(display),
+          timeoutTicks_(timeoutTicks)
+    {
+    }
+
+    void StimulusPresented(Ticks /*before*/, Ticks after)
+    {
+        presentCount_ = display_.LastPresentCount();
+        deadline_ = after + timeoutTicks_;
+    }
+
+    OnsetPoll Poll(Ticks now, Ticks& onset)
+    {
+        FrameStatistics stats;
+        if (display_.GetFrameStatistics(stats))
+        {
+            switch (ScanoutTicksForPresent(stats, presentCount_, display_.RefreshPeriodTicks(), onset))
+            {
+            case ScanoutLookup::Found:
+                return OnsetPoll::Scanout;
+            case ScanoutLookup::Missed:
+                return OnsetPoll::Midpoint;
+            case ScanoutLookup::NotYet:
+                break;
+            }
+        }
+        return now >= deadline_ ? OnsetPoll::Midpoint : OnsetPoll::Pending;
+    }
+
+private:
+    Display& display_;
+    Ticks timeoutTicks_;
+    std::uint32_t presentCount_ = 0;
+    Ticks deadline_ = 0;
+};
+} // namespace purple
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace purple
+{
+// Worker count for `requested` threads: 0 means one per hardware thread.
+inline int ResolveThreadCount(int requested)
+{
+    if (requested > 0)
+    {
+        return requested;
+    }
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+// Calls fn(index, worker) for every index in [0, count) on `threads` workers (worker 0 is the calling
+// thread). Each worker starts on its own contiguous slice and, once that runs dry, steals single indices
+// from the front of the other slices, so uneven items (large files next to small ones) still finish
+// together. fn must be safe to run concurrently for different indices.
+template <typename Fn>
+void ParallelFor(size_t count, int threads, Fn&& fn)
+{
+    const size_t workers = std::max<size_t>(1, std::min(static_cast<size_t>(threads), count));
+    if (workers == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    // One cache line per slice so owners and thieves do not false-share the cursors.
+    struct alignas(64) Slice
+    {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+    std::unique_ptr<Slice[]> slices(new Slice[workers]);
+    for (size_t w = 0; w < workers; ++w)
+    {
+        slices[w].next.store(count * w / workers, std::memory_order_relaxed);
+        slices[w].end = count * (w + 1) / workers;
+    }
+
+    const auto work = [&](size_t self)
+    {
+        for (size_t offset = 0; offset < workers; ++offset)
+        {
+            Slice& slice = slices[(self + offset) % workers];
+            for (size_t i = slice.next.fetch_add(1, std::memory_order_relaxed); i < slice.end;
+                 i = slice.next.fetch_add(1, std::memory_order_relaxed))
+            {
+                fn(i, static_cast<int>(self));
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t w = 1; w < workers; ++w)
+    {
+        pool.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : pool)
+    {
+        thread.join();
+    }
+}
+} // namespace purple
@@ -0,0 +1,214 @@
+#include "core/parse.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+void SkipSpace(const std::string& text, size_t& pos)
+{
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n'))
+    {
+        ++pos;
+    }
+}
+
+bool ParseJsonString(const std::string& text, size_t& pos, std::string& out)
+{
+    if (pos >= text.size() || text[pos] != '"')
+    {
+        return false;
+    }
+    ++pos;
+    out.clear();
+    while (pos < text.size())
+    {
+        const char c = text[pos++];
+        if (c == '"')
+        {
+            return true;
+        }
+        if (c != '\\')
+        {
+            out.push_back(c);
+            continue;
+        }
+        if (pos >= text.size())
+        {
+            return false;
+        }
+        const char escaped = text[pos++];
+        switch (escaped)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out.push_back(escaped);
+            break;
+        case 'n':
+            out.push_back('\n');
+            break;
+        case 't':
+            out.push_back('\t');
+            break;
+        case 'r':
+            out.push_back('\r');
+            break;
+        default:
+            // \b, \f and \uXXXX never appear in commands; reject rather than guess.
+            return false;
+        }
+    }
+    return false;
+}
+} // namespace
+
+bool TryParseIntNarrow(const std::string& value, int& out)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+
+    char* endPtr = nullptr;
+    const long parsed = std::strtol(value.c_str(), &endPtr, 10);
+    if (endPtr == value.c_str() || *endPtr != '\0')
+    {
+        return false;
+    }
+    if (parsed < 1 || parsed > 1000000)
+    {
+        return false;
+    }
+
+    out = static_cast<int>(parsed);
+    return true;
+}
+
+bool TryParseDoubleNarrow(const std::string& value, double& out)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+
+    char* endPtr = nullptr;
+    const double parsed = std::strtod(value.c_str(), &endPtr);
+    if (endPtr == value.c_str() || *endPtr != '\0')
+    {
+        return false;
+    }
+
+    out = parsed;
+    return true;
+}
+
+bool ParseFlatJsonObject(const std::string& text, std::vector<FlatJsonField>& fields)
+{
+    fields.clear();
+    size_t pos = 0;
+    SkipSpace(text, pos);
+    if (pos >= text.size() || text[pos] != '{')
+    {
+        return false;
+    }
+    ++pos;
+    SkipSpace(text, pos);
+    if (pos < text.size() && text[pos] == '}')
+    {
+        ++pos;
+        SkipSpace(text, pos);
+        return pos == text.size();
+    }
+
+    for (;;)
+    {
+        FlatJsonField field;
+        SkipSpace(text, pos);
+        if (!ParseJsonString(text, pos, field.key))
+        {
+            return false;
+        }
+        SkipSpace(text, pos);
+        if (pos >= text.size() || text[pos] != ':')
+        {
+            return false;
+        }
+        ++pos;
+        SkipSpace(text, pos);
+        if (pos < text.size() && text[pos] == '"')
+        {
+            field.isString = true;
+            if (!ParseJsonString(text, pos, field.value))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const size_t start = pos;
+            while (pos < text.size() && std::strchr(",} \t\r\n", text[pos]) == nullptr)
+            {
+                ++pos;
+            }
+            field.value = text.substr(start, pos - start);
+            if (field.value.empty() || field.value[0] == '{' || field.value[0] == '[')
+            {
+                return false;
+            }
+        }
+        fields.push_back(std::move(field));
+
+        SkipSpace(text, pos);
+        if (pos >= text.size())
+        {
+            return false;
+        }
+        if (text[pos] == ',')
+        {
+            ++pos;
+            continue;
+        }
+        if (text[pos] != '}')
+        {
+            return false;
+        }
+        ++pos;
+        SkipSpace(text, pos);
+        return pos == text.size();
+    }
+}
+
+const FlatJsonField* FindJsonField(const std::vector<FlatJsonField>& fields, const char* key)
+{
+    for (const FlatJsonField& field : fields)
+    {
+        if (field.key == key)
+        {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+#if defined(_WIN32)
+std::wstring Utf8ToWide(const std::string& value)
+{
+    const int length = MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, nullptr, 0);
+    if (length <= 0)
+    {
+        return std::wstring();
+    }
+    std::wstring wide(static_cast<size_t>(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, wide.data(), length);
+    wide.resize(static_cast<size_t>(length - 1));
+    return wide;
+}
+#endif
+} // namespace purple
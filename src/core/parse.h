@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Accepts 1..1000000, the same trial-count range as the CLI.
+bool TryParseIntNarrow(const std::string& value, int& out);
+bool TryParseDoubleNarrow(const std::string& value, double& out);
+
+struct FlatJsonField
+{
+    std::string key;
+    std::string value;     // unescaped string contents, or the literal text of a number/true/false/null
+    bool isString = false;
+};
+
+// Parses a single JSON object whose values are strings, numbers, booleans or null (no nesting), as used
+// by the --serve command protocol. Returns false on anything else.
+bool ParseFlatJsonObject(const std::string& text, std::vector<FlatJsonField>& fields);
+const FlatJsonField* FindJsonField(const std::vector<FlatJsonField>& fields, const char* key);
+
+#if defined(_WIN32)
+// A UTF-8 path or pipe name as the wide string the W APIs take (empty when it is not valid UTF-8).
+std::wstring Utf8ToWide(const std::string& value);
+#endif
+} // namespace purple
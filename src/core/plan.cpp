@@ -0,0 +1,163 @@
+#include "core/plan.h"
+
+#include "core/parse.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace purple
+{
+namespace
+{
+constexpr size_t kMaxPlanBlocks = 1000;
+
+bool IsValidBlockId(const std::string& id)
+{
+    if (id.empty() || id.size() > 64)
+    {
+        return false;
+    }
+    for (const char c : id)
+    {
+        const bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+            c == '_' || c == '-' || c == '.';
+        if (!allowed)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns an error message, or null when the line describes a valid block.
+const char* ParseBlock(const std::string& line, size_t position, const SessionConfig& defaults, PlanBlock& block)
+{
+    std::vector<FlatJsonField> fields;
+    if (!ParseFlatJsonObject(line, fields))
+    {
+        return "expected a flat JSON object";
+    }
+
+    block = PlanBlock{};
+    block.id = std::to_string(position);
+    block.minDelaySeconds = defaults.minDelaySeconds;
+    block.maxDelaySeconds = defaults.maxDelaySeconds;
+
+    for (const FlatJsonField& field : fields)
+    {
+        if (field.key == "id")
+        {
+            block.id = field.value;
+            if (!IsValidBlockId(block.id))
+            {
+                return "id must be 1-64 characters of [A-Za-z0-9_.-]";
+            }
+        }
+        else if (field.key == "trials")
+        {
+            if (field.isString || !TryParseIntNarrow(field.value, block.trialCount))
+            {
+                return "trials must be an integer in 1..1000000";
+            }
+        }
+        else if (field.key == "min_delay")
+        {
+            if (field.isString || !TryParseDoubleNarrow(field.value, block.minDelaySeconds))
+            {
+                return "min_delay must be a number";
+            }
+        }
+        else if (field.key == "max_delay")
+        {
+            if (field.isString || !TryParseDoubleNarrow(field.value, block.maxDelaySeconds))
+            {
+                return "max_delay must be a number";
+            }
+        }
+        else if (field.key == "rest")
+        {
+            if (field.isString || !TryParseDoubleNarrow(field.value, block.restSeconds) || block.restSeconds < 0.0)
+            {
+                return "rest must be a non-negative number of seconds";
+            }
+        }
+        else
+        {
+            return "unknown field";
+        }
+    }
+
+    if (FindJsonField(fields, "trials") == nullptr)
+    {
+        return "trials is required";
+    }
+    if (block.minDelaySeconds <= 0.0 || block.maxDelaySeconds <= 0.0 || block.minDelaySeconds >= block.maxDelaySeconds)
+    {
+        return "delays must satisfy 0 < min_delay < max_delay";
+    }
+    return nullptr;
+}
+} // namespace
+
+bool LoadPlanFile(const std::string& path, const SessionConfig& defaults, std::vector<PlanBlock>& blocks)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        std::printf("Failed to open plan: %s\n", path.c_str());
+        return false;
+    }
+
+    blocks.clear();
+    long long totalTrials = 0;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#')
+        {
+            continue;
+        }
+
+        PlanBlock block;
+        if (const char* error = ParseBlock(line, blocks.size() + 1, defaults, block))
+        {
+            std::printf("Plan %s line %d: %s\n", path.c_str(), lineNumber, error);
+            return false;
+        }
+        for (const PlanBlock& existing : blocks)
+        {
+            if (existing.id == block.id)
+            {
+                std::printf("Plan %s line %d: duplicate block id %s\n", path.c_str(), lineNumber, block.id.c_str());
+                return false;
+            }
+        }
+        if (blocks.size() >= kMaxPlanBlocks)
+        {
+            std::printf("Plan %s line %d: more than %zu blocks\n", path.c_str(), lineNumber, kMaxPlanBlocks);
+            return false;
+        }
+        totalTrials += block.trialCount;
+        blocks.push_back(block);
+    }
+
+    if (blocks.empty())
+    {
+        std::printf("Plan %s has no blocks.\n", path.c_str());
+        return false;
+    }
+    if (totalTrials > 1000000)
+    {
+        std::printf("Plan %s has more than 1000000 trials in total.\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+} // namespace purple
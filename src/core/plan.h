@@ -0,0 +1,18 @@
+#pragma once
+
+#include "core/session.h"
+
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Reads a --plan file: one JSON object per block, one per line, in run order. Blank lines and lines
+// starting with '#' are skipped.
+//   {"id": "practice", "trials": 5, "min_delay": 1.0, "max_delay": 2.0, "rest": 30}
+// "trials" is required; "min_delay"/"max_delay" default to `defaults`, "rest" (seconds after the block)
+// to 0 and "id" to the block's 1-based position. Ids may use letters, digits, '_', '-' and '.'.
+// At most 1000 blocks and 1000000 trials in total.
+// Prints the first problem and returns false on error.
+bool LoadPlanFile(const std::string& path, const SessionConfig& defaults, std::vector<PlanBlock>& blocks);
+} // namespace purple
@@ -0,0 +1,476 @@
+#include "core/polling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace purple
+{
+namespace
+{
+constexpr int kMouseButtons = 5;
+constexpr int kKeys = 256;
+constexpr double kUsbRatesHz[] = {125.0, 250.0, 500.0, 1000.0, 2000.0, 4000.0, 8000.0};
+
+struct ControlState
+{
+    bool down = false;
+    Ticks lastRelease = 0;  // 0: never released
+};
+
+// Per-device scratch of one analysis; sized before the event loop so it never grows there.
+struct DeviceScratch
+{
+    Ticks lastReport = 0;
+    std::vector<Ticks> gaps;
+    std::vector<ControlState> controls;
+};
+
+// Nearest-rank percentile of the first `count` sorted gaps, in ms.
+double GapPercentileMs(const std::vector<Ticks>& sorted, size_t count, double p, Ticks frequency)
+{
+    if (count == 0)
+    {
+        return 0.0;
+    }
+    const size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(count - 1) + 0.5);
+    return TicksToMilliseconds(sorted[std::min(index, count - 1)], frequency);
+}
+
+double NominalRateHz(double medianIntervalMs)
+{
+    for (const double rate : kUsbRatesHz)
+    {
+        if (std::fabs(medianIntervalMs - 1000.0 / rate) <= 0.1 * 1000.0 / rate)
+        {
+            return rate;
+        }
+    }
+    return 0.0;
+}
+
+void RecordTransition(DevicePolling& device, ControlState& control, bool down, Ticks timestamp, Ticks bounceWindow,
+    Ticks frequency)
+{
+    if (!down)
+    {
+        if (control.down)
+        {
+            control.down = false;
+            control.lastRelease = timestamp;
+        }
+        return;
+    }
+    // Keyboard auto-repeat sends makes while the key stays down; only a release starts a new press.
+    if (control.down)
+    {
+        return;
+    }
+    control.down = true;
+    ++device.presses;
+    if (control.lastRelease != 0 && timestamp - control.lastRelease < bounceWindow)
+    {
+        const double gapMs = TicksToMilliseconds(timestamp - control.lastRelease, frequency);
+        device.minBounceMs = device.bounces == 0 ? gapMs : std::min(device.minBounceMs, gapMs);
+        device.maxBounceMs = device.bounces == 0 ? gapMs : std::max(device.maxBounceMs, gapMs);
+        ++device.bounces;
+    }
+}
+
+// Polling statistics from a mouse's report gaps (sorted here).
+void SummarizeGaps(DevicePolling& device, std::vector<Ticks>& gaps, const PollingConfig& config, Ticks frequency)
+{
+    if (gaps.empty())
+    {
+        return;
+    }
+    std::sort(gaps.begin(), gaps.end());
+    const Ticks median = gaps[(gaps.size() - 1) / 2];
+    if (median <= 0)
+    {
+        return;
+    }
+    const double interval = static_cast<double>(median);
+    const Ticks idleLimit = static_cast<Ticks>(config.idlePolls * interval);
+
+    device.medianIntervalMs = TicksToMilliseconds(median, frequency);
+    device.nominalHz = NominalRateHz(device.medianIntervalMs);
+
+    double activeTicks = 0.0;
+    double regularSum = 0.0;
+    double regularSquares = 0.0;
+    size_t regularCount = 0;
+    for (const Ticks gap : gaps)
+    {
+        if (gap > idleLimit)
+        {
+            ++device.idleGaps;
+            continue;
+        }
+        ++device.intervals;
+        activeTicks += static_cast<double>(gap);
+        const double polls = static_cast<double>(gap) / interval;
+        if (polls < 0.5)
+        {
+            ++device.coalescedReports;
+        }
+        else if (polls >= 1.5)
+        {
+            device.missedReports += static_cast<size_t>(std::lround(polls)) - 1;
+        }
+        else
+        {
+            const double ms = TicksToMilliseconds(gap, frequency);
+            regularSum += ms;
+            regularSquares += ms * ms;
+            ++regularCount;
+        }
+        const int bin = static_cast<int>(polls * 20.0);
+        ++device.histogram[std::min(bin, kPollingHistogramBins - 1)];
+    }
+
+    if (activeTicks > 0.0)
+    {
+        device.effectiveHz = static_cast<double>(device.intervals) * static_cast<double>(frequency) / activeTicks;
+    }
+    if (regularCount > 1)
+    {
+        const double mean = regularSum / static_cast<double>(regularCount);
+        const double variance = (regularSquares - regularSum * mean) / static_cast<double>(regularCount - 1);
+        device.jitterMs = std::sqrt(std::max(0.0, variance));
+    }
+    device.p1IntervalMs = GapPercentileMs(gaps, device.intervals, 1.0, frequency);
+    device.p99IntervalMs = GapPercentileMs(gaps, device.intervals, 99.0, frequency);
+}
+} // namespace
+
+bool SaveReportStream(const std::string& path, const std::vector<InputReport>& reports, Ticks frequency)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        std::printf("Failed to open report stream path: %s\n", path.c_str());
+        return false;
+    }
+    ReportFileHeader header;
+    header.tickFrequency = frequency;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok &= reports.empty() || std::fwrite(reports.data(), sizeof(InputReport), reports.size(), file) == reports.size();
+    ok &= std::fclose(file) == 0;
+    if (!ok)
+    {
+        std::printf("Failed to write report stream: %s\n", path.c_str());
+    }
+    return ok;
+}
+
+bool LoadReportStream(const std::string& path, std::vector<InputReport>& reports, Ticks& frequency)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        std::printf("Failed to open report stream: %s\n", path.c_str());
+        return false;
+    }
+
+    ReportFileHeader header;
+    const ReportFileHeader expected;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0)
+    {
+        std::printf("Report stream %s: not a report stream file.\n", path.c_str());
+        std::fclose(file);
+        return false;
+    }
+    if (header.version != ReportFileHeader::kVersion || header.tickFrequency <= 0)
+    {
+        std::printf("Report stream %s: unsupported version %u or bad header.\n", path.c_str(), header.version);
+        std::fclose(file);
+        return false;
+    }
+
+    // A partial trailing record is dropped, as in traces.
+    reports.clear();
+    InputReport chunk[1024];
+    size_t read = 0;
+    while ((read = std::fread(chunk, sizeof(InputReport), 1024, file)) > 0)
+    {
+        reports.insert(reports.end(), chunk, chunk + read);
+    }
+    std::fclose(file);
+    frequency = header.tickFrequency;
+    return true;
+}
+
+std::vector<DevicePolling> AnalyzeReports(const std::vector<InputReport>& reports, Ticks frequency, const PollingConfig& config)
+{
+    // First pass: devices in order of first report and their report counts, so the scratch is sized once.
+    std::vector<DevicePolling> devices;
+    for (const InputReport& report : reports)
+    {
+        auto found = std::find_if(devices.begin(), devices.end(),
+            [&report](const DevicePolling& device) { return device.device == report.device; });
+        if (found == devices.end())
+        {
+            DevicePolling device;
+            device.device = report.device;
+            device.source = report.source;
+            devices.push_back(device);
+            found = devices.end() - 1;
+        }
+        ++found->reports;
+    }
+
+    std::vector<DeviceScratch> scratch(devices.size());
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        const bool mouse = devices[i].source == ReportSource::Mouse;
+        scratch[i].gaps.reserve(mouse ? devices[i].reports : 0);
+        scratch[i].controls.resize(mouse ? kMouseButtons : kKeys);
+    }
+
+    const Ticks bounceWindow = SecondsToTicks(config.bounceWindowMs / 1000.0, frequency);
+    size_t current = 0;
+    for (const InputReport& report : reports)
+    {
+        if (devices[current].device != report.device)
+        {
+            current = 0;
+            while (devices[current].device != report.device)
+            {
+                ++current;
+            }
+        }
+        DevicePolling& device = devices[current];
+        DeviceScratch& state = scratch[current];
+
+        if (device.source == ReportSource::Mouse)
+        {
+            if (state.lastReport != 0)
+            {
+                state.gaps.push_back(report.timestamp - state.lastReport);
+            }
+            state.lastReport = report.timestamp;
+            // A report holding both transitions of a button released it first (the re-press bounced inside one poll).
+            for (int button = 0; button < kMouseButtons; ++button)
+            {
+                if ((report.up >> button) & 1)
+                {
+                    RecordTransition(device, state.controls[button], false, report.timestamp, bounceWindow, frequency);
+                }
+                if ((report.down >> button) & 1)
+                {
+                    RecordTransition(device, state.controls[button], true, report.timestamp, bounceWindow, frequency);
+                }
+            }
+        }
+        else
+        {
+            ControlState& key = state.controls[report.key & (kKeys - 1)];
+            if (report.up != 0)
+            {
+                RecordTransition(device, key, false, report.timestamp, bounceWindow, frequency);
+            }
+            if (report.down != 0)
+            {
+                RecordTransition(device, key, true, report.timestamp, bounceWindow, frequency);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        SummarizeGaps(devices[i], scratch[i].gaps, config, frequency);
+    }
+    return devices;
+}
+
+void PrintPollingAnalysis(const std::vector<DevicePolling>& devices, double seconds)
+{
+    std::printf("\n=== Input Polling (%.1f s) ===\n", seconds);
+    if (devices.empty())
+    {
+        std::printf("No input reports.\n");
+        return;
+    }
+    for (const DevicePolling& device : devices)
+    {
+        char handle[32];
+        std::snprintf(handle, sizeof(handle), "0x%llx", static_cast<unsigned long long>(device.device));
+        std::printf("%s %s: %zu reports\n",
+            device.source == ReportSource::Mouse ? "Mouse" : "Keyboard",
+            device.id.empty() ? handle : device.id.c_str(),
+            device.reports);
+        if (device.intervals > 0)
+        {
+            char nominal[32] = "no standard rate";
+            if (device.nominalHz > 0.0)
+            {
+                std::snprintf(nominal, sizeof(nominal), "%.0f Hz nominal", device.nominalHz);
+            }
+            std::printf("  Interval: median %.3f ms (%s), effective %.1f Hz, jitter %.3f ms, p1 %.3f ms, p99 %.3f ms\n",
+                device.medianIntervalMs,
+                nominal,
+                device.effectiveHz,
+                device.jitterMs,
+                device.p1IntervalMs,
+                device.p99IntervalMs);
+            std::printf("  Missed reports: %zu, coalesced: %zu, idle gaps: %zu\n",
+                device.missedReports,
+                device.coalescedReports,
+                device.idleGaps);
+            std::uint32_t peak = 1;
+            for (const std::uint32_t count : device.histogram)
+            {
+                peak = std::max(peak, count);
+            }
+            for (int bin = 0; bin < kPollingHistogramBins; ++bin)
+            {
+                if (device.histogram[bin] == 0)
+                {
+                    continue;
+                }
+                char range[48];
+                if (bin + 1 < kPollingHistogramBins)
+                {
+                    std::snprintf(range, sizeof(range), "%.3f-%.3f ms",
+                        device.medianIntervalMs * bin / 20.0, device.medianIntervalMs * (bin + 1) / 20.0);
+                }
+                else
+                {
+                    std::snprintf(range, sizeof(range), ">= %.3f ms", device.medianIntervalMs * 2.0);
+                }
+                const int bar = static_cast<int>(40.0 * device.histogram[bin] / peak + 0.5);
+                std::printf("  %-20s %8u %.*s\n", range, device.histogram[bin], bar, "########################################");
+            }
+        }
+        else if (device.source == ReportSource::Mouse)
+        {
+            std::printf("  Too few reports for intervals; keep the mouse moving during the window.\n");
+        }
+        if (device.bounces > 0)
+        {
+            std::printf("  Presses: %zu, bounces: %zu (release to re-press %.3f-%.3f ms)\n",
+                device.presses,
+                device.bounces,
+                device.minBounceMs,
+                device.maxBounceMs);
+        }
+        else
+        {
+            std::printf("  Presses: %zu, bounces: 0\n", device.presses);
+        }
+    }
+}
+
+SyntheticPollingTruth SynthesizeReports(const SyntheticPollingModel& model, std::uint64_t device, std::uint64_t seed,
+    std::vector<InputReport>& reports)
+{
+    const size_t first = reports.size();
+    SyntheticPollingTruth truth;
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> jitter(0.0, model.jitterUs * 1000.0);
+
+    const double period = 1e9 / model.rateHz;
+    const Ticks coalesceGap = static_cast<Ticks>(std::min(20000.0, period / 8.0));
+    const Ticks bounceWindow = static_cast<Ticks>(PollingConfig{}.bounceWindowMs * 1e6);
+    const size_t polls = static_cast<size_t>(model.seconds * model.rateHz);
+    const size_t clickPolls = std::max<size_t>(4, static_cast<size_t>(std::lround(model.clickIntervalMs * 1e6 / period)));
+    const size_t holdPolls = clickPolls / 2;
+    const size_t bouncePolls = std::max<size_t>(1, static_cast<size_t>(std::lround(model.bounceMs * 1e6 / period)));
+
+    std::uint8_t pendingDown = 0;
+    std::uint8_t pendingUp = 0;
+    size_t bouncePressAt = 0;
+    size_t bounceReleaseAt = 0;
+    Ticks lastRelease = 0;
+    Ticks lastReport = 0;
+    size_t missedRun = 0;
+    for (size_t k = 0; k < polls; ++k)
+    {
+        // Button changes wait in the device until a report gets through. Reports carry the button state, so
+        // a change undone before then (a bounce inside a lost report) never shows.
+        const size_t phase = k % clickPolls;
+        bool press = false;
+        bool release = false;
+        if (phase == 0)
+        {
+            press = true;
+            ++truth.clicks;
+        }
+        else if (phase == holdPolls)
+        {
+            release = true;
+            if (unit(rng) < model.bounceProbability && holdPolls + bouncePolls + 1 < clickPolls)
+            {
+                bouncePressAt = k + bouncePolls;
+                bounceReleaseAt = bouncePressAt + 1;
+            }
+        }
+        else if (k == bouncePressAt)
+        {
+            press = true;
+        }
+        else if (k == bounceReleaseAt)
+        {
+            release = true;
+        }
+        if (press)
+        {
+            pendingDown = pendingUp != 0 ? 0 : 1;
+            pendingUp = 0;
+        }
+        if (release)
+        {
+            pendingUp = pendingDown != 0 ? 0 : 1;
+            pendingDown = 0;
+        }
+
+        // Lost polls only show as a gap between two delivered reports; longer runs would read as idle time.
+        ++truth.polls;
+        if (unit(rng) < model.missProbability && missedRun < 2)
+        {
+            ++missedRun;
+            continue;
+        }
+        truth.missed += lastReport != 0 ? missedRun : 0;
+        missedRun = 0;
+
+        InputReport report;
+        report.timestamp = 1000000000 + static_cast<Ticks>(static_cast<double>(k) * period + jitter(rng));
+        report.device = device;
+        report.source = ReportSource::Mouse;
+        report.moved = 1;
+        report.up = pendingUp;
+        report.down = pendingDown;
+        if (pendingUp != 0)
+        {
+            lastRelease = report.timestamp;
+        }
+        if (pendingDown != 0)
+        {
+            ++truth.presses;
+            truth.bounces += lastRelease != 0 && report.timestamp - lastRelease < bounceWindow ? 1 : 0;
+        }
+        pendingUp = 0;
+        pendingDown = 0;
+        reports.push_back(report);
+        lastReport = report.timestamp;
+
+        if (unit(rng) < model.coalesceProbability)
+        {
+            InputReport doubled = report;
+            doubled.timestamp += coalesceGap;
+            doubled.up = 0;
+            doubled.down = 0;
+            reports.push_back(doubled);
+            ++truth.coalesced;
+        }
+    }
+    std::stable_sort(reports.begin() + static_cast<std::ptrdiff_t>(first), reports.end(),
+        [](const InputReport& a, const InputReport& b) { return a.timestamp < b.timestamp; });
+    return truth;
+}
+} // namespace purple
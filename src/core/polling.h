@@ -0,0 +1,155 @@
+#pragma once
+
+#include "core/clock.h"
+#include "core/spsc_ring.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Input polling analyzer (--poll-analyze): every raw report a mouse or keyboard delivers during a fixed
+// window, movement included, so the device's real polling interval, its jitter, missed and coalesced
+// reports and switch bounce can be measured. The kernels below only see report streams, so recordings
+// (--poll-out) and synthetic streams analyze the same way on any platform.
+enum class ReportSource : std::uint8_t
+{
+    Mouse = 1,
+    Keyboard = 2
+};
+
+// One raw input report, stamped on arrival like InputEvent.
+struct InputReport
+{
+    Ticks timestamp = 0;
+    std::uint64_t device = 0;   // raw input device handle
+    std::uint16_t key = 0;      // keyboard: virtual key; mouse: 0
+    ReportSource source = ReportSource::Mouse;
+    std::uint8_t down = 0;      // mouse: buttons 1-5 pressed in this report (bit 0 = left); keyboard: 1 for a make
+    std::uint8_t up = 0;        // mouse: buttons released; keyboard: 1 for a break
+    std::uint8_t moved = 0;     // mouse: 1 when the report carries movement
+    std::uint16_t reserved = 0;
+};
+static_assert(sizeof(InputReport) == 24, "input reports are 24 bytes on disk");
+
+// Capture thread to analyzer thread; at 8 kHz this holds half a second of reports.
+using ReportRing = SpscRing<InputReport, 4096>;
+
+// Fixed-capacity report store for one capture window. Add never allocates: reports past the capacity
+// are counted as overflow instead.
+class ReportRecorder
+{
+public:
+    explicit ReportRecorder(size_t capacity) { reports_.reserve(capacity); }
+
+    void Add(const InputReport& report)
+    {
+        if (reports_.size() < reports_.capacity())
+        {
+            reports_.push_back(report);
+        }
+        else
+        {
+            ++overflow_;
+        }
+    }
+
+    const std::vector<InputReport>& Reports() const { return reports_; }
+    unsigned long long Overflow() const { return overflow_; }
+
+private:
+    std::vector<InputReport> reports_;
+    unsigned long long overflow_ = 0;
+};
+
+// Report stream file (--poll-out, native little-endian): this header, then InputReport records to the end.
+struct ReportFileHeader
+{
+    static constexpr std::uint32_t kVersion = 1;
+
+    char magic[8] = {'P', 'R', 'P', 'O', 'L', 'L', '\0', '\0'};
+    std::uint32_t version = kVersion;
+    std::uint32_t reserved = 0;
+    std::int64_t tickFrequency = 0;
+};
+static_assert(sizeof(ReportFileHeader) == 24, "report stream header is 24 bytes on disk");
+
+bool SaveReportStream(const std::string& path, const std::vector<InputReport>& reports, Ticks frequency);
+// Prints the reason and returns false for files that are not report streams.
+bool LoadReportStream(const std::string& path, std::vector<InputReport>& reports, Ticks& frequency);
+
+struct PollingConfig
+{
+    // A release followed by a new press of the same button or key within this window is bounce.
+    double bounceWindowMs = 10.0;
+    // Mouse gaps longer than this many polling intervals are idle time (no movement), not missed reports.
+    double idlePolls = 4.0;
+};
+
+// Inter-report intervals of a mouse in 1/20 of its median interval, over [0, 2) intervals, plus one bin
+// for the rest up to the idle limit.
+constexpr int kPollingHistogramBins = 41;
+
+struct DevicePolling
+{
+    std::uint64_t device = 0;
+    std::string id;  // filled in by the runner (AssignDeviceIds); empty prints the handle
+    ReportSource source = ReportSource::Mouse;
+    size_t reports = 0;
+
+    // Mouse reports only: keyboards report on key changes, which says nothing about their polling.
+    size_t intervals = 0;           // gaps below the idle limit
+    double medianIntervalMs = 0.0;
+    double nominalHz = 0.0;         // standard USB rate (125 Hz to 8 kHz) within 10% of the median, else 0
+    double effectiveHz = 0.0;       // reports per second of active (non-idle) time
+    double jitterMs = 0.0;          // standard deviation of the gaps within 0.5-1.5 intervals
+    double p1IntervalMs = 0.0;
+    double p99IntervalMs = 0.0;
+    size_t missedReports = 0;       // polls skipped by gaps of 1.5 intervals up to the idle limit
+    size_t coalescedReports = 0;    // reports arriving within half an interval of the previous one
+    size_t idleGaps = 0;
+    std::uint32_t histogram[kPollingHistogramBins] = {};
+
+    // Buttons and keys.
+    size_t presses = 0;
+    size_t bounces = 0;             // re-presses within the bounce window of a release
+    double minBounceMs = 0.0;       // release to re-press, over the bounces
+    double maxBounceMs = 0.0;
+};
+
+// One entry per device in order of first report. Reports must be in capture order.
+std::vector<DevicePolling> AnalyzeReports(const std::vector<InputReport>& reports, Ticks frequency,
+    const PollingConfig& config = {});
+
+void PrintPollingAnalysis(const std::vector<DevicePolling>& devices, double seconds);
+
+// Synthetic device for the kernels: a mouse polled at a fixed rate with Gaussian delivery jitter, lost and
+// doubled reports, and clicks whose releases bounce.
+struct SyntheticPollingModel
+{
+    double rateHz = 1000.0;
+    double jitterUs = 20.0;              // delivery time around each poll (standard deviation)
+    double missProbability = 0.01;       // a poll whose report is lost (at most two in a row)
+    double coalesceProbability = 0.005;  // a poll delivering a second report right after the first
+    double clickIntervalMs = 250.0;      // one click per interval, held for half of it
+    double bounceProbability = 0.2;      // a click that bounces once after its release
+    double bounceMs = 1.5;               // release to bounce press
+    double seconds = 10.0;
+};
+
+// Ground truth of a synthetic stream: what AnalyzeReports should count.
+struct SyntheticPollingTruth
+{
+    size_t polls = 0;
+    size_t missed = 0;   // lost polls between delivered reports
+    size_t coalesced = 0;
+    size_t clicks = 0;
+    size_t presses = 0;  // delivered presses: clicks and bounce re-presses
+    size_t bounces = 0;
+};
+
+// Appends the stream of `device` (1 ns ticks) to `reports`, in timestamp order.
+SyntheticPollingTruth SynthesizeReports(const SyntheticPollingModel& model, std::uint64_t device, std::uint64_t seed,
+    std::vector<InputReport>& reports);
+} // namespace purple
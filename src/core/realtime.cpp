@@ -0,0 +1,412 @@
+#include "core/realtime.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <avrt.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+#if !defined(_WIN32)
+constexpr int kFifoPriority = 80;  // above the kernel's threaded interrupt handlers (50)
+#endif
+
+int CpuCount()
+{
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+std::string FormatCpuList(const std::vector<int>& cpus)
+{
+    std::string text;
+    for (const int cpu : cpus)
+    {
+        if (!text.empty())
+        {
+            text += ',';
+        }
+        text += std::to_string(cpu);
+    }
+    return text;
+}
+
+// The configured CPUs, or the default core for `role` (0: timing, 1: input) of the Isolated profile.
+std::vector<int> ChooseCpus(const std::vector<int>& configured, int role)
+{
+    if (!configured.empty())
+    {
+        return configured;
+    }
+    const int count = CpuCount();
+    if (count < 2)
+    {
+        return {};
+    }
+    return {count - 1 - role};
+}
+
+#if defined(_WIN32)
+// Pins the calling thread; returns the previous mask (0 on failure).
+DWORD_PTR PinCurrentThread(const std::vector<int>& cpus)
+{
+    DWORD_PTR mask = 0;
+    for (const int cpu : cpus)
+    {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+        {
+            mask |= DWORD_PTR{1} << cpu;
+        }
+    }
+    return mask == 0 ? 0 : SetThreadAffinityMask(GetCurrentThread(), mask);
+}
+
+HANDLE RegisterMmcss(const wchar_t* task)
+{
+    DWORD taskIndex = 0;
+    HANDLE handle = AvSetMmThreadCharacteristicsW(task, &taskIndex);
+    if (handle != nullptr)
+    {
+        AvSetMmThreadPriority(handle, AVRT_PRIORITY_CRITICAL);
+    }
+    return handle;
+}
+
+// Opts the process out of EcoQoS execution-speed throttling (and timer-resolution throttling on Windows
+// 11) while `off`; false restores the system's default management.
+bool SetPowerThrottlingOff(bool off)
+{
+    PROCESS_POWER_THROTTLING_STATE state{};
+    state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    if (off)
+    {
+        state.ControlMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+#if defined(PROCESS_POWER_THROTTLING_IGNORE_TIMER_RESOLUTION)
+        state.ControlMask |= PROCESS_POWER_THROTTLING_IGNORE_TIMER_RESOLUTION;
+#endif
+    }
+    return SetProcessInformation(GetCurrentProcess(), ProcessPowerThrottling, &state, sizeof(state)) != FALSE;
+}
+#else
+bool PinCurrentThread(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus)
+    {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+std::vector<int> CurrentThreadCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+#endif
+} // namespace
+
+const char* RealtimeProfileName(RealtimeProfile profile)
+{
+    switch (profile)
+    {
+    case RealtimeProfile::None:
+        return "none";
+    case RealtimeProfile::Isolated:
+        return "isolated";
+    case RealtimeProfile::Standard:
+        break;
+    }
+    return "standard";
+}
+
+bool ParseRealtimeProfile(const std::string& name, RealtimeProfile& out)
+{
+    if (name == "none")
+    {
+        out = RealtimeProfile::None;
+    }
+    else if (name == "standard")
+    {
+        out = RealtimeProfile::Standard;
+    }
+    else if (name == "isolated")
+    {
+        out = RealtimeProfile::Isolated;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool ParseCpuList(const std::string& text, std::vector<int>& cpus)
+{
+    const int count = CpuCount();
+    std::vector<int> parsed;
+    size_t position = 0;
+    while (position <= text.size())
+    {
+        const size_t end = std::min(text.find(',', position), text.size());
+        const std::string item = text.substr(position, end - position);
+        const size_t dash = item.find('-');
+        const std::string firstText = item.substr(0, dash);
+        const std::string lastText = dash == std::string::npos ? firstText : item.substr(dash + 1);
+        if (firstText.empty() || lastText.empty() || firstText.size() > 4 || lastText.size() > 4 ||
+            firstText.find_first_not_of("0123456789") != std::string::npos ||
+            lastText.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        const int first = std::stoi(firstText);
+        const int last = std::stoi(lastText);
+        if (first > last || last >= count)
+        {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            parsed.push_back(cpu);
+        }
+        position = end + 1;
+    }
+    std::sort(parsed.begin(), parsed.end());
+    parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+    cpus = parsed;
+    return true;
+}
+
+RealtimeScope::~RealtimeScope()
+{
+    Leave();
+}
+
+void RealtimeScope::Enter(const RealtimeConfig& config)
+{
+    Leave();
+    entered_ = true;
+    report_ = RealtimeReport{};
+    report_.profile = config.profile;
+    if (config.profile == RealtimeProfile::None)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    report_.priorityRaised = true;
+    if (config.profile != RealtimeProfile::Isolated)
+    {
+        return;
+    }
+
+    const std::vector<int> cpus = ChooseCpus(config.timingCpus, 0);
+    if (!cpus.empty())
+    {
+        previousAffinity_ = PinCurrentThread(cpus);
+        if (previousAffinity_ != 0)
+        {
+            report_.timingCpus = FormatCpuList(cpus);
+        }
+        else
+        {
+            std::printf("Warning: could not pin the timing thread to CPU %s.\n", FormatCpuList(cpus).c_str());
+        }
+    }
+    mmcss_ = RegisterMmcss(L"Pro Audio");
+    if (mmcss_ != nullptr)
+    {
+        report_.mmcssTask = "Pro Audio";
+    }
+    else
+    {
+        std::printf("Warning: MMCSS registration failed (error %lu).\n", GetLastError());
+    }
+    report_.powerThrottlingOff = SetPowerThrottlingOff(true);
+    if (!report_.powerThrottlingOff)
+    {
+        std::printf("Warning: could not disable power throttling (needs Windows 10 1709 or later).\n");
+    }
+#else
+    // Scheduler priority needs privileges on POSIX; Standard leaves it as it is.
+    if (config.profile != RealtimeProfile::Isolated)
+    {
+        return;
+    }
+
+    const std::vector<int> cpus = ChooseCpus(config.timingCpus, 0);
+    if (!cpus.empty())
+    {
+        previousCpus_ = CurrentThreadCpus();
+        if (PinCurrentThread(cpus))
+        {
+            report_.timingCpus = FormatCpuList(cpus);
+        }
+        else
+        {
+            std::printf("Warning: could not pin the timing thread to CPU %s (%s).\n", FormatCpuList(cpus).c_str(), std::strerror(errno));
+        }
+    }
+
+    sched_param previous{};
+    pthread_getschedparam(pthread_self(), &previousPolicy_, &previous);
+    previousPriority_ = previous.sched_priority;
+    sched_param fifo{};
+    fifo.sched_priority = std::min(kFifoPriority, sched_get_priority_max(SCHED_FIFO));
+    const int fifoError = pthread_setschedparam(pthread_self(), SCHED_FIFO, &fifo);
+    if (fifoError == 0)
+    {
+        report_.fifoPriority = fifo.sched_priority;
+    }
+    else
+    {
+        std::printf("Warning: SCHED_FIFO refused (%s); needs CAP_SYS_NICE or an rtprio limit.\n", std::strerror(fifoError));
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+    {
+        report_.memoryLocked = true;
+    }
+    else
+    {
+        std::printf("Warning: mlockall failed (%s); raise the memlock limit.\n", std::strerror(errno));
+    }
+
+    // The PM QoS request lasts while the file stays open: no idle state with an exit latency above 0 us.
+    latencyFd_ = open("/dev/cpu_dma_latency", O_WRONLY | O_CLOEXEC);
+    const std::int32_t latencyUs = 0;
+    if (latencyFd_ >= 0 && write(latencyFd_, &latencyUs, sizeof(latencyUs)) == static_cast<ssize_t>(sizeof(latencyUs)))
+    {
+        report_.cpuDmaLatencyHeld = true;
+    }
+    else
+    {
+        std::printf("Warning: could not hold /dev/cpu_dma_latency at 0 (%s); deep idle states stay enabled.\n", std::strerror(errno));
+        if (latencyFd_ >= 0)
+        {
+            close(latencyFd_);
+            latencyFd_ = -1;
+        }
+    }
+#endif
+}
+
+void RealtimeScope::Leave()
+{
+    if (!entered_)
+    {
+        return;
+    }
+    entered_ = false;
+    if (report_.profile == RealtimeProfile::None)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    if (report_.powerThrottlingOff)
+    {
+        SetPowerThrottlingOff(false);
+    }
+    if (mmcss_ != nullptr)
+    {
+        AvRevertMmThreadCharacteristics(mmcss_);
+        mmcss_ = nullptr;
+    }
+    if (previousAffinity_ != 0)
+    {
+        SetThreadAffinityMask(GetCurrentThread(), previousAffinity_);
+        previousAffinity_ = 0;
+    }
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+    SetPriorityClass(GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
+#else
+    if (latencyFd_ >= 0)
+    {
+        close(latencyFd_);
+        latencyFd_ = -1;
+    }
+    if (report_.memoryLocked)
+    {
+        munlockall();
+    }
+    if (report_.fifoPriority != 0)
+    {
+        sched_param previous{};
+        previous.sched_priority = previousPriority_;
+        pthread_setschedparam(pthread_self(), previousPolicy_, &previous);
+    }
+    if (!previousCpus_.empty())
+    {
+        PinCurrentThread(previousCpus_);
+        previousCpus_.clear();
+    }
+#endif
+}
+
+InputThreadRealtime ApplyInputThreadRealtime(const RealtimeConfig& config)
+{
+    InputThreadRealtime applied;
+    if (config.profile == RealtimeProfile::None)
+    {
+        return applied;
+    }
+#if defined(_WIN32)
+    applied.priorityRaised = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != FALSE;
+#endif
+    if (config.profile != RealtimeProfile::Isolated)
+    {
+        return applied;
+    }
+
+#if defined(_WIN32)
+    RegisterMmcss(L"Pro Audio");  // for the thread's lifetime, pinned or not
+#endif
+    const std::vector<int> cpus = ChooseCpus(config.inputCpus, 1);
+    if (cpus.empty())
+    {
+        return applied;
+    }
+#if defined(_WIN32)
+    if (PinCurrentThread(cpus) == 0)
+    {
+        return applied;
+    }
+#else
+    if (!PinCurrentThread(cpus))
+    {
+        return applied;
+    }
+#endif
+    applied.cpus = FormatCpuList(cpus);
+    return applied;
+}
+} // namespace purple
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Scheduling profile of the timing thread during a run (--rt-profile).
+enum class RealtimeProfile
+{
+    None,      // leave process and thread scheduling alone (baseline)
+    Standard,  // Windows: HIGH_PRIORITY_CLASS + THREAD_PRIORITY_TIME_CRITICAL; elsewhere unchanged
+    Isolated   // Standard, plus: timing (and input) thread pinned to their own cores, MMCSS "Pro Audio"
+               // (Windows) or SCHED_FIFO + mlockall (Linux), and power throttling / deep idle states off
+};
+
+struct RealtimeConfig
+{
+    RealtimeProfile profile = RealtimeProfile::Standard;
+    // Isolated: logical CPUs for each thread; empty picks the last CPU for timing and the one before it
+    // for input (no pinning on a single-CPU machine).
+    std::vector<int> timingCpus;
+    std::vector<int> inputCpus;
+};
+
+// What a profile actually got: parts the OS refused (missing privileges, old Windows) are left out and
+// reported when the profile is entered. Recorded in the JSON export.
+struct RealtimeReport
+{
+    RealtimeProfile profile = RealtimeProfile::None;
+    bool priorityRaised = false;
+    bool inputPriorityRaised = false;  // Windows: the input capture thread at THREAD_PRIORITY_TIME_CRITICAL
+    std::string timingCpus;  // "3", "2,3"; empty: not pinned
+    std::string inputCpus;
+    std::string mmcssTask;   // empty: not registered
+    int fifoPriority = 0;    // 0: SCHED_FIFO not applied
+    bool memoryLocked = false;
+    bool powerThrottlingOff = false;  // Windows: power throttling disabled for the process
+    bool cpuDmaLatencyHeld = false;   // Linux: /dev/cpu_dma_latency held at 0 us (no deep idle states)
+};
+
+// "none", "standard" or "isolated".
+const char* RealtimeProfileName(RealtimeProfile profile);
+bool ParseRealtimeProfile(const std::string& name, RealtimeProfile& out);
+// Comma-separated CPU numbers and ranges ("3", "2,3", "0-3"), each below the machine's CPU count.
+bool ParseCpuList(const std::string& text, std::vector<int>& cpus);
+
+// Applies a profile to the calling (timing) thread and restores the previous state in Leave. One Enter
+// per Leave; the destructor leaves.
+class RealtimeScope
+{
+public:
+    RealtimeScope() = default;
+    ~RealtimeScope();
+
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+
+    // Prints a warning for each part of the profile that could not be applied.
+    void Enter(const RealtimeConfig& config);
+    void Leave();
+
+    // Settings applied by the last Enter (inputCpus is left to the caller, see ApplyInputThreadRealtime).
+    const RealtimeReport& Report() const { return report_; }
+
+private:
+    bool entered_ = false;
+    RealtimeReport report_;
+#if defined(_WIN32)
+    std::uintptr_t previousAffinity_ = 0;
+    void* mmcss_ = nullptr;  // HANDLE from AvSetMmThreadCharacteristics
+#else
+    std::vector<int> previousCpus_;
+    int previousPolicy_ = 0;
+    int previousPriority_ = 0;
+    int latencyFd_ = -1;  // /dev/cpu_dma_latency, held open while the profile is active
+#endif
+};
+
+// What ApplyInputThreadRealtime applied, for RealtimeReport::inputPriorityRaised and inputCpus.
+struct InputThreadRealtime
+{
+    bool priorityRaised = false;
+    std::string cpus;  // "" if not pinned
+};
+
+// Profile for the input capture thread: any profile but none raises its priority, isolated also registers
+// it with MMCSS and pins it. Called once on that thread; the settings last for the thread's lifetime.
+InputThreadRealtime ApplyInputThreadRealtime(const RealtimeConfig& config);
+} // namespace purple
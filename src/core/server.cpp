@@ -0,0 +1,335 @@
+#include "core/server.h"
+
+#include "core/foreperiod.h"
+#include "core/parse.h"
+
+#include <vector>
+
+namespace purple
+{
+namespace
+{
+void BuildError(StreamRecord& record, const char* message)
+{
+    NdjsonLineBuilder line(record, "error");
+    line.String("message", message);
+    line.End();
+}
+
+// Overrides `config` with the optional fields of a run command. Returns an error message, or null.
+// A run that sets trials or delays replaces the server's --plan with a single flat block.
+const char* ApplyRunFields(const std::vector<FlatJsonField>& fields, SessionConfig& config)
+{
+    if (FindJsonField(fields, "trials") != nullptr || FindJsonField(fields, "min_delay") != nullptr ||
+        FindJsonField(fields, "max_delay") != nullptr)
+    {
+        config.plan.clear();
+    }
+    if (const FlatJsonField* trials = FindJsonField(fields, "trials"))
+    {
+        if (trials->isString || !TryParseIntNarrow(trials->value, config.trialCount))
+        {
+            return "trials must be an integer in 1..1000000";
+        }
+    }
+    if (const FlatJsonField* minDelay = FindJsonField(fields, "min_delay"))
+    {
+        if (minDelay->isString || !TryParseDoubleNarrow(minDelay->value, config.minDelaySeconds))
+        {
+            return "min_delay must be a number";
+        }
+    }
+    if (const FlatJsonField* maxDelay = FindJsonField(fields, "max_delay"))
+    {
+        if (maxDelay->isString || !TryParseDoubleNarrow(maxDelay->value, config.maxDelaySeconds))
+        {
+            return "max_delay must be a number";
+        }
+    }
+    if (const FlatJsonField* spin = FindJsonField(fields, "spin_us"))
+    {
+        double spinUs = 0.0;
+        if (spin->isString || !TryParseDoubleNarrow(spin->value, spinUs) || spinUs < 0.0 || spinUs > 100000.0)
+        {
+            return "spin_us must be a number in 0..100000";
+        }
+        config.wait.spinBudgetSeconds = spinUs / 1000000.0;
+    }
+    if (const FlatJsonField* seed = FindJsonField(fields, "seed"))
+    {
+        if (seed->isString || !TryParseSeed(seed->value, config.foreperiod.seed))
+        {
+            return "seed must be an integer in 0..9007199254740991";
+        }
+        config.foreperiod.seeded = true;
+    }
+    if (const FlatJsonField* foreperiod = FindJsonField(fields, "foreperiod"))
+    {
+        if (!foreperiod->isString || !ParseForeperiodDistribution(foreperiod->value, config.foreperiod.distribution))
+        {
+            return "foreperiod must be uniform, exponential or geometric";
+        }
+    }
+    if (config.minDelaySeconds <= 0.0 || config.maxDelaySeconds <= 0.0 || config.minDelaySeconds >= config.maxDelaySeconds)
+    {
+        return "delays must satisfy 0 < min_delay < max_delay";
+    }
+    return nullptr;
+}
+} // namespace
+
+RunServer::RunServer(const SessionConfig& defaults)
+    : defaults_(defaults)
+{
+}
+
+RunServer::~RunServer()
+{
+    Stop();
+}
+
+bool RunServer::Start(const std::string& endpoint)
+{
+    if (!listener_.Listen(endpoint))
+    {
+        return false;
+    }
+    acceptThread_ = std::thread([this] { AcceptMain(); });
+    return true;
+}
+
+void RunServer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    cancel_.store(true, std::memory_order_release);
+    runRequested_.notify_all();
+
+    listener_.Stop();
+    if (acceptThread_.joinable())
+    {
+        acceptThread_.join();
+    }
+
+    std::list<std::unique_ptr<Client>> clients;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients.swap(clients_);
+    }
+    for (const std::unique_ptr<Client>& client : clients)
+    {
+        client->connection.Shutdown();
+        if (client->thread.joinable())
+        {
+            client->thread.join();
+        }
+    }
+    listener_.Close();
+}
+
+bool RunServer::WaitForRun(Session& session)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    runRequested_.wait(lock, [this] { return shutdown_ || runPending_; });
+    if (shutdown_)
+    {
+        return false;
+    }
+
+    runPending_ = false;
+    running_ = true;
+    ++runId_;
+    runClient_ = pendingClient_;
+    pendingClient_ = nullptr;
+    runTrialCount_ = PlannedTrialCount(pendingConfig_);
+    cancel_.store(false, std::memory_order_release);
+    progress_.store(0, std::memory_order_relaxed);
+    session.config = pendingConfig_;
+    lock.unlock();
+
+    stream_.OpenSink(&RunServer::WriteToRunClient, this);
+    session.stream = &stream_;
+    session.cancelRequested = false;
+    return true;
+}
+
+void RunServer::FinishRun(Session& session)
+{
+    // Close drains the summary/aborted event to the client before the run is released.
+    stream_.Close();
+    session.stream = nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    runClient_ = nullptr;
+}
+
+bool RunServer::WriteToRunClient(void* context, const char* data, size_t length)
+{
+    // runClient_ is fixed from OpenSink until the writer thread is joined in FinishRun.
+    Client* client = static_cast<RunServer*>(context)->runClient_;
+    std::lock_guard<std::mutex> lock(client->writeMutex);
+    return client->connection.WriteAll(data, length);
+}
+
+void RunServer::AcceptMain()
+{
+    for (;;)
+    {
+        auto client = std::make_unique<Client>();
+        if (!listener_.Accept(client->connection))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ReapFinishedClients();
+        if (shutdown_)
+        {
+            return;
+        }
+        Client& added = *client;
+        clients_.push_back(std::move(client));
+        added.thread = std::thread([this, &added] { ClientMain(added); });
+    }
+}
+
+void RunServer::ReapFinishedClients()
+{
+    for (auto it = clients_.begin(); it != clients_.end();)
+    {
+        Client* client = it->get();
+        if (client->finished.load(std::memory_order_acquire) && client != runClient_ && client != pendingClient_)
+        {
+            client->thread.join();
+            it = clients_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void RunServer::ClientMain(Client& client)
+{
+    std::string line;
+    while (client.connection.ReadLine(line))
+    {
+        if (!line.empty())
+        {
+            HandleCommand(client, line);
+        }
+    }
+
+    // A client that goes away takes its run with it.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pendingClient_ == &client)
+        {
+            runPending_ = false;
+            pendingClient_ = nullptr;
+        }
+        if (runClient_ == &client)
+        {
+            cancel_.store(true, std::memory_order_release);
+        }
+    }
+    client.finished.store(true, std::memory_order_release);
+}
+
+void RunServer::HandleCommand(Client& client, const std::string& line)
+{
+    StreamRecord record;
+    std::vector<FlatJsonField> fields;
+    const FlatJsonField* cmd = nullptr;
+    if (ParseFlatJsonObject(line, fields))
+    {
+        cmd = FindJsonField(fields, "cmd");
+    }
+    if (cmd == nullptr || !cmd->isString)
+    {
+        BuildError(record, "expected a JSON object with a string cmd field");
+        Reply(client, record);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cmd->value == "run")
+    {
+        SessionConfig config = defaults_;
+        const char* error = ApplyRunFields(fields, config);
+        if (error == nullptr && shutdown_)
+        {
+            error = "server is shutting down";
+        }
+        if (error == nullptr && (running_ || runPending_))
+        {
+            error = "a run is already in progress";
+        }
+        if (error != nullptr)
+        {
+            lock.unlock();
+            BuildError(record, error);
+            Reply(client, record);
+            return;
+        }
+
+        // No acknowledgement: the run's session_start event follows on this connection.
+        pendingConfig_ = config;
+        pendingClient_ = &client;
+        runPending_ = true;
+        lock.unlock();
+        runRequested_.notify_all();
+        return;
+    }
+
+    if (cmd->value == "status")
+    {
+        NdjsonLineBuilder reply(record, "status");
+        reply.String("state", running_ ? "running" : (runPending_ ? "starting" : "idle"));
+        reply.Int("run_id", static_cast<std::int64_t>(runId_));
+        reply.Int("completed_trials", running_ ? progress_.load(std::memory_order_relaxed) : 0);
+        reply.Int("trial_count", running_ ? runTrialCount_ : 0);
+        reply.End();
+    }
+    else if (cmd->value == "cancel")
+    {
+        const bool accepted = running_ || runPending_;
+        if (runPending_)
+        {
+            runPending_ = false;
+            pendingClient_ = nullptr;
+        }
+        if (running_)
+        {
+            cancel_.store(true, std::memory_order_release);
+        }
+        NdjsonLineBuilder reply(record, "cancel");
+        reply.Bool("accepted", accepted);
+        reply.End();
+    }
+    else if (cmd->value == "shutdown")
+    {
+        shutdown_ = true;
+        cancel_.store(true, std::memory_order_release);
+        NdjsonLineBuilder reply(record, "shutdown");
+        reply.End();
+        runRequested_.notify_all();
+    }
+    else
+    {
+        BuildError(record, "unknown cmd");
+    }
+    lock.unlock();
+    Reply(client, record);
+}
+
+void RunServer::Reply(Client& client, const StreamRecord& record)
+{
+    std::lock_guard<std::mutex> lock(client.writeMutex);
+    client.connection.WriteAll(record.text, record.length);
+}
+} // namespace purple
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "core/event_stream.h"
+#include "core/ipc.h"
+#include "core/session.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace purple
+{
+// Persistent runner (--serve). Clients connect over IpcListener and send one JSON command per line:
+//   {"cmd": "run", "trials": 20, "min_delay": 1.5, "max_delay": 4.0, "spin_us": 500}  (fields optional)
+//   {"cmd": "status"}   {"cmd": "cancel"}   {"cmd": "shutdown"}
+// A run answers on the requesting connection with the --stream-out events (session_start, trial...,
+// summary or aborted). Status and cancel are answered immediately, also while a run is in progress, and
+// may come from any connection. Invalid commands get {"event": "error", "message": ...}. Runs follow the
+// defaults' plan, if any, unless the command sets trials or delays.
+//
+// Runs execute on the thread that calls WaitForRun/FinishRun, so the runner keeps its device, window and
+// input capture alive between runs; the server only owns the IPC threads.
+class RunServer
+{
+public:
+    explicit RunServer(const SessionConfig& defaults);
+    ~RunServer();
+
+    RunServer(const RunServer&) = delete;
+    RunServer& operator=(const RunServer&) = delete;
+
+    bool Start(const std::string& endpoint);
+    void Stop();
+
+    // Blocks until a client requests a run, then applies its config to session.config and points
+    // session.stream at the client. Returns false once a shutdown was requested.
+    bool WaitForRun(Session& session);
+    void FinishRun(Session& session);
+
+    bool CancelRequested() const { return cancel_.load(std::memory_order_acquire); }
+    void ReportProgress(int completedTrials) { progress_.store(completedTrials, std::memory_order_relaxed); }
+
+private:
+    struct Client
+    {
+        IpcConnection connection;
+        std::mutex writeMutex;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    static bool WriteToRunClient(void* context, const char* data, size_t length);
+    void AcceptMain();
+    void ClientMain(Client& client);
+    void HandleCommand(Client& client, const std::string& line);
+    void Reply(Client& client, const StreamRecord& record);
+    void ReapFinishedClients();
+
+    SessionConfig defaults_;
+    IpcListener listener_;
+    std::thread acceptThread_;
+    EventStream stream_;
+
+    std::mutex mutex_;
+    std::condition_variable runRequested_;
+    std::list<std::unique_ptr<Client>> clients_;
+    bool shutdown_ = false;
+    bool runPending_ = false;
+    bool running_ = false;
+    SessionConfig pendingConfig_;
+    Client* pendingClient_ = nullptr;
+    Client* runClient_ = nullptr;
+    unsigned long long runId_ = 0;
+    int runTrialCount_ = 0;
+
+    std::atomic<bool> cancel_{false};
+    std::atomic<int> progress_{0};
+};
+
+// Input policy wrapper for served runs: forwards to the runner's own input, reports progress for status
+// queries and turns a client cancel into an aborted run.
+template <typename Input>
+class ServedInput
+{
+public:
+    ServedInput(Input& input, RunServer& server)
+        : input_(input),
+          server_(server)
+    {
+    }
+
+    void Pump(Session& session)
+    {
+        input_.Pump(session);
+        server_.ReportProgress(session.trialIndex);  // results stays empty while a journal holds them
+        if (server_.CancelRequested())
+        {
+            session.cancelRequested = true;
+        }
+    }
+
+private:
+    Input& input_;
+    RunServer& server_;
+};
+} // namespace purple
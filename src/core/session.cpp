@@ -0,0 +1,536 @@
+#include "core/session.h"
+
+#include "core/foreperiod.h"
+#include "core/journal.h"
+#include "core/telemetry.h"
+#include "core/trace.h"
+#include "core/trial_log.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace purple
+{
+namespace
+{
+TrialTicks CurrentTrialTicks(const Session& session)
+{
+    const bool presented = session.stimulusMidpointTicks != 0;
+    TrialTicks ticks;
+    ticks.trialStart = session.trialStartTicks;
+    ticks.delay = session.stimulusDueTicks - session.trialStartTicks;
+    ticks.stimulus = presented ? session.stimulusTicks : 0;
+    ticks.stimulusMidpoint = session.stimulusMidpointTicks;
+    ticks.input = session.inputTicks;
+    ticks.onsetOvershoot = presented ? session.onsetOvershootTicks : 0;
+    return ticks;
+}
+// Hands a finished trial to the stream, the journal and telemetry, and keeps it unless the journal holds it.
+void StoreResult(Session& session, const TrialResult& trial)
+{
+    StreamTrial(session, trial);
+    JournalTrial(session, trial);
+    if (session.telemetry != nullptr)
+    {
+        session.telemetry->RecordTrial(trial.falseStart, trial.reactionMs);
+    }
+    if (session.journal == nullptr)
+    {
+        session.results.push_back(trial);
+    }
+}
+
+// Advances past a stored result; the run finishes after the last planned trial or once the stopping rule is met.
+void FinishTrial(Session& session)
+{
+    ++session.trialIndex;
+    const StoppingRule& rule = session.config.stopping;
+    if (session.trialIndex >= session.config.trialCount)
+    {
+        session.stopReason = StopReason::TrialCount;
+        session.phase = Phase::Finished;
+    }
+    else if (rule.Enabled() && session.precision.Count() >= static_cast<size_t>(rule.minValidTrials) &&
+        session.precision.HalfWidthMs() <= rule.halfWidthMs)
+    {
+        session.stopReason = StopReason::Precision;
+        session.phase = Phase::Finished;
+    }
+    else
+    {
+        session.phase = Phase::BeginTrial;
+    }
+}
+
+// Index of `handle` in Session::devices, appending it on its first press.
+int DeviceIndex(Session& session, std::uint64_t handle)
+{
+    for (size_t i = 0; i < session.devices.size(); ++i)
+    {
+        if (session.devices[i].handle == handle)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    InputDevice device;
+    device.handle = handle;
+    session.devices.push_back(device);
+    return static_cast<int>(session.devices.size() - 1);
+}
+
+void LogTrialEvent(const Session& session, const TrialLogRecord& record)
+{
+    if (session.log == nullptr || !session.log->IsOpen())
+    {
+        FormatTrialLog(stdout, record);
+        return;
+    }
+    session.log->Publish(record);
+}
+} // namespace
+
+const char* PrecisionStatisticName(PrecisionStatistic statistic)
+{
+    return statistic == PrecisionStatistic::Median ? "median" : "mean";
+}
+
+bool ParsePrecisionStatistic(const std::string& text, PrecisionStatistic& statistic)
+{
+    if (text == "mean")
+    {
+        statistic = PrecisionStatistic::Mean;
+        return true;
+    }
+    if (text == "median")
+    {
+        statistic = PrecisionStatistic::Median;
+        return true;
+    }
+    return false;
+}
+
+const char* StopReasonName(StopReason reason)
+{
+    switch (reason)
+    {
+    case StopReason::TrialCount:
+        return "max_trials";
+    case StopReason::Precision:
+        return "precision";
+    case StopReason::None:
+        break;
+    }
+    return "none";
+}
+
+StoppingReport MakeStoppingReport(const Session& session)
+{
+    StoppingReport report;
+    report.rule = session.config.stopping;
+    report.reason = session.stopReason;
+    report.trials = session.trialIndex;
+    report.validTrials = session.precision.Count();
+    report.estimateMs = session.precision.EstimateMs();
+    report.halfWidthMs = session.precision.HalfWidthMs();
+    return report;
+}
+
+void ResetSessionState(Session& session)
+{
+    session.results.clear();
+    session.stats.Reset();
+    session.stopReason = StopReason::None;
+    if (session.config.stopping.Enabled())
+    {
+        session.precision.Reset(session.config.stopping.statistic, session.config.stopping.confidence);
+    }
+    session.trialIndex = 0;
+    session.phase = Phase::BeginTrial;
+    session.hasInput = false;
+    session.inputWasFalseStart = false;
+    session.escapePressed = false;
+    session.cancelRequested = false;
+    session.trialStartTicks = 0;
+    session.stimulusTicks = 0;
+    session.stimulusMidpointTicks = 0;
+    session.onsetSource = OnsetSource::Midpoint;
+    session.onsetPending = false;
+    session.inputTicks = 0;
+    session.inputDevice = -1;
+    session.restUntilTicks = 0;
+    session.scheduledDelaySeconds = 0.0;
+    session.blockIndex = 0;
+    session.timingProbe = Session::TimingProbe{};
+    session.trialTiming = TrialTiming{};
+    session.devices.clear();
+    session.devices.reserve(Session::kReservedInputDevices);
+
+    SessionConfig& config = session.config;
+    if (!config.plan.empty())
+    {
+        // The plan defines the run; the flat fields mirror its totals and first block for logging/UI.
+        config.trialCount = PlannedTrialCount(config);
+        config.minDelaySeconds = config.plan.front().minDelaySeconds;
+        config.maxDelaySeconds = config.plan.front().maxDelaySeconds;
+        session.blockEndTrial = config.plan.front().trialCount;
+    }
+    else
+    {
+        session.blockEndTrial = config.trialCount;
+    }
+    if (!config.foreperiod.seeded)
+    {
+        config.foreperiod.seed = DrawSeed();
+    }
+    session.schedule = BuildForeperiodSchedule(config);
+}
+
+void RecordPress(Session& session, Ticks timestamp, std::uint64_t device)
+{
+    // Every press is traced, including ones the current phase ignores, so replay sees what the loop saw.
+    TraceEvent(session, TraceEventKind::Press, 0, timestamp, static_cast<std::int64_t>(device));
+
+    if (session.phase == Phase::WaitingForResponse && !session.hasInput)
+    {
+        // Presses are stamped at capture, so one drained after onset may still predate the stimulus.
+        session.inputTicks = timestamp;
+        session.inputDevice = DeviceIndex(session, device);
+        session.hasInput = true;
+        session.inputWasFalseStart = timestamp < session.stimulusTicks;
+    }
+    else if (session.phase == Phase::WaitingForStimulus && !session.hasInput)
+    {
+        session.inputTicks = timestamp;
+        session.inputDevice = DeviceIndex(session, device);
+        session.hasInput = true;
+        session.inputWasFalseStart = true;
+    }
+}
+
+void BeginTrial(Session& session, Ticks now, double delaySeconds, Ticks frequency)
+{
+    if (session.trace != nullptr)
+    {
+        // Between trials: the previous response is stored and the next foreperiod has not started.
+        session.trace->FlushIfFull();
+    }
+    if (session.journal != nullptr)
+    {
+        session.journal->PrepareNext();
+    }
+    std::int64_t delayBits = 0;
+    std::memcpy(&delayBits, &delaySeconds, sizeof(delayBits));
+    TraceEvent(session, TraceEventKind::TrialBegin, 0, now, delayBits);
+
+    session.scheduledDelaySeconds = delaySeconds;
+    session.trialStartTicks = now;
+    session.stimulusDueTicks = now + SecondsToTicks(delaySeconds, frequency);
+    session.stimulusTicks = 0;
+    session.stimulusMidpointTicks = 0;
+    session.inputTicks = 0;
+    session.inputDevice = -1;
+    session.hasInput = false;
+    session.inputWasFalseStart = false;
+    session.phase = Phase::WaitingForStimulus;
+
+    if (session.config.logTrials)
+    {
+        TrialLogRecord record;
+        record.event = TrialLogEvent::TrialWaiting;
+        record.trial = session.trialIndex + 1;
+        record.trialCount = session.config.trialCount;
+        record.values[0] = session.scheduledDelaySeconds;
+        LogTrialEvent(session, record);
+    }
+}
+
+void PresentStimulus(Session& session, Ticks t0, Ticks t1, Ticks overshootTicks)
+{
+    TraceEvent(session, TraceEventKind::StimulusPresent, 0, t0, t1, overshootTicks);
+
+    session.stimulusMidpointTicks = (t0 + t1) / 2;
+    session.stimulusTicks = session.stimulusMidpointTicks;
+    session.onsetSource = OnsetSource::Midpoint;
+    session.onsetPending = true;
+    session.onsetOvershootTicks = overshootTicks;
+    session.phase = Phase::WaitingForResponse;
+}
+
+void RecordReaction(Session& session, Ticks frequency)
+{
+    const double reactionMs = TicksToMilliseconds(session.inputTicks - session.stimulusTicks, frequency);
+    const double overshootMs = TicksToMilliseconds(session.onsetOvershootTicks, frequency);
+
+    StoreResult(session, TrialResult{
+        session.scheduledDelaySeconds,
+        reactionMs,
+        false,
+        overshootMs,
+        session.blockIndex,
+        session.onsetSource,
+        TicksToMilliseconds(session.stimulusTicks - session.stimulusMidpointTicks, frequency),
+        session.trialTiming,
+        CurrentTrialTicks(session),
+        session.inputDevice
+        });
+    session.stats.AddReaction(reactionMs);
+    if (session.config.stopping.Enabled())
+    {
+        session.precision.Add(reactionMs);
+    }
+
+    if (session.config.logTrials)
+    {
+        TrialLogRecord record;
+        record.event = TrialLogEvent::Reaction;
+        record.values[0] = reactionMs;
+        record.values[1] = overshootMs;
+        LogTrialEvent(session, record);
+    }
+
+    FinishTrial(session);
+}
+
+void RecordFalseStart(Session& session)
+{
+    StoreResult(session, TrialResult{
+        session.scheduledDelaySeconds,
+        0.0,
+        true,
+        0.0,
+        session.blockIndex,
+        OnsetSource::Midpoint,
+        0.0,
+        session.trialTiming,
+        CurrentTrialTicks(session),
+        session.inputDevice
+        });
+    session.stats.AddFalseStart();
+
+    if (session.config.logTrials)
+    {
+        TrialLogRecord record;
+        record.event = TrialLogEvent::FalseStart;
+        LogTrialEvent(session, record);
+    }
+
+    FinishTrial(session);
+}
+
+void ResolveStimulusOnset(Session& session, OnsetPoll poll, Ticks scanoutTicks)
+{
+    TraceEvent(session, TraceEventKind::OnsetResolved, static_cast<std::uint32_t>(poll), scanoutTicks);
+    session.onsetPending = false;
+    if (poll == OnsetPoll::Scanout)
+    {
+        session.stimulusTicks = scanoutTicks;
+        session.onsetSource = OnsetSource::Scanout;
+    }
+    if (session.hasInput && session.inputTicks < session.stimulusTicks)
+    {
+        session.inputWasFalseStart = true;
+    }
+}
+
+void FinishTrialTiming(Session& session, Ticks frequency)
+{
+    const Session::TimingProbe& probe = session.timingProbe;
+    TraceEvent(session,
+        TraceEventKind::TrialTiming,
+        probe.loopIterations,
+        probe.presentTicks,
+        probe.inputSeenTicks,
+        probe.maxIterationGapTicks);
+    TrialTiming& timing = session.trialTiming;
+    const bool shown = session.stimulusTicks != 0;
+    timing.foreperiodMs = shown ? TicksToMilliseconds(session.stimulusTicks - session.trialStartTicks, frequency) : 0.0;
+    timing.presentMs = shown ? TicksToMilliseconds(probe.presentTicks, frequency) : 0.0;
+    timing.inputLagMs = probe.inputSeenTicks != 0 ? TicksToMilliseconds(probe.inputSeenTicks - session.inputTicks, frequency) : 0.0;
+    timing.maxIterationGapMs = TicksToMilliseconds(probe.maxIterationGapTicks, frequency);
+    timing.loopIterations = probe.loopIterations;
+}
+
+int PlannedTrialCount(const SessionConfig& config)
+{
+    if (config.plan.empty())
+    {
+        return config.trialCount;
+    }
+    int total = 0;
+    for (const PlanBlock& block : config.plan)
+    {
+        total += block.trialCount;
+    }
+    return total;
+}
+
+bool AtBlockBoundary(const Session& session)
+{
+    return session.trialIndex == session.blockEndTrial &&
+        static_cast<size_t>(session.blockIndex) + 1 < session.config.plan.size();
+}
+
+double StartNextBlock(Session& session)
+{
+    const double restSeconds = session.config.plan[static_cast<size_t>(session.blockIndex)].restSeconds;
+    ++session.blockIndex;
+    const PlanBlock& block = session.config.plan[static_cast<size_t>(session.blockIndex)];
+    session.blockEndTrial += block.trialCount;
+
+    if (session.config.logTrials)
+    {
+        TrialLogRecord record;
+        record.event = TrialLogEvent::BlockStart;
+        record.trial = session.blockIndex + 1;
+        record.trialCount = static_cast<std::int32_t>(session.config.plan.size());
+        record.count = block.trialCount;
+        record.values[0] = block.minDelaySeconds;
+        record.values[1] = block.maxDelaySeconds;
+        record.values[2] = restSeconds;
+        record.label = block.id.c_str();
+        LogTrialEvent(session, record);
+    }
+    return restSeconds;
+}
+
+void StreamSessionStart(const Session& session, Ticks frequency)
+{
+    if (session.stream == nullptr)
+    {
+        return;
+    }
+
+    StreamRecord record;
+    NdjsonLineBuilder line(record, "session_start");
+    line.Int("trial_count", session.config.trialCount);
+    line.Number("min_delay_seconds", session.config.minDelaySeconds);
+    line.Number("max_delay_seconds", session.config.maxDelaySeconds);
+    line.Number("spin_budget_us", session.config.wait.spinBudgetSeconds * 1000000.0);
+    line.Int("tick_frequency", frequency);
+    if (!session.config.plan.empty())
+    {
+        line.Int("block_count", static_cast<std::int64_t>(session.config.plan.size()));
+    }
+    line.String("foreperiod", ForeperiodDistributionName(session.config.foreperiod.distribution));
+    if (session.config.foreperiod.distribution != ForeperiodDistribution::List)
+    {
+        line.Int("seed", static_cast<std::int64_t>(session.config.foreperiod.seed));
+    }
+    line.End();
+    session.stream->Publish(record);
+}
+
+void StreamTrial(const Session& session, const TrialResult& trial)
+{
+    if (session.stream == nullptr)
+    {
+        return;
+    }
+
+    StreamRecord record;
+    NdjsonLineBuilder line(record, "trial");
+    line.Int("trial", session.trialIndex + 1);
+    line.Number("random_delay_seconds", trial.delaySeconds);
+    if (trial.falseStart)
+    {
+        line.Null("reaction_ms");
+    }
+    else
+    {
+        line.Number("reaction_ms", trial.reactionMs);
+    }
+    line.Bool("false_start", trial.falseStart);
+    line.Number("onset_overshoot_ms", trial.onsetOvershootMs);
+    if (!session.config.plan.empty())
+    {
+        line.String("block", session.config.plan[static_cast<size_t>(trial.block)].id.c_str());
+    }
+    line.Int("trial_start_ticks", session.trialStartTicks);
+    line.Int("stimulus_due_ticks", session.stimulusDueTicks);
+    if (session.stimulusTicks != 0)
+    {
+        line.Int("stimulus_ticks", session.stimulusTicks);
+        line.Int("stimulus_midpoint_ticks", session.stimulusMidpointTicks);
+        line.String("onset_source", session.onsetSource == OnsetSource::Scanout ? "scanout" : "midpoint");
+    }
+    else
+    {
+        line.Null("stimulus_ticks");
+        line.Null("stimulus_midpoint_ticks");
+        line.Null("onset_source");
+    }
+    line.Int("input_ticks", session.inputTicks);
+    if (session.config.recordTiming)
+    {
+        const TrialTiming& timing = trial.timing;
+        line.Number("foreperiod_ms", timing.foreperiodMs);
+        line.Number("present_ms", timing.presentMs);
+        line.Number("input_lag_ms", timing.inputLagMs);
+        line.Int("loop_iterations", timing.loopIterations);
+        line.Number("max_loop_gap_ms", timing.maxIterationGapMs);
+    }
+    line.End();
+    session.stream->Publish(record);
+}
+
+void StreamOutcome(const Session& session, SessionOutcome outcome)
+{
+    if (session.stream == nullptr)
+    {
+        return;
+    }
+
+    StreamRecord record;
+    if (outcome != SessionOutcome::Completed)
+    {
+        NdjsonLineBuilder line(record, "aborted");
+        const char* reason = "quit";
+        if (outcome == SessionOutcome::Aborted)
+        {
+            reason = session.cancelRequested ? "cancel" : "escape";
+        }
+        line.String("reason", reason);
+        line.Int("completed_trials", session.trialIndex);
+        line.End();
+        session.stream->PublishWhenSpace(record);
+        return;
+    }
+
+    const ReactionSummary summary = session.stats.Summary();
+    const auto optional = [](NdjsonLineBuilder& line, const char* key, double value, bool hasValue)
+    {
+        if (hasValue)
+        {
+            line.Number(key, value);
+        }
+        else
+        {
+            line.Null(key);
+        }
+    };
+
+    NdjsonLineBuilder line(record, "summary");
+    line.Int("trial_count", static_cast<std::int64_t>(summary.trialCount));
+    line.Int("valid_count", static_cast<std::int64_t>(summary.validCount));
+    line.Int("false_start_count", static_cast<std::int64_t>(summary.falseStartCount));
+    optional(line, "average_reaction_ms", summary.meanMs, summary.validCount > 0);
+    optional(line, "reaction_sd_ms", summary.sdMs, summary.validCount > 1);
+    optional(line, "median_reaction_ms", summary.p50Ms, summary.validCount > 0);
+    optional(line, "p90_reaction_ms", summary.p90Ms, summary.validCount > 0);
+    optional(line, "p95_reaction_ms", summary.p95Ms, summary.validCount > 0);
+    optional(line, "p99_reaction_ms", summary.p99Ms, summary.validCount > 0);
+    optional(line, "min_reaction_ms", summary.minMs, summary.validCount > 0);
+    optional(line, "max_reaction_ms", summary.maxMs, summary.validCount > 0);
+    optional(line, "trimmed_mean_reaction_ms", summary.trimmedMeanMs, summary.validCount > 0);
+    optional(line, "mad_reaction_ms", summary.madMs, summary.validCount > 0);
+    if (session.config.stopping.Enabled())
+    {
+        const StoppingReport stopping = MakeStoppingReport(session);
+        line.String("stop_reason", StopReasonName(stopping.reason));
+        optional(line, "ci_half_width_ms", stopping.halfWidthMs, std::isfinite(stopping.halfWidthMs));
+    }
+    line.Int("stream_dropped", static_cast<std::int64_t>(session.stream->Dropped()));
+    line.End();
+    session.stream->PublishWhenSpace(record);
+}
+} // namespace purple
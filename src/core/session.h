@@ -0,0 +1,462 @@
+#pragma once
+
+#include "core/clock.h"
+#include "core/event_stream.h"
+#include "core/onset.h"
+#include "core/stats.h"
+#include "core/wait.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+class TelemetryWriter;
+class TraceWriter;
+class TrialJournal;
+class TrialLog;
+
+// --trial-timing breakdown of one trial. Zero when the flag is off.
+struct TrialTiming
+{
+    double foreperiodMs = 0.0;        // trial start to the onset used; the target is delaySeconds (0 before onset)
+    double presentMs = 0.0;           // stimulus Present call, t1 - t0 (0 before onset)
+    double inputLagMs = 0.0;          // input timestamp to the loop iteration that first saw it
+    double maxIterationGapMs = 0.0;   // longest gap between loop iterations during the trial
+    std::uint32_t loopIterations = 0; // loop iterations from trial start to the result
+};
+
+// Clock readings behind a result, in the session clock's ticks, for lossless storage (columnar.h). Zero
+// where the trial never got that far (a false start before the stimulus has no stimulus ticks).
+struct TrialTicks
+{
+    Ticks trialStart = 0;
+    Ticks delay = 0;             // scheduled foreperiod
+    Ticks stimulus = 0;          // onset the reaction is measured from
+    Ticks stimulusMidpoint = 0;  // Present midpoint
+    Ticks input = 0;
+    Ticks onsetOvershoot = 0;
+};
+
+struct TrialResult
+{
+    double delaySeconds = 0.0;
+    double reactionMs = 0.0;
+    bool falseStart = false;
+    double onsetOvershootMs = 0.0;
+    int block = 0;  // index into SessionConfig::plan (0 without a plan)
+    // Valid trials: reactionMs is measured from the onset below; the Present-midpoint reaction is
+    // reactionMs + onsetCorrectionMs.
+    OnsetSource onsetSource = OnsetSource::Midpoint;
+    double onsetCorrectionMs = 0.0;  // onset - Present midpoint (0 for midpoint onsets)
+    TrialTiming timing;
+    TrialTicks ticks;
+    int device = -1;  // index into Session::devices of the device that pressed (-1: not attributed)
+};
+
+enum class Phase
+{
+    BeginTrial,
+    WaitingForStimulus,
+    WaitingForResponse,
+    Resting,
+    Finished
+};
+
+enum class SessionOutcome
+{
+    Completed,
+    Aborted,
+    QuitRequested
+};
+
+// One block of a --plan run. Blocks run back to back in the same session.
+struct PlanBlock
+{
+    std::string id;
+    int trialCount = 10;
+    double minDelaySeconds = 2.0;
+    double maxDelaySeconds = 5.0;
+    double restSeconds = 0.0;  // black-screen break after this block (ignored for the last block)
+};
+
+// Foreperiod distribution of a run (--foreperiod). Every trial's delay is drawn before the run starts
+// (Session::schedule, see foreperiod.h).
+enum class ForeperiodDistribution
+{
+    Uniform,      // min..max
+    Exponential,  // non-aging: min + Exponential(meanSeconds), redrawn when above max
+    Geometric,    // the exponential rounded down to a multiple of stepSeconds
+    List          // the delays of a --foreperiod-list file in order, repeated as needed
+};
+
+struct ForeperiodConfig
+{
+    ForeperiodDistribution distribution = ForeperiodDistribution::Uniform;
+    double meanSeconds = 0.0;  // Exponential/Geometric mean above the minimum; 0: a quarter of the range
+    double stepSeconds = 0.1;  // Geometric
+    std::vector<double> list;  // List
+    bool seeded = false;       // --seed given; otherwise every run draws a fresh seed
+    std::uint64_t seed = 0;    // seed of the current run (the drawn one when !seeded)
+};
+
+// Input device presses came from. The trial loop only records the input policy's handle; the runner fills in
+// the identity after the run (DescribeInputDevice, AssignDeviceIds in device.h).
+struct InputDevice
+{
+    std::uint64_t handle = 0;  // raw input device handle (synthetic in headless and simulated runs)
+    std::string id;            // stable across runs, see AssignDeviceIds
+    std::string name;          // OS device path or description
+    std::uint16_t vendorId = 0;
+    std::uint16_t productId = 0;
+};
+
+// Sequential stopping (--stop-ci-ms): after every trial the run ends once the confidence interval of the
+// mean or median reaction is narrow enough (PrecisionEstimator). trialCount stays the maximum.
+struct StoppingRule
+{
+    double halfWidthMs = 0.0;  // target interval half-width; 0 runs every trial
+    PrecisionStatistic statistic = PrecisionStatistic::Mean;
+    double confidence = 0.95;
+    int minValidTrials = 20;   // never stops before this many valid trials
+
+    bool Enabled() const { return halfWidthMs > 0.0; }
+};
+
+enum class StopReason
+{
+    None,        // the run has not finished, or was aborted
+    TrialCount,  // ran every planned trial
+    Precision    // the stopping rule was met
+};
+
+struct SessionConfig
+{
+    int trialCount = 10;
+    double minDelaySeconds = 2.0;
+    double maxDelaySeconds = 5.0;
+    bool logTrials = true;
+    bool recordTiming = false;  // --trial-timing: fill TrialResult::timing
+    WaitConfig wait;
+    // When set, replaces trialCount/minDelaySeconds/maxDelaySeconds for the run.
+    std::vector<PlanBlock> plan;
+    ForeperiodConfig foreperiod;
+    StoppingRule stopping;
+};
+
+struct Session
+{
+    SessionConfig config;
+
+    int trialIndex = 0;
+    Phase phase = Phase::BeginTrial;
+    bool hasInput = false;
+    bool inputWasFalseStart = false;
+    bool escapePressed = false;
+    bool quitRequested = false;
+    bool cancelRequested = false;  // remote cancel (--serve); ends the run like Esc
+
+    Ticks trialStartTicks = 0;
+    Ticks stimulusDueTicks = 0;
+    Ticks stimulusTicks = 0;          // onset used for reactions; the midpoint until the provider resolves it
+    Ticks stimulusMidpointTicks = 0;
+    OnsetSource onsetSource = OnsetSource::Midpoint;
+    bool onsetPending = false;
+    Ticks inputTicks = 0;
+    int inputDevice = -1;  // Session::devices index of the current trial's press
+    Ticks onsetOvershootTicks = 0;
+    Ticks restUntilTicks = 0;
+    double scheduledDelaySeconds = 0.0;
+
+    // --trial-timing probe for the current trial, in ticks; folded into trialTiming when the trial ends.
+    struct TimingProbe
+    {
+        Ticks presentTicks = 0;
+        Ticks inputSeenTicks = 0;
+        Ticks lastIterationTicks = 0;
+        Ticks maxIterationGapTicks = 0;
+        std::uint32_t loopIterations = 0;
+    } timingProbe;
+    TrialTiming trialTiming;
+
+    int blockIndex = 0;
+    int blockEndTrial = 0;  // trialIndex at which the current block ends
+
+    // Every trial's foreperiod in seconds, drawn by ResetSessionState before the run starts.
+    std::vector<double> schedule;
+    std::vector<TrialResult> results;
+    RunningStats stats;
+    // Valid reactions for config.stopping; only fed while the rule is enabled.
+    PrecisionEstimator precision;
+    StopReason stopReason = StopReason::None;
+    // Devices that produced a trial's press, in first-use order (TrialResult::device). Reserved by
+    // ResetSessionState, so the first press of a device does not allocate unless a run uses more than
+    // kReservedInputDevices of them.
+    static constexpr size_t kReservedInputDevices = 16;
+    std::vector<InputDevice> devices;
+
+    // Optional live NDJSON stream (not owned); null disables streaming.
+    EventStream* stream = nullptr;
+    // Optional raw event trace (not owned, see trace.h); null disables recording.
+    TraceWriter* trace = nullptr;
+    // Optional crash-safe journal (not owned, see journal.h). While one is attached, results are written
+    // to it instead of being kept in `results`, so memory stays flat however long the run is.
+    TrialJournal* journal = nullptr;
+    // Optional asynchronous console log (not owned, see trial_log.h); with logTrials set and no log
+    // attached, the messages are printed synchronously.
+    TrialLog* log = nullptr;
+    // Optional shared-memory telemetry block (not owned, see telemetry.h); null disables publishing.
+    TelemetryWriter* telemetry = nullptr;
+};
+
+const char* PrecisionStatisticName(PrecisionStatistic statistic);
+bool ParsePrecisionStatistic(const std::string& text, PrecisionStatistic& statistic);
+const char* StopReasonName(StopReason reason);
+
+// How a run with a stopping rule ended, for the console summary and the exports.
+struct StoppingReport
+{
+    StoppingRule rule;
+    StopReason reason = StopReason::None;
+    int trials = 0;
+    size_t validTrials = 0;
+    double estimateMs = 0.0;   // mean or median the interval is around
+    double halfWidthMs = 0.0;  // at the end of the run (infinite when too few reactions)
+};
+StoppingReport MakeStoppingReport(const Session& session);
+
+// Clears the previous run and draws the new run's foreperiod schedule, with a fresh seed unless
+// config.foreperiod.seeded.
+void ResetSessionState(Session& session);
+
+// Called by input policies for every key/button press (Esc excluded) with the tick at which it was captured.
+// `device` identifies the input device for the trace and TrialResult::device (0 when the policy has no handle).
+void RecordPress(Session& session, Ticks timestamp, std::uint64_t device = 0);
+
+// BeginTrial phase: starts the foreperiod at `now` with the caller's scheduled delay.
+void BeginTrial(Session& session, Ticks now, double delaySeconds, Ticks frequency);
+
+// The stimulus Present call ran from t0 to t1, `overshootTicks` after the stimulus was due. The Present
+// midpoint stands in for the onset until the provider's answer reaches ResolveStimulusOnset.
+void PresentStimulus(Session& session, Ticks t0, Ticks t1, Ticks overshootTicks);
+
+// Stores a valid result measured from the resolved onset and advances to the next trial.
+void RecordReaction(Session& session, Ticks frequency);
+
+// Stores a false-start result for the current trial and advances to the next one.
+void RecordFalseStart(Session& session);
+
+// Applies a provider's answer: moves stimulusTicks to the scanout time for OnsetPoll::Scanout and turns
+// a press that came before the actual onset into a false start.
+void ResolveStimulusOnset(Session& session, OnsetPoll poll, Ticks scanoutTicks);
+
+// Converts timingProbe into trialTiming; called once per trial, before its result is stored.
+void FinishTrialTiming(Session& session, Ticks frequency);
+
+// Trials a run of `config` will have: the plan's total when a plan is set, trialCount otherwise.
+int PlannedTrialCount(const SessionConfig& config);
+
+// Plan runs: true when trialIndex has reached the end of a block that is followed by another one.
+bool AtBlockBoundary(const Session& session);
+// Moves on to the next block; returns that block's preceding rest in seconds.
+double StartNextBlock(Session& session);
+
+// Live stream events; no-ops unless session.stream is set. StreamOutcome writes the final summary for a
+// completed run and an "aborted" event otherwise.
+void StreamSessionStart(const Session& session, Ticks frequency);
+void StreamTrial(const Session& session, const TrialResult& trial);
+void StreamOutcome(const Session& session, SessionOutcome outcome);
+
+// Trace header and final record; no-ops unless session.trace is set.
+void TraceSessionStart(const Session& session, Ticks frequency);
+void TraceOutcome(const Session& session, SessionOutcome outcome);
+
+// Telemetry snapshots (telemetry.h); no-ops unless session.telemetry is set. TelemetryIteration runs once
+// per loop iteration and publishes on phase and trial changes, and at the writer's heartbeat in between.
+void TelemetrySessionStart(const Session& session, Ticks frequency, Ticks now);
+void TelemetryIteration(const Session& session, Ticks now);
+void TelemetryOutcome(const Session& session, SessionOutcome outcome, Ticks now);
+
+// Runs the trial state machine until every trial completes or the run is aborted.
+//
+// Policies are plain types resolved at compile time so the loop has no virtual dispatch:
+//   Clock:   Ticks Now(); Ticks Frequency() const; void SleepUntil(Ticks deadline); void YieldThread();
+//   Display: void PresentSolidColor(float gray);
+//   Input:   void Pump(Session& session);  (feeds RecordPress / escapePressed / quitRequested)
+//   Onset:   void StimulusPresented(Ticks before, Ticks after); OnsetPoll Poll(Ticks now, Ticks& onset);
+//            (see onset.h; polled every iteration after the stimulus until it stops returning Pending)
+// RecordTiming compiles the --trial-timing probes in; RunTrialLoop picks the instantiation from
+// SessionConfig::recordTiming, so runs without the flag execute no probe code at all.
+template <bool RecordTiming, typename Clock, typename Display, typename Input, typename Onset>
+SessionOutcome RunTrialLoopImpl(Session& session, Clock& clock, Display& display, Input& input, Onset& onset)
+{
+    const Ticks freq = clock.Frequency();
+
+    ForeperiodWaiter<Clock> waiter(clock, session.config.wait);
+    waiter.Calibrate();
+    StreamSessionStart(session, freq);
+    TraceSessionStart(session, freq);
+    TelemetrySessionStart(session, freq, clock.Now());
+
+    for (;;)
+    {
+        input.Pump(session);
+        if (session.quitRequested)
+        {
+            StreamOutcome(session, SessionOutcome::QuitRequested);
+            TraceOutcome(session, SessionOutcome::QuitRequested);
+            TelemetryOutcome(session, SessionOutcome::QuitRequested, clock.Now());
+            return SessionOutcome::QuitRequested;
+        }
+        if (session.escapePressed || session.cancelRequested)
+        {
+            StreamOutcome(session, SessionOutcome::Aborted);
+            TraceOutcome(session, SessionOutcome::Aborted);
+            TelemetryOutcome(session, SessionOutcome::Aborted, clock.Now());
+            return SessionOutcome::Aborted;
+        }
+
+        const Ticks now = clock.Now();
+        TelemetryIteration(session, now);
+
+        if constexpr (RecordTiming)
+        {
+            if (session.phase == Phase::WaitingForStimulus || session.phase == Phase::WaitingForResponse)
+            {
+                Session::TimingProbe& probe = session.timingProbe;
+                ++probe.loopIterations;
+                probe.maxIterationGapTicks = std::max(probe.maxIterationGapTicks, now - probe.lastIterationTicks);
+                probe.lastIterationTicks = now;
+                if (session.hasInput && probe.inputSeenTicks == 0)
+                {
+                    probe.inputSeenTicks = now;
+                }
+            }
+        }
+
+        switch (session.phase)
+        {
+        case Phase::BeginTrial:
+            if (AtBlockBoundary(session))
+            {
+                const double restSeconds = StartNextBlock(session);
+                if (restSeconds > 0.0)
+                {
+                    display.PresentSolidColor(0.0f);
+                    session.restUntilTicks = now + SecondsToTicks(restSeconds, freq);
+                    session.phase = Phase::Resting;
+                    break;
+                }
+            }
+
+            BeginTrial(session, now, session.schedule[static_cast<size_t>(session.trialIndex)], freq);
+            if constexpr (RecordTiming)
+            {
+                session.timingProbe = Session::TimingProbe{};
+                session.timingProbe.lastIterationTicks = now;
+                session.timingProbe.loopIterations = 1;
+            }
+
+            display.PresentSolidColor(0.0f);
+            break;
+
+        case Phase::WaitingForStimulus:
+        {
+            if (session.hasInput && session.inputWasFalseStart)
+            {
+                if constexpr (RecordTiming)
+                {
+                    FinishTrialTiming(session, freq);
+                }
+                RecordFalseStart(session);
+                break;
+            }
+
+            if (waiter.WaitStep(session.stimulusDueTicks))
+            {
+                const Ticks t0 = clock.Now();
+                display.PresentSolidColor(1.0f);
+                const Ticks t1 = clock.Now();
+                if constexpr (RecordTiming)
+                {
+                    session.timingProbe.presentTicks = t1 - t0;
+                }
+
+                // Present blocks with VSync; the provider may later replace the midpoint with the scanout time.
+                PresentStimulus(session, t0, t1, waiter.LastOvershootTicks());
+                onset.StimulusPresented(t0, t1);
+            }
+            break;
+        }
+
+        case Phase::WaitingForResponse:
+            if (session.onsetPending)
+            {
+                Ticks scanoutTicks = 0;
+                const OnsetPoll poll = onset.Poll(now, scanoutTicks);
+                if (poll != OnsetPoll::Pending)
+                {
+                    ResolveStimulusOnset(session, poll, scanoutTicks);
+                }
+            }
+
+            if (session.hasInput && session.inputWasFalseStart)
+            {
+                if constexpr (RecordTiming)
+                {
+                    FinishTrialTiming(session, freq);
+                }
+                RecordFalseStart(session);
+            }
+            else if (session.hasInput && !session.onsetPending)
+            {
+                if constexpr (RecordTiming)
+                {
+                    FinishTrialTiming(session, freq);
+                }
+                RecordReaction(session, freq);
+            }
+            else
+            {
+                clock.YieldThread();
+            }
+            break;
+
+        case Phase::Resting:
+            // Presses are ignored while resting (RecordPress only acts in the trial phases).
+            if (waiter.WaitStep(session.restUntilTicks))
+            {
+                session.phase = Phase::BeginTrial;
+            }
+            break;
+
+        case Phase::Finished:
+            StreamOutcome(session, SessionOutcome::Completed);
+            TraceOutcome(session, SessionOutcome::Completed);
+            TelemetryOutcome(session, SessionOutcome::Completed, now);
+            return SessionOutcome::Completed;
+        }
+    }
+}
+
+template <typename Clock, typename Display, typename Input, typename Onset>
+SessionOutcome RunTrialLoop(Session& session, Clock& clock, Display& display, Input& input, Onset& onset)
+{
+    if (session.config.recordTiming)
+    {
+        return RunTrialLoopImpl<true>(session, clock, display, input, onset);
+    }
+    return RunTrialLoopImpl<false>(session, clock, display, input, onset);
+}
+
+// Present-midpoint onsets, the behaviour for displays without frame statistics.
+template <typename Clock, typename Display, typename Input>
+SessionOutcome RunTrialLoop(Session& session, Clock& clock, Display& display, Input& input)
+{
+    MidpointOnset onset;
+    return RunTrialLoop(session, clock, display, input, onset);
+}
+} // namespace purple
@@ -0,0 +1,81 @@
+#include "core/simulate.h"
+
+namespace purple
+{
+namespace
+{
+Ticks MillisecondsToTicks(double ms)
+{
+    return static_cast<Ticks>(ms * 1000000.0);
+}
+} // namespace
+
+SimulatedResponder::SimulatedResponder(VirtualClock& clock, const ResponderModel& model, std::uint64_t seed)
+    : clock_(clock),
+      model_(model),
+      rng_(seed),
+      gaussian_(model.muMs, model.sigmaMs),
+      exponential_(1.0 / model.tauMs)
+{
+}
+
+double SimulatedResponder::DeviceLagMs(const SimulatedTrial& trial) const
+{
+    return trial.device == 0 ? 0.0 : model_.deviceLagMs[trial.device - 1];
+}
+
+void SimulatedResponder::PlanTrial(const Session& session)
+{
+    plannedTrial_ = session.trialIndex;
+    SimulatedTrial trial;
+    trial.onsetTicks = session.stimulusDueTicks;
+    if (!model_.deviceLagMs.empty())
+    {
+        const size_t count = model_.deviceLagMs.size();
+        trial.device = 1 + std::min(count - 1, static_cast<size_t>(unit_(rng_) * static_cast<double>(count)));
+    }
+    trial.anticipated = unit_(rng_) < model_.anticipationProbability;
+    if (trial.anticipated)
+    {
+        const double foreperiodMs = TicksToMilliseconds(session.stimulusDueTicks - session.trialStartTicks, clock_.Frequency());
+        trial.captureTicks = session.trialStartTicks + MillisecondsToTicks(UniformMs(foreperiodMs)) +
+            MillisecondsToTicks(model_.inputLatencyMs + UniformMs(model_.inputJitterMs) + DeviceLagMs(trial));
+        pressPending_ = true;
+        clock_.SetWake(trial.captureTicks);
+    }
+    else
+    {
+        trial.lapse = unit_(rng_) < model_.missProbability;
+    }
+    trials_.push_back(trial);
+}
+
+void SimulatedResponder::Pump(Session& session)
+{
+    if (session.phase == Phase::WaitingForStimulus && plannedTrial_ != session.trialIndex)
+    {
+        PlanTrial(session);
+    }
+    else if (session.phase == Phase::WaitingForResponse && !trials_.empty() && trials_.back().captureTicks == 0)
+    {
+        // React to the frame the loop actually presented.
+        SimulatedTrial& trial = trials_.back();
+        double delayMs = model_.displayLatencyMs + UniformMs(model_.displayJitterMs) + gaussian_(rng_) +
+            exponential_(rng_) + model_.inputLatencyMs + UniformMs(model_.inputJitterMs) + DeviceLagMs(trial);
+        if (trial.lapse)
+        {
+            delayMs += model_.lapseMs;
+        }
+        trial.captureTicks = session.stimulusMidpointTicks + MillisecondsToTicks(delayMs);
+        pressPending_ = true;
+        clock_.SetWake(trial.captureTicks);
+    }
+
+    if (pressPending_ && clock_.Now() >= trials_.back().captureTicks)
+    {
+        pressPending_ = false;
+        clock_.SetWake(VirtualClock::kNoWake);
+        RecordPress(session, trials_.back().captureTicks, trials_.back().device);
+    }
+}
+} // namespace purple
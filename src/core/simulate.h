@@ -0,0 +1,95 @@
+#pragma once
+
+#include "core/session.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace purple
+{
+// Virtual nanosecond clock for simulated sessions. Time only moves when the loop sleeps or yields, and a
+// sleep ends early at the wake the input policy registered for its next event (the simulated form of a
+// wait that input interrupts), so a trial costs a handful of loop iterations whatever its foreperiod.
+// Nothing advances time while spinning: run it with WaitConfig::spinBudgetSeconds = 0.
+class VirtualClock
+{
+public:
+    static constexpr Ticks kNoWake = std::numeric_limits<Ticks>::max();
+
+    Ticks Now() const { return now_; }
+    Ticks Frequency() const { return 1000000000; }
+    void SleepUntil(Ticks deadline) { now_ = std::max(now_, std::min(deadline, wake_)); }
+    // Jumps to the pending wake; without one, moves a microsecond so a polling loop still progresses.
+    void YieldThread() { now_ = wake_ != kNoWake ? std::max(now_, wake_) : now_ + 1000; }
+
+    void SetWake(Ticks wake) { wake_ = wake; }
+
+private:
+    Ticks now_ = 1000000000;  // start at 1 s: the loop treats tick 0 as "no stimulus yet"
+    Ticks wake_ = kNoWake;
+};
+
+// Synthetic participant plus the latencies between the loop and the participant.
+struct ResponderModel
+{
+    // Ex-Gaussian reaction time: Normal(mu, sigma) + Exponential(mean tau), from stimulus onset to press.
+    double muMs = 250.0;
+    double sigmaMs = 30.0;
+    double tauMs = 80.0;
+    double anticipationProbability = 0.03;  // press at a uniform point of the foreperiod instead
+    double missProbability = 0.01;          // lapse: the response comes lapseMs later than drawn
+    double lapseMs = 2000.0;
+    // Present call to photons: latency + Uniform(0, jitter) (scanout position within the frame).
+    double displayLatencyMs = 10.0;
+    double displayJitterMs = 16.7;
+    // Press to the timestamp the input path stamps: latency + Uniform(0, jitter) (device polling).
+    double inputLatencyMs = 1.0;
+    double inputJitterMs = 1.0;
+    // Extra input latency of each device; when set, each trial's press comes from a device drawn uniformly
+    // (handles 1..n). Empty: every press comes from handle 0 and no draw is made.
+    std::vector<double> deviceLagMs;
+};
+
+// Ground truth for one simulated trial, indexed like Session::results.
+struct SimulatedTrial
+{
+    Ticks onsetTicks = 0;    // when the loop is due to present the stimulus
+    Ticks captureTicks = 0;  // input timestamp of the press
+    std::uint64_t device = 0;  // handle the press came from
+    bool anticipated = false;
+    bool lapse = false;
+
+    bool ExpectFalseStart() const { return captureTicks < onsetTicks; }
+};
+
+// Input policy that plays the participant on a VirtualClock: one press per trial, delivered on the first
+// Pump at or after its capture time, with every random draw recorded in Trials().
+class SimulatedResponder
+{
+public:
+    SimulatedResponder(VirtualClock& clock, const ResponderModel& model, std::uint64_t seed);
+
+    void Reserve(size_t trials) { trials_.reserve(trials); }
+    void Pump(Session& session);
+
+    const std::vector<SimulatedTrial>& Trials() const { return trials_; }
+
+private:
+    void PlanTrial(const Session& session);
+    double DeviceLagMs(const SimulatedTrial& trial) const;
+    double UniformMs(double widthMs) { return widthMs * unit_(rng_); }
+
+    VirtualClock& clock_;
+    ResponderModel model_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> unit_{0.0, 1.0};
+    std::normal_distribution<double> gaussian_;
+    std::exponential_distribution<double> exponential_;
+    std::vector<SimulatedTrial> trials_;
+    int plannedTrial_ = -1;
+    bool pressPending_ = false;
+};
+} // namespace purple
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace purple
+{
+// Bounded lock-free single-producer/single-consumer ring. TryPush is only called from one thread and
+// TryPop from one (other) thread; neither ever blocks or allocates. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    using value_type = T;
+
+    bool TryPush(const T& value)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cachedTail_ == Capacity)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail_ == Capacity)
+            {
+                return false;
+            }
+        }
+        slots_[head & kMask] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& out)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cachedHead_)
+        {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail == cachedHead_)
+            {
+                return false;
+            }
+        }
+        out = slots_[tail & kMask];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    // Producer and consumer indices live on separate cache lines, each next to its owner's cached copy of the other.
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+    alignas(64) T slots_[Capacity]{};
+};
+
+// Consumer side: pops everything currently queued and hands each item to fn. Returns the count.
+template <typename Ring, typename Fn>
+size_t DrainRing(Ring& ring, Fn&& fn)
+{
+    size_t count = 0;
+    typename Ring::value_type item;
+    while (ring.TryPop(item))
+    {
+        fn(item);
+        ++count;
+    }
+    return count;
+}
+} // namespace purple
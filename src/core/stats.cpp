@@ -0,0 +1,741 @@
+#include "core/stats.h"
+
+#include "core/session.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace purple
+{
+P2Quantile::P2Quantile(double p)
+    : p_(p)
+{
+}
+
+void P2Quantile::Reset()
+{
+    count_ = 0;
+}
+
+void P2Quantile::Add(double x)
+{
+    if (count_ < 5)
+    {
+        heights_[count_++] = x;
+        if (count_ == 5)
+        {
+            std::sort(heights_, heights_ + 5);
+            for (int i = 0; i < 5; ++i)
+            {
+                positions_[i] = static_cast<double>(i + 1);
+            }
+            desired_[0] = 1.0;
+            desired_[1] = 1.0 + 2.0 * p_;
+            desired_[2] = 1.0 + 4.0 * p_;
+            desired_[3] = 3.0 + 2.0 * p_;
+            desired_[4] = 5.0;
+            increments_[0] = 0.0;
+            increments_[1] = p_ / 2.0;
+            increments_[2] = p_;
+            increments_[3] = (1.0 + p_) / 2.0;
+            increments_[4] = 1.0;
+        }
+        return;
+    }
+
+    int k = 0;
+    if (x < heights_[0])
+    {
+        heights_[0] = x;
+        k = 0;
+    }
+    else if (x >= heights_[4])
+    {
+        heights_[4] = x;
+        k = 3;
+    }
+    else
+    {
+        k = 0;
+        while (k < 3 && x >= heights_[k + 1])
+        {
+            ++k;
+        }
+    }
+
+    for (int i = k + 1; i < 5; ++i)
+    {
+        positions_[i] += 1.0;
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        desired_[i] += increments_[i];
+    }
+
+    for (int i = 1; i <= 3; ++i)
+    {
+        const double d = desired_[i] - positions_[i];
+        if ((d >= 1.0 && positions_[i + 1] - positions_[i] > 1.0) ||
+            (d <= -1.0 && positions_[i - 1] - positions_[i] < -1.0))
+        {
+            const double s = d >= 0.0 ? 1.0 : -1.0;
+            const double qPrev = heights_[i - 1];
+            const double q = heights_[i];
+            const double qNext = heights_[i + 1];
+            const double nPrev = positions_[i - 1];
+            const double n = positions_[i];
+            const double nNext = positions_[i + 1];
+
+            // Piecewise-parabolic prediction; fall back to linear when it would break marker ordering.
+            const double parabolic = q + s / (nNext - nPrev) *
+                ((n - nPrev + s) * (qNext - q) / (nNext - n) + (nNext - n - s) * (q - qPrev) / (n - nPrev));
+            if (qPrev < parabolic && parabolic < qNext)
+            {
+                heights_[i] = parabolic;
+            }
+            else
+            {
+                const int j = i + static_cast<int>(s);
+                heights_[i] = q + s * (heights_[j] - q) / (positions_[j] - n);
+            }
+            positions_[i] += s;
+        }
+    }
+    ++count_;
+}
+
+double P2Quantile::Value() const
+{
+    if (count_ == 0)
+    {
+        return 0.0;
+    }
+    if (count_ < 5)
+    {
+        double sorted[5]{};
+        std::copy(heights_, heights_ + count_, sorted);
+        std::sort(sorted, sorted + count_);
+        const size_t index = static_cast<size_t>(p_ * static_cast<double>(count_ - 1) + 0.5);
+        return sorted[std::min(index, count_ - 1)];
+    }
+    return heights_[2];
+}
+
+RunningStats::RunningStats()
+    : histogram_(kHistogramBins, 0),
+      histogramSums_(kHistogramBins, 0.0)
+{
+}
+
+void RunningStats::Reset()
+{
+    validCount_ = 0;
+    falseStartCount_ = 0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+    min_ = 0.0;
+    max_ = 0.0;
+    p50_.Reset();
+    p90_.Reset();
+    p95_.Reset();
+    p99_.Reset();
+    std::fill(histogram_.begin(), histogram_.end(), 0u);
+    std::fill(histogramSums_.begin(), histogramSums_.end(), 0.0);
+}
+
+void RunningStats::AddReaction(double reactionMs)
+{
+    if (validCount_ < kExactQuantileSamples)
+    {
+        firstSamples_[validCount_] = reactionMs;
+    }
+    ++validCount_;
+    const double delta = reactionMs - mean_;
+    mean_ += delta / static_cast<double>(validCount_);
+    m2_ += delta * (reactionMs - mean_);
+
+    if (validCount_ == 1)
+    {
+        min_ = reactionMs;
+        max_ = reactionMs;
+    }
+    else
+    {
+        min_ = std::min(min_, reactionMs);
+        max_ = std::max(max_, reactionMs);
+    }
+
+    p50_.Add(reactionMs);
+    p90_.Add(reactionMs);
+    p95_.Add(reactionMs);
+    p99_.Add(reactionMs);
+
+    const double binPosition = reactionMs / kHistogramBinMs;
+    size_t bin = 0;
+    if (binPosition > 0.0)
+    {
+        bin = std::min(static_cast<size_t>(binPosition), kHistogramBins - 1);
+    }
+    ++histogram_[bin];
+    histogramSums_[bin] += reactionMs;
+}
+
+void RunningStats::AddFalseStart()
+{
+    ++falseStartCount_;
+}
+
+double RunningStats::ExactQuantile(double p) const
+{
+    double sorted[kExactQuantileSamples];
+    std::copy(firstSamples_, firstSamples_ + validCount_, sorted);
+    std::sort(sorted, sorted + validCount_);
+    const size_t index = static_cast<size_t>(p * static_cast<double>(validCount_ - 1) + 0.5);
+    return sorted[std::min(index, validCount_ - 1)];
+}
+
+double RunningStats::BinCenter(size_t bin) const
+{
+    return (static_cast<double>(bin) + 0.5) * kHistogramBinMs;
+}
+
+size_t RunningStats::HistogramMedianBin() const
+{
+    const size_t half = (validCount_ + 1) / 2;
+    size_t seen = 0;
+    for (size_t bin = 0; bin < kHistogramBins; ++bin)
+    {
+        seen += histogram_[bin];
+        if (seen >= half)
+        {
+            return bin;
+        }
+    }
+    return kHistogramBins - 1;
+}
+
+double RunningStats::TrimmedMean() const
+{
+    const size_t trim = static_cast<size_t>(static_cast<double>(validCount_) * kTrimFraction);
+    const size_t keep = validCount_ - 2 * trim;
+    if (keep == 0)
+    {
+        return mean_;
+    }
+
+    size_t skipped = 0;
+    size_t taken = 0;
+    double total = 0.0;
+    for (size_t bin = 0; bin < kHistogramBins && taken < keep; ++bin)
+    {
+        size_t available = histogram_[bin];
+        if (skipped < trim)
+        {
+            const size_t skip = std::min(available, trim - skipped);
+            skipped += skip;
+            available -= skip;
+        }
+        const size_t take = std::min(available, keep - taken);
+        if (take > 0)
+        {
+            taken += take;
+            total += histogramSums_[bin] * static_cast<double>(take) / static_cast<double>(histogram_[bin]);
+        }
+    }
+    return total / static_cast<double>(keep);
+}
+
+double RunningStats::MedianAbsoluteDeviation() const
+{
+    // Grow a window outward from the median bin, always taking the nearer side, until it holds half the samples.
+    const size_t medianBin = HistogramMedianBin();
+    const double median = BinCenter(medianBin);
+    const size_t half = (validCount_ + 1) / 2;
+
+    size_t covered = histogram_[medianBin];
+    double deviation = 0.0;
+    size_t left = medianBin;
+    size_t right = medianBin + 1;
+    while (covered < half)
+    {
+        const double leftDistance = left > 0 ? median - BinCenter(left - 1) : std::numeric_limits<double>::infinity();
+        const double rightDistance = right < kHistogramBins ? BinCenter(right) - median : std::numeric_limits<double>::infinity();
+        if (leftDistance <= rightDistance)
+        {
+            --left;
+            covered += histogram_[left];
+            deviation = leftDistance;
+        }
+        else
+        {
+            covered += histogram_[right];
+            deviation = rightDistance;
+            ++right;
+        }
+    }
+    return deviation;
+}
+
+ReactionSummary RunningStats::Summary() const
+{
+    ReactionSummary summary = QuickSummary();
+    if (validCount_ > 0)
+    {
+        summary.trimmedMeanMs = TrimmedMean();
+        summary.madMs = MedianAbsoluteDeviation();
+    }
+    return summary;
+}
+
+ReactionSummary RunningStats::QuickSummary() const
+{
+    ReactionSummary summary;
+    summary.validCount = validCount_;
+    summary.falseStartCount = falseStartCount_;
+    summary.trialCount = validCount_ + falseStartCount_;
+    if (validCount_ == 0)
+    {
+        return summary;
+    }
+
+    summary.meanMs = mean_;
+    summary.sdMs = validCount_ > 1 ? std::sqrt(m2_ / static_cast<double>(validCount_ - 1)) : 0.0;
+    summary.minMs = min_;
+    summary.maxMs = max_;
+    if (validCount_ <= kExactQuantileSamples)
+    {
+        summary.p50Ms = ExactQuantile(0.50);
+        summary.p90Ms = ExactQuantile(0.90);
+        summary.p95Ms = ExactQuantile(0.95);
+        summary.p99Ms = ExactQuantile(0.99);
+    }
+    else
+    {
+        summary.p50Ms = p50_.Value();
+        summary.p90Ms = p90_.Value();
+        summary.p95Ms = p95_.Value();
+        summary.p99Ms = p99_.Value();
+    }
+    return summary;
+}
+
+ReactionSummary SummarizeSorted(const std::vector<double>& sortedValid, size_t falseStartCount)
+{
+    ReactionSummary summary;
+    const size_t n = sortedValid.size();
+    summary.validCount = n;
+    summary.falseStartCount = falseStartCount;
+    summary.trialCount = n + falseStartCount;
+    if (n == 0)
+    {
+        return summary;
+    }
+
+    double mean = 0.0;
+    double m2 = 0.0;
+    size_t count = 0;
+    for (const double value : sortedValid)
+    {
+        ++count;
+        const double delta = value - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (value - mean);
+    }
+    const auto quantile = [&sortedValid, n](double p)
+    {
+        const size_t index = static_cast<size_t>(p * static_cast<double>(n - 1) + 0.5);
+        return sortedValid[std::min(index, n - 1)];
+    };
+
+    summary.meanMs = mean;
+    summary.sdMs = n > 1 ? std::sqrt(m2 / static_cast<double>(n - 1)) : 0.0;
+    summary.minMs = sortedValid.front();
+    summary.maxMs = sortedValid.back();
+    summary.p50Ms = quantile(0.50);
+    summary.p90Ms = quantile(0.90);
+    summary.p95Ms = quantile(0.95);
+    summary.p99Ms = quantile(0.99);
+
+    const size_t trim = static_cast<size_t>(static_cast<double>(n) * RunningStats::kTrimFraction);
+    double kept = 0.0;
+    for (size_t i = trim; i < n - trim; ++i)
+    {
+        kept += sortedValid[i];
+    }
+    summary.trimmedMeanMs = n > 2 * trim ? kept / static_cast<double>(n - 2 * trim) : mean;
+
+    // Deviations from the median grow outward from it in both directions; merge the two sorted runs up to
+    // the same nearest-rank position the median itself uses.
+    const size_t mid = static_cast<size_t>(0.5 * static_cast<double>(n - 1) + 0.5);
+    const double median = sortedValid[mid];
+    size_t left = mid + 1;
+    size_t right = mid + 1;
+    double deviation = 0.0;
+    for (size_t taken = 0; taken <= mid; ++taken)
+    {
+        const double leftDistance = left > 0 ? median - sortedValid[left - 1] : std::numeric_limits<double>::infinity();
+        const double rightDistance = right < n ? sortedValid[right] - median : std::numeric_limits<double>::infinity();
+        if (leftDistance <= rightDistance)
+        {
+            deviation = leftDistance;
+            --left;
+        }
+        else
+        {
+            deviation = rightDistance;
+            ++right;
+        }
+    }
+    summary.madMs = deviation;
+    return summary;
+}
+
+RunningStats ComputeRunningStats(const std::vector<TrialResult>& results)
+{
+    RunningStats stats;
+    for (const TrialResult& trial : results)
+    {
+        if (trial.falseStart)
+        {
+            stats.AddFalseStart();
+        }
+        else
+        {
+            stats.AddReaction(trial.reactionMs);
+        }
+    }
+    return stats;
+}
+
+std::vector<ReactionSummary> SummarizeBlocks(const std::vector<TrialResult>& results, size_t blockCount)
+{
+    // Blocks run in order, so each one is a contiguous range of results.
+    std::vector<ReactionSummary> summaries(blockCount);
+    RunningStats stats;
+    size_t i = 0;
+    while (i < results.size())
+    {
+        const int block = results[i].block;
+        stats.Reset();
+        for (; i < results.size() && results[i].block == block; ++i)
+        {
+            if (results[i].falseStart)
+            {
+                stats.AddFalseStart();
+            }
+            else
+            {
+                stats.AddReaction(results[i].reactionMs);
+            }
+        }
+        if (static_cast<size_t>(block) < blockCount)
+        {
+            summaries[static_cast<size_t>(block)] = stats.Summary();
+        }
+    }
+    return summaries;
+}
+
+namespace
+{
+// Continued fraction of the regularized incomplete beta function (modified Lentz), for x < (a+1)/(a+b+2).
+double IncompleteBetaFraction(double a, double b, double x)
+{
+    constexpr double kTiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < kTiny ? kTiny : d);
+    double h = d;
+    for (int m = 1; m <= 300; ++m)
+    {
+        const double m2 = 2.0 * m;
+        for (int step = 0; step < 2; ++step)
+        {
+            const double numerator = step == 0 ? m * (b - m) * x / ((a + m2 - 1.0) * (a + m2))
+                                               : -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+            d = 1.0 + numerator * d;
+            d = 1.0 / (std::fabs(d) < kTiny ? kTiny : d);
+            c = 1.0 + numerator / c;
+            c = std::fabs(c) < kTiny ? kTiny : c;
+            h *= d * c;
+            if (step == 1 && std::fabs(d * c - 1.0) < 1e-15)
+            {
+                return h;
+            }
+        }
+    }
+    return h;
+}
+
+// Regularized incomplete beta I_x(a, b).
+double RegularizedIncompleteBeta(double a, double b, double x)
+{
+    if (x <= 0.0)
+    {
+        return 0.0;
+    }
+    if (x >= 1.0)
+    {
+        return 1.0;
+    }
+    const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log1p(-x));
+    if (x < (a + 1.0) / (a + b + 2.0))
+    {
+        return front * IncompleteBetaFraction(a, b, x) / a;
+    }
+    return 1.0 - front * IncompleteBetaFraction(b, a, 1.0 - x) / b;
+}
+
+// P(T <= t) for t >= 0.
+double StudentTUpperCdf(double t, double degreesOfFreedom)
+{
+    return 1.0 - 0.5 * RegularizedIncompleteBeta(degreesOfFreedom / 2.0, 0.5, degreesOfFreedom / (degreesOfFreedom + t * t));
+}
+} // namespace
+
+std::vector<ReactionSummary> SummarizeDevices(const std::vector<TrialResult>& results, size_t deviceCount)
+{
+    std::vector<std::vector<double>> valid(deviceCount);
+    std::vector<size_t> falseStarts(deviceCount, 0);
+    for (const TrialResult& trial : results)
+    {
+        if (trial.device < 0 || static_cast<size_t>(trial.device) >= deviceCount)
+        {
+            continue;
+        }
+        const size_t device = static_cast<size_t>(trial.device);
+        if (trial.falseStart)
+        {
+            ++falseStarts[device];
+        }
+        else
+        {
+            valid[device].push_back(trial.reactionMs);
+        }
+    }
+
+    std::vector<ReactionSummary> summaries(deviceCount);
+    for (size_t d = 0; d < deviceCount; ++d)
+    {
+        std::sort(valid[d].begin(), valid[d].end());
+        summaries[d] = SummarizeSorted(valid[d], falseStarts[d]);
+    }
+    return summaries;
+}
+
+MeanDifference CompareMeans(const ReactionSummary& sample, const ReactionSummary& reference, double confidence)
+{
+    MeanDifference result;
+    if (sample.validCount < 2 || reference.validCount < 2)
+    {
+        return result;
+    }
+    const double n1 = static_cast<double>(sample.validCount);
+    const double n2 = static_cast<double>(reference.validCount);
+    const double v1 = sample.sdMs * sample.sdMs / n1;
+    const double v2 = reference.sdMs * reference.sdMs / n2;
+    const double se = std::sqrt(v1 + v2);
+
+    result.valid = true;
+    result.differenceMs = sample.meanMs - reference.meanMs;
+    if (!(se > 0.0))
+    {
+        // Both samples constant (scripted responders): the difference is exact.
+        result.degreesOfFreedom = n1 + n2 - 2.0;
+        result.lowMs = result.differenceMs;
+        result.highMs = result.differenceMs;
+        return result;
+    }
+    result.degreesOfFreedom = (v1 + v2) * (v1 + v2) / (v1 * v1 / (n1 - 1.0) + v2 * v2 / (n2 - 1.0));
+    const double halfWidth = StudentTQuantile(0.5 + confidence / 2.0, result.degreesOfFreedom) * se;
+    result.lowMs = result.differenceMs - halfWidth;
+    result.highMs = result.differenceMs + halfWidth;
+    return result;
+}
+
+double StudentTQuantile(double p, double degreesOfFreedom)
+{
+    if (p < 0.5)
+    {
+        return -StudentTQuantile(1.0 - p, degreesOfFreedom);
+    }
+    // The CDF is monotonic in t: bracket the quantile, then bisect to double precision.
+    double low = 0.0;
+    double high = 1.0;
+    while (StudentTUpperCdf(high, degreesOfFreedom) < p && high < 1e12)
+    {
+        low = high;
+        high *= 2.0;
+    }
+    for (int i = 0; i < 200 && high - low > 1e-12 * high; ++i)
+    {
+        const double mid = 0.5 * (low + high);
+        if (StudentTUpperCdf(mid, degreesOfFreedom) < p)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return 0.5 * (low + high);
+}
+
+void PrecisionEstimator::Reset(PrecisionStatistic statistic, double confidence)
+{
+    if (count_ > 0 && !histogram_.empty())
+    {
+        std::fill(histogram_.begin() + firstBin_, histogram_.begin() + lastBin_ + 1, 0u);
+        std::fill(histogramSums_.begin() + firstBin_, histogramSums_.begin() + lastBin_ + 1, 0.0);
+    }
+    if (statistic == PrecisionStatistic::Median && histogram_.empty())
+    {
+        histogram_.assign(RunningStats::kHistogramBins, 0);
+        histogramSums_.assign(RunningStats::kHistogramBins, 0.0);
+    }
+    statistic_ = statistic;
+    count_ = 0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+    lowRank_ = 0;
+    if (confidence == confidence_ && !criticalValues_.empty())
+    {
+        return;
+    }
+
+    confidence_ = confidence;
+    const double p = 0.5 + confidence / 2.0;
+    criticalValues_.resize(kTableDegrees);
+    for (size_t df = 1; df <= kTableDegrees; ++df)
+    {
+        criticalValues_[df - 1] = StudentTQuantile(p, static_cast<double>(df));
+    }
+    // Standard normal quantile by bisection on the upper tail.
+    double low = 0.0;
+    double high = 40.0;
+    for (int i = 0; i < 200 && high - low > 1e-15 * high; ++i)
+    {
+        const double mid = 0.5 * (low + high);
+        if (0.5 * std::erfc(mid / std::sqrt(2.0)) > 1.0 - p)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    normalQuantile_ = 0.5 * (low + high);
+}
+
+void PrecisionEstimator::Add(double reactionMs)
+{
+    ++count_;
+    const double delta = reactionMs - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (reactionMs - mean_);
+    if (statistic_ != PrecisionStatistic::Median)
+    {
+        return;
+    }
+
+    // Binned the way RunningStats bins.
+    const double binPosition = reactionMs / RunningStats::kHistogramBinMs;
+    size_t bin = 0;
+    if (binPosition > 0.0)
+    {
+        bin = std::min(static_cast<size_t>(binPosition), RunningStats::kHistogramBins - 1);
+    }
+    ++histogram_[bin];
+    histogramSums_[bin] += reactionMs;
+    if (count_ == 1)
+    {
+        firstBin_ = bin;
+        lastBin_ = bin;
+        medianLow_ = medianHigh_ = low_ = high_ = RankCursor{bin, 0};
+        return;
+    }
+    firstBin_ = std::min(firstBin_, bin);
+    lastBin_ = std::max(lastBin_, bin);
+    for (RankCursor* cursor : {&medianLow_, &medianHigh_, &low_, &high_})
+    {
+        cursor->below += bin < cursor->bin ? 1 : 0;
+    }
+
+    Seek(medianLow_, (count_ + 1) / 2);
+    Seek(medianHigh_, count_ / 2 + 1);
+    // Lower rank of the normal approximation to the binomial; the upper one mirrors it.
+    const double n = static_cast<double>(count_);
+    const double rank = std::floor((n + 1.0) / 2.0 - normalQuantile_ * std::sqrt(n) / 2.0);
+    lowRank_ = rank < 1.0 ? 0 : static_cast<size_t>(rank);
+    if (lowRank_ > 0)
+    {
+        Seek(low_, lowRank_);
+        Seek(high_, count_ + 1 - lowRank_);
+    }
+}
+
+void PrecisionEstimator::Seek(RankCursor& cursor, size_t rank) const
+{
+    while (cursor.below >= rank)
+    {
+        --cursor.bin;
+        cursor.below -= histogram_[cursor.bin];
+    }
+    while (cursor.below + histogram_[cursor.bin] < rank)
+    {
+        cursor.below += histogram_[cursor.bin];
+        ++cursor.bin;
+    }
+}
+
+double PrecisionEstimator::BinValue(const RankCursor& cursor) const
+{
+    return histogramSums_[cursor.bin] / static_cast<double>(histogram_[cursor.bin]);
+}
+
+double PrecisionEstimator::EstimateMs() const
+{
+    if (statistic_ == PrecisionStatistic::Mean || count_ == 0)
+    {
+        return mean_;
+    }
+    return 0.5 * (BinValue(medianLow_) + BinValue(medianHigh_));
+}
+
+double PrecisionEstimator::CriticalValue() const
+{
+    const size_t df = count_ - 1;
+    if (df <= kTableDegrees)
+    {
+        return criticalValues_[df - 1];
+    }
+    // Cornish-Fisher expansion around the normal quantile; below 1e-6 past the table.
+    const double z = normalQuantile_;
+    const double n = static_cast<double>(df);
+    const double z3 = z * z * z;
+    return z + (z3 + z) / (4.0 * n) + (5.0 * z3 * z * z + 16.0 * z3 + 3.0 * z) / (96.0 * n * n);
+}
+
+double PrecisionEstimator::HalfWidthMs() const
+{
+    constexpr double kInfinite = std::numeric_limits<double>::infinity();
+    if (count_ < 2 || criticalValues_.empty())
+    {
+        return kInfinite;
+    }
+    const double n = static_cast<double>(count_);
+    if (statistic_ == PrecisionStatistic::Mean)
+    {
+        return CriticalValue() * std::sqrt(m2_ / (n - 1.0) / n);
+    }
+    if (lowRank_ == 0)
+    {
+        return kInfinite;
+    }
+    const double median = EstimateMs();
+    return std::max(median - BinValue(low_), BinValue(high_) - median);
+}
+} // namespace purple
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace purple
+{
+struct TrialResult;
+
+// P² streaming quantile estimator (Jain & Chlamtac): five markers, O(1) memory and update.
+// Exact while fewer than five samples have been seen.
+class P2Quantile
+{
+public:
+    explicit P2Quantile(double p = 0.5);
+
+    void Reset();
+    void Add(double x);
+    double Value() const;
+
+private:
+    double p_;
+    size_t count_ = 0;
+    double heights_[5]{};
+    double positions_[5]{};
+    double desired_[5]{};
+    double increments_[5]{};
+};
+
+struct ReactionSummary
+{
+    size_t trialCount = 0;
+    size_t validCount = 0;
+    size_t falseStartCount = 0;
+
+    // Valid trials only; meaningful when validCount > 0 (sdMs needs validCount > 1).
+    double meanMs = 0.0;
+    double sdMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double trimmedMeanMs = 0.0;
+    double madMs = 0.0;
+};
+
+// Online reaction-time statistics, updated once per trial in constant memory: Welford mean/variance,
+// min/max, P² quantiles, and a fixed 0.1 ms histogram (0-4000 ms, larger values clamp to the last bin)
+// for the 10% trimmed mean and the median absolute deviation. Each bin also keeps its sum so fully kept
+// bins contribute exact values to the trimmed mean. Quantiles are exact over the first
+// kExactQuantileSamples trials, where P² markers have not converged yet; typical sessions stay there.
+class RunningStats
+{
+public:
+    static constexpr double kTrimFraction = 0.10;
+    static constexpr double kHistogramBinMs = 0.1;
+    static constexpr size_t kHistogramBins = 40000;
+    static constexpr size_t kExactQuantileSamples = 64;
+
+    RunningStats();
+
+    void Reset();
+    void AddReaction(double reactionMs);
+    void AddFalseStart();
+
+    size_t ValidCount() const { return validCount_; }
+    size_t FalseStartCount() const { return falseStartCount_; }
+
+    ReactionSummary Summary() const;
+    // Summary without the histogram statistics (trimmedMeanMs and madMs stay 0): no scan of the histogram,
+    // so the timing thread can take one after every trial (telemetry.h).
+    ReactionSummary QuickSummary() const;
+
+private:
+    double ExactQuantile(double p) const;
+    double BinCenter(size_t bin) const;
+    size_t HistogramMedianBin() const;
+    double TrimmedMean() const;
+    double MedianAbsoluteDeviation() const;
+
+    size_t validCount_ = 0;
+    size_t falseStartCount_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+    P2Quantile p50_{0.50};
+    P2Quantile p90_{0.90};
+    P2Quantile p95_{0.95};
+    P2Quantile p99_{0.99};
+    double firstSamples_[kExactQuantileSamples]{};
+    std::vector<std::uint32_t> histogram_;
+    std::vector<double> histogramSums_;
+};
+
+enum class PrecisionStatistic
+{
+    Mean,
+    Median
+};
+
+// Confidence-interval half-width of the mean or median reaction, for sequential stopping (SessionConfig::stopping).
+// The mean interval comes from Welford moments and Student's t, with the t quantiles tabulated by Reset so
+// the trial loop never iterates for them. The median interval is the distribution-free one between the
+// order statistics of ranks n/2 -/+ z sqrt(n)/2, widened to be symmetric around the sample median; a
+// density-based standard error is too noisy at a few dozen trials, and a rule that stops on a narrow
+// interval picks out exactly the sessions where it came out too narrow. Those order statistics come from
+// RunningStats' 0.1 ms histogram layout, each bin with its sum, through cursors that follow their ranks a few
+// bins per reaction: Add takes constant time and memory, and an order statistic is the mean of its bin
+// (exact for repeated values, within 0.1 ms otherwise).
+class PrecisionEstimator
+{
+public:
+    static constexpr size_t kTableDegrees = 256;  // t quantiles tabulated up to this many degrees of freedom
+
+    void Reset(PrecisionStatistic statistic, double confidence);
+    void Add(double reactionMs);
+
+    PrecisionStatistic Statistic() const { return statistic_; }
+    double Confidence() const { return confidence_; }
+    size_t Count() const { return count_; }
+    double EstimateMs() const;
+    // Infinite while fewer than two reactions (mean), or too few for the order-statistic ranks (median: six
+    // at 95%), have been added.
+    double HalfWidthMs() const;
+
+private:
+    // Histogram bin holding the order statistic of one rank, and how many reactions lie in earlier bins.
+    struct RankCursor
+    {
+        size_t bin = 0;
+        size_t below = 0;
+    };
+
+    double CriticalValue() const;
+    void Seek(RankCursor& cursor, size_t rank) const;
+    double BinValue(const RankCursor& cursor) const;
+
+    PrecisionStatistic statistic_ = PrecisionStatistic::Mean;
+    double confidence_ = 0.0;
+    double normalQuantile_ = 0.0;  // limit of the t quantiles past the table
+    size_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    // Median only: RunningStats::kHistogramBins counts and sums, allocated by the first median Reset; bins
+    // [firstBin_, lastBin_] are the ones in use.
+    std::vector<std::uint32_t> histogram_;
+    std::vector<double> histogramSums_;
+    size_t firstBin_ = 0;
+    size_t lastBin_ = 0;
+    size_t lowRank_ = 0;  // lower interval rank (1-based), 0 while too few reactions
+    RankCursor medianLow_;   // ranks (n + 1) / 2 and n / 2 + 1
+    RankCursor medianHigh_;
+    RankCursor low_;         // ranks lowRank_ and n + 1 - lowRank_
+    RankCursor high_;
+    std::vector<double> criticalValues_;  // [df - 1] for df 1..kTableDegrees
+};
+
+// Folds an existing result list, for callers that did not track statistics during the run.
+RunningStats ComputeRunningStats(const std::vector<TrialResult>& results);
+
+// Exact summary of a sorted sample of valid reactions plus a false-start count, for offline tools that hold
+// every value. Quantiles use the same nearest-rank rule as RunningStats' exact phase; the trimmed mean drops
+// kTrimFraction from each end and the MAD is taken around the median.
+ReactionSummary SummarizeSorted(const std::vector<double>& sortedValid, size_t falseStartCount);
+
+// Per-block summaries of a plan run (TrialResult::block in [0, blockCount), non-decreasing). Blocks
+// without results get an empty summary.
+std::vector<ReactionSummary> SummarizeBlocks(const std::vector<TrialResult>& results, size_t blockCount);
+
+// Exact per-device summaries (TrialResult::device in [0, deviceCount), in any order; trials without a
+// device are left out).
+std::vector<ReactionSummary> SummarizeDevices(const std::vector<TrialResult>& results, size_t deviceCount);
+
+// Mean of `sample` minus mean of `reference`, with a Welch (unequal variances) confidence interval.
+struct MeanDifference
+{
+    bool valid = false;  // both need 2+ valid trials; constant samples give a zero-width interval
+    double differenceMs = 0.0;
+    double lowMs = 0.0;
+    double highMs = 0.0;
+    double degreesOfFreedom = 0.0;  // Welch-Satterthwaite
+};
+MeanDifference CompareMeans(const ReactionSummary& sample, const ReactionSummary& reference, double confidence = 0.95);
+
+// Quantile of Student's t distribution with `degreesOfFreedom` (> 0) at probability p in (0, 1).
+double StudentTQuantile(double p, double degreesOfFreedom);
+} // namespace purple
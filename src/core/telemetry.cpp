@@ -0,0 +1,383 @@
+#include "core/telemetry.h"
+
+#include "core/event_stream.h"
+#include "core/session.h"
+#include "core/trial_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+// Copy attempts per Read; the writer holds the sequence odd for a few dozen stores, so one retry is the norm.
+constexpr int kReadAttempts = 1000;
+
+#if defined(_WIN32)
+std::wstring MappingName(const std::string& name)
+{
+    const std::string full = "Local\\purple-telemetry-" + name;
+    return std::wstring(full.begin(), full.end());  // IsValidTelemetryName: ASCII only
+}
+#else
+std::string ObjectName(const std::string& name)
+{
+    return "/purple-telemetry-" + name;
+}
+#endif
+} // namespace
+
+bool IsValidTelemetryName(const std::string& name)
+{
+    if (name.empty() || name.size() > 64)
+    {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+    });
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+bool TelemetryWriter::Open(const std::string& name)
+{
+    Close();
+    if (!IsValidTelemetryName(name))
+    {
+        return false;
+    }
+    // An existing mapping of the name (a reader holding it open) is reused and reinitialized.
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+        static_cast<DWORD>(sizeof(TelemetryBlock)), MappingName(name).c_str());
+    if (mapping == nullptr)
+    {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(TelemetryBlock));
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    block_ = new (view) TelemetryBlock();
+    pid_ = static_cast<std::int64_t>(GetCurrentProcessId());
+    sequence_ = 0;
+    snapshot_ = TelemetrySnapshot{};
+    return true;
+}
+
+void TelemetryWriter::Close()
+{
+    if (block_ != nullptr)
+    {
+        UnmapViewOfFile(block_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+    block_ = nullptr;
+    mapping_ = nullptr;
+}
+#else
+bool TelemetryWriter::Open(const std::string& name)
+{
+    Close();
+    if (!IsValidTelemetryName(name))
+    {
+        return false;
+    }
+    // A block left by a crashed writer is unlinked rather than truncated under readers that still map it;
+    // they keep the stale copy until they reopen.
+    const std::string objectName = ObjectName(name);
+    ::shm_unlink(objectName.c_str());
+    const int fd = ::shm_open(objectName.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(sizeof(TelemetryBlock))) != 0)
+    {
+        ::close(fd);
+        ::shm_unlink(objectName.c_str());
+        return false;
+    }
+    void* view = ::mmap(nullptr, sizeof(TelemetryBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        ::shm_unlink(objectName.c_str());
+        return false;
+    }
+    objectName_ = objectName;
+    block_ = new (view) TelemetryBlock();
+    pid_ = static_cast<std::int64_t>(::getpid());
+    sequence_ = 0;
+    snapshot_ = TelemetrySnapshot{};
+    return true;
+}
+
+void TelemetryWriter::Close()
+{
+    if (block_ != nullptr)
+    {
+        ::munmap(block_, sizeof(TelemetryBlock));
+        ::shm_unlink(objectName_.c_str());
+    }
+    block_ = nullptr;
+    objectName_.clear();
+}
+#endif
+
+void TelemetryWriter::Publish(TelemetrySnapshot& snapshot)
+{
+    if (block_ == nullptr)
+    {
+        return;
+    }
+    snapshot.publishes = sequence_ / 2 + 1;
+    snapshot.writerPid = pid_;
+    std::uint64_t words[kTelemetryWords];
+    std::memcpy(words, &snapshot, sizeof(words));
+
+    // Odd sequence first; the release fence keeps the word stores from moving above it.
+    block_->sequence.store(sequence_ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kTelemetryWords; ++i)
+    {
+        block_->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_ += 2;
+    block_->sequence.store(sequence_, std::memory_order_release);
+}
+
+void TelemetryWriter::BeginRun(const Session& session, Ticks frequency, Ticks now)
+{
+    frequency_ = frequency;
+    heartbeatTicks_ = SecondsToTicks(kHeartbeatSeconds, frequency);
+    lastIterationTicks_ = now;
+    maxResponseGapTicks_ = 0;
+    lastPhase_ = -1;
+    lastTrialIndex_ = -1;
+    statsChanged_ = true;
+
+    const std::int64_t runs = snapshot_.runs + 1;
+    snapshot_ = TelemetrySnapshot{};
+    snapshot_.tickFrequency = frequency;
+    snapshot_.runs = runs;
+    snapshot_.running = 1;
+    snapshot_.trialCount = PlannedTrialCount(session.config);
+    PublishState(session, now);
+}
+
+void TelemetryWriter::Iteration(const Session& session, Ticks now)
+{
+    ++snapshot_.loopIterations;
+    const int phase = static_cast<int>(session.phase);
+    if (session.phase == Phase::WaitingForResponse && lastPhase_ == phase)
+    {
+        maxResponseGapTicks_ = std::max(maxResponseGapTicks_, now - lastIterationTicks_);
+    }
+    lastIterationTicks_ = now;
+    if (phase != lastPhase_ || session.trialIndex != lastTrialIndex_ || now - lastPublishTicks_ >= heartbeatTicks_)
+    {
+        PublishState(session, now);
+    }
+}
+
+void TelemetryWriter::RecordTrial(bool falseStart, double reactionMs)
+{
+    snapshot_.lastResult = falseStart ? 2 : 1;
+    snapshot_.lastReactionMs = falseStart ? 0.0 : reactionMs;
+    statsChanged_ = true;
+}
+
+void TelemetryWriter::EndRun(const Session& session, int outcome, Ticks now)
+{
+    snapshot_.running = 0;
+    snapshot_.outcome = outcome;
+    PublishState(session, now);
+}
+
+void TelemetryWriter::PublishState(const Session& session, Ticks now)
+{
+    lastPhase_ = static_cast<int>(session.phase);
+    lastTrialIndex_ = session.trialIndex;
+    lastPublishTicks_ = now;
+
+    snapshot_.updateTicks = now;
+    snapshot_.phase = lastPhase_;
+    snapshot_.trialIndex = session.trialIndex;
+    snapshot_.blockIndex = session.blockIndex;
+    // Results reach the statistics after the hook saw them, so they are folded in on the next publish.
+    if (statsChanged_)
+    {
+        const ReactionSummary summary = session.stats.QuickSummary();
+        snapshot_.validCount = static_cast<std::int64_t>(summary.validCount);
+        snapshot_.falseStartCount = static_cast<std::int64_t>(summary.falseStartCount);
+        snapshot_.meanMs = summary.meanMs;
+        snapshot_.sdMs = summary.sdMs;
+        snapshot_.minMs = summary.minMs;
+        snapshot_.maxMs = summary.maxMs;
+        snapshot_.p50Ms = summary.p50Ms;
+        snapshot_.p90Ms = summary.p90Ms;
+        statsChanged_ = false;
+    }
+    snapshot_.maxResponseGapMs = TicksToMilliseconds(maxResponseGapTicks_, frequency_);
+    snapshot_.lastOvershootMs = TicksToMilliseconds(session.onsetOvershootTicks, frequency_);
+    snapshot_.streamDropped = session.stream != nullptr ? session.stream->Dropped() : 0;
+    snapshot_.logDropped = session.log != nullptr ? session.log->Dropped() : 0;
+    Publish(snapshot_);
+}
+
+TelemetryReader::~TelemetryReader()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+bool TelemetryReader::Open(const std::string& name)
+{
+    Close();
+    if (!IsValidTelemetryName(name))
+    {
+        return false;
+    }
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, MappingName(name).c_str());
+    if (mapping == nullptr)
+    {
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(TelemetryBlock));
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    block_ = static_cast<const TelemetryBlock*>(view);
+    return true;
+}
+
+void TelemetryReader::Close()
+{
+    if (block_ != nullptr)
+    {
+        UnmapViewOfFile(block_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+    block_ = nullptr;
+    mapping_ = nullptr;
+}
+#else
+bool TelemetryReader::Open(const std::string& name)
+{
+    Close();
+    if (!IsValidTelemetryName(name))
+    {
+        return false;
+    }
+    const int fd = ::shm_open(ObjectName(name).c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    void* view = ::mmap(nullptr, sizeof(TelemetryBlock), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+    block_ = static_cast<const TelemetryBlock*>(view);
+    return true;
+}
+
+void TelemetryReader::Close()
+{
+    if (block_ != nullptr)
+    {
+        ::munmap(const_cast<TelemetryBlock*>(block_), sizeof(TelemetryBlock));
+    }
+    block_ = nullptr;
+}
+#endif
+
+bool TelemetryReader::Read(TelemetrySnapshot& snapshot)
+{
+    if (block_ == nullptr)
+    {
+        return false;
+    }
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt)
+    {
+        const std::uint64_t before = block_->sequence.load(std::memory_order_acquire);
+        if (before == 0)
+        {
+            return false;
+        }
+        if ((before & 1) == 0)
+        {
+            std::uint64_t words[kTelemetryWords];
+            for (size_t i = 0; i < kTelemetryWords; ++i)
+            {
+                words[i] = block_->words[i].load(std::memory_order_relaxed);
+            }
+            // The acquire fence keeps the word loads above the second sequence load.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (block_->sequence.load(std::memory_order_relaxed) == before &&
+                std::memcmp(block_->magic, "PRTELEM", 8) == 0 && block_->version == TelemetryBlock::kVersion &&
+                block_->wordCount == kTelemetryWords)
+            {
+                std::memcpy(&snapshot, words, sizeof(words));
+                return true;
+            }
+        }
+        ++retries_;
+    }
+    return false;
+}
+
+void TelemetrySessionStart(const Session& session, Ticks frequency, Ticks now)
+{
+    if (session.telemetry != nullptr)
+    {
+        session.telemetry->BeginRun(session, frequency, now);
+    }
+}
+
+void TelemetryIteration(const Session& session, Ticks now)
+{
+    if (session.telemetry != nullptr)
+    {
+        session.telemetry->Iteration(session, now);
+    }
+}
+
+void TelemetryOutcome(const Session& session, SessionOutcome outcome, Ticks now)
+{
+    if (session.telemetry != nullptr)
+    {
+        session.telemetry->EndRun(session, static_cast<int>(outcome), now);
+    }
+}
+} // namespace purple
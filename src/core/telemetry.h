@@ -0,0 +1,151 @@
+#pragma once
+
+#include "core/clock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace purple
+{
+struct Session;
+
+// Live session state for dashboards and monitors in other processes (--telemetry name). Every field is
+// 8 bytes so the block copies word by word; times are in milliseconds unless named Ticks.
+struct TelemetrySnapshot
+{
+    std::uint64_t publishes = 0;      // snapshots published since the writer opened
+    std::int64_t tickFrequency = 0;
+    std::int64_t updateTicks = 0;     // writer clock at publish; QPC / CLOCK_MONOTONIC, comparable across processes
+    std::int64_t writerPid = 0;
+
+    std::int64_t runs = 0;            // runs started since the writer opened
+    std::int64_t running = 0;         // 1 from the start of a run until its outcome
+    std::int64_t outcome = -1;        // SessionOutcome of the last finished run (-1: none yet, or running)
+    std::int64_t phase = 0;           // Phase of the current run
+    std::int64_t trialIndex = 0;      // trials finished in the current run
+    std::int64_t trialCount = 0;      // trials planned for it
+    std::int64_t blockIndex = 0;
+
+    std::int64_t lastResult = 0;      // last trial of the run: 0 none yet, 1 reaction, 2 false start
+    double lastReactionMs = 0.0;
+    std::int64_t validCount = 0;
+    std::int64_t falseStartCount = 0;
+    // Valid trials of the run so far (RunningStats::QuickSummary); zero until the first one.
+    double meanMs = 0.0;
+    double sdMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+
+    // Loop health of the run.
+    std::uint64_t loopIterations = 0;
+    double maxResponseGapMs = 0.0;    // longest gap between loop iterations while waiting for a response
+    double lastOvershootMs = 0.0;     // last stimulus Present past its due time
+    std::uint64_t streamDropped = 0;  // --stream-out events dropped
+    std::uint64_t logDropped = 0;     // console log messages dropped
+};
+static_assert(std::is_trivially_copyable<TelemetrySnapshot>::value && sizeof(TelemetrySnapshot) % 8 == 0,
+    "telemetry snapshots copy as 64-bit words");
+
+constexpr size_t kTelemetryWords = sizeof(TelemetrySnapshot) / 8;
+
+// Shared memory layout: a named file mapping (Local\purple-telemetry-<name>) on Windows, a POSIX shared
+// memory object (/purple-telemetry-<name>) elsewhere. The snapshot sits behind a seqlock: the writer makes
+// `sequence` odd, stores the words and makes it even again, so it never waits for a reader; readers retry
+// when the sequence was odd or moved while they copied.
+struct TelemetryBlock
+{
+    static constexpr std::uint32_t kVersion = 1;
+
+    char magic[8] = {'P', 'R', 'T', 'E', 'L', 'E', 'M', '\0'};
+    std::uint32_t version = kVersion;
+    std::uint32_t wordCount = static_cast<std::uint32_t>(kTelemetryWords);
+    alignas(64) std::atomic<std::uint64_t> sequence{0};  // 0 until the first publish
+    std::atomic<std::uint64_t> words[kTelemetryWords] = {};
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the seqlock shares plain 64-bit atomics across processes");
+
+// Letters, digits, '-' and '_', up to 64 characters.
+bool IsValidTelemetryName(const std::string& name);
+
+// Owns the block of one name. Publish is wait-free; the session hooks (TelemetrySessionStart and friends in
+// session.h) call it on phase and trial changes and every kHeartbeatSeconds in between.
+class TelemetryWriter
+{
+public:
+    static constexpr double kHeartbeatSeconds = 0.01;
+
+    TelemetryWriter() = default;
+    ~TelemetryWriter();
+
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    // Creates the block, replacing one a previous writer of the same name left behind.
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return block_ != nullptr; }
+
+    // Stamps `publishes` and `writerPid` and makes the snapshot visible to readers.
+    void Publish(TelemetrySnapshot& snapshot);
+
+    // Session hooks, timing thread only.
+    void BeginRun(const Session& session, Ticks frequency, Ticks now);
+    void Iteration(const Session& session, Ticks now);
+    void RecordTrial(bool falseStart, double reactionMs);
+    void EndRun(const Session& session, int outcome, Ticks now);
+
+private:
+    void PublishState(const Session& session, Ticks now);
+
+    TelemetryBlock* block_ = nullptr;
+    std::string objectName_;
+#if defined(_WIN32)
+    void* mapping_ = nullptr;  // HANDLE
+#endif
+    std::uint64_t sequence_ = 0;
+    std::int64_t pid_ = 0;
+
+    TelemetrySnapshot snapshot_;
+    Ticks frequency_ = 1;
+    Ticks heartbeatTicks_ = 0;
+    Ticks lastPublishTicks_ = 0;
+    Ticks lastIterationTicks_ = 0;
+    Ticks maxResponseGapTicks_ = 0;
+    int lastPhase_ = -1;
+    int lastTrialIndex_ = -1;
+    bool statsChanged_ = false;
+};
+
+// Read-only view of a writer's block; any number of readers may poll it at any rate without slowing the
+// writer down beyond sharing its cache lines.
+class TelemetryReader
+{
+public:
+    TelemetryReader() = default;
+    ~TelemetryReader();
+
+    TelemetryReader(const TelemetryReader&) = delete;
+    TelemetryReader& operator=(const TelemetryReader&) = delete;
+
+    // False while no writer has created the block.
+    bool Open(const std::string& name);
+    void Close();
+
+    // Copies a consistent snapshot; false before the first publish, or when the writer kept the block busy
+    // through every retry.
+    bool Read(TelemetrySnapshot& snapshot);
+    // Copies abandoned because the writer was mid-update.
+    unsigned long long Retries() const { return retries_; }
+
+private:
+    const TelemetryBlock* block_ = nullptr;
+#if defined(_WIN32)
+    void* mapping_ = nullptr;  // HANDLE
+#endif
+    unsigned long long retries_ = 0;
+};
+} // namespace purple
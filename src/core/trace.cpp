@@ -0,0 +1,442 @@
+#include "core/trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace purple
+{
+namespace
+{
+template <typename T>
+bool ReadPod(std::FILE* file, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+constexpr size_t kTextRecordBytes = 3 * sizeof(std::int64_t);
+
+// Realtime record flag bits.
+constexpr std::int64_t kRealtimePriorityRaised = 1;
+constexpr std::int64_t kRealtimeMemoryLocked = 2;
+constexpr std::int64_t kRealtimePowerThrottlingOff = 4;
+constexpr std::int64_t kRealtimeCpuDmaLatencyHeld = 8;
+constexpr std::int64_t kRealtimeInputPriorityRaised = 16;
+
+// Reads the string of the Text records at `index`, leaving `index` past them.
+bool ReadTraceText(const std::vector<TraceRecord>& records, size_t& index, std::string& text)
+{
+    text.clear();
+    for (; index < records.size() && records[index].kind == TraceEventKind::Text; ++index)
+    {
+        const TraceRecord& record = records[index];
+        if (record.aux > kTextRecordBytes)
+        {
+            return false;
+        }
+        char bytes[kTextRecordBytes];
+        std::memcpy(bytes, &record.a, sizeof(record.a));
+        std::memcpy(bytes + 8, &record.b, sizeof(record.b));
+        std::memcpy(bytes + 16, &record.c, sizeof(record.c));
+        text.append(bytes, record.aux);
+        if (record.aux < kTextRecordBytes)
+        {
+            ++index;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Devices and realtime report of the records after End.
+bool ReadTraceTrailer(const std::vector<TraceRecord>& records, size_t index, SessionTrace& trace)
+{
+    while (index < records.size())
+    {
+        const TraceRecord& record = records[index++];
+        if (record.kind == TraceEventKind::Device)
+        {
+            InputDevice device;
+            device.handle = static_cast<std::uint64_t>(record.a);
+            device.vendorId = static_cast<std::uint16_t>(record.aux >> 16);
+            device.productId = static_cast<std::uint16_t>(record.aux & 0xFFFF);
+            if (!ReadTraceText(records, index, device.id) || !ReadTraceText(records, index, device.name))
+            {
+                return false;
+            }
+            trace.devices.push_back(device);
+        }
+        else if (record.kind == TraceEventKind::Realtime)
+        {
+            RealtimeReport& realtime = trace.realtime;
+            realtime.profile = static_cast<RealtimeProfile>(record.aux);
+            realtime.priorityRaised = (record.a & kRealtimePriorityRaised) != 0;
+            realtime.inputPriorityRaised = (record.a & kRealtimeInputPriorityRaised) != 0;
+            realtime.memoryLocked = (record.a & kRealtimeMemoryLocked) != 0;
+            realtime.powerThrottlingOff = (record.a & kRealtimePowerThrottlingOff) != 0;
+            realtime.cpuDmaLatencyHeld = (record.a & kRealtimeCpuDmaLatencyHeld) != 0;
+            realtime.fifoPriority = static_cast<int>(record.b);
+            if (!ReadTraceText(records, index, realtime.timingCpus) || !ReadTraceText(records, index, realtime.inputCpus)
+                || !ReadTraceText(records, index, realtime.mmcssTask))
+            {
+                return false;
+            }
+            trace.hasRealtime = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The loop settles a trial in the iteration that saw the deciding event; with --trial-timing that
+// iteration also wrote the TrialTiming record just before the result.
+void SettleReplayedTrial(Session& session, Ticks frequency)
+{
+    if (!session.hasInput || (session.phase != Phase::WaitingForStimulus && session.phase != Phase::WaitingForResponse))
+    {
+        return;
+    }
+    if (session.inputWasFalseStart)
+    {
+        RecordFalseStart(session);
+    }
+    else if (session.phase == Phase::WaitingForResponse && !session.onsetPending)
+    {
+        RecordReaction(session, frequency);
+    }
+}
+} // namespace
+
+TraceWriter::~TraceWriter()
+{
+    Close();
+}
+
+bool TraceWriter::Open(const std::string& path)
+{
+    Close();
+    failed_ = false;
+    pending_.clear();
+    pending_.reserve(2 * kFlushRecords);
+    file_ = std::fopen(path.c_str(), "wb");
+    return file_ != nullptr;
+}
+
+void TraceWriter::Begin(const SessionConfig& config, Ticks frequency)
+{
+    if (file_ == nullptr)
+    {
+        return;
+    }
+
+    TraceFileHeader header;
+    header.planBlocks = static_cast<std::uint32_t>(config.plan.size());
+    header.tickFrequency = frequency;
+    header.trialCount = config.trialCount;
+    header.flags = config.recordTiming ? TraceFileHeader::kFlagRecordTiming : 0;
+    header.minDelaySeconds = config.minDelaySeconds;
+    header.maxDelaySeconds = config.maxDelaySeconds;
+    failed_ |= std::fwrite(&header, sizeof(header), 1, file_) != 1;
+
+    for (const PlanBlock& block : config.plan)
+    {
+        TracePlanBlock entry;
+        std::memcpy(entry.id, block.id.data(), std::min(block.id.size(), sizeof(entry.id)));
+        entry.trialCount = block.trialCount;
+        entry.minDelaySeconds = block.minDelaySeconds;
+        entry.maxDelaySeconds = block.maxDelaySeconds;
+        entry.restSeconds = block.restSeconds;
+        failed_ |= std::fwrite(&entry, sizeof(entry), 1, file_) != 1;
+    }
+
+    TraceRunSettings settings;
+    settings.foreperiodDistribution = static_cast<std::uint32_t>(config.foreperiod.distribution);
+    settings.foreperiodSeed = config.foreperiod.seed;
+    settings.foreperiodMeanSeconds = config.foreperiod.meanSeconds;
+    settings.foreperiodStepSeconds = config.foreperiod.stepSeconds;
+    settings.stopHalfWidthMs = config.stopping.halfWidthMs;
+    settings.stopStatistic = static_cast<std::uint32_t>(config.stopping.statistic);
+    settings.stopConfidence = config.stopping.confidence;
+    settings.stopMinValidTrials = config.stopping.minValidTrials;
+    failed_ |= std::fwrite(&settings, sizeof(settings), 1, file_) != 1;
+}
+
+void TraceWriter::AppendText(const std::string& text)
+{
+    // Always ends with a short record, an empty one when the length is a multiple of the record size.
+    size_t offset = 0;
+    for (;;)
+    {
+        const size_t length = std::min(text.size() - offset, kTextRecordBytes);
+        char bytes[kTextRecordBytes] = {};
+        std::memcpy(bytes, text.data() + offset, length);
+        TraceRecord record{TraceEventKind::Text, static_cast<std::uint32_t>(length), 0, 0, 0};
+        std::memcpy(&record.a, bytes, sizeof(record.a));
+        std::memcpy(&record.b, bytes + 8, sizeof(record.b));
+        std::memcpy(&record.c, bytes + 16, sizeof(record.c));
+        Append(record);
+        offset += length;
+        if (length < kTextRecordBytes)
+        {
+            return;
+        }
+    }
+}
+
+void TraceWriter::AppendRunMetadata(const std::vector<InputDevice>& devices, const RealtimeReport& realtime)
+{
+    if (file_ == nullptr)
+    {
+        return;
+    }
+    for (const InputDevice& device : devices)
+    {
+        const std::uint32_t ids = static_cast<std::uint32_t>(device.vendorId) << 16 | device.productId;
+        Append(TraceRecord{TraceEventKind::Device, ids, static_cast<std::int64_t>(device.handle), 0, 0});
+        AppendText(device.id);
+        AppendText(device.name);
+    }
+
+    std::int64_t flags = 0;
+    flags |= realtime.priorityRaised ? kRealtimePriorityRaised : 0;
+    flags |= realtime.inputPriorityRaised ? kRealtimeInputPriorityRaised : 0;
+    flags |= realtime.memoryLocked ? kRealtimeMemoryLocked : 0;
+    flags |= realtime.powerThrottlingOff ? kRealtimePowerThrottlingOff : 0;
+    flags |= realtime.cpuDmaLatencyHeld ? kRealtimeCpuDmaLatencyHeld : 0;
+    Append(TraceRecord{TraceEventKind::Realtime, static_cast<std::uint32_t>(realtime.profile), flags, realtime.fifoPriority, 0});
+    AppendText(realtime.timingCpus);
+    AppendText(realtime.inputCpus);
+    AppendText(realtime.mmcssTask);
+}
+
+void TraceWriter::FlushIfFull()
+{
+    if (pending_.size() >= kFlushRecords)
+    {
+        Flush();
+    }
+}
+
+void TraceWriter::Flush()
+{
+    if (file_ != nullptr && !pending_.empty())
+    {
+        failed_ |= std::fwrite(pending_.data(), sizeof(TraceRecord), pending_.size(), file_) != pending_.size();
+    }
+    pending_.clear();
+}
+
+bool TraceWriter::Close()
+{
+    if (file_ == nullptr)
+    {
+        return !failed_;
+    }
+    Flush();
+    failed_ |= std::fclose(file_) != 0;
+    file_ = nullptr;
+    return !failed_;
+}
+
+std::string NumberedTracePath(const std::string& path, int run)
+{
+    return run <= 1 ? path : path + "." + std::to_string(run);
+}
+
+bool LoadTrace(const std::string& path, SessionTrace& trace)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        std::printf("Failed to open trace: %s\n", path.c_str());
+        return false;
+    }
+
+    TraceFileHeader header;
+    const TraceFileHeader expected;
+    if (!ReadPod(file, header) || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0)
+    {
+        std::printf("Trace %s: not a trace file.\n", path.c_str());
+        std::fclose(file);
+        return false;
+    }
+    if (header.version < 1 || header.version > TraceFileHeader::kVersion || header.tickFrequency <= 0 || header.planBlocks > 1000)
+    {
+        std::printf("Trace %s: unsupported version %u or bad header.\n", path.c_str(), header.version);
+        std::fclose(file);
+        return false;
+    }
+
+    trace.tickFrequency = header.tickFrequency;
+    trace.config = SessionConfig{};
+    trace.config.trialCount = header.trialCount;
+    trace.config.minDelaySeconds = header.minDelaySeconds;
+    trace.config.maxDelaySeconds = header.maxDelaySeconds;
+    trace.config.recordTiming = (header.flags & TraceFileHeader::kFlagRecordTiming) != 0;
+    for (std::uint32_t i = 0; i < header.planBlocks; ++i)
+    {
+        TracePlanBlock entry;
+        if (!ReadPod(file, entry))
+        {
+            std::printf("Trace %s: truncated plan.\n", path.c_str());
+            std::fclose(file);
+            return false;
+        }
+        PlanBlock block;
+        block.id.assign(entry.id, std::find(entry.id, entry.id + sizeof(entry.id), '\0'));
+        block.trialCount = entry.trialCount;
+        block.minDelaySeconds = entry.minDelaySeconds;
+        block.maxDelaySeconds = entry.maxDelaySeconds;
+        block.restSeconds = entry.restSeconds;
+        trace.config.plan.push_back(block);
+    }
+
+    trace.hasSettings = header.version >= 2;
+    if (trace.hasSettings)
+    {
+        TraceRunSettings settings;
+        if (!ReadPod(file, settings))
+        {
+            std::printf("Trace %s: truncated settings.\n", path.c_str());
+            std::fclose(file);
+            return false;
+        }
+        ForeperiodConfig& foreperiod = trace.config.foreperiod;
+        foreperiod.distribution = static_cast<ForeperiodDistribution>(settings.foreperiodDistribution);
+        foreperiod.meanSeconds = settings.foreperiodMeanSeconds;
+        foreperiod.stepSeconds = settings.foreperiodStepSeconds;
+        foreperiod.seeded = true;  // replay keeps the recorded seed instead of drawing one
+        foreperiod.seed = settings.foreperiodSeed;
+        StoppingRule& stopping = trace.config.stopping;
+        stopping.halfWidthMs = settings.stopHalfWidthMs;
+        stopping.statistic = static_cast<PrecisionStatistic>(settings.stopStatistic);
+        stopping.confidence = settings.stopConfidence;
+        stopping.minValidTrials = settings.stopMinValidTrials;
+    }
+
+    // Records run to the end of the file; a partial trailing record (a crash mid-write) is dropped.
+    trace.records.clear();
+    TraceRecord chunk[1024];
+    size_t read = 0;
+    while ((read = std::fread(chunk, sizeof(TraceRecord), 1024, file)) > 0)
+    {
+        trace.records.insert(trace.records.end(), chunk, chunk + read);
+    }
+    std::fclose(file);
+
+    // Whatever follows End is the trailer; a damaged one is dropped rather than failing the replay.
+    const auto end = std::find_if(trace.records.begin(), trace.records.end(),
+        [](const TraceRecord& record) { return record.kind == TraceEventKind::End; });
+    trace.complete = end != trace.records.end();
+    trace.devices.clear();
+    trace.hasRealtime = false;
+    trace.realtime = RealtimeReport{};
+    if (trace.complete)
+    {
+        const size_t trailer = static_cast<size_t>(end - trace.records.begin()) + 1;
+        if (!ReadTraceTrailer(trace.records, trailer, trace))
+        {
+            std::printf("Trace %s: bad run metadata after the end record; exporting without it.\n", path.c_str());
+            trace.devices.clear();
+            trace.hasRealtime = false;
+            trace.realtime = RealtimeReport{};
+        }
+        trace.records.resize(trailer);
+    }
+    return true;
+}
+
+SessionOutcome ReplayTrace(const SessionTrace& trace, Session& session)
+{
+    const bool logTrials = session.config.logTrials;
+    session.config = trace.config;
+    session.config.logTrials = logTrials;
+    session.stream = nullptr;
+    session.trace = nullptr;
+    session.quitRequested = false;
+    ResetSessionState(session);
+
+    const Ticks freq = trace.tickFrequency;
+    const bool settleOnTiming = trace.config.recordTiming;
+    for (const TraceRecord& record : trace.records)
+    {
+        switch (record.kind)
+        {
+        case TraceEventKind::TrialBegin:
+        {
+            if (AtBlockBoundary(session))
+            {
+                StartNextBlock(session);
+            }
+            double delaySeconds = 0.0;
+            std::memcpy(&delaySeconds, &record.b, sizeof(delaySeconds));
+            BeginTrial(session, record.a, delaySeconds, freq);
+            break;
+        }
+        case TraceEventKind::StimulusPresent:
+            PresentStimulus(session, record.a, record.b, record.c);
+            break;
+        case TraceEventKind::OnsetResolved:
+            ResolveStimulusOnset(session, static_cast<OnsetPoll>(record.aux), record.a);
+            break;
+        case TraceEventKind::Press:
+            RecordPress(session, record.a, static_cast<std::uint64_t>(record.b));
+            break;
+        case TraceEventKind::TrialTiming:
+            session.timingProbe.loopIterations = record.aux;
+            session.timingProbe.presentTicks = record.a;
+            session.timingProbe.inputSeenTicks = record.b;
+            session.timingProbe.maxIterationGapTicks = record.c;
+            FinishTrialTiming(session, freq);
+            SettleReplayedTrial(session, freq);
+            break;
+        case TraceEventKind::End:
+        {
+            const SessionOutcome outcome = static_cast<SessionOutcome>(record.aux);
+            session.quitRequested = outcome == SessionOutcome::QuitRequested;
+            session.escapePressed = outcome == SessionOutcome::Aborted && record.a == 0;
+            session.cancelRequested = outcome == SessionOutcome::Aborted && record.a != 0;
+            return outcome;
+        }
+        case TraceEventKind::Device:
+        case TraceEventKind::Realtime:
+        case TraceEventKind::Text:
+            break;  // trailer, cut off by LoadTrace
+        }
+
+        if (!settleOnTiming && record.kind != TraceEventKind::TrialTiming)
+        {
+            SettleReplayedTrial(session, freq);
+        }
+    }
+    return SessionOutcome::Aborted;
+}
+
+void TraceEvent(const Session& session, TraceEventKind kind, std::uint32_t aux, std::int64_t a, std::int64_t b, std::int64_t c)
+{
+    if (session.trace != nullptr)
+    {
+        session.trace->Append(TraceRecord{kind, aux, a, b, c});
+    }
+}
+
+void TraceSessionStart(const Session& session, Ticks frequency)
+{
+    if (session.trace != nullptr)
+    {
+        session.trace->Begin(session.config, frequency);
+    }
+}
+
+void TraceOutcome(const Session& session, SessionOutcome outcome)
+{
+    if (session.trace == nullptr)
+    {
+        return;
+    }
+    const std::int64_t cancelled = outcome == SessionOutcome::Aborted && session.cancelRequested ? 1 : 0;
+    TraceEvent(session, TraceEventKind::End, static_cast<std::uint32_t>(outcome), cancelled);
+}
+} // namespace purple
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "core/clock.h"
+#include "core/realtime.h"
+#include "core/session.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace purple
+{
+// Raw session trace (`--trace`): everything the trial loop observed, in the order it observed it, so a
+// later build can re-derive the results with its own session logic (ReplayTrace).
+//
+// File layout (native little-endian): TraceFileHeader, header.planBlocks TracePlanBlock entries, a
+// TraceRunSettings (version 2), then TraceRecord entries to the end of the file. After the End record,
+// version 2 files carry a trailer the runner writes once it has resolved the run's devices and realtime
+// report (AppendRunMetadata): Device and Realtime records, each followed by its strings as Text records.
+// Version 1 files are still read; their replays export without that metadata.
+enum class TraceEventKind : std::uint32_t
+{
+    TrialBegin = 1,      // a = trial start ticks, b = scheduled delay (bits of the double)
+    StimulusPresent = 2, // a = t0, b = t1 around the Present call, c = wait overshoot ticks
+    OnsetResolved = 3,   // aux = OnsetPoll, a = scanout ticks
+    Press = 4,           // a = capture timestamp, b = device handle (0 when unknown)
+    TrialTiming = 5,     // --trial-timing probe: aux = loop iterations, a = present, b = input seen, c = max gap
+    End = 6,             // aux = SessionOutcome, a = 1 for a remote cancel (Aborted only)
+    Device = 7,          // trailer, in Session::devices order: aux = vendor << 16 | product, a = handle; Text id, name
+    Realtime = 8,        // trailer: aux = RealtimeProfile, a = flag bits, b = SCHED_FIFO priority; Text timing
+                         // CPUs, input CPUs, MMCSS task
+    Text = 9             // aux = bytes (0-24) in a, b, c; a string ends with its first record under 24 bytes
+};
+
+struct TraceRecord
+{
+    TraceEventKind kind = TraceEventKind::End;
+    std::uint32_t aux = 0;
+    std::int64_t a = 0;
+    std::int64_t b = 0;
+    std::int64_t c = 0;
+};
+static_assert(sizeof(TraceRecord) == 32, "trace records are 32 bytes on disk");
+
+struct TraceFileHeader
+{
+    static constexpr std::uint32_t kVersion = 2;
+
+    char magic[8] = {'P', 'R', 'T', 'R', 'A', 'C', 'E', '\0'};
+    std::uint32_t version = kVersion;
+    std::uint32_t planBlocks = 0;
+    std::int64_t tickFrequency = 0;
+    std::int32_t trialCount = 0;
+    std::uint32_t flags = 0;  // kFlagRecordTiming
+    double minDelaySeconds = 0.0;
+    double maxDelaySeconds = 0.0;
+
+    static constexpr std::uint32_t kFlagRecordTiming = 1;
+};
+static_assert(sizeof(TraceFileHeader) == 48, "trace header is 48 bytes on disk");
+
+struct TracePlanBlock
+{
+    char id[64] = {};  // not NUL-terminated at 64 characters
+    std::int32_t trialCount = 0;
+    std::uint32_t reserved = 0;
+    double minDelaySeconds = 0.0;
+    double maxDelaySeconds = 0.0;
+    double restSeconds = 0.0;
+};
+static_assert(sizeof(TracePlanBlock) == 96, "trace plan blocks are 96 bytes on disk");
+
+// Run settings the exports report but the records do not carry (version 2).
+struct TraceRunSettings
+{
+    std::uint32_t foreperiodDistribution = 0;  // ForeperiodDistribution
+    std::uint32_t stopStatistic = 0;           // PrecisionStatistic
+    std::uint64_t foreperiodSeed = 0;
+    double foreperiodMeanSeconds = 0.0;
+    double foreperiodStepSeconds = 0.0;
+    double stopHalfWidthMs = 0.0;              // 0: no stopping rule
+    double stopConfidence = 0.0;
+    std::int32_t stopMinValidTrials = 0;
+    std::uint32_t reserved[3] = {};
+};
+static_assert(sizeof(TraceRunSettings) == 64, "trace run settings are 64 bytes on disk");
+
+// Trace file writer owned by the runner and attached as Session::trace. Records are buffered in memory
+// and only written out at trial boundaries (and on Close), never between stimulus and response.
+class TraceWriter
+{
+public:
+    TraceWriter() = default;
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool Open(const std::string& path);
+    bool IsOpen() const { return file_ != nullptr; }
+
+    // Writes the file header; called by the trial loop when the run starts (one run per file).
+    void Begin(const SessionConfig& config, Ticks frequency);
+    void Append(const TraceRecord& record) { pending_.push_back(record); }
+    // Writes buffered records once enough have accumulated; called between trials.
+    void FlushIfFull();
+    // The trailer: the run's described devices (ids assigned, as exported) and realtime report. Called by
+    // the runner after the run ended and before Close.
+    void AppendRunMetadata(const std::vector<InputDevice>& devices, const RealtimeReport& realtime);
+
+    // Flushes and closes; false if any write failed since Open.
+    bool Close();
+
+private:
+    void Flush();
+    void AppendText(const std::string& text);
+
+    static constexpr size_t kFlushRecords = 2048;
+
+    std::FILE* file_ = nullptr;
+    bool failed_ = false;
+    std::vector<TraceRecord> pending_;
+};
+
+struct SessionTrace
+{
+    Ticks tickFrequency = 0;
+    SessionConfig config;  // trial count, delays, plan and recordTiming; foreperiod and stopping from version 2
+    bool hasSettings = false;  // version 2: config.foreperiod and config.stopping are the recorded run's
+    std::vector<TraceRecord> records;  // up to and including End
+    bool complete = false;  // has an End record (false for a run that crashed mid-way)
+    std::vector<InputDevice> devices;  // from the trailer; empty without one
+    bool hasRealtime = false;
+    RealtimeReport realtime;
+};
+
+// Trace file for the run-th run (1-based) of a process: `path` itself for the first run, `path.N` after.
+std::string NumberedTracePath(const std::string& path, int run);
+
+// Reads a whole trace file; prints the reason and returns false for files that are not valid traces.
+bool LoadTrace(const std::string& path, SessionTrace& trace);
+
+// Feeds the trace through the current session logic in recorded order. Resets `session` (its config
+// comes from the trace apart from logTrials) and leaves the regenerated results in it. A truncated trace
+// replays as far as it goes and reports Aborted.
+SessionOutcome ReplayTrace(const SessionTrace& trace, Session& session);
+
+// Appends one record when session.trace is set (TraceSessionStart/TraceOutcome are in session.h).
+void TraceEvent(const Session& session, TraceEventKind kind, std::uint32_t aux, std::int64_t a, std::int64_t b = 0, std::int64_t c = 0);
+} // namespace purple
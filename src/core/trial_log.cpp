@@ -0,0 +1,125 @@
+#include "core/trial_log.h"
+
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace purple
+{
+namespace
+{
+// The log thread should never compete with the timing thread for a core.
+void LowerCurrentThreadPriority()
+{
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    // Linux keeps nice values per thread; `who` 0 is the calling thread.
+    setpriority(PRIO_PROCESS, 0, 10);
+#endif
+}
+} // namespace
+
+void FormatTrialLog(std::FILE* out, const TrialLogRecord& record)
+{
+    switch (record.event)
+    {
+    case TrialLogEvent::TrialWaiting:
+        std::fprintf(out, "Trial %d/%d: waiting %.3f s\n", record.trial, record.trialCount, record.values[0]);
+        break;
+    case TrialLogEvent::Reaction:
+        std::fprintf(out, "  Reaction: %.3f ms (onset overshoot %.1f us)\n", record.values[0], record.values[1] * 1000.0);
+        break;
+    case TrialLogEvent::FalseStart:
+        std::fprintf(out, "  False start: input before stimulus.\n");
+        break;
+    case TrialLogEvent::BlockStart:
+        std::fprintf(out, "Block %s (%d/%d): %d trials, delay %.3f-%.3f s, after %.1f s rest\n",
+            record.label,
+            record.trial,
+            record.trialCount,
+            record.count,
+            record.values[0],
+            record.values[1],
+            record.values[2]);
+        break;
+    }
+}
+
+TrialLog::~TrialLog()
+{
+    Close();
+}
+
+void TrialLog::Open(std::FILE* out)
+{
+    Close();
+    out_ = out;
+    ring_ = std::make_unique<Ring>();
+    stopping_.store(false, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    open_ = true;
+    writer_ = std::thread([this] { WriterMain(); });
+}
+
+bool TrialLog::Publish(const TrialLogRecord& record)
+{
+    // No wakeup: notifying a sleeping thread is a system call, and the writer polls often enough for a console.
+    if (!open_ || !ring_->TryPush(record))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void TrialLog::Close()
+{
+    if (!open_)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_.store(true, std::memory_order_release);
+    }
+    wake_.notify_one();
+    writer_.join();
+
+    const unsigned long long dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        std::fprintf(out_, "(%llu log messages dropped: console too slow)\n", dropped);
+    }
+    std::fflush(out_);
+    out_ = nullptr;
+    open_ = false;
+    ring_.reset();
+}
+
+void TrialLog::WriterMain()
+{
+    LowerCurrentThreadPriority();
+    for (;;)
+    {
+        const bool stopping = stopping_.load(std::memory_order_acquire);
+        const size_t written = DrainRing(*ring_, [this](const TrialLogRecord& record) { FormatTrialLog(out_, record); });
+        if (written > 0)
+        {
+            std::fflush(out_);
+        }
+        if (stopping)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wake_.wait_for(lock, std::chrono::milliseconds(2), [this] { return stopping_.load(std::memory_order_relaxed); });
+    }
+}
+} // namespace purple
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "core/spsc_ring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace purple
+{
+enum class TrialLogEvent : std::uint32_t
+{
+    TrialWaiting,  // trial/trialCount, values[0] = delay in seconds
+    Reaction,      // values[0] = reaction ms, values[1] = onset overshoot ms
+    FalseStart,
+    BlockStart     // trial = block number, trialCount = block count, count = block trials, label = block id,
+                   // values = min delay, max delay, preceding rest (seconds)
+};
+
+// One console message of the trial loop as raw values; the text is produced on the log thread.
+struct TrialLogRecord
+{
+    TrialLogEvent event = TrialLogEvent::TrialWaiting;
+    std::int32_t trial = 0;
+    std::int32_t trialCount = 0;
+    std::int32_t count = 0;
+    double values[3] = {};
+    // Static or owned by the run's SessionConfig (block ids); read when the record is formatted.
+    const char* label = nullptr;
+};
+static_assert(sizeof(TrialLogRecord) <= 64, "trial log records fit one cache line");
+
+// Writes the record's console line(s) to `out`.
+void FormatTrialLog(std::FILE* out, const TrialLogRecord& record);
+
+// Per-trial console log (Session::log). Publish copies a fixed-size record into a lock-free SPSC ring and
+// never blocks, formats or writes: a lower-priority thread drains the ring every few milliseconds and does
+// the printf. If the console stalls long enough for the ring to fill, messages are dropped and counted.
+class TrialLog
+{
+public:
+    using Ring = SpscRing<TrialLogRecord, 1024>;
+
+    TrialLog() = default;
+    ~TrialLog();
+
+    TrialLog(const TrialLog&) = delete;
+    TrialLog& operator=(const TrialLog&) = delete;
+
+    // Starts the log thread writing to `out` (not closed by the log).
+    void Open(std::FILE* out = stdout);
+    bool IsOpen() const { return open_; }
+
+    bool Publish(const TrialLogRecord& record);
+    unsigned long long Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Writes everything still queued (and a note if messages were dropped), then stops the log thread.
+    // Call before printing anything else, so the run's messages come first.
+    void Close();
+
+private:
+    void WriterMain();
+
+    std::unique_ptr<Ring> ring_;
+    bool open_ = false;
+    std::FILE* out_ = nullptr;
+    std::thread writer_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<unsigned long long> dropped_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+};
+} // namespace purple
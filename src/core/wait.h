@@ -0,0 +1,105 @@
+#pragma once
+
+#include "core/clock.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace purple
+{
+struct WaitConfig
+{
+    // Upper bound on busy-waiting before each stimulus; the calibrated spin lead never exceeds it.
+    double spinBudgetSeconds = 0.0005;
+    // Longest single coarse sleep, so the session loop still pumps input (false starts) during the foreperiod.
+    double pollIntervalSeconds = 0.002;
+};
+
+inline void CpuRelax()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Two-phase deadline wait: coarse high-resolution timer sleeps until a calibrated lead before the
+// deadline, then a short spin. Clock policies provide SleepUntil(Ticks) for the coarse phase.
+template <typename Clock>
+class ForeperiodWaiter
+{
+public:
+    ForeperiodWaiter(Clock& clock, const WaitConfig& config)
+        : clock_(clock),
+          spinBudgetTicks_(SecondsToTicks(config.spinBudgetSeconds, clock.Frequency())),
+          pollTicks_(std::max<Ticks>(1, SecondsToTicks(config.pollIntervalSeconds, clock.Frequency()))),
+          spinLeadTicks_(spinBudgetTicks_)
+    {
+    }
+
+    // Measures how late coarse sleeps wake on this machine and sizes the spin lead to cover the p99.
+    void Calibrate(int samples = 64)
+    {
+        std::vector<Ticks> lateness;
+        lateness.reserve(static_cast<size_t>(samples));
+        const Ticks sleepTicks = std::max<Ticks>(1, clock_.Frequency() / 2000);
+        for (int i = 0; i < samples; ++i)
+        {
+            const Ticks wake = clock_.Now() + sleepTicks;
+            clock_.SleepUntil(wake);
+            lateness.push_back(std::max<Ticks>(0, clock_.Now() - wake));
+        }
+        if (lateness.empty())
+        {
+            return;
+        }
+
+        const size_t p99 = (lateness.size() * 99) / 100;
+        std::nth_element(lateness.begin(), lateness.begin() + p99, lateness.end());
+        const Ticks margin = clock_.Frequency() / 20000;
+        spinLeadTicks_ = std::min(spinBudgetTicks_, lateness[p99] + margin);
+    }
+
+    // One step of the wait. Returns false after a coarse sleep (caller should pump input and call again),
+    // true once the deadline has been reached by spinning; LastOvershootTicks() then holds the lateness.
+    bool WaitStep(Ticks deadline)
+    {
+        Ticks now = clock_.Now();
+        const Ticks spinStart = deadline - spinLeadTicks_;
+        if (now < spinStart)
+        {
+            const Ticks wake = std::min(spinStart, now + pollTicks_);
+            clock_.SleepUntil(wake);
+
+            // Grow the lead when a coarse wake runs past it, bounded by the spin budget.
+            const Ticks late = clock_.Now() - wake;
+            if (late > spinLeadTicks_)
+            {
+                spinLeadTicks_ = std::min(spinBudgetTicks_, late);
+            }
+            return false;
+        }
+
+        while (now < deadline)
+        {
+            CpuRelax();
+            now = clock_.Now();
+        }
+        lastOvershootTicks_ = now - deadline;
+        return true;
+    }
+
+    Ticks LastOvershootTicks() const { return lastOvershootTicks_; }
+    Ticks SpinLeadTicks() const { return spinLeadTicks_; }
+
+private:
+    Clock& clock_;
+    Ticks spinBudgetTicks_;
+    Ticks pollTicks_;
+    Ticks spinLeadTicks_;
+    Ticks lastOvershootTicks_ = 0;
+};
+} // namespace purple
@@ -0,0 +1,718 @@
+#include "core/columnar.h"
+#include "core/device.h"
+#include "core/export.h"
+#include "core/foreperiod.h"
+#include "core/headless.h"
+#include "core/journal.h"
+#include "core/parse.h"
+#include "core/plan.h"
+#include "core/realtime.h"
+#include "core/server.h"
+#include "core/session.h"
+#include "core/telemetry.h"
+#include "core/trace.h"
+#include "core/trial_log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+struct HeadlessOptions
+{
+    purple::SessionConfig config;
+    double respondMs = 200.0;
+    std::vector<double> deviceLagMs;  // --device-lag-ms: one synthetic device per entry, used in turn
+    std::string jsonOutputPath;
+    bool jsonDistribution = false;  // --json-distribution
+    purple::DistributionOptions distribution;
+    std::string csvOutputPath;
+    std::string binaryOutputPath;
+    std::string streamOutputPath;
+    std::string serveEndpoint;
+    std::string planPath;
+    std::string foreperiodListPath;
+    std::string tracePath;
+    std::string journalPath;
+    std::string telemetryName;
+    bool simulateVsync = false;
+    purple::VsyncModel vsync;
+    bool scanoutOnset = true;  // with simulateVsync; false keeps the Present midpoint
+    purple::RealtimeConfig realtime;
+};
+
+enum class ArgParseResult
+{
+    Ok,
+    ExitRequested,
+    Error
+};
+
+// Presses a fixed latency after the stimulus appears, like an ideal participant. Under simulated vsync
+// that is the true scanout time, so measured reactions show the onset estimate's bias. With device lags,
+// trial i presses on synthetic device i % n + 1 (handle), that much later.
+class ScriptedResponder
+{
+public:
+    ScriptedResponder(purple::MonotonicClock& clock, double respondMs, const std::vector<double>& deviceLagMs = {})
+        : clock_(clock),
+          latencyTicks_(MillisecondsToTicks(clock, respondMs))
+    {
+        for (const double lagMs : deviceLagMs)
+        {
+            deviceLagTicks_.push_back(MillisecondsToTicks(clock, lagMs));
+        }
+    }
+
+    void Follow(const purple::SimulatedVsyncDisplay* display) { display_ = display; }
+
+    void Pump(purple::Session& session)
+    {
+        if (session.phase == purple::Phase::WaitingForResponse && !session.hasInput)
+        {
+            const purple::Ticks shown = display_ != nullptr ? display_->LastScanoutTicks() : session.stimulusMidpointTicks;
+            const size_t device = deviceLagTicks_.empty() ? 0 : static_cast<size_t>(session.trialIndex) % deviceLagTicks_.size();
+            const purple::Ticks due = shown + latencyTicks_ + (deviceLagTicks_.empty() ? 0 : deviceLagTicks_[device]);
+            if (clock_.Now() >= due)
+            {
+                injected_.InjectPress(due, deviceLagTicks_.empty() ? 0 : device + 1);
+            }
+        }
+        injected_.Pump(session);
+    }
+
+private:
+    static purple::Ticks MillisecondsToTicks(const purple::MonotonicClock& clock, double ms)
+    {
+        return static_cast<purple::Ticks>(ms * static_cast<double>(clock.Frequency()) / 1000.0);
+    }
+
+    purple::MonotonicClock& clock_;
+    purple::Ticks latencyTicks_;
+    std::vector<purple::Ticks> deviceLagTicks_;
+    const purple::SimulatedVsyncDisplay* display_ = nullptr;
+    purple::InjectedInput injected_;
+};
+
+// Runs one session on the display and onset provider selected by the options.
+template <typename Input>
+purple::SessionOutcome RunOnDisplay(
+    const HeadlessOptions& options,
+    purple::Session& session,
+    purple::MonotonicClock& clock,
+    ScriptedResponder& responder,
+    Input& input)
+{
+    if (!options.simulateVsync)
+    {
+        purple::NullDisplay display;
+        responder.Follow(nullptr);
+        return purple::RunTrialLoop(session, clock, display, input);
+    }
+
+    purple::SimulatedVsyncDisplay display(clock, options.vsync);
+    responder.Follow(&display);
+    if (!options.scanoutOnset)
+    {
+        return purple::RunTrialLoop(session, clock, display, input);
+    }
+    purple::FrameStatisticsOnset<purple::SimulatedVsyncDisplay> onset(display, clock.Frequency() / 10);
+    return purple::RunTrialLoop(session, clock, display, input, onset);
+}
+
+// RunOnDisplay under the --rt-profile, with the per-trial console messages queued to a log thread instead
+// of printed in the loop. `realtime` receives the settings the run got.
+template <typename Input>
+purple::SessionOutcome RunSession(
+    const HeadlessOptions& options,
+    purple::Session& session,
+    purple::MonotonicClock& clock,
+    ScriptedResponder& responder,
+    Input& input,
+    purple::RealtimeReport& realtime)
+{
+    purple::TrialLog log;
+    if (session.config.logTrials)
+    {
+        log.Open();
+        session.log = &log;
+    }
+    // Entered after the log thread starts: threads created later would inherit the pinning and SCHED_FIFO.
+    purple::RealtimeScope scope;
+    scope.Enter(options.realtime);
+    const purple::SessionOutcome outcome = RunOnDisplay(options, session, clock, responder, input);
+    scope.Leave();
+    realtime = scope.Report();
+    session.log = nullptr;
+    log.Close();
+    return outcome;
+}
+
+// Synthetic ids for the devices of a --device-lag-ms run (handle n is "synthetic:n"); none otherwise, so
+// plain runs export without a device column.
+std::vector<purple::InputDevice> DescribeDevices(const HeadlessOptions& options, const purple::Session& session)
+{
+    if (options.deviceLagMs.empty())
+    {
+        return {};
+    }
+    std::vector<purple::InputDevice> devices = session.devices;
+    for (purple::InputDevice& device : devices)
+    {
+        purple::DescribeSyntheticDevice(device, static_cast<int>(device.handle));
+    }
+    purple::AssignDeviceIds(devices);
+    return devices;
+}
+
+void PrintUsage()
+{
+    std::printf("Usage:\n");
+    std::printf("  purple_headless [--min-delay seconds] [--max-delay seconds] [--trials count]\n");
+    std::printf("                  [--respond-ms ms] [--device-lag-ms list] [--spin-us microseconds] [--quiet]\n");
+    std::printf("                  [--json-out path] [--json-distribution] [--csv-out path] [--bin-out path]\n");
+    std::printf("                  [--stream-out path|-] [--serve socket-path] [--plan path]\n");
+    std::printf("                  [--vsync-hz hz] [--vsync-phase-ms ms] [--queue-depth frames] [--onset midpoint|scanout]\n");
+    std::printf("                  [--trial-timing] [--trace path] [--journal path] [--telemetry name]\n");
+    std::printf("                  [--seed n] [--foreperiod uniform|exponential|geometric] [--foreperiod-mean seconds]\n");
+    std::printf("                  [--foreperiod-step seconds] [--foreperiod-list path]\n");
+    std::printf("                  [--rt-profile none|standard|isolated] [--timing-cpus list]\n");
+    std::printf("                  [--stop-ci-ms ms] [--stop-statistic mean|median] [--min-trials n]\n");
+    std::printf("Defaults: --min-delay 2.0 --max-delay 5.0 --trials 10 --respond-ms 200 --spin-us 500 --rt-profile standard\n");
+    std::printf("          --foreperiod uniform, a fresh seed per run; --foreperiod-mean (max - min) / 4, --foreperiod-step 0.1\n");
+    std::printf("          no --stop-ci-ms (every trial runs); with it: --stop-statistic mean --min-trials 20, --trials is the maximum\n");
+    std::printf("          no vsync (instant presents); with --vsync-hz: --vsync-phase-ms 0 --queue-depth 1 --onset scanout\n");
+}
+
+ArgParseResult ParseArgs(int argc, char** argv, HeadlessOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--min-delay") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.config.minDelaySeconds))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--max-delay") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.config.maxDelaySeconds))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--trials") == 0)
+        {
+            if (!hasValue || !purple::TryParseIntNarrow(argv[++i], options.config.trialCount))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--respond-ms") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.respondMs) || options.respondMs < 0.0)
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--device-lag-ms") == 0)
+        {
+            if (!hasValue || !purple::ParseDeviceLagList(argv[++i], options.deviceLagMs))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--spin-us") == 0)
+        {
+            double spinUs = 0.0;
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], spinUs) || spinUs < 0.0 || spinUs > 100000.0)
+            {
+                return ArgParseResult::Error;
+            }
+            options.config.wait.spinBudgetSeconds = spinUs / 1000000.0;
+        }
+        else if (std::strcmp(arg, "--quiet") == 0)
+        {
+            options.config.logTrials = false;
+        }
+        else if (std::strcmp(arg, "--trial-timing") == 0)
+        {
+            options.config.recordTiming = true;
+        }
+        else if (std::strcmp(arg, "--json-out") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.jsonOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--json-distribution") == 0)
+        {
+            options.jsonDistribution = true;
+        }
+        else if (std::strcmp(arg, "--csv-out") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.csvOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--bin-out") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.binaryOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--stream-out") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.streamOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--serve") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.serveEndpoint = argv[++i];
+        }
+        else if (std::strcmp(arg, "--trace") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.tracePath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--journal") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.journalPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--telemetry") == 0)
+        {
+            if (!hasValue || !purple::IsValidTelemetryName(argv[i + 1]))
+            {
+                return ArgParseResult::Error;
+            }
+            options.telemetryName = argv[++i];
+        }
+        else if (std::strcmp(arg, "--rt-profile") == 0)
+        {
+            if (!hasValue || !purple::ParseRealtimeProfile(argv[++i], options.realtime.profile))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--timing-cpus") == 0)
+        {
+            if (!hasValue || !purple::ParseCpuList(argv[++i], options.realtime.timingCpus))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--seed") == 0)
+        {
+            if (!hasValue || !purple::TryParseSeed(argv[++i], options.config.foreperiod.seed))
+            {
+                return ArgParseResult::Error;
+            }
+            options.config.foreperiod.seeded = true;
+        }
+        else if (std::strcmp(arg, "--foreperiod") == 0)
+        {
+            if (!hasValue || !purple::ParseForeperiodDistribution(argv[++i], options.config.foreperiod.distribution))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--foreperiod-mean") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.config.foreperiod.meanSeconds) ||
+                !(options.config.foreperiod.meanSeconds > 0.0))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--foreperiod-step") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.config.foreperiod.stepSeconds) ||
+                !(options.config.foreperiod.stepSeconds > 0.0))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--stop-ci-ms") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.config.stopping.halfWidthMs) ||
+                !(options.config.stopping.halfWidthMs > 0.0))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--stop-statistic") == 0)
+        {
+            if (!hasValue || !purple::ParsePrecisionStatistic(argv[++i], options.config.stopping.statistic))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--min-trials") == 0)
+        {
+            if (!hasValue || !purple::TryParseIntNarrow(argv[++i], options.config.stopping.minValidTrials) ||
+                options.config.stopping.minValidTrials < 2)
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--foreperiod-list") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.foreperiodListPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--plan") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            options.planPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--vsync-hz") == 0)
+        {
+            double hz = 0.0;
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], hz) || hz < 1.0 || hz > 1000.0)
+            {
+                return ArgParseResult::Error;
+            }
+            options.simulateVsync = true;
+            options.vsync.refreshHz = hz;
+        }
+        else if (std::strcmp(arg, "--vsync-phase-ms") == 0)
+        {
+            if (!hasValue || !purple::TryParseDoubleNarrow(argv[++i], options.vsync.phaseMs))
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--queue-depth") == 0)
+        {
+            if (!hasValue || !purple::TryParseIntNarrow(argv[++i], options.vsync.queueDepth) || options.vsync.queueDepth > 8)
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--onset") == 0)
+        {
+            if (!hasValue)
+            {
+                return ArgParseResult::Error;
+            }
+            const char* value = argv[++i];
+            if (std::strcmp(value, "scanout") == 0)
+            {
+                options.scanoutOnset = true;
+            }
+            else if (std::strcmp(value, "midpoint") == 0)
+            {
+                options.scanoutOnset = false;
+            }
+            else
+            {
+                return ArgParseResult::Error;
+            }
+        }
+        else if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0)
+        {
+            return ArgParseResult::ExitRequested;
+        }
+        else
+        {
+            return ArgParseResult::Error;
+        }
+    }
+
+    const purple::SessionConfig& config = options.config;
+    if (config.minDelaySeconds <= 0.0 || config.maxDelaySeconds <= 0.0 || config.minDelaySeconds >= config.maxDelaySeconds)
+    {
+        return ArgParseResult::Error;
+    }
+    return ArgParseResult::Ok;
+}
+// Attaches a trace writer for the run-th run when --trace is set; false when the file cannot be created.
+bool OpenTrace(const HeadlessOptions& options, int run, purple::TraceWriter& trace, purple::Session& session)
+{
+    session.trace = nullptr;
+    if (options.tracePath.empty())
+    {
+        return true;
+    }
+    const std::string path = purple::NumberedTracePath(options.tracePath, run);
+    if (!trace.Open(path))
+    {
+        std::printf("Failed to open trace path: %s\n", path.c_str());
+        return false;
+    }
+    session.trace = &trace;
+    return true;
+}
+
+// Detaches and closes the run's trace after appending its devices and realtime report; false when a write
+// failed.
+bool CloseTrace(purple::TraceWriter& trace, purple::Session& session, const std::vector<purple::InputDevice>& devices,
+    const purple::RealtimeReport& realtime)
+{
+    if (session.trace == nullptr)
+    {
+        return true;
+    }
+    session.trace = nullptr;
+    trace.AppendRunMetadata(devices, realtime);
+    if (!trace.Close())
+    {
+        std::printf("Warning: trace file incomplete (write failed).\n");
+        return false;
+    }
+    return true;
+}
+
+// Attaches a journal for the run-th run when --journal is set. An interrupted journal already at the path
+// is moved aside first; false when that or creating the new file fails.
+bool OpenJournal(const HeadlessOptions& options, int run, purple::Ticks frequency, purple::TrialJournal& journal, purple::Session& session)
+{
+    session.journal = nullptr;
+    if (options.journalPath.empty())
+    {
+        return true;
+    }
+    const std::string path = purple::NumberedTracePath(options.journalPath, run);
+    if (!purple::PreserveInterruptedJournal(path) || !journal.Open(path, session.config, frequency))
+    {
+        return false;
+    }
+    session.journal = &journal;
+    return true;
+}
+
+// Closes the run's journal and reads its trials back into session.results for printing and export;
+// false when the journal could not be flushed or read.
+bool CloseJournal(const HeadlessOptions& options, int run, purple::SessionOutcome outcome, purple::TrialJournal& journal, purple::Session& session)
+{
+    if (session.journal == nullptr)
+    {
+        return true;
+    }
+    session.journal = nullptr;
+    bool ok = journal.Close(outcome);
+    if (!ok)
+    {
+        std::printf("Warning: journal may be incomplete (flush failed).\n");
+    }
+    purple::JournalContents contents;
+    if (purple::LoadJournal(purple::NumberedTracePath(options.journalPath, run), contents))
+    {
+        session.results = std::move(contents.results);
+    }
+    else
+    {
+        ok = false;
+    }
+    return ok;
+}
+
+// Creates the --telemetry block, kept across runs so monitors can stay attached; false when that fails.
+bool OpenTelemetry(const HeadlessOptions& options, purple::TelemetryWriter& telemetry, purple::Session& session)
+{
+    if (options.telemetryName.empty())
+    {
+        return true;
+    }
+    if (!telemetry.Open(options.telemetryName))
+    {
+        std::printf("Failed to create telemetry block: %s\n", options.telemetryName.c_str());
+        return false;
+    }
+    session.telemetry = &telemetry;
+    return true;
+}
+
+// --serve: stays up and runs whatever clients request; the options only supply defaults.
+int Serve(const HeadlessOptions& options)
+{
+    purple::RunServer server(options.config);
+    if (!server.Start(options.serveEndpoint))
+    {
+        std::printf("Failed to listen on %s\n", options.serveEndpoint.c_str());
+        return 2;
+    }
+    std::printf("Serving on %s\n", options.serveEndpoint.c_str());
+    std::fflush(stdout);
+
+    purple::Session session;
+    purple::TelemetryWriter telemetry;
+    if (!OpenTelemetry(options, telemetry, session))
+    {
+        server.Stop();
+        return 2;
+    }
+    purple::MonotonicClock clock;
+    ScriptedResponder responder(clock, options.respondMs, options.deviceLagMs);
+    purple::TraceWriter trace;
+    purple::TrialJournal journal;
+    int runs = 0;
+    while (server.WaitForRun(session))
+    {
+        purple::ResetSessionState(session);
+        OpenTrace(options, ++runs, trace, session);
+        OpenJournal(options, runs, clock.Frequency(), journal, session);
+        purple::ServedInput<ScriptedResponder> input(responder, server);
+        purple::RealtimeReport realtime;
+        const purple::SessionOutcome outcome = RunSession(options, session, clock, responder, input, realtime);
+        const std::vector<purple::InputDevice> devices = DescribeDevices(options, session);
+        CloseTrace(trace, session, devices, realtime);
+        CloseJournal(options, runs, outcome, journal, session);
+        server.FinishRun(session);
+
+        if (outcome == purple::SessionOutcome::Completed)
+        {
+            const purple::StoppingReport stopping = purple::MakeStoppingReport(session);
+            purple::PrintResults(session.results, session.stats, session.config.plan, devices,
+                session.config.stopping.Enabled() ? &stopping : nullptr);
+        }
+        else
+        {
+            std::printf("\nRun aborted.\n");
+        }
+        std::fflush(stdout);
+    }
+
+    server.Stop();
+    return 0;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    HeadlessOptions options;
+    const ArgParseResult argResult = ParseArgs(argc, argv, options);
+    if (argResult != ArgParseResult::Ok)
+    {
+        PrintUsage();
+        return argResult == ArgParseResult::ExitRequested ? 0 : 1;
+    }
+    if (!options.planPath.empty() && !purple::LoadPlanFile(options.planPath, options.config, options.config.plan))
+    {
+        return 1;
+    }
+    if (!options.foreperiodListPath.empty())
+    {
+        if (!purple::LoadForeperiodList(options.foreperiodListPath, options.config.foreperiod.list))
+        {
+            return 1;
+        }
+        options.config.foreperiod.distribution = purple::ForeperiodDistribution::List;
+    }
+
+    if (!options.serveEndpoint.empty())
+    {
+        return Serve(options);
+    }
+
+    purple::Session session;
+    session.config = options.config;
+    purple::ResetSessionState(session);
+
+    purple::EventStream stream;
+    if (!options.streamOutputPath.empty())
+    {
+        if (!stream.Open(options.streamOutputPath))
+        {
+            std::printf("Failed to open stream path: %s\n", options.streamOutputPath.c_str());
+            return 2;
+        }
+        session.stream = &stream;
+    }
+    // Keep stdout pure NDJSON when it carries the stream.
+    const bool streamToStdout = stream.WritesToStdout();
+    if (streamToStdout)
+    {
+        session.config.logTrials = false;
+    }
+
+    purple::TraceWriter trace;
+    if (!OpenTrace(options, 1, trace, session))
+    {
+        return 2;
+    }
+    purple::TelemetryWriter telemetry;
+    if (!OpenTelemetry(options, telemetry, session))
+    {
+        return 2;
+    }
+
+    purple::MonotonicClock clock;
+    ScriptedResponder input(clock, options.respondMs, options.deviceLagMs);
+
+    purple::TrialJournal journal;
+    if (!OpenJournal(options, 1, clock.Frequency(), journal, session))
+    {
+        return 2;
+    }
+
+    purple::RealtimeReport realtime;
+    const purple::SessionOutcome outcome = RunSession(options, session, clock, input, input, realtime);
+    stream.Close();
+    const std::vector<purple::InputDevice> devices = DescribeDevices(options, session);
+    const bool traceWritten = CloseTrace(trace, session, devices, realtime);
+    const bool journalWritten = CloseJournal(options, 1, outcome, journal, session);
+    if (stream.Dropped() > 0)
+    {
+        std::fprintf(stderr, "Warning: %llu stream events dropped (consumer too slow).\n", stream.Dropped());
+    }
+    if (outcome != purple::SessionOutcome::Completed)
+    {
+        return outcome == purple::SessionOutcome::Aborted ? 3 : 4;
+    }
+
+    const purple::StoppingReport stoppingReport = purple::MakeStoppingReport(session);
+    const purple::StoppingReport* stopping = session.config.stopping.Enabled() ? &stoppingReport : nullptr;
+    if (!streamToStdout)
+    {
+        purple::PrintResults(session.results, session.stats, session.config.plan, devices, stopping);
+    }
+
+    bool exported = true;
+    const purple::ExportMetadata metadata{&session.config.foreperiod, &realtime, &devices, stopping,
+        options.jsonDistribution ? &options.distribution : nullptr};
+    if (!options.csvOutputPath.empty() || !options.jsonOutputPath.empty())
+    {
+        exported = purple::ExportResults(session.results, session.stats, options.csvOutputPath, options.jsonOutputPath,
+            session.config.plan, metadata);
+    }
+    if (!options.binaryOutputPath.empty())
+    {
+        exported = purple::ExportResultsColumnar(session.results, session.config, clock.Frequency(), options.binaryOutputPath,
+            metadata) && exported;
+    }
+    return exported && traceWritten && journalWritten ? 0 : 2;
+}
@@ -4,14 +4,31 @@
 #include <shellapi.h>
 #include <wrl/client.h>
 
+#include "core/columnar.h"
+#include "core/device.h"
+#include "core/export.h"
+#include "core/foreperiod.h"
+#include "core/input.h"
+#include "core/journal.h"
+#include "core/parse.h"
+#include "core/plan.h"
+#include "core/polling.h"
+#include "core/realtime.h"
+#include "core/server.h"
+#include "core/session.h"
+#include "core/telemetry.h"
+#include "core/trace.h"
+#include "core/trial_log.h"
+
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cwchar>
-#include <fstream>
-#include <iomanip>
+#include <future>
 #include <iostream>
-#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #pragma comment(lib, "d3d11.lib")
@@ -21,28 +38,6 @@ using Microsoft::WRL::ComPtr;
 
 namespace
 {
-struct TrialResult
-{
-    double delaySeconds = 0.0;
-    double reactionMs = 0.0;
-    bool falseStart = false;
-};
-
-enum class Phase
-{
-    BeginTrial,
-    WaitingForStimulus,
-    WaitingForResponse,
-    Finished
-};
-
-enum class SessionOutcome
-{
-    Completed,
-    Aborted,
-    QuitRequested
-};
-
 enum class ArgParseResult
 {
     Ok,
@@ -50,6 +45,24 @@ enum class ArgParseResult
     Error
 };
 
+// Raw Input is received on a dedicated thread with its own message-only window, so every press is
+// stamped when it arrives rather than whenever the session loop next pumps messages (e.g. after a
+// blocking Present). Events reach the session loop through a lock-free SPSC ring.
+struct InputCapture
+{
+    HWND hwnd = nullptr;
+    std::thread thread;
+    std::atomic<bool> capturing{false};
+    std::atomic<unsigned long long> dropped{0};
+    purple::InputRing ring;
+    // --poll-analyze: while set, every raw report goes to `reports` instead of the trial ring.
+    std::atomic<bool> analyzing{false};
+    std::atomic<unsigned long long> reportsDropped{0};
+    purple::ReportRing reports;
+    purple::RealtimeConfig realtime;  // set before the thread starts
+    purple::InputThreadRealtime applied;  // what the profile applied to the thread
+};
+
 struct App
 {
     HWND hwnd = nullptr;
@@ -62,33 +75,44 @@ struct App
     ComPtr<ID3D11RenderTargetView> rtv;
 
     LARGE_INTEGER qpcFreq{};
+    HANDLE waitTimer = nullptr;
+    LONGLONG refreshPeriodQpc = 0;
 
-    int trialCount = 10;
-    double minDelaySeconds = 2.0;
-    double maxDelaySeconds = 5.0;
     bool runOnceNoPrompt = false;
+    bool scanoutOnset = true;  // --onset scanout (default) vs midpoint
     std::string jsonOutputPath;
+    bool jsonDistribution = false;  // --json-distribution
+    purple::DistributionOptions distribution;
     std::string csvOutputPath;
+    std::string binaryOutputPath;
+    std::string streamOutputPath;
+    std::string planPath;
+    std::string tracePath;
+    int traceRuns = 0;
+    std::string journalPath;
+    int journalRuns = 0;
+    std::string foreperiodListPath;
+    double pollAnalyzeSeconds = 0.0;  // --poll-analyze window; 0 runs the test instead
+    std::string pollOutputPath;
+    std::string telemetryName;
+    purple::RealtimeConfig realtime;
+    purple::RealtimeScope realtimeScope;
+    purple::RealtimeReport realtimeReport;  // settings of the last run
+    purple::StoppingReport stoppingReport;  // how the last run ended (with --stop-ci-ms)
+    std::string serveEndpoint;
+    purple::RunServer* server = nullptr;
 
-    int trialIndex = 0;
-    Phase phase = Phase::BeginTrial;
-    bool hasInput = false;
-    bool inputWasFalseStart = false;
-    bool escapePressed = false;
     bool quitRequested = false;
 
-    LONGLONG trialStartQpc = 0;
-    LONGLONG stimulusQpc = 0;
-    LONGLONG inputQpc = 0;
-    double scheduledDelaySeconds = 0.0;
-
-    std::mt19937 rng{std::random_device{}()};
-    std::uniform_real_distribution<double> delayDist{2.0, 5.0};
-    std::vector<TrialResult> results;
+    InputCapture input;
+    purple::EventStream stream;
+    purple::TraceWriter trace;
+    purple::TrialJournal journal;
+    purple::TrialLog log;
+    purple::TelemetryWriter telemetry;
+    purple::Session session;
 };
 
-double ComputeAverageReactionMs(const App& app);
-
 LONGLONG QpcNow()
 {
     LARGE_INTEGER value{};
@@ -96,16 +120,6 @@ LONGLONG QpcNow()
     return value.QuadPart;
 }
 
-double QpcDeltaToMilliseconds(LONGLONG delta, LONGLONG freq)
-{
-    return static_cast<double>(delta) * 1000.0 / static_cast<double>(freq);
-}
-
-double QpcDeltaToSeconds(LONGLONG delta, LONGLONG freq)
-{
-    return static_cast<double>(delta) / static_cast<double>(freq);
-}
-
 void PrintLastErrorAndExit(const char* message)
 {
     std::fprintf(stderr, "%s (GetLastError=%lu)\n", message, GetLastError());
@@ -126,84 +140,155 @@ void PresentSolidColor(App& app, float gray)
     app.swapChain->Present(1, 0);
 }
 
-void RecordRawInputPress(App& app)
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    App* app = reinterpret_cast<App*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+
+    switch (msg)
+    {
+    case WM_CLOSE:
+        if (app)
+        {
+            app->quitRequested = true;
+        }
+        DestroyWindow(hwnd);
+        return 0;
+
+    case WM_DESTROY:
+        if (app)
+        {
+            app->quitRequested = true;
+        }
+        PostQuitMessage(0);
+        return 0;
+    }
+
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+bool DecodeRawInput(HRAWINPUT handle, LONGLONG timestamp, purple::InputEvent& event)
 {
-    if (app.phase == Phase::WaitingForResponse && !app.hasInput)
+    RAWINPUT raw{};
+    UINT size = sizeof(raw);
+    if (GetRawInputData(handle, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1))
+    {
+        return false;
+    }
+
+    event.timestamp = timestamp;
+    event.device = static_cast<std::uint64_t>(reinterpret_cast<ULONG_PTR>(raw.header.hDevice));
+
+    if (raw.header.dwType == RIM_TYPEKEYBOARD)
     {
-        app.inputQpc = QpcNow();
-        app.hasInput = true;
-        app.inputWasFalseStart = false;
+        const RAWKEYBOARD& kb = raw.data.keyboard;
+        const bool isBreak = (kb.Flags & RI_KEY_BREAK) != 0;
+        if (isBreak)
+        {
+            return false;
+        }
+        event.kind = (kb.VKey == VK_ESCAPE) ? purple::InputEventKind::Escape : purple::InputEventKind::Press;
+        return true;
     }
-    else if (app.phase == Phase::WaitingForStimulus && !app.hasInput)
+    if (raw.header.dwType == RIM_TYPEMOUSE)
     {
-        app.inputQpc = QpcNow();
-        app.hasInput = true;
-        app.inputWasFalseStart = true;
+        const USHORT f = raw.data.mouse.usButtonFlags;
+        if ((f & RI_MOUSE_LEFT_BUTTON_DOWN) ||
+            (f & RI_MOUSE_RIGHT_BUTTON_DOWN) ||
+            (f & RI_MOUSE_MIDDLE_BUTTON_DOWN) ||
+            (f & RI_MOUSE_BUTTON_4_DOWN) ||
+            (f & RI_MOUSE_BUTTON_5_DOWN))
+        {
+            event.kind = purple::InputEventKind::Press;
+            return true;
+        }
     }
+    return false;
 }
 
-LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+// Every report of the polling analyzer, movement-only mouse reports and key releases included.
+bool DecodeRawReport(HRAWINPUT handle, LONGLONG timestamp, purple::InputReport& report)
 {
-    App* app = reinterpret_cast<App*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    RAWINPUT raw{};
+    UINT size = sizeof(raw);
+    if (GetRawInputData(handle, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1))
+    {
+        return false;
+    }
 
-    switch (msg)
+    report.timestamp = timestamp;
+    report.device = static_cast<std::uint64_t>(reinterpret_cast<ULONG_PTR>(raw.header.hDevice));
+    if (raw.header.dwType == RIM_TYPEKEYBOARD)
     {
-    case WM_INPUT:
+        const bool isBreak = (raw.data.keyboard.Flags & RI_KEY_BREAK) != 0;
+        report.source = purple::ReportSource::Keyboard;
+        report.key = raw.data.keyboard.VKey;
+        report.down = isBreak ? 0 : 1;
+        report.up = isBreak ? 1 : 0;
+        return true;
+    }
+    if (raw.header.dwType == RIM_TYPEMOUSE)
     {
-        if (!app)
+        static constexpr USHORT kDownFlags[] = {RI_MOUSE_LEFT_BUTTON_DOWN, RI_MOUSE_RIGHT_BUTTON_DOWN,
+            RI_MOUSE_MIDDLE_BUTTON_DOWN, RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_5_DOWN};
+        static constexpr USHORT kUpFlags[] = {RI_MOUSE_LEFT_BUTTON_UP, RI_MOUSE_RIGHT_BUTTON_UP,
+            RI_MOUSE_MIDDLE_BUTTON_UP, RI_MOUSE_BUTTON_4_UP, RI_MOUSE_BUTTON_5_UP};
+        const RAWMOUSE& mouse = raw.data.mouse;
+        report.source = purple::ReportSource::Mouse;
+        for (int button = 0; button < 5; ++button)
         {
-            break;
+            if (mouse.usButtonFlags & kDownFlags[button])
+            {
+                report.down = static_cast<std::uint8_t>(report.down | (1 << button));
+            }
+            if (mouse.usButtonFlags & kUpFlags[button])
+            {
+                report.up = static_cast<std::uint8_t>(report.up | (1 << button));
+            }
         }
+        report.moved = (mouse.lLastX != 0 || mouse.lLastY != 0) ? 1 : 0;
+        return true;
+    }
+    return false;
+}
+
+LRESULT CALLBACK InputWindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    switch (msg)
+    {
+    case WM_INPUT:
+    {
+        // Stamp before anything else; this thread does nothing but wait for input.
+        const LONGLONG timestamp = QpcNow();
 
-        RAWINPUT raw{};
-        UINT size = sizeof(raw);
-        if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1))
+        InputCapture* capture = reinterpret_cast<InputCapture*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+        if (!capture || !capture->capturing.load(std::memory_order_relaxed))
         {
-            break;
+            return 0;
         }
 
-        if (raw.header.dwType == RIM_TYPEKEYBOARD)
+        if (capture->analyzing.load(std::memory_order_relaxed))
         {
-            const RAWKEYBOARD& kb = raw.data.keyboard;
-            const bool isBreak = (kb.Flags & RI_KEY_BREAK) != 0;
-            if (!isBreak)
+            purple::InputReport report{};
+            if (DecodeRawReport(reinterpret_cast<HRAWINPUT>(lParam), timestamp, report) && !capture->reports.TryPush(report))
             {
-                if (kb.VKey == VK_ESCAPE)
-                {
-                    app->escapePressed = true;
-                    return 0;
-                }
-                RecordRawInputPress(*app);
+                capture->reportsDropped.fetch_add(1, std::memory_order_relaxed);
             }
+            return 0;
         }
-        else if (raw.header.dwType == RIM_TYPEMOUSE)
+
+        purple::InputEvent event{};
+        if (DecodeRawInput(reinterpret_cast<HRAWINPUT>(lParam), timestamp, event) && !capture->ring.TryPush(event))
         {
-            const USHORT f = raw.data.mouse.usButtonFlags;
-            if ((f & RI_MOUSE_LEFT_BUTTON_DOWN) ||
-                (f & RI_MOUSE_RIGHT_BUTTON_DOWN) ||
-                (f & RI_MOUSE_MIDDLE_BUTTON_DOWN) ||
-                (f & RI_MOUSE_BUTTON_4_DOWN) ||
-                (f & RI_MOUSE_BUTTON_5_DOWN))
-            {
-                RecordRawInputPress(*app);
-            }
+            capture->dropped.fetch_add(1, std::memory_order_relaxed);
         }
         return 0;
     }
 
     case WM_CLOSE:
-        if (app)
-        {
-            app->quitRequested = true;
-        }
         DestroyWindow(hwnd);
         return 0;
 
     case WM_DESTROY:
-        if (app)
-        {
-            app->quitRequested = true;
-        }
         PostQuitMessage(0);
         return 0;
     }
@@ -237,14 +322,15 @@ void RegisterRawInput(HWND hwnd)
 {
     RAWINPUTDEVICE devices[2]{};
 
+    // The capture window is message-only and never foreground, so it needs INPUTSINK to receive anything.
     devices[0].usUsagePage = 0x01;
     devices[0].usUsage = 0x02;
-    devices[0].dwFlags = 0;
+    devices[0].dwFlags = RIDEV_INPUTSINK;
     devices[0].hwndTarget = hwnd;
 
     devices[1].usUsagePage = 0x01;
     devices[1].usUsage = 0x06;
-    devices[1].dwFlags = 0;
+    devices[1].dwFlags = RIDEV_INPUTSINK;
     devices[1].hwndTarget = hwnd;
 
     if (!RegisterRawInputDevices(devices, 2, sizeof(RAWINPUTDEVICE)))
@@ -291,6 +377,61 @@ HWND CreateWindowForFullscreen(HINSTANCE instance, UINT width, UINT height)
     return hwnd;
 }
 
+void RunInputThread(InputCapture* capture, HINSTANCE instance, std::promise<void>* ready)
+{
+    capture->applied = purple::ApplyInputThreadRealtime(capture->realtime);
+
+    const wchar_t* className = L"PurpleReactionInputClass";
+
+    WNDCLASSEXW wc{};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = InputWindowProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = className;
+
+    if (!RegisterClassExW(&wc))
+    {
+        PrintLastErrorAndExit("RegisterClassExW (input) failed");
+    }
+
+    HWND hwnd = CreateWindowExW(0, className, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, instance, nullptr);
+    if (!hwnd)
+    {
+        PrintLastErrorAndExit("CreateWindowExW (input) failed");
+    }
+    SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(capture));
+    RegisterRawInput(hwnd);
+
+    capture->hwnd = hwnd;
+    ready->set_value();
+
+    MSG msg{};
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0)
+    {
+        DispatchMessageW(&msg);
+    }
+}
+
+void StartInputCapture(App& app, HINSTANCE instance)
+{
+    std::promise<void> ready;
+    std::future<void> started = ready.get_future();
+    app.input.thread = std::thread(RunInputThread, &app.input, instance, &ready);
+    started.wait();
+}
+
+void StopInputCapture(App& app)
+{
+    if (app.input.hwnd)
+    {
+        PostMessageW(app.input.hwnd, WM_CLOSE, 0, 0);
+    }
+    if (app.input.thread.joinable())
+    {
+        app.input.thread.join();
+    }
+}
+
 void InitD3D11(App& app, UINT refreshHz)
 {
     DXGI_SWAP_CHAIN_DESC swapDesc{};
@@ -304,8 +445,9 @@ void InitD3D11(App& app, UINT refreshHz)
     swapDesc.BufferCount = 2;
     swapDesc.OutputWindow = app.hwnd;
     swapDesc.Windowed = TRUE;
-    swapDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-    swapDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+    // Flip model on a borderless window that covers the monitor: DWM hands it an independent flip, so
+    // there is no display mode switch and frame statistics report the vblank of each present.
+    swapDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
 
     UINT flags = D3D11_CREATE_DEVICE_SINGLETHREADED;
 #if defined(_DEBUG)
@@ -394,20 +536,8 @@ void InitD3D11(App& app, UINT refreshHz)
     {
         dxgiDevice->SetMaximumFrameLatency(1);
     }
-}
 
-void SetRealtimePriority(bool enabled)
-{
-    if (enabled)
-    {
-        SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
-        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-    }
-    else
-    {
-        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
-        SetPriorityClass(GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
-    }
+    app.refreshPeriodQpc = app.qpcFreq.QuadPart / static_cast<LONGLONG>(refreshHz);
 }
 
 void EnterFullscreen(App& app)
@@ -416,20 +546,10 @@ void EnterFullscreen(App& app)
     SetForegroundWindow(app.hwnd);
     SetFocus(app.hwnd);
     ShowCursor(FALSE);
-
-    const HRESULT hr = app.swapChain->SetFullscreenState(TRUE, nullptr);
-    if (FAILED(hr))
-    {
-        PrintHResultAndExit("SetFullscreenState(TRUE) failed", hr);
-    }
 }
 
 void LeaveFullscreen(App& app)
 {
-    if (app.swapChain)
-    {
-        app.swapChain->SetFullscreenState(FALSE, nullptr);
-    }
     ShowCursor(TRUE);
     ShowWindow(app.hwnd, SW_HIDE);
 }
@@ -448,196 +568,101 @@ void PumpMessages(App& app)
     }
 }
 
-void PrintResults(const App& app)
+HANDLE CreateWaitTimer()
 {
-    std::printf("\n=== Results ===\n");
-    size_t validCount = 0;
-    size_t falseStartCount = 0;
-    for (size_t i = 0; i < app.results.size(); ++i)
-    {
-        if (app.results[i].falseStart)
-        {
-            std::printf("Trial %zu: delay=%.3f s, FALSE START\n",
-                i + 1,
-                app.results[i].delaySeconds);
-            ++falseStartCount;
-        }
-        else
-        {
-            std::printf("Trial %zu: delay=%.3f s, reaction=%.3f ms\n",
-                i + 1,
-                app.results[i].delaySeconds,
-                app.results[i].reactionMs);
-            ++validCount;
-        }
-    }
-    if (validCount > 0)
+    // High-resolution timers (Windows 10 1803+) wake within tens of microseconds instead of the scheduler tick.
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer)
     {
-        std::printf("Average reaction (valid only): %.3f ms\n", ComputeAverageReactionMs(app));
+        timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
     }
-    std::printf("Valid trials: %zu, false starts: %zu\n", validCount, falseStartCount);
-    std::printf("================\n");
+    return timer;
 }
 
-double ComputeAverageReactionMs(const App& app)
+void SleepUntilQpc(HANDLE timer, LONGLONG deadline, LONGLONG freq)
 {
-    double total = 0.0;
-    size_t validCount = 0;
-    for (const TrialResult& trial : app.results)
+    const LONGLONG remaining = deadline - QpcNow();
+    if (remaining <= 0)
     {
-        if (!trial.falseStart)
-        {
-            total += trial.reactionMs;
-            ++validCount;
-        }
-    }
-    if (validCount == 0)
-    {
-        return 0.0;
+        return;
     }
-    return total / static_cast<double>(validCount);
-}
-
-std::string BuildDefaultCsvPath()
-{
-    SYSTEMTIME localTime{};
-    GetLocalTime(&localTime);
-
-    char fileName[128]{};
-    std::snprintf(
-        fileName,
-        sizeof(fileName),
-        "PurpleReaction_%04u%02u%02u_%02u%02u%02u.csv",
-        static_cast<unsigned>(localTime.wYear),
-        static_cast<unsigned>(localTime.wMonth),
-        static_cast<unsigned>(localTime.wDay),
-        static_cast<unsigned>(localTime.wHour),
-        static_cast<unsigned>(localTime.wMinute),
-        static_cast<unsigned>(localTime.wSecond));
-
-    return std::string(fileName);
-}
-
-bool ExportResultsCsv(const App& app, const std::string& path)
-{
-    if (app.results.empty())
+    if (!timer)
     {
-        std::printf("No results to export.\n");
-        return false;
+        Sleep(1);
+        return;
     }
 
-    std::ofstream out(path, std::ios::trunc);
-    if (!out.is_open())
+    // Negative due time is relative, in 100 ns units.
+    LARGE_INTEGER due{};
+    due.QuadPart = -((remaining * 10000000) / freq);
+    if (due.QuadPart == 0)
     {
-        std::printf("Failed to open CSV path: %s\n", path.c_str());
-        return false;
+        return;
     }
-
-    out << std::fixed << std::setprecision(6);
-    out << "trial,random_delay_seconds,reaction_ms,false_start\n";
-    for (size_t i = 0; i < app.results.size(); ++i)
+    if (SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE))
     {
-        out << (i + 1) << ","
-            << app.results[i].delaySeconds << ",";
-        if (app.results[i].falseStart)
-        {
-            out << ",1\n";
-        }
-        else
-        {
-            out << app.results[i].reactionMs << ",0\n";
-        }
+        WaitForSingleObject(timer, INFINITE);
     }
-    out << "average,," << ComputeAverageReactionMs(app) << ",\n";
+}
 
-    if (!out.good())
-    {
-        std::printf("Failed while writing CSV: %s\n", path.c_str());
-        return false;
-    }
+// Policies that bind the portable trial loop to QPC, D3D11 and the Raw Input capture thread.
+struct QpcClock
+{
+    LONGLONG frequency = 0;
+    HANDLE waitTimer = nullptr;
 
-    std::printf("CSV exported: %s\n", path.c_str());
-    return true;
-}
+    purple::Ticks Now() const { return QpcNow(); }
+    purple::Ticks Frequency() const { return frequency; }
+    void SleepUntil(purple::Ticks deadline) { SleepUntilQpc(waitTimer, deadline, frequency); }
+    void YieldThread() { SwitchToThread(); }
+};
 
-bool ExportResultsJson(const App& app, const std::string& path)
+struct D3D11Display
 {
-    if (app.results.empty())
-    {
-        std::printf("No results to export.\n");
-        return false;
-    }
+    App& app;
 
-    std::ofstream out(path, std::ios::trunc);
-    if (!out.is_open())
-    {
-        std::printf("Failed to open JSON path: %s\n", path.c_str());
-        return false;
-    }
+    void PresentSolidColor(float gray) { ::PresentSolidColor(app, gray); }
 
-    size_t validCount = 0;
-    size_t falseStartCount = 0;
-    for (const TrialResult& trial : app.results)
+    // Frame-statistics source for purple::FrameStatisticsOnset.
+    bool GetFrameStatistics(purple::FrameStatistics& stats) const
     {
-        if (trial.falseStart)
-        {
-            ++falseStartCount;
-        }
-        else
+        DXGI_FRAME_STATISTICS dxgiStats{};
+        if (FAILED(app.swapChain->GetFrameStatistics(&dxgiStats)))
         {
-            ++validCount;
+            // DXGI_ERROR_FRAME_STATISTICS_DISJOINT or not yet available; poll again.
+            return false;
         }
+        stats.presentCount = dxgiStats.PresentCount;
+        stats.presentRefreshCount = dxgiStats.PresentRefreshCount;
+        stats.syncRefreshCount = dxgiStats.SyncRefreshCount;
+        stats.syncTicks = dxgiStats.SyncQPCTime.QuadPart;
+        return true;
     }
 
-    out << std::fixed << std::setprecision(6);
-    out << "{\n";
-    out << "  \"trial_count\": " << app.results.size() << ",\n";
-    out << "  \"valid_count\": " << validCount << ",\n";
-    out << "  \"false_start_count\": " << falseStartCount << ",\n";
-    out << "  \"average_reaction_ms\": ";
-    if (validCount > 0)
-    {
-        out << ComputeAverageReactionMs(app);
-    }
-    else
+    std::uint32_t LastPresentCount() const
     {
-        out << "null";
+        UINT count = 0;
+        app.swapChain->GetLastPresentCount(&count);
+        return count;
     }
-    out << ",\n";
-    out << "  \"trials\": [\n";
-    for (size_t i = 0; i < app.results.size(); ++i)
+
+    purple::Ticks RefreshPeriodTicks() const { return app.refreshPeriodQpc; }
+};
+
+struct Win32Input
+{
+    App& app;
+
+    void Pump(purple::Session& session)
     {
-        const TrialResult& trial = app.results[i];
-        out << "    {\"trial\": " << (i + 1)
-            << ", \"random_delay_seconds\": " << trial.delaySeconds
-            << ", \"reaction_ms\": ";
-        if (trial.falseStart)
-        {
-            out << "null";
-        }
-        else
-        {
-            out << trial.reactionMs;
-        }
-        out << ", \"false_start\": " << (trial.falseStart ? "true" : "false") << "}";
-        if (i + 1 < app.results.size())
+        PumpMessages(app);
+        if (app.quitRequested)
         {
-            out << ",";
+            session.quitRequested = true;
         }
-        out << "\n";
-    }
-    out << "  ]\n";
-    out << "}\n";
-
-    if (!out.good())
-    {
-        std::printf("Failed while writing JSON: %s\n", path.c_str());
-        return false;
+        purple::DrainInputEvents(app.input.ring, session);
     }
-
-    std::printf("JSON exported: %s\n", path.c_str());
-    return true;
-}
+};
 
 std::string WideToUtf8(const wchar_t* value)
 {
@@ -670,6 +695,28 @@ std::string WideToUtf8(const wchar_t* value)
     return result;
 }
 
+// Resolves the Raw Input handles the run's presses came from to their device paths (VID/PID for USB HID)
+// and assigns the ids the exports record. Runs after the run; a device unplugged since reads as "unknown".
+void DescribeRawInputDevices(std::vector<purple::InputDevice>& devices)
+{
+    for (purple::InputDevice& device : devices)
+    {
+        std::string name;
+        const HANDLE handle = reinterpret_cast<HANDLE>(static_cast<ULONG_PTR>(device.handle));
+        UINT chars = 0;
+        if (handle != nullptr && GetRawInputDeviceInfoW(handle, RIDI_DEVICENAME, nullptr, &chars) == 0 && chars > 0)
+        {
+            std::wstring path(chars, L'\0');
+            if (GetRawInputDeviceInfoW(handle, RIDI_DEVICENAME, path.data(), &chars) != static_cast<UINT>(-1))
+            {
+                name = WideToUtf8(path.c_str());
+            }
+        }
+        purple::DescribeInputDevice(device, name);
+    }
+    purple::AssignDeviceIds(devices);
+}
+
 bool TryParseDoubleW(const wchar_t* value, double& out)
 {
     if (!value || *value == L'\0')
@@ -710,52 +757,22 @@ bool TryParseIntW(const wchar_t* value, int& out)
     return true;
 }
 
-bool TryParseIntNarrow(const std::string& value, int& out)
-{
-    if (value.empty())
-    {
-        return false;
-    }
-
-    char* endPtr = nullptr;
-    const long parsed = std::strtol(value.c_str(), &endPtr, 10);
-    if (endPtr == value.c_str() || *endPtr != '\0')
-    {
-        return false;
-    }
-    if (parsed < 1 || parsed > 1000000)
-    {
-        return false;
-    }
-
-    out = static_cast<int>(parsed);
-    return true;
-}
-
-bool TryParseDoubleNarrow(const std::string& value, double& out)
-{
-    if (value.empty())
-    {
-        return false;
-    }
-
-    char* endPtr = nullptr;
-    const double parsed = std::strtod(value.c_str(), &endPtr);
-    if (endPtr == value.c_str() || *endPtr != '\0')
-    {
-        return false;
-    }
-
-    out = parsed;
-    return true;
-}
-
 void PrintUsage()
 {
     std::printf("Usage:\n");
     std::printf("  PurpleReaction.exe [--min-delay seconds] [--max-delay seconds] [--trials count]\n");
-    std::printf("                     [--run-once] [--json-out path] [--csv-out path]\n");
-    std::printf("Defaults: --min-delay 2.0 --max-delay 5.0 --trials 10\n");
+    std::printf("                     [--spin-us microseconds] [--trial-timing]\n");
+    std::printf("                     [--run-once] [--json-out path] [--json-distribution] [--csv-out path] [--bin-out path]\n");
+    std::printf("                     [--stream-out path|-]\n");
+    std::printf("                     [--serve \\\\.\\pipe\\name] [--plan path] [--onset scanout|midpoint] [--trace path]\n");
+    std::printf("                     [--journal path] [--seed n] [--foreperiod uniform|exponential|geometric]\n");
+    std::printf("                     [--foreperiod-mean seconds] [--foreperiod-step seconds] [--foreperiod-list path]\n");
+    std::printf("                     [--rt-profile none|standard|isolated] [--timing-cpus list] [--input-cpus list]\n");
+    std::printf("                     [--stop-ci-ms ms] [--stop-statistic mean|median] [--min-trials n] [--telemetry name]\n");
+    std::printf("  PurpleReaction.exe --poll-analyze seconds [--poll-out path]\n");
+    std::printf("Defaults: --min-delay 2.0 --max-delay 5.0 --trials 10 --spin-us 500 --onset scanout --rt-profile standard\n");
+    std::printf("          --foreperiod uniform, a fresh seed per run; --foreperiod-mean (max - min) / 4, --foreperiod-step 0.1\n");
+    std::printf("          no --stop-ci-ms (every trial runs); with it: --stop-statistic mean --min-trials 20, --trials is the maximum\n");
 }
 
 ArgParseResult ParseArgs(App& app)
@@ -776,7 +793,7 @@ ArgParseResult ParseArgs(App& app)
 
         if (wcscmp(arg, L"--min-delay") == 0)
         {
-            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.minDelaySeconds))
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.session.config.minDelaySeconds))
             {
                 ok = false;
                 break;
@@ -784,7 +801,7 @@ ArgParseResult ParseArgs(App& app)
         }
         else if (wcscmp(arg, L"--max-delay") == 0)
         {
-            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.maxDelaySeconds))
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.session.config.maxDelaySeconds))
             {
                 ok = false;
                 break;
@@ -792,16 +809,30 @@ ArgParseResult ParseArgs(App& app)
         }
         else if (wcscmp(arg, L"--trials") == 0)
         {
-            if (i + 1 >= argc || !TryParseIntW(argv[++i], app.trialCount))
+            if (i + 1 >= argc || !TryParseIntW(argv[++i], app.session.config.trialCount))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--spin-us") == 0)
+        {
+            double spinUs = 0.0;
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], spinUs) || spinUs < 0.0 || spinUs > 100000.0)
             {
                 ok = false;
                 break;
             }
+            app.session.config.wait.spinBudgetSeconds = spinUs / 1000000.0;
         }
         else if (wcscmp(arg, L"--run-once") == 0)
         {
             app.runOnceNoPrompt = true;
         }
+        else if (wcscmp(arg, L"--trial-timing") == 0)
+        {
+            app.session.config.recordTiming = true;
+        }
         else if (wcscmp(arg, L"--json-out") == 0)
         {
             if (i + 1 >= argc)
@@ -816,6 +847,10 @@ ArgParseResult ParseArgs(App& app)
                 break;
             }
         }
+        else if (wcscmp(arg, L"--json-distribution") == 0)
+        {
+            app.jsonDistribution = true;
+        }
         else if (wcscmp(arg, L"--csv-out") == 0)
         {
             if (i + 1 >= argc)
@@ -830,9 +865,255 @@ ArgParseResult ParseArgs(App& app)
                 break;
             }
         }
-        else if (wcscmp(arg, L"--help") == 0 || wcscmp(arg, L"-h") == 0)
+        else if (wcscmp(arg, L"--bin-out") == 0)
         {
-            helpRequested = true;
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.binaryOutputPath = WideToUtf8(argv[++i]);
+            if (app.binaryOutputPath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--stream-out") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.streamOutputPath = WideToUtf8(argv[++i]);
+            if (app.streamOutputPath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--serve") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.serveEndpoint = WideToUtf8(argv[++i]);
+            if (app.serveEndpoint.empty())
+            {
+                ok = false;
+                break;
+            }
+            // Served runs never prompt either; requests arrive over the pipe.
+            app.runOnceNoPrompt = true;
+        }
+        else if (wcscmp(arg, L"--onset") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            const wchar_t* value = argv[++i];
+            if (wcscmp(value, L"scanout") == 0)
+            {
+                app.scanoutOnset = true;
+            }
+            else if (wcscmp(value, L"midpoint") == 0)
+            {
+                app.scanoutOnset = false;
+            }
+            else
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--trace") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.tracePath = WideToUtf8(argv[++i]);
+            if (app.tracePath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--journal") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.journalPath = WideToUtf8(argv[++i]);
+            if (app.journalPath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--rt-profile") == 0)
+        {
+            if (i + 1 >= argc || !purple::ParseRealtimeProfile(WideToUtf8(argv[++i]), app.realtime.profile))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--timing-cpus") == 0)
+        {
+            if (i + 1 >= argc || !purple::ParseCpuList(WideToUtf8(argv[++i]), app.realtime.timingCpus))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--telemetry") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.telemetryName = WideToUtf8(argv[++i]);
+            if (!purple::IsValidTelemetryName(app.telemetryName))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--poll-analyze") == 0)
+        {
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.pollAnalyzeSeconds) || app.pollAnalyzeSeconds <= 0.0 ||
+                app.pollAnalyzeSeconds > 600.0)
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--poll-out") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.pollOutputPath = WideToUtf8(argv[++i]);
+            if (app.pollOutputPath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--input-cpus") == 0)
+        {
+            if (i + 1 >= argc || !purple::ParseCpuList(WideToUtf8(argv[++i]), app.realtime.inputCpus))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--seed") == 0)
+        {
+            if (i + 1 >= argc || !purple::TryParseSeed(WideToUtf8(argv[++i]), app.session.config.foreperiod.seed))
+            {
+                ok = false;
+                break;
+            }
+            app.session.config.foreperiod.seeded = true;
+        }
+        else if (wcscmp(arg, L"--foreperiod") == 0)
+        {
+            if (i + 1 >= argc ||
+                !purple::ParseForeperiodDistribution(WideToUtf8(argv[++i]), app.session.config.foreperiod.distribution))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--stop-ci-ms") == 0)
+        {
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.session.config.stopping.halfWidthMs) ||
+                !(app.session.config.stopping.halfWidthMs > 0.0))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--stop-statistic") == 0)
+        {
+            if (i + 1 >= argc ||
+                !purple::ParsePrecisionStatistic(WideToUtf8(argv[++i]), app.session.config.stopping.statistic))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--min-trials") == 0)
+        {
+            if (i + 1 >= argc || !TryParseIntW(argv[++i], app.session.config.stopping.minValidTrials) ||
+                app.session.config.stopping.minValidTrials < 2)
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--foreperiod-mean") == 0)
+        {
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.session.config.foreperiod.meanSeconds) ||
+                !(app.session.config.foreperiod.meanSeconds > 0.0))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--foreperiod-step") == 0)
+        {
+            if (i + 1 >= argc || !TryParseDoubleW(argv[++i], app.session.config.foreperiod.stepSeconds) ||
+                !(app.session.config.foreperiod.stepSeconds > 0.0))
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--foreperiod-list") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.foreperiodListPath = WideToUtf8(argv[++i]);
+            if (app.foreperiodListPath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--plan") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                ok = false;
+                break;
+            }
+            app.planPath = WideToUtf8(argv[++i]);
+            if (app.planPath.empty())
+            {
+                ok = false;
+                break;
+            }
+        }
+        else if (wcscmp(arg, L"--help") == 0 || wcscmp(arg, L"-h") == 0)
+        {
+            helpRequested = true;
             break;
         }
         else
@@ -848,10 +1129,24 @@ ArgParseResult ParseArgs(App& app)
     {
         return ArgParseResult::ExitRequested;
     }
-    if (!ok || app.minDelaySeconds <= 0.0 || app.maxDelaySeconds <= 0.0 || app.minDelaySeconds >= app.maxDelaySeconds)
+    if (!ok || app.session.config.minDelaySeconds <= 0.0 || app.session.config.maxDelaySeconds <= 0.0 || app.session.config.minDelaySeconds >= app.session.config.maxDelaySeconds)
+    {
+        return ArgParseResult::Error;
+    }
+    // After the flags, so blocks without their own delays inherit --min-delay/--max-delay.
+    if (!app.planPath.empty() &&
+        !purple::LoadPlanFile(app.planPath, app.session.config, app.session.config.plan))
     {
         return ArgParseResult::Error;
     }
+    if (!app.foreperiodListPath.empty())
+    {
+        if (!purple::LoadForeperiodList(app.foreperiodListPath, app.session.config.foreperiod.list))
+        {
+            return ArgParseResult::Error;
+        }
+        app.session.config.foreperiod.distribution = purple::ForeperiodDistribution::List;
+    }
 
     return ArgParseResult::Ok;
 }
@@ -875,7 +1170,7 @@ int PromptChoice(const char* prompt, int minValue, int maxValue)
     {
         const std::string line = ReadLine(prompt);
         int value = 0;
-        if (TryParseIntNarrow(line, value) && value >= minValue && value <= maxValue)
+        if (purple::TryParseIntNarrow(line, value) && value >= minValue && value <= maxValue)
         {
             return value;
         }
@@ -883,9 +1178,17 @@ int PromptChoice(const char* prompt, int minValue, int maxValue)
     }
 }
 
+// Run context for the exports of the last run.
+purple::ExportMetadata RunMetadata(const App& app)
+{
+    return purple::ExportMetadata{&app.session.config.foreperiod, &app.realtimeReport, &app.session.devices,
+        app.session.config.stopping.Enabled() ? &app.stoppingReport : nullptr,
+        app.jsonDistribution ? &app.distribution : nullptr};
+}
+
 void PromptCsvExport(const App& app)
 {
-    if (app.results.empty())
+    if (app.session.results.empty())
     {
         return;
     }
@@ -905,8 +1208,9 @@ void PromptCsvExport(const App& app)
 
         if (choice == 1)
         {
-            const std::string path = BuildDefaultCsvPath();
-            if (ExportResultsCsv(app, path))
+            const std::string path = purple::BuildDefaultCsvPath();
+            if (purple::ExportResultsCsv(app.session.results, app.session.stats, path, app.session.config.plan,
+                    RunMetadata(app)))
             {
                 return;
             }
@@ -919,7 +1223,8 @@ void PromptCsvExport(const App& app)
             std::printf("Path cannot be empty.\n");
             continue;
         }
-        if (ExportResultsCsv(app, path))
+        if (purple::ExportResultsCsv(app.session.results, app.session.stats, path, app.session.config.plan,
+                RunMetadata(app)))
         {
             return;
         }
@@ -932,7 +1237,8 @@ void ShowAboutPage()
     std::printf("Purpose: measure human reaction time with low-latency timing.\n");
     std::printf("Timing: QueryPerformanceCounter for stimulus and input timestamps.\n");
     std::printf("Input: Raw Input API for keyboard/mouse press events.\n");
-    std::printf("Display: DirectX 11 exclusive fullscreen, VSync present.\n");
+    std::printf("Display: DirectX 11 flip model, borderless fullscreen (no mode switch), VSync present.\n");
+    std::printf("Stimulus onset: vblank of the stimulus frame from DXGI frame statistics.\n");
     std::printf("Stimulus: black screen -> white screen only (no animations).\n");
     std::printf("============================\n");
     (void)ReadLine("Press Enter to return to menu...");
@@ -943,9 +1249,15 @@ void ShowSettingsPage(App& app)
     for (;;)
     {
         std::printf("\n=== Settings ===\n");
-        std::printf("1. Min random delay (seconds): %.3f\n", app.minDelaySeconds);
-        std::printf("2. Max random delay (seconds): %.3f\n", app.maxDelaySeconds);
-        std::printf("3. Trial count: %d\n", app.trialCount);
+        if (!app.session.config.plan.empty())
+        {
+            std::printf("Plan: %zu blocks from %s (changing a setting below drops it)\n",
+                app.session.config.plan.size(),
+                app.planPath.c_str());
+        }
+        std::printf("1. Min random delay (seconds): %.3f\n", app.session.config.minDelaySeconds);
+        std::printf("2. Max random delay (seconds): %.3f\n", app.session.config.maxDelaySeconds);
+        std::printf("3. Trial count: %d\n", app.session.config.trialCount);
         std::printf("4. Back\n");
 
         const int choice = PromptChoice("Select option: ", 1, 4);
@@ -958,56 +1270,42 @@ void ShowSettingsPage(App& app)
         {
             const std::string line = ReadLine("New min delay (seconds): ");
             double value = 0.0;
-            if (!TryParseDoubleNarrow(line, value) || value <= 0.0 || value >= app.maxDelaySeconds)
+            if (!purple::TryParseDoubleNarrow(line, value) || value <= 0.0 || value >= app.session.config.maxDelaySeconds)
             {
                 std::printf("Invalid value. Must be > 0 and < current max delay.\n");
                 continue;
             }
-            app.minDelaySeconds = value;
+            app.session.config.minDelaySeconds = value;
         }
         else if (choice == 2)
         {
             const std::string line = ReadLine("New max delay (seconds): ");
             double value = 0.0;
-            if (!TryParseDoubleNarrow(line, value) || value <= app.minDelaySeconds)
+            if (!purple::TryParseDoubleNarrow(line, value) || value <= app.session.config.minDelaySeconds)
             {
                 std::printf("Invalid value. Must be > current min delay.\n");
                 continue;
             }
-            app.maxDelaySeconds = value;
+            app.session.config.maxDelaySeconds = value;
         }
         else if (choice == 3)
         {
             const std::string line = ReadLine("New trial count: ");
             int value = 0;
-            if (!TryParseIntNarrow(line, value))
+            if (!purple::TryParseIntNarrow(line, value))
             {
                 std::printf("Invalid value. Must be a positive integer.\n");
                 continue;
             }
-            app.trialCount = value;
+            app.session.config.trialCount = value;
         }
+        app.session.config.plan.clear();
     }
 }
 
-void ResetSessionState(App& app)
+purple::SessionOutcome RunTestSession(App& app, bool promptForStart)
 {
-    app.results.clear();
-    app.trialIndex = 0;
-    app.phase = Phase::BeginTrial;
-    app.hasInput = false;
-    app.inputWasFalseStart = false;
-    app.escapePressed = false;
-    app.trialStartQpc = 0;
-    app.stimulusQpc = 0;
-    app.inputQpc = 0;
-    app.scheduledDelaySeconds = 0.0;
-    app.delayDist = std::uniform_real_distribution<double>(app.minDelaySeconds, app.maxDelaySeconds);
-}
-
-SessionOutcome RunTestSession(App& app, bool promptForStart)
-{
-    ResetSessionState(app);
+    purple::ResetSessionState(app.session);
 
     std::printf("\n=== Test Run ===\n");
     std::printf("Wait for white screen, then press any key or mouse button as fast as possible.\n");
@@ -1019,128 +1317,117 @@ SessionOutcome RunTestSession(App& app, bool promptForStart)
     }
 
     EnterFullscreen(app);
-    SetRealtimePriority(true);
 
-    SessionOutcome outcome = SessionOutcome::Completed;
-    bool sessionActive = true;
-    while (sessionActive)
+    // Drop anything left over from a previous run, then start queueing presses for this one.
+    purple::DrainRing(app.input.ring, [](const purple::InputEvent&) {});
+    app.input.dropped.store(0, std::memory_order_relaxed);
+    app.input.capturing.store(true, std::memory_order_release);
+
+    if (!app.tracePath.empty())
     {
-        PumpMessages(app);
-        if (app.quitRequested)
+        const std::string path = purple::NumberedTracePath(app.tracePath, ++app.traceRuns);
+        if (app.trace.Open(path))
         {
-            outcome = SessionOutcome::QuitRequested;
-            break;
+            app.session.trace = &app.trace;
         }
-        if (app.escapePressed)
+        else
         {
-            outcome = SessionOutcome::Aborted;
-            break;
+            std::printf("Failed to open trace path: %s (recording disabled for this run)\n", path.c_str());
         }
+    }
 
-        const LONGLONG now = QpcNow();
-
-        switch (app.phase)
+    std::string journalPath;
+    if (!app.journalPath.empty())
+    {
+        journalPath = purple::NumberedTracePath(app.journalPath, ++app.journalRuns);
+        if (purple::PreserveInterruptedJournal(journalPath) &&
+            app.journal.Open(journalPath, app.session.config, app.qpcFreq.QuadPart))
         {
-        case Phase::BeginTrial:
-            app.scheduledDelaySeconds = app.delayDist(app.rng);
-            app.trialStartQpc = now;
-            app.stimulusQpc = 0;
-            app.inputQpc = 0;
-            app.hasInput = false;
-            app.inputWasFalseStart = false;
-
-            PresentSolidColor(app, 0.0f);
-
-            std::printf("Trial %d/%d: waiting %.3f s\n",
-                app.trialIndex + 1,
-                app.trialCount,
-                app.scheduledDelaySeconds);
-
-            app.phase = Phase::WaitingForStimulus;
-            break;
-
-        case Phase::WaitingForStimulus:
+            app.session.journal = &app.journal;
+        }
+        else
         {
-            if (app.hasInput && app.inputWasFalseStart)
-            {
-                app.results.push_back(TrialResult{
-                    app.scheduledDelaySeconds,
-                    0.0,
-                    true
-                    });
-
-                std::printf("  False start: input before stimulus.\n");
-
-                ++app.trialIndex;
-                app.phase = (app.trialIndex >= app.trialCount) ? Phase::Finished : Phase::BeginTrial;
-                break;
-            }
-
-            const double elapsed = QpcDeltaToSeconds(now - app.trialStartQpc, app.qpcFreq.QuadPart);
-            if (elapsed >= app.scheduledDelaySeconds)
-            {
-                const LONGLONG t0 = QpcNow();
-                PresentSolidColor(app, 1.0f);
-                const LONGLONG t1 = QpcNow();
-
-                // Present blocks with VSync; midpoint around this call is used as the displayed stimulus timestamp.
-                app.stimulusQpc = (t0 + t1) / 2;
-                app.phase = Phase::WaitingForResponse;
-            }
-            else
-            {
-                const double remaining = app.scheduledDelaySeconds - elapsed;
-                if (remaining > 0.003)
-                {
-                    Sleep(1);
-                }
-                else
-                {
-                    SwitchToThread();
-                }
-            }
-            break;
+            std::printf("Journaling disabled for this run.\n");
         }
+    }
 
-        case Phase::WaitingForResponse:
-            if (app.hasInput && !app.inputWasFalseStart)
-            {
-                const double reactionMs = QpcDeltaToMilliseconds(
-                    app.inputQpc - app.stimulusQpc,
-                    app.qpcFreq.QuadPart);
+    // Console writes can block for milliseconds; the timing thread only queues the per-trial messages.
+    if (app.session.config.logTrials)
+    {
+        app.log.Open();
+        app.session.log = &app.log;
+    }
+    app.realtimeScope.Enter(app.realtime);
 
-                app.results.push_back(TrialResult{
-                    app.scheduledDelaySeconds,
-                    reactionMs,
-                    false
-                    });
+    QpcClock clock{app.qpcFreq.QuadPart, app.waitTimer};
+    D3D11Display display{app};
+    Win32Input input{app};
+    purple::SessionOutcome outcome = purple::SessionOutcome::Completed;
+    // Frame statistics normally arrive within a frame or two of the vblank; give up after 100 ms.
+    purple::FrameStatisticsOnset<D3D11Display> scanoutOnset(display, app.qpcFreq.QuadPart / 10);
+    purple::MidpointOnset midpointOnset;
+    if (app.server != nullptr)
+    {
+        purple::ServedInput<Win32Input> served(input, *app.server);
+        outcome = app.scanoutOnset ?
+            purple::RunTrialLoop(app.session, clock, display, served, scanoutOnset) :
+            purple::RunTrialLoop(app.session, clock, display, served, midpointOnset);
+    }
+    else
+    {
+        outcome = app.scanoutOnset ?
+            purple::RunTrialLoop(app.session, clock, display, input, scanoutOnset) :
+            purple::RunTrialLoop(app.session, clock, display, input, midpointOnset);
+    }
 
-                std::printf("  Reaction: %.3f ms\n", reactionMs);
+    app.input.capturing.store(false, std::memory_order_release);
+    app.session.log = nullptr;
+    app.log.Close();
+    const unsigned long long dropped = app.input.dropped.load(std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        std::printf("Warning: %llu input events dropped (capture ring full).\n", dropped);
+    }
 
-                ++app.trialIndex;
-                app.phase = (app.trialIndex >= app.trialCount) ? Phase::Finished : Phase::BeginTrial;
-            }
-            else
-            {
-                SwitchToThread();
-            }
-            break;
+    app.realtimeScope.Leave();
+    app.realtimeReport = app.realtimeScope.Report();
+    app.realtimeReport.inputPriorityRaised = app.input.applied.priorityRaised;
+    app.realtimeReport.inputCpus = app.input.applied.cpus;
+    app.stoppingReport = purple::MakeStoppingReport(app.session);
+    LeaveFullscreen(app);
+    DescribeRawInputDevices(app.session.devices);
 
-        case Phase::Finished:
-            sessionActive = false;
-            outcome = SessionOutcome::Completed;
-            break;
+    if (app.session.trace != nullptr)
+    {
+        app.session.trace = nullptr;
+        app.trace.AppendRunMetadata(app.session.devices, app.realtimeReport);
+        if (!app.trace.Close())
+        {
+            std::printf("Warning: trace file incomplete (write failed).\n");
         }
     }
 
-    SetRealtimePriority(false);
-    LeaveFullscreen(app);
+    if (app.session.journal != nullptr)
+    {
+        // The run kept nothing in memory; the menu, the summary and the exports read the journal back.
+        app.session.journal = nullptr;
+        if (!app.journal.Close(outcome))
+        {
+            std::printf("Warning: journal may be incomplete (flush failed).\n");
+        }
+        purple::JournalContents contents;
+        if (purple::LoadJournal(journalPath, contents))
+        {
+            app.session.results = std::move(contents.results);
+        }
+    }
 
-    if (outcome == SessionOutcome::Completed)
+    if (outcome == purple::SessionOutcome::Completed && !app.stream.WritesToStdout())
     {
-        PrintResults(app);
+        purple::PrintResults(app.session.results, app.session.stats, app.session.config.plan, app.session.devices,
+            app.session.config.stopping.Enabled() ? &app.stoppingReport : nullptr);
     }
-    else if (outcome == SessionOutcome::Aborted)
+    else if (outcome == purple::SessionOutcome::Aborted)
     {
         std::printf("\nRun aborted.\n");
     }
@@ -1156,6 +1443,59 @@ int PromptPostRunChoice()
     std::printf("3. Quit\n");
     return PromptChoice("Select option: ", 1, 3);
 }
+
+// --poll-analyze: records every raw report for the window, then prints each device's polling interval,
+// jitter, missed/coalesced reports and bounce. Nothing is allocated per report.
+int RunPollingAnalyzer(App& app)
+{
+    std::printf("Input polling analysis: keep the mouse moving, click and type for %.1f s...\n", app.pollAnalyzeSeconds);
+    // Room for four 8 kHz devices over the whole window.
+    purple::ReportRecorder recorder(static_cast<size_t>(app.pollAnalyzeSeconds * 4.0 * 8000.0) + purple::ReportRing::capacity());
+    const auto record = [&recorder](const purple::InputReport& report) { recorder.Add(report); };
+
+    app.input.reportsDropped.store(0, std::memory_order_relaxed);
+    app.input.analyzing.store(true, std::memory_order_release);
+    app.input.capturing.store(true, std::memory_order_release);
+    const LONGLONG end = QpcNow() + static_cast<LONGLONG>(app.pollAnalyzeSeconds * static_cast<double>(app.qpcFreq.QuadPart));
+    while (QpcNow() < end && !app.quitRequested)
+    {
+        PumpMessages(app);
+        purple::DrainRing(app.input.reports, record);
+        Sleep(1);
+    }
+    app.input.capturing.store(false, std::memory_order_release);
+    app.input.analyzing.store(false, std::memory_order_release);
+    purple::DrainRing(app.input.reports, record);
+
+    const unsigned long long dropped = app.input.reportsDropped.load(std::memory_order_relaxed) + recorder.Overflow();
+    if (dropped > 0)
+    {
+        std::printf("Warning: %llu reports dropped (capture ring or recorder full); missed counts are too high.\n", dropped);
+    }
+
+    std::vector<purple::DevicePolling> analysis = purple::AnalyzeReports(recorder.Reports(), app.qpcFreq.QuadPart);
+    std::vector<purple::InputDevice> devices(analysis.size());
+    for (size_t i = 0; i < analysis.size(); ++i)
+    {
+        devices[i].handle = analysis[i].device;
+    }
+    DescribeRawInputDevices(devices);
+    for (size_t i = 0; i < analysis.size(); ++i)
+    {
+        analysis[i].id = devices[i].id;
+    }
+    purple::PrintPollingAnalysis(analysis, app.pollAnalyzeSeconds);
+
+    if (!app.pollOutputPath.empty())
+    {
+        if (!purple::SaveReportStream(app.pollOutputPath, recorder.Reports(), app.qpcFreq.QuadPart))
+        {
+            return 2;
+        }
+        std::printf("Report stream saved: %s\n", app.pollOutputPath.c_str());
+    }
+    return 0;
+}
 } // namespace
 
 int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int)
@@ -1186,6 +1526,32 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int)
         CreateConsole();
     }
 
+    if (!app.streamOutputPath.empty())
+    {
+        // In --run-once mode stdout is whatever the launching process handed us, typically a pipe.
+        if (!app.stream.Open(app.streamOutputPath))
+        {
+            std::printf("Failed to open stream path: %s\n", app.streamOutputPath.c_str());
+            return 2;
+        }
+        app.session.stream = &app.stream;
+        if (app.stream.WritesToStdout())
+        {
+            app.session.config.logTrials = false;
+        }
+    }
+
+    if (!app.telemetryName.empty())
+    {
+        // Kept for the whole process so monitors stay attached across runs.
+        if (!app.telemetry.Open(app.telemetryName))
+        {
+            std::printf("Failed to create telemetry block: %s\n", app.telemetryName.c_str());
+            return 2;
+        }
+        app.session.telemetry = &app.telemetry;
+    }
+
     DEVMODEW dm{};
     dm.dmSize = sizeof(dm);
     if (!EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &dm))
@@ -1201,29 +1567,64 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int)
         PrintLastErrorAndExit("QueryPerformanceFrequency failed");
     }
 
+    app.waitTimer = CreateWaitTimer();
+
     app.hwnd = CreateWindowForFullscreen(instance, app.width, app.height);
     SetWindowLongPtrW(app.hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&app));
 
-    RegisterRawInput(app.hwnd);
+    app.input.realtime = app.realtime;
+    StartInputCapture(app, instance);
     InitD3D11(app, dm.dmDisplayFrequency > 0 ? dm.dmDisplayFrequency : 60);
     ShowWindow(app.hwnd, SW_HIDE);
 
     int exitCode = 0;
-    if (app.runOnceNoPrompt)
+    if (app.pollAnalyzeSeconds > 0.0)
     {
-        const SessionOutcome outcome = RunTestSession(app, false);
-        if (outcome == SessionOutcome::Completed)
+        exitCode = RunPollingAnalyzer(app);
+    }
+    else if (!app.serveEndpoint.empty())
+    {
+        // Device, window and input capture stay up between runs; each client run gets its own fullscreen pass.
+        purple::RunServer server(app.session.config);
+        if (!server.Start(app.serveEndpoint))
         {
-            if (!app.csvOutputPath.empty() && !ExportResultsCsv(app, app.csvOutputPath))
+            exitCode = 2;
+        }
+        else
+        {
+            app.server = &server;
+            while (!app.quitRequested && server.WaitForRun(app.session))
+            {
+                const purple::SessionOutcome outcome = RunTestSession(app, false);
+                server.FinishRun(app.session);
+                if (outcome == purple::SessionOutcome::QuitRequested)
+                {
+                    app.quitRequested = true;
+                }
+            }
+            server.Stop();
+            app.server = nullptr;
+        }
+    }
+    else if (app.runOnceNoPrompt)
+    {
+        const purple::SessionOutcome outcome = RunTestSession(app, false);
+        if (outcome == purple::SessionOutcome::Completed)
+        {
+            if ((!app.csvOutputPath.empty() || !app.jsonOutputPath.empty()) &&
+                !purple::ExportResults(app.session.results, app.session.stats, app.csvOutputPath, app.jsonOutputPath,
+                    app.session.config.plan, RunMetadata(app)))
             {
                 exitCode = 2;
             }
-            if (!app.jsonOutputPath.empty() && !ExportResultsJson(app, app.jsonOutputPath))
+            if (!app.binaryOutputPath.empty() &&
+                !purple::ExportResultsColumnar(app.session.results, app.session.config, app.qpcFreq.QuadPart,
+                    app.binaryOutputPath, RunMetadata(app)))
             {
                 exitCode = 2;
             }
         }
-        else if (outcome == SessionOutcome::Aborted)
+        else if (outcome == purple::SessionOutcome::Aborted)
         {
             exitCode = 3;
         }
@@ -1245,10 +1646,20 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int)
             }
 
             std::printf("\n=== PurpleReaction ===\n");
-            std::printf("Current settings: delay %.3f-%.3f s, trials %d\n",
-                app.minDelaySeconds,
-                app.maxDelaySeconds,
-                app.trialCount);
+            if (app.session.config.plan.empty())
+            {
+                std::printf("Current settings: delay %.3f-%.3f s, trials %d\n",
+                    app.session.config.minDelaySeconds,
+                    app.session.config.maxDelaySeconds,
+                    app.session.config.trialCount);
+            }
+            else
+            {
+                std::printf("Current settings: plan %s, %zu blocks, trials %d\n",
+                    app.planPath.c_str(),
+                    app.session.config.plan.size(),
+                    purple::PlannedTrialCount(app.session.config));
+            }
             std::printf("1. Start test\n");
             std::printf("2. Settings\n");
             std::printf("3. About\n");
@@ -1261,13 +1672,13 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int)
                 bool keepRunningTests = true;
                 while (keepRunningTests && !app.quitRequested)
                 {
-                    const SessionOutcome outcome = RunTestSession(app, true);
-                    if (outcome == SessionOutcome::QuitRequested)
+                    const purple::SessionOutcome outcome = RunTestSession(app, true);
+                    if (outcome == purple::SessionOutcome::QuitRequested)
                     {
                         app.quitRequested = true;
                         break;
                     }
-                    if (outcome == SessionOutcome::Completed)
+                    if (outcome == purple::SessionOutcome::Completed)
                     {
                         PromptCsvExport(app);
                     }
@@ -1303,15 +1714,17 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int)
         }
     }
 
-    if (app.swapChain)
-    {
-        app.swapChain->SetFullscreenState(FALSE, nullptr);
-    }
     ShowCursor(TRUE);
+    StopInputCapture(app);
+    app.stream.Close();
     if (app.hwnd)
     {
         DestroyWindow(app.hwnd);
     }
+    if (app.waitTimer)
+    {
+        CloseHandle(app.waitTimer);
+    }
 
     return exitCode;
 }
@@ -0,0 +1,217 @@
+#include "core/columnar.h"
+#include "core/export.h"
+#include "core/headless.h"
+#include "core/polling.h"
+#include "core/session.h"
+#include "core/trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct ReplayOptions
+{
+    std::string csvOutputPath;
+    std::string jsonOutputPath;
+    bool jsonDistribution = false;  // --json-distribution
+    purple::DistributionOptions distribution;
+    std::string binaryOutputPath;
+    std::string outputDirectory;
+    bool quiet = false;
+    bool polling = false;  // the inputs are --poll-out report streams
+    std::vector<std::string> traces;
+};
+
+void PrintUsage()
+{
+    std::printf("Usage:\n");
+    std::printf("  purple_replay [--csv-out path] [--json-out path] [--json-distribution] [--bin-out path] trace\n");
+    std::printf("  purple_replay [--out-dir directory] [--json-distribution] [--quiet] trace...\n");
+    std::printf("Re-derives each trace's results with the current session logic. --out-dir writes <name>.csv and\n");
+    std::printf("<name>.json per completed trace; a single trace prints its results unless --quiet.\n");
+    std::printf("  purple_replay --polling recording...\n");
+    std::printf("Runs the input polling analysis on report streams recorded with --poll-analyze --poll-out.\n");
+}
+
+bool ParseArgs(int argc, char** argv, ReplayOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--csv-out") == 0 && hasValue)
+        {
+            options.csvOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--json-out") == 0 && hasValue)
+        {
+            options.jsonOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--json-distribution") == 0)
+        {
+            options.jsonDistribution = true;
+        }
+        else if (std::strcmp(arg, "--bin-out") == 0 && hasValue)
+        {
+            options.binaryOutputPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--out-dir") == 0 && hasValue)
+        {
+            options.outputDirectory = argv[++i];
+        }
+        else if (std::strcmp(arg, "--quiet") == 0)
+        {
+            options.quiet = true;
+        }
+        else if (std::strcmp(arg, "--polling") == 0)
+        {
+            options.polling = true;
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.traces.push_back(arg);
+        }
+    }
+
+    const bool singleOutputs =
+        !options.csvOutputPath.empty() || !options.jsonOutputPath.empty() || !options.binaryOutputPath.empty();
+    if (options.traces.empty() || (singleOutputs && (options.traces.size() != 1 || !options.outputDirectory.empty())))
+    {
+        return false;
+    }
+    return !options.polling || (!singleOutputs && options.outputDirectory.empty());
+}
+
+const char* OutcomeName(purple::SessionOutcome outcome)
+{
+    switch (outcome)
+    {
+    case purple::SessionOutcome::Completed:
+        return "completed";
+    case purple::SessionOutcome::Aborted:
+        return "aborted";
+    case purple::SessionOutcome::QuitRequested:
+        return "quit";
+    }
+    return "unknown";
+}
+int AnalyzeRecordings(const ReplayOptions& options)
+{
+    std::vector<purple::InputReport> reports;
+    size_t failed = 0;
+    for (const std::string& path : options.traces)
+    {
+        purple::Ticks frequency = 0;
+        if (!purple::LoadReportStream(path, reports, frequency))
+        {
+            ++failed;
+            continue;
+        }
+        const double seconds =
+            reports.empty() ? 0.0 : purple::TicksToSeconds(reports.back().timestamp - reports.front().timestamp, frequency);
+        std::printf("%s:", path.c_str());
+        purple::PrintPollingAnalysis(purple::AnalyzeReports(reports, frequency), seconds);
+    }
+    return failed == 0 ? 0 : 2;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (options.polling)
+    {
+        return AnalyzeRecordings(options);
+    }
+
+    const bool single = options.traces.size() == 1;
+    purple::MonotonicClock clock;
+    const purple::Ticks start = clock.Now();
+    purple::SessionTrace trace;
+    purple::Session session;
+    session.config.logTrials = false;
+    size_t failed = 0;
+    size_t trials = 0;
+    for (const std::string& path : options.traces)
+    {
+        if (!purple::LoadTrace(path, trace))
+        {
+            ++failed;
+            continue;
+        }
+
+        const purple::SessionOutcome outcome = purple::ReplayTrace(trace, session);
+        trials += session.results.size();
+        if (!options.quiet)
+        {
+            const purple::ReactionSummary summary = session.stats.Summary();
+            std::printf("%s: %s%s, %zu trials, %zu valid, %zu false starts, mean %.3f ms\n",
+                path.c_str(),
+                OutcomeName(outcome),
+                trace.complete ? "" : " (truncated trace)",
+                summary.trialCount,
+                summary.validCount,
+                summary.falseStartCount,
+                summary.meanMs);
+        }
+        if (outcome != purple::SessionOutcome::Completed)
+        {
+            continue;
+        }
+
+        // Version 2 traces carry what the recorded run exported beyond its trials; older ones export without it.
+        const purple::StoppingReport stoppingReport = purple::MakeStoppingReport(session);
+        const purple::StoppingReport* stopping = session.config.stopping.Enabled() ? &stoppingReport : nullptr;
+        const purple::ExportMetadata metadata{trace.hasSettings ? &session.config.foreperiod : nullptr,
+            trace.hasRealtime ? &trace.realtime : nullptr, &trace.devices, stopping,
+            options.jsonDistribution ? &options.distribution : nullptr};
+        if (single && !options.quiet)
+        {
+            purple::PrintResults(session.results, session.stats, session.config.plan, trace.devices, stopping);
+        }
+
+        std::string csvPath = options.csvOutputPath;
+        std::string jsonPath = options.jsonOutputPath;
+        if (!options.outputDirectory.empty())
+        {
+            const std::filesystem::path base = std::filesystem::path(options.outputDirectory) / std::filesystem::path(path).stem();
+            csvPath = base.string() + ".csv";
+            jsonPath = base.string() + ".json";
+        }
+        if ((!csvPath.empty() || !jsonPath.empty()) &&
+            !purple::ExportResults(session.results, session.stats, csvPath, jsonPath, session.config.plan, metadata))
+        {
+            ++failed;
+        }
+        if (!options.binaryOutputPath.empty() &&
+            !purple::ExportResultsColumnar(session.results, session.config, trace.tickFrequency, options.binaryOutputPath,
+                metadata))
+        {
+            ++failed;
+        }
+    }
+
+    const double seconds = purple::TicksToSeconds(clock.Now() - start, clock.Frequency());
+    if (!single)
+    {
+        std::printf("Replayed %zu traces (%zu trials) in %.3f s; %zu failed.\n",
+            options.traces.size() - failed,
+            trials,
+            seconds,
+            failed);
+    }
+    return failed == 0 ? 0 : 2;
+}